@@ -0,0 +1,93 @@
+#include "auto_tuner.h"
+#include <algorithm>
+
+OnlineTuner::OnlineTuner(const TunerOptions& options, const TunerKnobs& initial)
+    : options_(options), best_(initial), current_(initial) {
+    options_.max_workers = std::max<size_t>(1, options_.max_workers);
+    options_.max_batch_limit = std::max<size_t>(1, options_.max_batch_limit);
+    best_.max_batch = std::clamp<size_t>(best_.max_batch, 1, options_.max_batch_limit);
+    best_.batch_wait_us = std::clamp<int64_t>(best_.batch_wait_us, 0, options_.max_batch_wait_us);
+    best_.workers = std::clamp<size_t>(best_.workers, 1, options_.max_workers);
+    current_ = best_;
+}
+
+bool OnlineTuner::better(const TunerSample& candidate, const TunerSample& base) const {
+    if (feasible(candidate) != feasible(base)) {
+        return feasible(candidate);
+    }
+    // 같은 쪽이면 처리량 우선 (둘 다 상한을 넘는 과부하에서는 p99가 큐 대기로 포화되어 비교가 안 됨)
+    // 부하가 처리량보다 낮으면 qps는 같으므로 p99로 비교
+    if (candidate.qps > base.qps * (1.0 + QPS_TOLERANCE)) {
+        return true;
+    }
+    return candidate.qps >= base.qps * (1.0 - QPS_TOLERANCE) && candidate.p99_us < base.p99_us * P99_IMPROVEMENT;
+}
+
+bool OnlineTuner::applyMove(size_t move, TunerKnobs& knobs) const {
+    knobs = best_;
+    bool up = move % 2 == 0;
+    switch (move / 2) {
+        case 0:
+            knobs.max_batch = up ? std::min(options_.max_batch_limit, knobs.max_batch * 2)
+                                 : std::max<size_t>(1, knobs.max_batch / 2);
+            break;
+        case 1:
+            if (up) {
+                knobs.batch_wait_us = knobs.batch_wait_us == 0 ? MIN_BATCH_WAIT_STEP_US : knobs.batch_wait_us * 2;
+                knobs.batch_wait_us = std::min(options_.max_batch_wait_us, knobs.batch_wait_us);
+            } else {
+                knobs.batch_wait_us = knobs.batch_wait_us <= MIN_BATCH_WAIT_STEP_US ? 0 : knobs.batch_wait_us / 2;
+            }
+            break;
+        default: {
+            size_t step = std::max<size_t>(1, knobs.workers / 8);
+            knobs.workers = up ? std::min(options_.max_workers, knobs.workers + step)
+                               : std::max<size_t>(1, knobs.workers > step ? knobs.workers - step : 1);
+            break;
+        }
+    }
+    return !(knobs == best_);
+}
+
+void OnlineTuner::startTrial() {
+    for (size_t tried = 0; tried < NUM_MOVES; ++tried) {
+        if (applyMove(move_, current_)) {
+            measuring_best_ = false;
+            ++trials_;
+            return;
+        }
+        move_ = (move_ + 1) % NUM_MOVES;
+    }
+    // 모든 knob이 범위 끝 (예: 워커 1개, 배치 1): best만 계속 측정
+    current_ = best_;
+    measuring_best_ = true;
+}
+
+const TunerKnobs& OnlineTuner::observe(const TunerSample& sample) {
+    if (sample.queries < options_.min_window_queries) {
+        // 유휴 구간: 판단하지 않고 best로 돌아가 다시 측정
+        current_ = best_;
+        measuring_best_ = true;
+        return current_;
+    }
+
+    if (measuring_best_) {
+        best_sample_ = sample;
+        startTrial();
+        return current_;
+    }
+
+    if (better(sample, best_sample_)) {
+        // 채택: 방금 측정값이 새 best의 측정값, 같은 방향으로 한 번 더
+        best_ = current_;
+        best_sample_ = sample;
+        ++accepted_;
+        startTrial();
+    } else {
+        // 되돌림: 나쁜 후보가 남긴 backlog가 빠지도록 best를 다시 측정한 뒤 다음 move
+        move_ = (move_ + 1) % NUM_MOVES;
+        current_ = best_;
+        measuring_best_ = true;
+    }
+    return current_;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// 온라인 튜닝 대상 설정 (검색 워커가 배치마다 읽음)
+struct TunerKnobs {
+    size_t max_batch = 32;        // 배치 크기 상한 (그 아래에서는 AIMD가 조정)
+    int64_t batch_wait_us = 0;    // 가장 오래된 쿼리 기준 배치 대기 시간
+    size_t workers = 1;           // 태스크를 가져가는 워커 수 (나머지는 대기)
+
+    bool operator==(const TunerKnobs& other) const = default;
+};
+
+// 목표: p99 상한 안에서 처리량 최대
+struct TunerOptions {
+    std::chrono::microseconds p99_bound{20000};
+    std::chrono::milliseconds interval{2000};   // 설정 하나를 측정하는 구간
+    uint64_t min_window_queries = 200;          // 이보다 적게 처리한 구간은 판단에 쓰지 않음 (유휴)
+    size_t max_batch_limit = 256;
+    int64_t max_batch_wait_us = 2000;
+    size_t max_workers = 1;                     // 검색 pool의 워커 수
+};
+
+// 구간 하나의 측정값
+struct TunerSample {
+    double qps = 0.0;
+    uint64_t p99_us = 0;
+    uint64_t queries = 0;
+};
+
+// 좌표별 hill-climbing
+// - 현재 최선 설정(best)을 한 구간 측정한 뒤, 한 knob을 한 방향으로 움직인 후보를 한 구간 측정해서 비교
+// - 후보가 나으면 채택하고 같은 방향으로 계속, 아니면 되돌리고 다음 (knob, 방향)으로
+// - 탐색을 멈추지 않으므로 부하나 DRAM 복제 비율이 바뀌면 최적점을 따라감
+class OnlineTuner {
+public:
+    OnlineTuner(const TunerOptions& options, const TunerKnobs& initial);
+
+    // 직전 구간에 적용돼 있던 설정의 측정값을 받고, 다음 구간에 적용할 설정을 반환
+    const TunerKnobs& observe(const TunerSample& sample);
+
+    const TunerKnobs& best() const { return best_; }
+    const TunerKnobs& current() const { return current_; }
+    const TunerSample& bestSample() const { return best_sample_; }
+    uint64_t getTrials() const { return trials_; }
+    uint64_t getAccepted() const { return accepted_; }
+    const TunerOptions& options() const { return options_; }
+
+private:
+    static constexpr size_t NUM_MOVES = 6;   // (batch, wait, workers) × (증가, 감소)
+    static constexpr double QPS_TOLERANCE = 0.02;
+    static constexpr double P99_IMPROVEMENT = 0.9;
+    static constexpr int64_t MIN_BATCH_WAIT_STEP_US = 50;
+
+    TunerOptions options_;
+    TunerKnobs best_;
+    TunerKnobs current_;
+    TunerSample best_sample_;
+    bool measuring_best_ = true;   // true: best 측정 구간, false: 후보 측정 구간
+    size_t move_ = 0;
+    uint64_t trials_ = 0;
+    uint64_t accepted_ = 0;
+
+    bool feasible(const TunerSample& sample) const {
+        return sample.p99_us <= static_cast<uint64_t>(options_.p99_bound.count());
+    }
+    bool better(const TunerSample& candidate, const TunerSample& base) const;
+    // best에서 move만큼 움직인 설정 (범위 끝이라 움직일 수 없으면 false)
+    bool applyMove(size_t move, TunerKnobs& knobs) const;
+    // move_부터 움직일 수 있는 첫 move로 후보를 만듦
+    void startTrial();
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// POST /api/search/bin 바이너리 프로토콜 (application/octet-stream, little-endian)
+//
+// 요청:  [SearchRequestHeader][float32 × dim × count]
+// 응답:  [SearchResponseHeader][ResultEntry × k × count]
+//        쿼리마다 정확히 k개 슬롯, 결과가 k개보다 적으면 남는 슬롯은 id = INVALID_ID
+namespace binproto {
+
+constexpr uint32_t REQUEST_MAGIC  = 0x53424456;  // "VDBS"
+constexpr uint32_t RESPONSE_MAGIC = 0x52424456;  // "VDBR"
+constexpr uint64_t INVALID_ID = UINT64_MAX;
+
+constexpr uint32_t MAX_QUERIES_PER_REQUEST = 1024;
+
+// 응답 상태 코드
+enum : uint32_t {
+    STATUS_OK = 0,
+    STATUS_ERROR = 1,
+    STATUS_PARTIAL = 2,   // coordinator (--allow-partial): 응답하지 않은 파티션을 빼고 병합한 결과
+};
+
+#pragma pack(push, 1)
+struct SearchRequestHeader {
+    uint32_t magic;      // REQUEST_MAGIC
+    uint32_t k;          // 쿼리당 결과 개수
+    uint32_t ef;         // HNSW ef (0이면 서버 기본값)
+    uint32_t count;      // 쿼리 개수
+    uint32_t dim;        // 벡터 차원 (서버 차원과 일치해야 함)
+    uint32_t reserved;
+};
+
+struct SearchResponseHeader {
+    uint32_t magic;      // RESPONSE_MAGIC
+    uint32_t status;     // STATUS_*
+    uint32_t count;      // 쿼리 개수
+    uint32_t k;          // 쿼리당 슬롯 개수
+};
+
+struct ResultEntry {
+    uint64_t id;
+    float distance;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SearchRequestHeader) == 24, "SearchRequestHeader must be 24 bytes");
+static_assert(sizeof(SearchResponseHeader) == 16, "SearchResponseHeader must be 16 bytes");
+static_assert(sizeof(ResultEntry) == 12, "ResultEntry must be 12 bytes");
+
+inline size_t requestSize(uint32_t count, uint32_t dim) {
+    return sizeof(SearchRequestHeader) + static_cast<size_t>(count) * dim * sizeof(float);
+}
+
+inline size_t responseSize(uint32_t count, uint32_t k) {
+    return sizeof(SearchResponseHeader) + static_cast<size_t>(count) * k * sizeof(ResultEntry);
+}
+
+}  // namespace binproto
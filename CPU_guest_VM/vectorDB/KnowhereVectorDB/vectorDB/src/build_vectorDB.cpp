@@ -10,6 +10,14 @@ z* 향상된 HNSW 예제 - Faiss HNSW 백엔드 사용
 #include <memory>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <cstdio>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -22,6 +30,10 @@ z* 향상된 HNSW 예제 - Faiss HNSW 백엔드 사용
 #include <knowhere/comp/index_param.h>
 #include <knowhere/version.h>
 
+#include "hnsw_builder.h"
+#include "hnsw_reorder.h"
+#include "hnsw_layout.h"
+
 // Apache Arrow headers
 #include <arrow/api.h>
 #include <arrow/io/api.h>
@@ -29,8 +41,200 @@ z* 향상된 HNSW 예제 - Faiss HNSW 백엔드 사용
 #include <arrow/table.h>
 #include <arrow/array.h>
 
+// 파이프라인 빌드 옵션 (--num-shards 등)
+struct ShardBuildOptions {
+    size_t num_shards = 0;             // 0이면 기존처럼 --index-file 하나를 빌드한 뒤 로드/벤치마크
+    std::string output_dir = ".";      // 샤드 출력 디렉토리 (hnsw_index_NNN.bin)
+    size_t parallel_shards = 1;        // 동시에 빌드할 샤드 수
+    size_t memory_budget_bytes = 0;    // 동시 빌드 샤드들의 추정 메모리 합 상한 (0이면 제한 없음)
+    size_t prefetch_files = 1;         // Add 중에 미리 디코드/prefetch해 둘 다음 Arrow 파일 수
+    bool mmap_output = true;           // 미리 할당한 파일을 mmap해서 직렬화 결과를 바로 복사
+    HNSWReorderMethod reorder = HNSWReorderMethod::None;   // 저장 후 노드 재번호 (locality 최적화)
+};
+
+// mmap한 Arrow IPC stream 파일의 embedding 컬럼 (zero-copy)
+// record batch들이 매핑을 참조하므로 이 객체가 살아 있는 동안 span 포인터가 유효함
+struct MappedEmbeddingFile {
+    struct Span {
+        const float* data;
+        int64_t rows;
+    };
+    
+    std::string path;
+    std::shared_ptr<arrow::io::MemoryMappedFile> file;
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+    std::vector<Span> spans;
+    int64_t rows = 0;
+    
+    // 배치 메타데이터만 읽음 (벡터 페이지는 건드리지 않음)
+    bool open(const std::string& file_path, int dim) {
+        path = file_path;
+        auto file_result = arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ);
+        if (!file_result.ok()) {
+            std::cerr << "Arrow 파일 mmap 실패: " << path << std::endl;
+            return false;
+        }
+        file = file_result.ValueOrDie();
+        auto reader_result = arrow::ipc::RecordBatchStreamReader::Open(file);
+        if (!reader_result.ok()) {
+            std::cerr << "Arrow stream 포맷이 아닙니다: " << path << std::endl;
+            return false;
+        }
+        auto reader = reader_result.ValueOrDie();
+        
+        while (true) {
+            std::shared_ptr<arrow::RecordBatch> batch;
+            if (!reader->ReadNext(&batch).ok()) {
+                std::cerr << "Arrow record batch 읽기 실패: " << path << std::endl;
+                return false;
+            }
+            if (!batch) {
+                break;
+            }
+            auto column = batch->GetColumnByName("embedding");
+            if (!column) {
+                std::cerr << "'embedding' 컬럼을 찾을 수 없습니다: " << path << std::endl;
+                return false;
+            }
+            auto fsl = std::static_pointer_cast<arrow::FixedSizeListArray>(column);
+            if (fsl->length() > 0 && fsl->value_length(0) != dim) {
+                std::cerr << "임베딩 차원이 " << dim << "이 아닙니다: " << path << std::endl;
+                return false;
+            }
+            auto values = std::static_pointer_cast<arrow::FloatArray>(fsl->values());
+            if (fsl->length() > 0) {
+                spans.push_back({values->raw_values() + fsl->value_offset(0), fsl->length()});
+                rows += fsl->length();
+            }
+            batches.push_back(std::move(batch));
+        }
+        return true;
+    }
+    
+    // 벡터 페이지를 미리 올림 (readahead를 건 뒤 페이지마다 한 번씩 읽어서 Add가 page fault로 멈추지 않게 함)
+    void prefetch(int dim) const {
+        static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        for (const auto& span : spans) {
+            uintptr_t begin = reinterpret_cast<uintptr_t>(span.data) & ~(page_size - 1);
+            uintptr_t end = reinterpret_cast<uintptr_t>(span.data + span.rows * dim);
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+        }
+        volatile char sink = 0;
+        for (const auto& span : spans) {
+            const char* bytes = reinterpret_cast<const char*>(span.data);
+            size_t len = static_cast<size_t>(span.rows) * dim * sizeof(float);
+            for (size_t offset = 0; offset < len; offset += page_size) {
+                sink = sink + bytes[offset];
+            }
+        }
+    }
+};
+
+// 파일 목록을 순서대로 디코드 + prefetch하는 스레드 (최대 depth개를 앞서 준비)
+class EmbeddingFilePrefetcher {
+private:
+    std::vector<std::string> files_;
+    int dim_;
+    size_t depth_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<MappedEmbeddingFile>> ready_;   // nullptr이면 실패한 파일 (건너뜀)
+    size_t produced_ = 0;
+    bool stop_ = false;
+
+public:
+    EmbeddingFilePrefetcher(std::vector<std::string> files, int dim, size_t depth)
+        : files_(std::move(files)), dim_(dim), depth_(std::max<size_t>(1, depth)) {
+        thread_ = std::thread([this] { run(); });
+    }
+    
+    ~EmbeddingFilePrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+    
+    // 다음 파일 (모든 파일을 넘겨줬으면 false, 열지 못한 파일은 file이 nullptr)
+    bool next(std::unique_ptr<MappedEmbeddingFile>& file) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !ready_.empty() || (produced_ == files_.size()); });
+        if (ready_.empty()) {
+            return false;
+        }
+        file = std::move(ready_.front());
+        ready_.pop_front();
+        cv_.notify_all();
+        return true;
+    }
+
+private:
+    void run() {
+        for (const auto& path : files_) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return ready_.size() < depth_ || stop_; });
+                if (stop_) {
+                    return;
+                }
+            }
+            auto file = std::make_unique<MappedEmbeddingFile>();
+            if (file->open(path, dim_)) {
+                file->prefetch(dim_);
+            } else {
+                file.reset();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.push_back(std::move(file));
+                ++produced_;
+            }
+            cv_.notify_all();
+        }
+    }
+};
+
+// 동시 빌드 샤드들의 추정 메모리 합을 예산 안으로 제한 (예산보다 큰 샤드도 혼자서는 진행)
+class MemoryBudget {
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t limit_;
+    size_t used_ = 0;
+
+public:
+    explicit MemoryBudget(size_t limit) : limit_(limit) {}
+    
+    void acquire(size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return limit_ == 0 || used_ == 0 || used_ + bytes <= limit_; });
+        used_ += bytes;
+    }
+    
+    void release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            used_ -= bytes;
+        }
+        cv_.notify_all();
+    }
+};
+
+// 샤드 하나가 Add할 연속 파일 구간
+struct ShardPlan {
+    std::vector<std::string> files;
+    int64_t rows = 0;
+    int64_t first_row = 0;   // Add 구간 전체에서 이 샤드 첫 벡터의 행 번호 (.ids 사이드카의 시작 ID)
+};
+
 class AdvancedHNSWMmapExample {
 private:
+    // 이보다 작은 record batch는 staging 버퍼에 모아서 Add (Add 호출당 고정 비용 분산)
+    static constexpr int64_t COALESCE_ROWS = 4096;
+    
     // 설정 변수들 (생성자에서 설정)
     int DIM;          // BGE embedding dimension
     int NB;           // Database size (extracted from PubMed)
@@ -39,13 +243,16 @@ private:
     int FIRST_FILE_IDX; // 첫 번째 파일 인덱스 (0)
     std::string dataset_dir;  // Dataset directory path (PubMed_bge_100000)
     std::string index_file; // Index file path
+    ShardBuildOptions build_options_;
 
 public:
     // 생성자 - 파라미터 설정
     AdvancedHNSWMmapExample(int dim = 768, int nb = 50000, int nq = 100, int k = 10, int first_file_idx = 0,
                            const std::string& dataset_path = "/home/comsys/CXLSharedMemVM/KnowhereVectorDB/Dataset/PubMed_bge/PubMed_bge_100000",
-                           const std::string& index_path = "hnsw_index.bin")
-        : DIM(dim), NB(nb), NQ(nq), K(k), dataset_dir(dataset_path), index_file(index_path), FIRST_FILE_IDX(first_file_idx) {
+                           const std::string& index_path = "hnsw_index.bin",
+                           const ShardBuildOptions& build_options = ShardBuildOptions())
+        : DIM(dim), NB(nb), NQ(nq), K(k), FIRST_FILE_IDX(first_file_idx), dataset_dir(dataset_path), index_file(index_path),
+          build_options_(build_options) {
 
         // 데이터셋 디렉토리 경로가 '/'로 끝나지 않으면 추가
         if (!dataset_dir.empty() && dataset_dir.back() != '/') {
@@ -58,7 +265,12 @@ public:
         std::cout << "NQ: " << NQ << std::endl;
         std::cout << "K: " << K << std::endl;
         std::cout << "PubMed BGE 데이터셋 디렉토리: " << dataset_dir << std::endl;
-        std::cout << "인덱스 파일: " << index_file << std::endl;
+        if (build_options_.num_shards > 0) {
+            std::cout << "샤드: " << build_options_.num_shards << "개 → " << build_options_.output_dir
+                      << " (동시 " << build_options_.parallel_shards << "개)" << std::endl;
+        } else {
+            std::cout << "인덱스 파일: " << index_file << std::endl;
+        }
     }
 
     std::vector<float> loadQueryData() {
@@ -92,29 +304,8 @@ public:
         return queries;
     }
     
-    // HNSW 인덱스 생성 (Arrow 파일 단위 처리)
-    void buildAndSaveIndex() {
-        std::cout << "\n=== HNSW 인덱스 빌드 시작 (Arrow 파일 단위 처리) ===" << std::endl;
-        auto start = std::chrono::high_resolution_clock::now();
-
-        auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
-        auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>("HNSW", version);
-        if (!index.has_value()) {
-            throw std::runtime_error("HNSW 인덱스 생성 실패");
-        }
-        
-        // 메모리 효율적 HNSW 파라미터 (대용량 데이터용)
-        knowhere::Json config;
-        config[knowhere::meta::DIM] = DIM;
-        config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
-        config[knowhere::indexparam::HNSW_M] = 64;           // 메모리 사용량 줄이기
-        config[knowhere::indexparam::EFCONSTRUCTION] = 200;  // 적절한 품질 유지
-        config[knowhere::indexparam::EF] = 100;              // 검색 품질
-        config[knowhere::meta::TOPK] = K;
-        
-        // mmap 지원 활성화
-        config["enable_mmap"] = true;
-        
+    // dataset_dir 아래의 .arrow 파일 (이름순)
+    std::vector<std::string> listArrowFiles() const {
         std::vector<std::string> arrow_files;
         for (const auto& entry : std::filesystem::recursive_directory_iterator(dataset_dir)) {
             if (entry.path().extension() == ".arrow") {
@@ -123,65 +314,251 @@ public:
         }
         if (arrow_files.empty()) throw std::runtime_error("Arrow 파일을 찾을 수 없습니다.");
         std::sort(arrow_files.begin(), arrow_files.end());
-
-        // 첫 번째 Arrow 파일 전체를 로드하여 Train에 사용
-        std::cout << "인덱스 초기화를 위해 첫 번째 Arrow 파일 로드 중..." << std::endl;
+        return arrow_files;
+    }
+    
+    // Train 데이터 (FIRST_FILE_IDX + 1 파일 전체, 모든 샤드가 공유)
+    std::vector<float> loadTrainData(const std::vector<std::string>& arrow_files) {
+        if (arrow_files.size() < static_cast<size_t>(FIRST_FILE_IDX) + 2) {
+            throw std::runtime_error("Train용 Arrow 파일이 없습니다.");
+        }
+        std::cout << "인덱스 초기화를 위해 Train용 Arrow 파일 로드 중..." << std::endl;
+        MappedEmbeddingFile file;
+        if (!file.open(arrow_files[FIRST_FILE_IDX + 1], DIM) || file.rows == 0) {
+            throw std::runtime_error("Train용 Arrow 파일을 로드할 수 없습니다.");
+        }
         std::vector<float> train_data;
-        processFileInBatches(arrow_files[FIRST_FILE_IDX + 1],
-            [&](const std::vector<float>& file_vectors) {
-                train_data = file_vectors;
-            });
-
-        if (train_data.empty()) {
-            throw std::runtime_error("첫 번째 Arrow 파일을 로드할 수 없습니다.");
+        train_data.reserve(static_cast<size_t>(file.rows) * DIM);
+        for (const auto& span : file.spans) {
+            train_data.insert(train_data.end(), span.data, span.data + span.rows * DIM);
         }
-
-        int train_size = train_data.size() / DIM;
-        std::cout << "인덱스 Train 단계... (Train 데이터: " << train_size << "개 벡터)" << std::endl;
-        auto init_dataset = knowhere::GenDataSet(train_size, DIM, train_data.data());
-        auto status = index.value().Train(init_dataset, config);
-        if (status != knowhere::Status::success) {
-            throw std::runtime_error("인덱스 Train 실패");
+        return train_data;
+    }
+    
+    // FIRST_FILE_IDX + 2부터 NB를 채우는 파일 prefix를 행 수 기준으로 num_shards개의 연속 구간으로 나눔
+    // (파일 단위로 나누므로 샤드 크기는 대략 같음, 파일 수가 부족하면 빈 샤드는 만들지 않음)
+    std::vector<ShardPlan> planShards(const std::vector<std::string>& arrow_files, size_t num_shards) {
+        std::vector<std::string> files;
+        std::vector<int64_t> file_rows;
+        int64_t total_rows = 0;
+        for (size_t file_idx = FIRST_FILE_IDX + 2; file_idx < arrow_files.size() && total_rows < NB; ++file_idx) {
+            MappedEmbeddingFile file;
+            if (!file.open(arrow_files[file_idx], DIM) || file.rows == 0) {
+                continue;
+            }
+            files.push_back(arrow_files[file_idx]);
+            file_rows.push_back(file.rows);
+            total_rows += file.rows;
         }
-
-        // 두 번째 Arrow 파일부터 파일 단위로 Add
-        std::cout << "Arrow 파일 단위로 인덱스에 데이터 추가하는 중... (총 " << arrow_files.size() << "개 파일)" << std::endl;
+        if (files.empty()) {
+            throw std::runtime_error("Add할 Arrow 파일이 없습니다.");
+        }
+        
+        std::vector<ShardPlan> plans;
+        ShardPlan current;
+        int64_t cumulative = 0;
+        for (size_t i = 0; i < files.size(); ++i) {
+            current.files.push_back(files[i]);
+            current.rows += file_rows[i];
+            cumulative += file_rows[i];
+            // 누적 행 수가 다음 샤드 경계(total × (s + 1) / num_shards)를 넘으면 샤드를 닫음
+            int64_t boundary = total_rows * static_cast<int64_t>(plans.size() + 1) /
+                               static_cast<int64_t>(num_shards);
+            if (cumulative >= boundary || i + 1 == files.size()) {
+                current.first_row = cumulative - current.rows;
+                plans.push_back(std::move(current));
+                current = ShardPlan();
+            }
+        }
+        if (plans.size() < num_shards) {
+            std::cout << "파일 수가 부족하여 샤드 " << plans.size() << "개만 빌드합니다." << std::endl;
+        }
+        return plans;
+    }
+    
+    // 파일들을 순서대로 Add (다음 파일은 prefetch 스레드가 디코드/페이지 선로드)
+    // 큰 record batch는 mmap된 Arrow 버퍼에서 바로 Add하고, 작은 batch는 모아서 한 번에 Add
+    int64_t addFiles(HNSWBuilder& builder, const std::vector<std::string>& files, const std::string& tag) {
+        EmbeddingFilePrefetcher prefetcher(files, DIM, build_options_.prefetch_files);
+        std::vector<float> staging;
+        int64_t staged_rows = 0;
         int64_t total_added = 0;
-
-        for (size_t file_idx = FIRST_FILE_IDX + 2; file_idx < arrow_files.size(); ++file_idx) {
-            if (total_added >= NB) break;
-            
-            const auto& file_path = arrow_files[file_idx];
-            std::cout << "  파일 처리 중 [" << file_idx << "/" << arrow_files.size()-1 << "]: " << std::filesystem::path(file_path).filename() << std::endl;
-            
-            std::vector<float> file_data;
-            processFileInBatches(file_path,
-                [&](const std::vector<float>& file_vectors) {
-                    file_data = file_vectors;
-                });
-            
-            if (file_data.empty()) continue;
-            
-            int current_file_size = file_data.size() / DIM;
-            
-            auto add_dataset = knowhere::GenDataSet(current_file_size, DIM, file_data.data());
-            auto add_status = index.value().Add(add_dataset, config);
-            if (add_status != knowhere::Status::success) {
-                throw std::runtime_error("파일 데이터 추가 실패");
+        
+        auto addRows = [&](const float* data, int64_t rows) {
+            if (!builder.add(data, rows)) {
+                throw std::runtime_error(tag + "파일 데이터 추가 실패");
             }
-            
-            total_added += current_file_size;
-            std::cout << "    > 파일 추가 완료. (현재 파일: " << current_file_size 
-                      << "개, 총 추가: " << total_added << "/" << NB 
-                      << ", ID 범위: " << total_added - current_file_size 
-                      << "-" << total_added - 1 << ")" << std::endl;
+            total_added += rows;
+        };
+        auto flushStaging = [&]() {
+            if (staged_rows > 0) {
+                addRows(staging.data(), staged_rows);
+                staging.clear();
+                staged_rows = 0;
+            }
+        };
+        
+        std::unique_ptr<MappedEmbeddingFile> file;
+        size_t file_number = 0;
+        while (prefetcher.next(file)) {
+            ++file_number;
+            if (!file) {
+                continue;
+            }
+            for (const auto& span : file->spans) {
+                if (span.rows >= COALESCE_ROWS) {
+                    flushStaging();
+                    addRows(span.data, span.rows);
+                } else {
+                    staging.insert(staging.end(), span.data, span.data + span.rows * DIM);
+                    staged_rows += span.rows;
+                    if (staged_rows >= COALESCE_ROWS) {
+                        flushStaging();
+                    }
+                }
+            }
+            // staging은 복사본이므로 파일 매핑은 여기서 놓아도 됨
+            std::cout << "  " << tag << "파일 추가 완료 [" << file_number << "/" << files.size() << "]: "
+                      << std::filesystem::path(file->path).filename() << " (" << file->rows
+                      << "개, 총 추가: " << total_added + staged_rows << ")" << std::endl;
+        }
+        flushStaging();
+        return total_added;
+    }
+    
+    // 샤드 하나를 Train → Add → 저장 (write_ids면 전역 행 번호를 .ids 사이드카로 기록)
+    void buildShard(const ShardPlan& plan, const std::vector<float>& train_data,
+                    const std::string& output, bool write_ids, const std::string& tag) {
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        // 메모리 효율적 HNSW 파라미터 (대용량 데이터용, hnsw_builder.h 기본값)
+        HNSWBuildParams params;
+        params.dim = DIM;
+        params.topk = K;
+        HNSWBuilder builder(params);
+        
+        int train_size = train_data.size() / DIM;
+        std::cout << tag << "인덱스 Train 단계... (Train 데이터: " << train_size << "개 벡터)" << std::endl;
+        if (!builder.train(train_data.data(), train_size)) {
+            throw std::runtime_error(tag + "인덱스 Train 실패");
         }
         
+        std::cout << tag << "Arrow 파일 단위로 인덱스에 데이터 추가하는 중... (총 " << plan.files.size()
+                  << "개 파일, " << plan.rows << "개 벡터)" << std::endl;
+        int64_t added = addFiles(builder, plan.files, tag);
+        
         auto end_build = std::chrono::high_resolution_clock::now();
         auto duration_build = std::chrono::duration_cast<std::chrono::seconds>(end_build - start);
-        std::cout << "인덱스 빌드 완료: " << duration_build.count() << "s" << std::endl;
-
-        saveIndexWithMmapSupport(index.value(), index_file, config);
+        std::cout << tag << "인덱스 빌드 완료: " << duration_build.count() << "s (" << added << "개 벡터)" << std::endl;
+        
+        saveIndexWithMmapSupport(builder, output);
+        
+        if (write_ids) {
+            std::filesystem::path ids_path = std::filesystem::path(output).replace_extension(".ids");
+            std::vector<uint64_t> ids(static_cast<size_t>(added));
+            for (size_t i = 0; i < ids.size(); ++i) {
+                ids[i] = static_cast<uint64_t>(plan.first_row) + i;
+            }
+            std::ofstream ofs(ids_path, std::ios::binary | std::ios::trunc);
+            ofs.write(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(uint64_t));
+            if (!ofs) {
+                throw std::runtime_error(tag + "ID 매핑 기록 실패: " + ids_path.string());
+            }
+        }
+        
+        if (build_options_.reorder != HNSWReorderMethod::None) {
+            reorderIndexFile(output, build_options_.reorder, DIM, tag);
+        }
+    }
+    
+    // 저장된 샤드를 재번호 (원래 ID는 .ids 사이드카로 남겨 서버가 변환)
+    // beg_id: .ids 사이드카가 없는 샤드의 오프셋 ID 시작 (재번호 후 .ids에 beg_id + label로 기록)
+    static void reorderIndexFile(const std::string& path, HNSWReorderMethod method, int dim, const std::string& tag,
+                                 uint64_t beg_id = 0) {
+        std::cout << tag << "노드 재번호 중 (" << hnswReorderMethodName(method) << "): " << path << std::endl;
+        HNSWReorderStats stats;
+        if (!reorderHNSWFile(path, dim, method, stats, beg_id)) {
+            throw std::runtime_error(tag + "노드 재번호 실패: " + path);
+        }
+        std::cout << tag << "재번호 완료: " << stats.elapsed_ms << "ms, level0 이웃이 걸친 페이지 수 "
+                  << stats.pages_per_hop_before << " → " << stats.pages_per_hop_after << std::endl;
+    }
+    
+    // HNSW 인덱스 생성 (Arrow 파일 단위 처리)
+    void buildAndSaveIndex() {
+        std::cout << "\n=== HNSW 인덱스 빌드 시작 (Arrow 파일 단위 처리) ===" << std::endl;
+        
+        auto arrow_files = listArrowFiles();
+        std::vector<float> train_data = loadTrainData(arrow_files);
+        std::vector<ShardPlan> plans = planShards(arrow_files, 1);
+        buildShard(plans[0], train_data, index_file, false, "");
+    }
+    
+    // --num-shards: 샤드 N개를 output_dir/hnsw_index_NNN.bin으로 빌드
+    // 최대 parallel_shards개를 동시에 빌드하되, 추정 메모리 합이 memory_budget_bytes를 넘지 않게 함
+    void buildShards() {
+        std::cout << "\n=== HNSW 샤드 " << build_options_.num_shards << "개 빌드 시작 (동시 "
+                  << build_options_.parallel_shards << "개) ===" << std::endl;
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        auto arrow_files = listArrowFiles();
+        std::vector<float> train_data = loadTrainData(arrow_files);
+        std::vector<ShardPlan> plans = planShards(arrow_files, build_options_.num_shards);
+        std::filesystem::create_directories(build_options_.output_dir);
+        
+        HNSWBuildParams params;
+        params.dim = DIM;
+        size_t bytes_per_vector = HNSWBuilder::estimateBytesPerVector(params);
+        MemoryBudget budget(build_options_.memory_budget_bytes);
+        
+        std::atomic<size_t> next_shard{0};
+        std::atomic<bool> failed{false};
+        std::mutex error_mutex;
+        std::string first_error;
+        
+        auto worker = [&]() {
+            while (!failed.load()) {
+                size_t shard = next_shard.fetch_add(1);
+                if (shard >= plans.size()) {
+                    return;
+                }
+                // 인덱스와 직렬화된 BinarySet이 잠시 함께 존재하므로 2배로 잡음
+                size_t bytes = bytes_per_vector * static_cast<size_t>(plans[shard].rows) * 2;
+                budget.acquire(bytes);
+                
+                char name[32];
+                std::snprintf(name, sizeof(name), "hnsw_index_%03zu.bin", shard);
+                std::string output = (std::filesystem::path(build_options_.output_dir) / name).string();
+                std::string tag = "[shard " + std::to_string(shard) + "] ";
+                try {
+                    buildShard(plans[shard], train_data, output, true, tag);
+                } catch (const std::exception& e) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (first_error.empty()) {
+                        first_error = e.what();
+                    }
+                    failed = true;
+                }
+                budget.release(bytes);
+            }
+        };
+        
+        size_t worker_count = std::min(std::max<size_t>(1, build_options_.parallel_shards), plans.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers.emplace_back(worker);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+        if (failed) {
+            throw std::runtime_error(first_error);
+        }
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start);
+        std::cout << "샤드 " << plans.size() << "개 빌드 완료: " << duration.count() << "s ("
+                  << build_options_.output_dir << ")" << std::endl;
     }
 
 // Arrow 파일을 배치 단위로 읽고 처리하기 위한 헬퍼 함수
@@ -286,39 +663,23 @@ public:
     }
     
     // HNSW 네이티브 형식으로 인덱스 저장
-    void saveIndexWithMmapSupport(knowhere::Index<knowhere::IndexNode>& index,
-                                 const std::string& filename,
-                                 const knowhere::Json& config) {
-        std::cout << "HNSW 네이티브 형식으로 인덱스 저장 중..." << std::endl;
+    void saveIndexWithMmapSupport(HNSWBuilder& builder, const std::string& filename) {
+        std::cout << "HNSW 네이티브 형식으로 인덱스 저장 중: " << filename << std::endl;
         
         auto start = std::chrono::high_resolution_clock::now();
         
-        // 1. BinarySet으로 직렬화 (표준 방식)
-        knowhere::BinarySet binary_set;
-        auto status = index.Serialize(binary_set);
-        if (status != knowhere::Status::success) {
-            throw std::runtime_error("Failed to serialize index");
-        }
-        
-        // 2. HNSW 네이티브 바이너리 데이터 추출
-        auto hnsw_binary = binary_set.GetByName("HNSW");
-        if (!hnsw_binary) {
-            throw std::runtime_error("Failed to get HNSW binary data");
-        }
-        
-        // 3. 네이티브 HNSW 포맷으로 파일에 직접 저장 (mmap 호환)
-        std::ofstream ofs(filename, std::ios::binary);
-        if (!ofs) {
-            throw std::runtime_error("Failed to open file for writing");
+        // Serialize 후 "HNSW" 바이너리를 네이티브 포맷으로 저장 (mmap 호환)
+        // 직렬화가 끝나면 인덱스를 먼저 해제해서 그래프 + BinarySet + 기록 버퍼가 겹치지 않게 함
+        HNSWSaveOptions save_options;
+        save_options.mmap_output = build_options_.mmap_output;
+        save_options.release_index = true;
+        if (!builder.save(filename, save_options)) {
+            throw std::runtime_error("Failed to save index");
         }
         
-        ofs.write(reinterpret_cast<const char*>(hnsw_binary->data.get()), hnsw_binary->size);
-        ofs.close();
-        
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
         std::cout << "HNSW 네이티브 저장 완료: " << duration.count() << "ms" << std::endl;
-        std::cout << "네이티브 HNSW 데이터: " << hnsw_binary->size / 1024 << " KB" << std::endl;
         
         // 파일 크기 확인
         struct stat st;
@@ -524,6 +885,13 @@ public:
             
             analyzeMemoryUsage("시작");
             
+            // 샤드 빌드 모드는 빌드만 하고 종료 (로드/벤치마크는 vector_db 서버에서)
+            if (build_options_.num_shards > 0) {
+                buildShards();
+                analyzeMemoryUsage("샤드 빌드 후");
+                return;
+            }
+            
             // 1. [수정] 최적화된 함수로 쿼리 데이터만 로드
             std::vector<float> queries = loadQueryData();
 
@@ -579,11 +947,20 @@ void printUsage(const char* program_name) {
     std::cout << "  --dataset-dir <path>  PubMed BGE 데이터셋 디렉토리 경로" << std::endl;
     std::cout << "                        (기본값: /home/comsys/CXLSharedMemVM/KnowhereVectorDB/Dataset/PubMed_bge/PubMed_bge_100000)" << std::endl;
     std::cout << "  --index-file <path>   인덱스 파일 경로 (기본값: hnsw_index.bin)" << std::endl;
+    std::cout << "  --num-shards <int>    샤드 N개를 --output-dir/hnsw_index_NNN.bin으로 빌드 (로드/벤치마크 생략)" << std::endl;
+    std::cout << "  --output-dir <path>   샤드 출력 디렉토리 (기본값: .)" << std::endl;
+    std::cout << "  --parallel-shards <int> 동시에 빌드할 샤드 수 (기본값: 1)" << std::endl;
+    std::cout << "  --memory-budget-gb <float> 동시 빌드 샤드들의 추정 메모리 합 상한 (기본값: 제한 없음)" << std::endl;
+    std::cout << "  --prefetch-files <int> Add 중에 미리 디코드할 다음 Arrow 파일 수 (기본값: 1)" << std::endl;
+    std::cout << "  --no-mmap-output      인덱스를 mmap 대신 write()로 기록" << std::endl;
+    std::cout << "  --reorder <none|bfs|rcm> 저장 후 level0 그래프 순서로 노드 재번호 (--num-shards 전용, 기본값: none)" << std::endl;
+    std::cout << "  --reorder-dir <path>  기존 hnsw_index_*.bin 샤드들만 재번호하고 종료 (방식 기본값: bfs)" << std::endl;
     std::cout << "  --help, -h            이 도움말 표시" << std::endl;
     std::cout << std::endl;
     std::cout << "예시:" << std::endl;
     std::cout << "  " << program_name << " --nb 28000000" << std::endl;
     std::cout << "  " << program_name << " --dataset-dir /path/to/pubmed/dataset/ --index-file my_index.bin" << std::endl;
+    std::cout << "  " << program_name << " --nb 28000000 --num-shards 8 --parallel-shards 2 --output-dir /mnt/famfs/index" << std::endl;
     std::cout << std::endl;
     std::cout << "대용량 데이터 처리:" << std::endl;
     std::cout << "  28M 벡터의 경우: --nb 28000000" << std::endl;
@@ -604,6 +981,8 @@ int main(int argc, char* argv[]) {
 
     std::string dataset_dir = "/home/comsys/CXLSharedMemVM/KnowhereVectorDB/Dataset/PubMed_bge/PubMed_bge_100000";
     std::string index_file = "hnsw_index.bin";
+    ShardBuildOptions build_options;
+    std::string reorder_dir;
     
     // Command line argument 파싱
     for (int i = 1; i < argc; i++) {
@@ -621,11 +1000,31 @@ int main(int argc, char* argv[]) {
         } else if (arg == "--k" && i + 1 < argc) {
             k = std::atoi(argv[++i]);
         } else if (arg == "--first-file-idx" && i + 1 < argc) {
-            first_file_idx = std::atoi(argv[i]);
+            first_file_idx = std::atoi(argv[++i]);
         } else if (arg == "--dataset-dir" && i + 1 < argc) {
             dataset_dir = argv[++i];
         } else if (arg == "--index-file" && i + 1 < argc) {
             index_file = argv[++i];
+        } else if (arg == "--num-shards" && i + 1 < argc) {
+            build_options.num_shards = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            build_options.output_dir = argv[++i];
+        } else if (arg == "--parallel-shards" && i + 1 < argc) {
+            build_options.parallel_shards = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--memory-budget-gb" && i + 1 < argc) {
+            build_options.memory_budget_bytes =
+                static_cast<size_t>(std::atof(argv[++i]) * 1024.0 * 1024.0 * 1024.0);
+        } else if (arg == "--prefetch-files" && i + 1 < argc) {
+            build_options.prefetch_files = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-mmap-output") {
+            build_options.mmap_output = false;
+        } else if (arg == "--reorder" && i + 1 < argc) {
+            if (!parseHNSWReorderMethod(argv[++i], build_options.reorder)) {
+                std::cerr << "--reorder는 none|bfs|rcm 중 하나여야 합니다." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--reorder-dir" && i + 1 < argc) {
+            reorder_dir = argv[++i];
         } else {
             std::cerr << "알 수 없는 옵션: " << arg << std::endl;
             printUsage(argv[0]);
@@ -634,14 +1033,64 @@ int main(int argc, char* argv[]) {
     }
     
     // 파라미터 유효성 검사
-    if (dim <= 0 || nb <= 0 || nq <= 0 || k <= 0) {
+    if (dim <= 0 || nb <= 0 || nq <= 0 || k <= 0 || first_file_idx < 0) {
         std::cerr << "오류: 모든 수치 파라미터는 양수여야 합니다." << std::endl;
         return 1;
     }
+    if (build_options.parallel_shards == 0 || build_options.prefetch_files == 0) {
+        std::cerr << "오류: --parallel-shards, --prefetch-files는 1 이상이어야 합니다." << std::endl;
+        return 1;
+    }
+    // 단일 인덱스(--index-file)는 디렉토리 안에서 몇 번째 샤드가 될지 모르므로 오프셋 ID 시작값을 정할 수 없음
+    // (재번호하면 .ids에 샤드 로컬 label이 남아 앞 샤드의 오프셋 ID와 겹침)
+    if (build_options.reorder != HNSWReorderMethod::None && build_options.num_shards == 0 && reorder_dir.empty()) {
+        std::cerr << "오류: --reorder는 --num-shards 빌드에서만 쓸 수 있습니다. "
+                  << "--index-file로 만든 샤드는 디렉토리에 모은 뒤 --reorder-dir로 재번호하세요." << std::endl;
+        return 1;
+    }
+    
     
+    // --reorder-dir: 이미 빌드된 샤드들만 재번호하고 종료
+    if (!reorder_dir.empty()) {
+        HNSWReorderMethod method = build_options.reorder == HNSWReorderMethod::None ? HNSWReorderMethod::Bfs
+                                                                                    : build_options.reorder;
+        try {
+            std::vector<std::string> shard_files;
+            for (const auto& entry : std::filesystem::directory_iterator(reorder_dir)) {
+                std::string filename = entry.path().filename().string();
+                if (filename.starts_with("hnsw_index_") && filename.ends_with(".bin")) {
+                    shard_files.push_back(entry.path().string());
+                }
+            }
+            std::sort(shard_files.begin(), shard_files.end());
+            
+            // 서버가 .ids 없는 샤드에 부여하는 오프셋 ID 시작 (파일명 순서의 누적 벡터 수)
+            // 재번호하면 .ids가 생기므로 모든 샤드의 시작값을 재번호 전에 계산
+            std::vector<uint64_t> beg_ids;
+            uint64_t beg_id = 0;
+            for (const auto& path : shard_files) {
+                beg_ids.push_back(beg_id);
+                if (std::filesystem::exists(std::filesystem::path(path).replace_extension(".ids"))) {
+                    continue;
+                }
+                size_t element_count = 0;
+                if (!readHNSWElementCount(path, element_count)) {
+                    throw std::runtime_error("HNSW 헤더를 읽을 수 없음: " + path);
+                }
+                beg_id += element_count;
+            }
+            for (size_t i = 0; i < shard_files.size(); ++i) {
+                AdvancedHNSWMmapExample::reorderIndexFile(shard_files[i], method, dim, "", beg_ids[i]);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "실행 오류: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
     
     try {
-        AdvancedHNSWMmapExample example(dim, nb, nq, k, first_file_idx, dataset_dir, index_file);
+        AdvancedHNSWMmapExample example(dim, nb, nq, k, first_file_idx, dataset_dir, index_file, build_options);
         // Arrow 파일 단위 처리로 실행
         example.run();
         
@@ -0,0 +1,93 @@
+#include "cache_flush.h"
+#include <cstdint>
+#include <immintrin.h>
+
+namespace cacheline {
+
+namespace {
+
+using FlushFn = void (*)(const char* begin, const char* end);
+
+void flushClflush(const char* begin, const char* end) {
+    for (const char* p = begin; p < end; p += LINE_SIZE) {
+        _mm_clflush(p);
+    }
+}
+
+__attribute__((target("clflushopt")))
+void flushClflushopt(const char* begin, const char* end) {
+    for (const char* p = begin; p < end; p += LINE_SIZE) {
+        _mm_clflushopt(const_cast<char*>(p));
+    }
+}
+
+__attribute__((target("clwb")))
+void flushClwb(const char* begin, const char* end) {
+    for (const char* p = begin; p < end; p += LINE_SIZE) {
+        _mm_clwb(const_cast<char*>(p));
+    }
+}
+
+FlushFn selectWriteBack(const char** name) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("clwb")) {
+        *name = "clwb";
+        return flushClwb;
+    }
+    if (__builtin_cpu_supports("clflushopt")) {
+        *name = "clflushopt";
+        return flushClflushopt;
+    }
+    *name = "clflush";
+    return flushClflush;
+}
+
+FlushFn selectInvalidate(const char** name) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("clflushopt")) {
+        *name = "clflushopt";
+        return flushClflushopt;
+    }
+    *name = "clflush";
+    return flushClflush;
+}
+
+const char* g_write_back_name = "clflush";
+const FlushFn g_write_back = selectWriteBack(&g_write_back_name);
+const char* g_invalidate_name = "clflush";
+const FlushFn g_invalidate = selectInvalidate(&g_invalidate_name);
+
+// 주소 범위를 라인 경계로 확장
+inline const char* lineBegin(const void* addr) {
+    return reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(addr) & ~(LINE_SIZE - 1));
+}
+
+}  // namespace
+
+void writeBack(const void* addr, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    g_write_back(lineBegin(addr), static_cast<const char*>(addr) + len);
+    _mm_sfence();
+}
+
+void invalidate(const void* addr, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    // clflushopt는 뒤따르는 load와 순서가 보장되지 않으므로 mfence로 막음
+    _mm_mfence();
+    g_invalidate(lineBegin(addr), static_cast<const char*>(addr) + len);
+    _mm_mfence();
+}
+
+const char* getWriteBackName() {
+    return g_write_back_name;
+}
+
+const char* getInvalidateName() {
+    return g_invalidate_name;
+}
+
+}  // namespace cacheline
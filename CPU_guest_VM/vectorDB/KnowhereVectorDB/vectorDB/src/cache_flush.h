@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+// 비일관(non-coherent) CXL 공유 메모리용 캐시 라인 flush/invalidate
+// 다른 호스트의 캐시는 snoop되지 않으므로, writer는 쓴 라인을 메모리로 내려보내고
+// reader는 읽기 전에 자기 캐시의 (stale일 수 있는) 라인을 버려야 함
+// 런타임에 CPU 기능을 확인하여 clwb / clflushopt / clflush 중 하나를 선택
+namespace cacheline {
+
+constexpr size_t LINE_SIZE = 64;
+
+// [addr, addr + len)을 덮는 라인을 메모리에 write-back한 뒤 sfence
+// (dax_test.c persist()와 같은 순서, clwb가 있으면 라인을 캐시에 남겨 둠)
+void writeBack(const void* addr, size_t len);
+
+// [addr, addr + len)을 덮는 라인을 캐시에서 제거한 뒤 mfence
+// (이후 load는 메모리에서 다시 읽음, clwb는 라인을 남기므로 쓰지 않음)
+void invalidate(const void* addr, size_t len);
+
+// 선택된 명령 이름 ("clwb", "clflushopt", "clflush" / invalidate는 "clflushopt", "clflush")
+const char* getWriteBackName();
+const char* getInvalidateName();
+
+}  // namespace cacheline
@@ -0,0 +1,854 @@
+#include "coordinator.h"
+#include <boost/asio/connect.hpp>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+bool parseEndpoint(const std::string& spec, BackendEndpoint& endpoint) {
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= spec.size()) {
+        return false;
+    }
+    int port = std::atoi(spec.c_str() + colon + 1);
+    if (port <= 0 || port > 65535) {
+        return false;
+    }
+    endpoint.host = spec.substr(0, colon);
+    endpoint.port = port;
+    return true;
+}
+
+bool parseBackendList(const std::string& spec, std::vector<std::vector<BackendEndpoint>>& partitions) {
+    partitions.clear();
+    std::stringstream partition_stream(spec);
+    std::string partition_spec;
+    while (std::getline(partition_stream, partition_spec, ',')) {
+        std::vector<BackendEndpoint> replicas;
+        std::stringstream replica_stream(partition_spec);
+        std::string replica_spec;
+        while (std::getline(replica_stream, replica_spec, '|')) {
+            BackendEndpoint endpoint;
+            if (!parseEndpoint(replica_spec, endpoint)) {
+                return false;
+            }
+            replicas.push_back(endpoint);
+        }
+        if (replicas.empty()) {
+            return false;
+        }
+        partitions.push_back(std::move(replicas));
+    }
+    return !partitions.empty();
+}
+
+// ---------------------------------------------------------------------------
+// BackendConnection
+
+BackendConnection::BackendConnection(net::io_context& ioc, Backend* backend)
+    : backend_(backend), stream_(net::make_strand(ioc)) {
+}
+
+void BackendConnection::start(BackendCall&& call) {
+    call_ = std::move(call);
+    // 항상 post: 호출자(다른 요청의 완료 콜백 등)가 잡고 있는 잠금 안에서 done이 호출되지 않도록
+    net::post(stream_.get_executor(), [self = shared_from_this()]() {
+        if (self->connected_) {
+            return self->doWrite();
+        }
+        self->stream_.expires_after(self->backend_->config_.backend_timeout);
+        self->stream_.async_connect(self->backend_->resolved_,
+            [self](beast::error_code ec, const tcp::endpoint&) { self->onConnect(ec); });
+    });
+}
+
+void BackendConnection::onConnect(beast::error_code ec) {
+    if (ec) {
+        return finish(false, true);
+    }
+    connected_ = true;
+    stream_.socket().set_option(tcp::no_delay(true), ec);
+    doWrite();
+}
+
+void BackendConnection::doWrite() {
+    req_ = {};
+    req_.method(call_.method);
+    req_.target(call_.target);
+    req_.version(11);
+    req_.set(http::field::host, backend_->endpoint_.host);
+    req_.keep_alive(true);
+    if (call_.body) {
+        req_.set(http::field::content_type, call_.content_type);
+        req_.body() = *call_.body;
+    }
+    req_.prepare_payload();
+
+    stream_.expires_after(backend_->config_.backend_timeout);
+    http::async_write(stream_, req_, beast::bind_front_handler(&BackendConnection::onWrite, shared_from_this()));
+}
+
+void BackendConnection::onWrite(beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+    if (ec) {
+        return finish(false, false);
+    }
+    res_ = {};
+    // 1024 쿼리 × k=1000 바이너리 응답은 Beast 기본 응답 상한(8MB)을 넘음
+    parser_.emplace();
+    parser_->body_limit(HTTP_BODY_LIMIT);
+    http::async_read(stream_, buffer_, *parser_,
+                     beast::bind_front_handler(&BackendConnection::onRead, shared_from_this()));
+}
+
+void BackendConnection::onRead(beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+    if (ec) {
+        return finish(false, false);
+    }
+    res_ = parser_->release();
+    finish(true, false);
+}
+
+void BackendConnection::finish(bool ok, bool connect_failed) {
+    unsigned status = 0;
+    std::string body;
+    if (ok) {
+        status = res_.result_int();
+        body = std::move(res_.body());
+    }
+    // 중간에 끊긴 연결은 버퍼 상태를 알 수 없으므로 닫고 다음 요청에서 다시 연결
+    // (complete 이후에는 다른 요청이 이 연결을 쓸 수 있으므로 반드시 그 전에 정리)
+    if (!ok || !res_.keep_alive()) {
+        beast::error_code ignored;
+        stream_.socket().close(ignored);
+        buffer_.clear();
+        connected_ = false;
+    }
+    stream_.expires_never();
+    backend_->complete(shared_from_this(), std::move(call_), ok, connect_failed, status, std::move(body));
+}
+
+// ---------------------------------------------------------------------------
+// Backend
+
+Backend::Backend(net::io_context& ioc, const BackendEndpoint& endpoint, size_t partition,
+                 const CoordinatorConfig& config)
+    : ioc_(ioc), endpoint_(endpoint), partition_(partition), config_(config) {
+}
+
+bool Backend::resolve() {
+    beast::error_code ec;
+    tcp::resolver resolver(ioc_);
+    resolved_ = resolver.resolve(endpoint_.host, std::to_string(endpoint_.port), ec);
+    if (ec) {
+        std::cerr << "Failed to resolve backend " << endpoint_.toString() << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Backend::submit(BackendCall&& call) {
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    total_requests_.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_ptr<BackendConnection> conn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            conn = std::move(idle_.back());
+            idle_.pop_back();
+        } else if (connection_count_ < std::max<size_t>(1, config_.connections_per_backend)) {
+            conn = std::make_shared<BackendConnection>(ioc_, this);
+            ++connection_count_;
+        } else {
+            pending_.push_back(std::move(call));
+            return;
+        }
+    }
+    conn->start(std::move(call));
+}
+
+void Backend::complete(const std::shared_ptr<BackendConnection>& conn, BackendCall&& call, bool ok,
+                       bool connect_failed, unsigned status, std::string&& body) {
+    outstanding_.fetch_sub(1, std::memory_order_relaxed);
+    if (!ok) {
+        total_errors_.fetch_add(1, std::memory_order_relaxed);
+        down_until_ns_.store(steadyNowNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(
+            config_.down_backoff).count(), std::memory_order_relaxed);
+        if (connect_failed) {
+            std::cerr << "Backend " << endpoint_.toString() << " unreachable" << std::endl;
+        }
+    }
+    call.done(ok, status, std::move(body));
+
+    BackendCall next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty()) {
+            idle_.push_back(conn);
+            return;
+        }
+        next = std::move(pending_.front());
+        pending_.pop_front();
+    }
+    conn->start(std::move(next));
+}
+
+bool Backend::healthy() const {
+    return steadyNowNs() >= down_until_ns_.load(std::memory_order_relaxed);
+}
+
+json Backend::stats() const {
+    return {
+        {"endpoint", endpoint_.toString()},
+        {"partition", partition_},
+        {"healthy", healthy()},
+        {"outstanding", outstanding()},
+        {"total_requests", total_requests_.load()},
+        {"total_errors", total_errors_.load()}
+    };
+}
+
+// ---------------------------------------------------------------------------
+// LatencyWindow
+
+void LatencyWindow::record(int64_t latency_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.size() < WINDOW) {
+        samples_.push_back(latency_us);
+    } else {
+        samples_[next_] = latency_us;
+        next_ = (next_ + 1) % WINDOW;
+    }
+    if (++since_recompute_ < RECOMPUTE_EVERY) {
+        return;
+    }
+    since_recompute_ = 0;
+    std::vector<int64_t> sorted = samples_;
+    size_t rank = sorted.size() * 95 / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    p95_us_.store(sorted[rank], std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// SearchCoordinator
+
+SearchCoordinator::SearchCoordinator(const CoordinatorConfig& config)
+    : config_(config), ioc_(static_cast<int>(std::max<size_t>(1, config.io_threads))), acceptor_(ioc_) {
+}
+
+SearchCoordinator::~SearchCoordinator() {
+    stop();
+}
+
+bool SearchCoordinator::initialize() {
+    std::cout << "=== Coordinator 초기화 ===" << std::endl;
+    if (config_.partitions.empty()) {
+        std::cerr << "No backend partitions configured" << std::endl;
+        return false;
+    }
+    if (config_.io_threads == 0) {
+        config_.io_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t p = 0; p < config_.partitions.size(); ++p) {
+        std::vector<std::unique_ptr<Backend>> replicas;
+        for (const auto& endpoint : config_.partitions[p]) {
+            auto backend = std::make_unique<Backend>(ioc_, endpoint, p, config_);
+            if (!backend->resolve()) {
+                return false;
+            }
+            if (config_.writer.port != 0 && endpoint.host == config_.writer.host &&
+                endpoint.port == config_.writer.port) {
+                writer_ = backend.get();
+            }
+            replicas.push_back(std::move(backend));
+        }
+        std::cout << "  Partition " << p << "/" << config_.partitions.size() << ": ";
+        for (size_t r = 0; r < replicas.size(); ++r) {
+            std::cout << (r ? ", " : "") << replicas[r]->endpoint().toString();
+        }
+        std::cout << std::endl;
+        partitions_.push_back(std::move(replicas));
+    }
+
+    if (config_.writer.port == 0) {
+        writer_ = partitions_[0][0].get();
+    } else if (!writer_) {
+        writer_owned_ = std::make_unique<Backend>(ioc_, config_.writer, SIZE_MAX, config_);
+        if (!writer_owned_->resolve()) {
+            return false;
+        }
+        writer_ = writer_owned_.get();
+    }
+    std::cout << "  Writer: " << writer_->endpoint().toString() << std::endl;
+    std::cout << "  Hedge delay: "
+              << (config_.hedge_delay.count() > 0 ? std::to_string(config_.hedge_delay.count()) + "us"
+                                                  : std::string("adaptive (p95)"))
+              << ", backend timeout " << config_.backend_timeout.count() << "ms"
+              << (config_.allow_partial ? ", partial results allowed" : "") << std::endl;
+    return true;
+}
+
+void SearchCoordinator::start() {
+    if (running_.load()) {
+        return;
+    }
+    running_.store(true);
+
+    try {
+        tcp::endpoint endpoint{net::ip::make_address("0.0.0.0"), static_cast<unsigned short>(config_.port)};
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen(net::socket_base::max_listen_connections);
+
+        std::cout << "Coordinator 시작됨 - 포트: " << config_.port << std::endl;
+        std::cout << "API 엔드포인트:" << std::endl;
+        std::cout << "  POST /api/search       - 모든 파티션에 fan-out 후 top-k 병합" << std::endl;
+        std::cout << "  POST /api/search/bin   - 바이너리 검색 fan-out" << std::endl;
+        std::cout << "  POST /api/vectors      - writer 백엔드로 전달 (alias: /api/insert)" << std::endl;
+        std::cout << "  GET  /api/status       - 백엔드별 상태" << std::endl;
+        std::cout << "  GET  /health           - 헬스체크" << std::endl;
+
+        startAccepting();
+        probeBackends();
+
+        for (size_t i = 1; i < config_.io_threads; ++i) {
+            ioc_threads_.emplace_back([this] { ioc_.run(); });
+        }
+        ioc_.run();
+    } catch (std::exception const& e) {
+        std::cerr << "Coordinator 시작 실패: " << e.what() << std::endl;
+        running_.store(false);
+    }
+}
+
+void SearchCoordinator::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    std::cout << "Coordinator 종료 중..." << std::endl;
+    if (acceptor_.is_open()) {
+        beast::error_code ec;
+        acceptor_.close(ec);
+    }
+    ioc_.stop();
+    for (auto& t : ioc_threads_) {
+        if (t.joinable() && t.get_id() != std::this_thread::get_id()) {
+            t.join();
+        }
+    }
+    ioc_threads_.clear();
+}
+
+void SearchCoordinator::startAccepting() {
+    acceptor_.async_accept(net::make_strand(ioc_),
+                           beast::bind_front_handler(&SearchCoordinator::onAccept, this));
+}
+
+void SearchCoordinator::onAccept(beast::error_code ec, tcp::socket socket) {
+    if (ec) {
+        if (ec != net::error::operation_aborted) {
+            std::cerr << "Accept error: " << ec.message() << std::endl;
+        }
+        return;
+    }
+    std::make_shared<HttpSession>(std::move(socket),
+        [this](http::request<http::string_body>&& req, HttpSendCallback send_callback) {
+            handleRequest(std::move(req), std::move(send_callback));
+        })->run();
+    if (running_.load()) {
+        startAccepting();
+    }
+}
+
+void SearchCoordinator::probeBackends() {
+    size_t partition_count = partitions_.size();
+    // flat 티어(삽입)는 writer의 파티션에만 있음 (writer가 검색 목록에 없으면 파티션 0의 replica가 공유 reader)
+    size_t flat_partition = writer_->partition() < partition_count ? writer_->partition() : 0;
+    bool shared_flat = writer_owned_ != nullptr || partitions_[flat_partition].size() > 1;
+    std::vector<Backend*> targets;
+    for (const auto& replicas : partitions_) {
+        for (const auto& backend : replicas) {
+            targets.push_back(backend.get());
+        }
+    }
+    if (writer_owned_) {
+        targets.push_back(writer_owned_.get());
+    }
+    for (Backend* target : targets) {
+        BackendCall call;
+        call.method = http::verb::get;
+        call.target = "/api/status";
+        call.done = [this, target, partition_count, flat_partition, shared_flat](bool ok, unsigned status,
+                                                                                 std::string&& body) {
+            if (!ok || status != 200) {
+                std::cerr << "Backend " << target->endpoint().toString() << " status probe failed" << std::endl;
+                return;
+            }
+            // value()는 타입이 다르면 예외를 던지므로 이 스레드(io_context)가 죽지 않도록 먼저 확인
+            json status_json = json::parse(body, nullptr, false);
+            if (status_json.is_discarded() || !status_json.is_object() || !status_json.contains("data") ||
+                !status_json["data"].is_object()) {
+                std::cerr << "Backend " << target->endpoint().toString() << " returned an invalid status body"
+                          << std::endl;
+                return;
+            }
+            const json& data = status_json["data"];
+            auto stringField = [&data](const char* key, const std::string& fallback) {
+                return data.contains(key) && data[key].is_string() ? data[key].get<std::string>() : fallback;
+            };
+            auto countField = [&data](const char* key) {
+                return data.contains(key) && data[key].is_number_unsigned() ? data[key].get<size_t>() : size_t{0};
+            };
+            std::string filter = stringField("shard_filter", "0/1");
+            std::string sharing = stringField("flat_sharing", "local");
+            std::string expected = std::to_string(target->partition()) + "/" + std::to_string(partition_count);
+            std::cout << "Backend " << target->endpoint().toString() << ": shard filter " << filter << ", "
+                      << countField("hnsw_index_count") << " shards, flat " << sharing << std::endl;
+            if (target->partition() < partition_count && filter != expected) {
+                std::cerr << "WARNING: backend " << target->endpoint().toString() << " serves shard filter "
+                          << filter << " but is configured as partition " << expected << std::endl;
+            }
+            
+            // replica마다 flat 내용이 다르면 어느 replica가 응답하느냐(선택, hedge)에 따라 새 벡터가 보였다 안 보였다 함
+            std::string error;
+            if (target == writer_) {
+                if (shared_flat && sharing != "writer") {
+                    error = "the writer must run with --flat-sharing writer when its partition has replicas";
+                }
+            } else if (target->partition() == flat_partition) {
+                if (sharing != "reader") {
+                    error = "replicas of the writer's partition must run with --flat-sharing reader "
+                            "on the writer's flat file";
+                }
+            } else if (sharing == "reader" || countField("flat_index_count") > 0) {
+                error = "backends outside the writer's partition must have an empty, unshared flat tier";
+            }
+            if (!error.empty()) {
+                std::cerr << "Backend " << target->endpoint().toString() << ": " << error << std::endl;
+                // start()의 ioc_.run()이 돌아오면 main이 종료 (이 스레드에서 stop()을 부르면 자기 자신을 join하게 됨)
+                startup_failed_.store(true);
+                ioc_.stop();
+            }
+        };
+        target->submit(std::move(call));
+    }
+}
+
+http::response<http::string_body> SearchCoordinator::errorResponse(http::status status, unsigned version,
+                                                                   const std::string& message) const {
+    http::response<http::string_body> res{status, version};
+    res.set(http::field::content_type, "application/json");
+    res.body() = json{{"success", false}, {"error", message}, {"timestamp", std::time(nullptr)}}.dump();
+    res.prepare_payload();
+    return res;
+}
+
+void SearchCoordinator::handleRequest(http::request<http::string_body>&& req, HttpSendCallback send_callback) {
+    // 핸들러 안에서 예외가 나도 세션 스레드가 죽지 않도록 (응답 전에만 던지므로 복사본으로 400 응답)
+    HttpSendCallback error_callback = send_callback;
+    unsigned version = req.version();
+    try {
+        dispatchRequest(std::move(req), std::move(send_callback));
+    } catch (const std::exception& e) {
+        std::cerr << "Coordinator request error: " << e.what() << std::endl;
+        error_callback(errorResponse(http::status::bad_request, version, std::string("Invalid request: ") + e.what()));
+    }
+}
+
+void SearchCoordinator::dispatchRequest(http::request<http::string_body>&& req, HttpSendCallback send_callback) {
+    std::string target = std::string(req.target());
+
+    if (req.method() == http::verb::post && target == "/api/search") {
+        return handleSearchRequest(req, std::move(send_callback));
+    } else if (req.method() == http::verb::post && target == "/api/search/bin") {
+        return handleBinarySearchRequest(req, std::move(send_callback));
+    } else if (req.method() == http::verb::post && (target == "/api/vectors" || target == "/api/insert")) {
+        return handleInsertRequest(req, std::move(send_callback));
+    } else if (req.method() == http::verb::get && target == "/api/status") {
+        return send_callback(handleStatusRequest(req));
+    } else if (req.method() == http::verb::get && target == "/health") {
+        http::response<http::string_body> res{http::status::ok, req.version()};
+        res.set(http::field::content_type, "application/json");
+        res.body() = json{{"status", "healthy"}, {"timestamp", std::time(nullptr)}}.dump();
+        res.prepare_payload();
+        return send_callback(std::move(res));
+    }
+    send_callback(errorResponse(http::status::not_found, req.version(), "Endpoint not found"));
+}
+
+void SearchCoordinator::handleSearchRequest(const http::request<http::string_body>& req,
+                                            HttpSendCallback send_callback) {
+    json request_json = json::parse(req.body(), nullptr, false);
+    if (request_json.is_discarded() || !request_json.is_object()) {
+        return send_callback(errorResponse(http::status::bad_request, req.version(), "Invalid JSON"));
+    }
+    if (!request_json.contains("vector") || !request_json["vector"].is_array() ||
+        request_json["vector"].size() != config_.dim) {
+        return send_callback(errorResponse(http::status::bad_request, req.version(),
+                                           "Missing or invalid 'vector' field"));
+    }
+    if (request_json.contains("recall_target")) {
+        // 바이너리 프로토콜에는 recall_target 필드가 없음
+        return send_callback(errorResponse(http::status::bad_request, req.version(),
+                                           "recall_target is not supported by the coordinator, use ef"));
+    }
+    if ((request_json.contains("k") && !request_json["k"].is_number_integer()) ||
+        (request_json.contains("ef") && !request_json["ef"].is_number_integer())) {
+        return send_callback(errorResponse(http::status::bad_request, req.version(), "k and ef must be integers"));
+    }
+    int64_t k = request_json.value("k", int64_t{10});
+    int64_t ef = request_json.value("ef", int64_t{0});
+    if (k <= 0 || k > 1000 || ef < 0 || ef > std::numeric_limits<int32_t>::max()) {
+        return send_callback(errorResponse(http::status::bad_request, req.version(), "Invalid k or ef"));
+    }
+
+    auto body = std::make_shared<std::string>(binproto::requestSize(1, static_cast<uint32_t>(config_.dim)), '\0');
+    binproto::SearchRequestHeader header{binproto::REQUEST_MAGIC, static_cast<uint32_t>(k),
+                                         static_cast<uint32_t>(ef), 1, static_cast<uint32_t>(config_.dim), 0};
+    std::memcpy(body->data(), &header, sizeof(header));
+    float* query = reinterpret_cast<float*>(body->data() + sizeof(header));
+    const auto& vector_json = request_json["vector"];
+    for (size_t d = 0; d < config_.dim; ++d) {
+        if (!vector_json[d].is_number()) {
+            return send_callback(errorResponse(http::status::bad_request, req.version(), "Invalid vector value"));
+        }
+        query[d] = vector_json[d].get<float>();
+    }
+
+    auto fanout = std::make_shared<Fanout>();
+    fanout->k = static_cast<uint32_t>(k);
+    fanout->count = 1;
+    fanout->ef = static_cast<int>(ef);
+    fanout->request_body = std::move(body);
+    fanout->reply = Reply::Json;
+    fanout->http_version = req.version();
+    fanout->send_callback = std::move(send_callback);
+    startFanout(fanout);
+}
+
+void SearchCoordinator::handleBinarySearchRequest(const http::request<http::string_body>& req,
+                                                  HttpSendCallback send_callback) {
+    const std::string& body = req.body();
+    binproto::SearchRequestHeader header{};
+    if (body.size() >= sizeof(header)) {
+        std::memcpy(&header, body.data(), sizeof(header));
+    }
+    if (body.size() < sizeof(header) || header.magic != binproto::REQUEST_MAGIC || header.dim != config_.dim ||
+        header.count == 0 || header.count > binproto::MAX_QUERIES_PER_REQUEST || header.k == 0 ||
+        header.k > 1000 || body.size() != binproto::requestSize(header.count, header.dim)) {
+        return send_callback(errorResponse(http::status::bad_request, req.version(), "Invalid binary search request"));
+    }
+
+    auto fanout = std::make_shared<Fanout>();
+    fanout->k = header.k;
+    fanout->count = header.count;
+    fanout->ef = static_cast<int>(header.ef);
+    fanout->request_body = std::make_shared<const std::string>(body);
+    fanout->reply = Reply::Binary;
+    fanout->http_version = req.version();
+    fanout->send_callback = std::move(send_callback);
+    startFanout(fanout);
+}
+
+void SearchCoordinator::handleInsertRequest(const http::request<http::string_body>& req,
+                                            HttpSendCallback send_callback) {
+    BackendCall call;
+    call.method = http::verb::post;
+    call.target = std::string(req.target());
+    call.content_type = "application/json";
+    call.body = std::make_shared<const std::string>(req.body());
+    unsigned version = req.version();
+    call.done = [this, version, send_callback = std::move(send_callback)](bool ok, unsigned status,
+                                                                           std::string&& body) mutable {
+        http::response<http::string_body> res;
+        if (ok) {
+            res = http::response<http::string_body>{static_cast<http::status>(status), version};
+            res.set(http::field::content_type, "application/json");
+            res.body() = std::move(body);
+            res.prepare_payload();
+        } else {
+            res = errorResponse(http::status::bad_gateway, version, "Writer backend unavailable");
+        }
+        net::post(ioc_, [send_callback = std::move(send_callback), res = std::move(res)]() mutable {
+            send_callback(std::move(res));
+        });
+    };
+    writer_->submit(std::move(call));
+}
+
+std::chrono::microseconds SearchCoordinator::hedgeDelay() const {
+    if (config_.hedge_delay.count() > 0) {
+        return config_.hedge_delay;
+    }
+    // 샘플이 모이기 전에는 백엔드 timeout의 1/10
+    int64_t p95 = partition_latency_.p95();
+    if (p95 == 0) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(config_.backend_timeout) / 10;
+    }
+    return std::max(config_.min_hedge_delay, std::chrono::microseconds(p95));
+}
+
+void SearchCoordinator::startFanout(const std::shared_ptr<Fanout>& fanout) {
+    total_requests_.fetch_add(1, std::memory_order_relaxed);
+    total_queries_.fetch_add(fanout->count, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(fanout->mutex);
+    fanout->start = std::chrono::steady_clock::now();
+    fanout->entries.resize(fanout->count);
+    fanout->partitions.resize(partitions_.size());
+    fanout->remaining = partitions_.size();
+    for (size_t p = 0; p < partitions_.size(); ++p) {
+        auto& partition = fanout->partitions[p];
+        partition.tried.assign(partitions_[p].size(), false);
+        partition.start = fanout->start;
+        sendToReplica(fanout, p);
+        if (partitions_[p].size() > 1) {
+            armHedgeTimer(fanout, p);
+        }
+    }
+}
+
+bool SearchCoordinator::sendToReplica(const std::shared_ptr<Fanout>& fanout, size_t p) {
+    auto& partition = fanout->partitions[p];
+    const auto& replicas = partitions_[p];
+
+    // 아직 보내지 않은 replica 중 healthy하고 가장 한가한 곳, 모두 unhealthy면 가장 먼저 복구될 곳
+    Backend* best = nullptr;
+    size_t best_index = 0;
+    for (size_t r = 0; r < replicas.size(); ++r) {
+        if (partition.tried[r]) {
+            continue;
+        }
+        Backend* candidate = replicas[r].get();
+        if (!best) {
+            best = candidate;
+            best_index = r;
+            continue;
+        }
+        bool candidate_healthy = candidate->healthy();
+        bool best_healthy = best->healthy();
+        if (candidate_healthy != best_healthy) {
+            if (candidate_healthy) {
+                best = candidate;
+                best_index = r;
+            }
+        } else if (candidate_healthy ? candidate->outstanding() < best->outstanding()
+                                     : candidate->downUntil() < best->downUntil()) {
+            best = candidate;
+            best_index = r;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+
+    partition.tried[best_index] = true;
+    size_t attempt = partition.attempts++;
+    ++partition.in_flight;
+
+    BackendCall call;
+    call.method = http::verb::post;
+    call.target = "/api/search/bin";
+    call.content_type = "application/octet-stream";
+    call.body = fanout->request_body;
+    call.done = [this, fanout, p, attempt](bool ok, unsigned status, std::string&& body) {
+        onPartitionResponse(fanout, p, attempt, ok, status, body);
+    };
+    best->submit(std::move(call));
+    return true;
+}
+
+void SearchCoordinator::armHedgeTimer(const std::shared_ptr<Fanout>& fanout, size_t p) {
+    auto& partition = fanout->partitions[p];
+    partition.hedge_timer = std::make_unique<net::steady_timer>(ioc_, hedgeDelay());
+    partition.hedge_timer->async_wait([this, fanout, p](beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(fanout->mutex);
+        auto& partition = fanout->partitions[p];
+        if (!partition.done && sendToReplica(fanout, p)) {
+            partition.hedge_attempt = partition.attempts - 1;
+            total_hedges_.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+}
+
+void SearchCoordinator::onPartitionResponse(const std::shared_ptr<Fanout>& fanout, size_t p, size_t attempt,
+                                            bool ok, unsigned status, const std::string& body) {
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(fanout->mutex);
+        auto& partition = fanout->partitions[p];
+        --partition.in_flight;
+        if (partition.done) {
+            return;  // hedge에서 진 응답
+        }
+
+        binproto::SearchResponseHeader header{};
+        bool valid = ok && status == 200 && body.size() >= sizeof(header);
+        if (valid) {
+            std::memcpy(&header, body.data(), sizeof(header));
+            valid = header.magic == binproto::RESPONSE_MAGIC && header.status == binproto::STATUS_OK &&
+                    header.count == fanout->count && header.k == fanout->k &&
+                    body.size() == binproto::responseSize(header.count, header.k);
+        }
+
+        if (valid) {
+            const char* src = body.data() + sizeof(header);
+            for (uint32_t q = 0; q < fanout->count; ++q) {
+                auto& entries = fanout->entries[q];
+                for (uint32_t j = 0; j < fanout->k; ++j) {
+                    binproto::ResultEntry entry;
+                    std::memcpy(&entry, src + (static_cast<size_t>(q) * fanout->k + j) * sizeof(entry),
+                                sizeof(entry));
+                    if (entry.id != binproto::INVALID_ID) {
+                        entries.push_back(entry);
+                    }
+                }
+            }
+            partition.done = true;
+            --fanout->remaining;
+            if (attempt == partition.hedge_attempt) {
+                total_hedge_wins_.fetch_add(1, std::memory_order_relaxed);
+            }
+            partition_latency_.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - partition.start).count());
+        } else if (sendToReplica(fanout, p)) {
+            total_retries_.fetch_add(1, std::memory_order_relaxed);
+        } else if (partition.in_flight == 0) {
+            partition.done = true;
+            --fanout->remaining;
+            ++fanout->failed_partitions;
+        }
+
+        if (partition.done && partition.hedge_timer) {
+            partition.hedge_timer->cancel();
+        }
+        finished = fanout->remaining == 0;
+    }
+    if (finished) {
+        finishFanout(fanout);
+    }
+}
+
+void SearchCoordinator::finishFanout(const std::shared_ptr<Fanout>& fanout) {
+    auto search_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - fanout->start);
+    bool partial = fanout->failed_partitions > 0;
+    http::response<http::string_body> res;
+
+    if (partial && (!config_.allow_partial || fanout->failed_partitions == partitions_.size())) {
+        total_failed_.fetch_add(1, std::memory_order_relaxed);
+        if (fanout->reply == Reply::Binary) {
+            res = http::response<http::string_body>{http::status::bad_gateway, fanout->http_version};
+            res.set(http::field::content_type, "application/octet-stream");
+            binproto::SearchResponseHeader error_header{binproto::RESPONSE_MAGIC, binproto::STATUS_ERROR, 0, 0};
+            res.body().assign(reinterpret_cast<const char*>(&error_header), sizeof(error_header));
+            res.prepare_payload();
+        } else {
+            res = errorResponse(http::status::bad_gateway, fanout->http_version, "Backend partition unavailable");
+        }
+    } else {
+        if (partial) {
+            total_partial_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // 쿼리별로 모든 파티션 후보를 거리순 병합
+        for (auto& entries : fanout->entries) {
+            size_t keep = std::min<size_t>(fanout->k, entries.size());
+            std::partial_sort(entries.begin(), entries.begin() + keep, entries.end(),
+                              [](const binproto::ResultEntry& a, const binproto::ResultEntry& b) {
+                                  return a.distance < b.distance;
+                              });
+            entries.resize(keep);
+        }
+
+        res = http::response<http::string_body>{http::status::ok, fanout->http_version};
+        if (fanout->reply == Reply::Binary) {
+            res.set(http::field::content_type, "application/octet-stream");
+            res.body().resize(binproto::responseSize(fanout->count, fanout->k));
+            binproto::SearchResponseHeader header{binproto::RESPONSE_MAGIC,
+                                                  partial ? binproto::STATUS_PARTIAL : binproto::STATUS_OK,
+                                                  fanout->count, fanout->k};
+            std::memcpy(res.body().data(), &header, sizeof(header));
+            char* dst = res.body().data() + sizeof(header);
+            for (uint32_t q = 0; q < fanout->count; ++q) {
+                for (uint32_t j = 0; j < fanout->k; ++j) {
+                    binproto::ResultEntry entry{binproto::INVALID_ID, 0.0f};
+                    if (j < fanout->entries[q].size()) {
+                        entry = fanout->entries[q][j];
+                    }
+                    std::memcpy(dst + (static_cast<size_t>(q) * fanout->k + j) * sizeof(entry), &entry,
+                                sizeof(entry));
+                }
+            }
+        } else {
+            json results_array = json::array();
+            for (const auto& entry : fanout->entries[0]) {
+                results_array.push_back({{"id", entry.id}, {"distance", entry.distance}});
+            }
+            json data = {
+                {"results", results_array},
+                {"search_time_us", search_time.count()},
+                {"total_results", fanout->entries[0].size()},
+                {"ef", fanout->ef},
+                {"partitions", partitions_.size()},
+                {"partial", partial}
+            };
+            res.set(http::field::content_type, "application/json");
+            res.body() = json{{"success", true}, {"timestamp", std::time(nullptr)}, {"data", data}}.dump();
+        }
+        res.prepare_payload();
+    }
+
+    net::post(ioc_, [send_callback = std::move(fanout->send_callback), res = std::move(res)]() mutable {
+        send_callback(std::move(res));
+    });
+}
+
+http::response<http::string_body> SearchCoordinator::handleStatusRequest(const http::request<http::string_body>& req) {
+    json partitions = json::array();
+    for (const auto& replicas : partitions_) {
+        json replica_stats = json::array();
+        for (const auto& backend : replicas) {
+            replica_stats.push_back(backend->stats());
+        }
+        partitions.push_back(replica_stats);
+    }
+    json data = {
+        {"mode", "coordinator"},
+        {"port", config_.port},
+        {"partitions", partitions},
+        {"writer", writer_->stats()},
+        {"hedge_delay_us", hedgeDelay().count()},
+        {"partition_latency_p95_us", partition_latency_.p95()},
+        {"total_requests", total_requests_.load()},
+        {"total_queries", total_queries_.load()},
+        {"total_failed", total_failed_.load()},
+        {"total_partial", total_partial_.load()},
+        {"total_hedges", total_hedges_.load()},
+        {"total_hedge_wins", total_hedge_wins_.load()},
+        {"total_retries", total_retries_.load()}
+    };
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::content_type, "application/json");
+    res.body() = json{{"success", true}, {"timestamp", std::time(nullptr)}, {"data", data}}.dump();
+    res.prepare_payload();
+    return res;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "binary_protocol.h"
+#include "http_session.h"
+#include <boost/asio/steady_timer.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Scatter-gather coordinator
+//
+// 샤드 부분집합(파티션)마다 vector_db 백엔드(--shard-filter p/P로 시작)가 하나 이상 있고,
+// 검색 쿼리를 모든 파티션에 바이너리 프로토콜로 보낸 뒤 top-k를 병합해서 응답함
+// - 백엔드 연결은 keep-alive로 유지하고 재사용 (백엔드당 최대 connections_per_backend개)
+// - 같은 파티션의 replica가 여럿이면 hedge_delay 안에 응답이 없을 때 다른 replica로 한 번 더 보냄
+//   (먼저 온 응답을 쓰고 나머지는 버림), 실패하면 바로 다른 replica로 재시도
+// - 삽입은 writer 백엔드 하나로 그대로 전달 (flat 티어는 writer의 파티션에만 있음, 같은 파티션의
+//   다른 replica는 --flat-sharing reader로 writer의 flat 파일을 공유해야 함)
+
+using json = nlohmann::json;
+
+struct BackendEndpoint {
+    std::string host;
+    int port = 0;
+    std::string toString() const { return host + ":" + std::to_string(port); }
+};
+
+struct CoordinatorConfig {
+    int port = 8090;
+    std::vector<std::vector<BackendEndpoint>> partitions;  // 파티션별 replica 목록
+    BackendEndpoint writer;                                 // 삽입 전달 대상 (port 0이면 첫 파티션의 첫 replica)
+    size_t io_threads = 0;                                  // 0이면 하드웨어 스레드 수
+    size_t dim = 768;
+    size_t connections_per_backend = 16;
+    std::chrono::microseconds hedge_delay{0};               // 0이면 최근 파티션 응답 latency의 p95로 적응
+    std::chrono::microseconds min_hedge_delay{1000};
+    std::chrono::milliseconds backend_timeout{2000};        // 연결/요청/응답 각각의 제한 시간
+    std::chrono::milliseconds down_backoff{1000};           // 실패한 백엔드를 replica 선택에서 뒤로 미루는 시간
+    bool allow_partial = false;                             // 파티션 하나가 실패해도 나머지 결과로 응답
+};
+
+// "h:p|h:p,h:p" → 파티션은 ',' 로, 같은 파티션의 replica는 '|' 로 구분
+bool parseBackendList(const std::string& spec, std::vector<std::vector<BackendEndpoint>>& partitions);
+bool parseEndpoint(const std::string& spec, BackendEndpoint& endpoint);
+
+// 백엔드 요청 하나 (done은 성공/실패와 관계없이 정확히 한 번 호출)
+struct BackendCall {
+    http::verb method = http::verb::post;
+    std::string target;
+    std::string content_type;
+    std::shared_ptr<const std::string> body;
+    std::function<void(bool ok, unsigned status, std::string&& body)> done;
+};
+
+class Backend;
+
+// 백엔드와의 keep-alive 연결 하나 (한 번에 요청 하나, 끊어지면 다음 요청에서 다시 연결)
+class BackendConnection : public std::enable_shared_from_this<BackendConnection> {
+private:
+    Backend* backend_;
+    beast::tcp_stream stream_;
+    beast::flat_buffer buffer_;
+    http::request<http::string_body> req_;
+    std::optional<http::response_parser<http::string_body>> parser_;  // 응답마다 새로 만들어 body 상한 설정
+    http::response<http::string_body> res_;
+    BackendCall call_;
+    bool connected_ = false;
+
+public:
+    BackendConnection(net::io_context& ioc, Backend* backend);
+    void start(BackendCall&& call);
+
+private:
+    void onConnect(beast::error_code ec);
+    void doWrite();
+    void onWrite(beast::error_code ec, std::size_t bytes_transferred);
+    void onRead(beast::error_code ec, std::size_t bytes_transferred);
+    void finish(bool ok, bool connect_failed);
+};
+
+// 백엔드 인스턴스 하나의 연결 풀과 상태
+class Backend {
+private:
+    net::io_context& ioc_;
+    BackendEndpoint endpoint_;
+    size_t partition_;
+    const CoordinatorConfig& config_;
+    tcp::resolver::results_type resolved_;
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<BackendConnection>> idle_;
+    std::deque<BackendCall> pending_;   // 연결이 모두 사용 중일 때 대기
+    size_t connection_count_ = 0;
+
+    std::atomic<int64_t> down_until_ns_{0};   // steady_clock 기준, 이 시각 전에는 unhealthy
+    std::atomic<size_t> outstanding_{0};
+    std::atomic<uint64_t> total_requests_{0};
+    std::atomic<uint64_t> total_errors_{0};
+
+    friend class BackendConnection;
+
+public:
+    Backend(net::io_context& ioc, const BackendEndpoint& endpoint, size_t partition, const CoordinatorConfig& config);
+
+    bool resolve();
+    void submit(BackendCall&& call);
+
+    bool healthy() const;
+    int64_t downUntil() const { return down_until_ns_.load(std::memory_order_relaxed); }
+    size_t outstanding() const { return outstanding_.load(std::memory_order_relaxed); }
+    size_t partition() const { return partition_; }
+    const BackendEndpoint& endpoint() const { return endpoint_; }
+    json stats() const;
+
+private:
+    // 연결이 요청 하나를 끝냄 (done 호출 후 연결을 다음 대기 요청에 넘기거나 idle로 반납)
+    void complete(const std::shared_ptr<BackendConnection>& conn, BackendCall&& call, bool ok,
+                  bool connect_failed, unsigned status, std::string&& body);
+};
+
+// 최근 파티션 응답 latency의 p95 (적응형 hedge delay)
+class LatencyWindow {
+private:
+    static constexpr size_t WINDOW = 1024;
+    static constexpr size_t RECOMPUTE_EVERY = 128;
+    std::mutex mutex_;
+    std::vector<int64_t> samples_;
+    size_t next_ = 0;
+    size_t since_recompute_ = 0;
+    std::atomic<int64_t> p95_us_{0};   // 샘플이 RECOMPUTE_EVERY개 모이기 전에는 0
+
+public:
+    void record(int64_t latency_us);
+    int64_t p95() const { return p95_us_.load(std::memory_order_relaxed); }
+};
+
+class SearchCoordinator {
+private:
+    // 검색 요청 하나의 fan-out 상태 (모든 파티션 응답이 끝나면 병합 후 응답)
+    struct PartitionState {
+        bool done = false;
+        std::vector<bool> tried;        // replica별 전송 여부
+        size_t in_flight = 0;
+        size_t attempts = 0;            // 0번째가 primary, 이후는 hedge/재시도
+        size_t hedge_attempt = SIZE_MAX;  // hedge timer가 보낸 attempt (hedge 성공 집계용)
+        std::unique_ptr<net::steady_timer> hedge_timer;
+        std::chrono::steady_clock::time_point start;
+    };
+    enum class Reply : uint8_t { Json, Binary };
+    struct Fanout {
+        std::mutex mutex;
+        uint32_t k = 0;
+        uint32_t count = 0;
+        int ef = 0;
+        std::shared_ptr<const std::string> request_body;  // 바이너리 요청 (모든 백엔드가 공유)
+        std::vector<PartitionState> partitions;
+        std::vector<std::vector<binproto::ResultEntry>> entries;  // 쿼리별 후보 (파티션 결과를 모음)
+        size_t remaining = 0;
+        size_t failed_partitions = 0;
+        Reply reply = Reply::Json;
+        unsigned http_version = 11;
+        HttpSendCallback send_callback;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    CoordinatorConfig config_;
+    net::io_context ioc_;
+    tcp::acceptor acceptor_;
+    std::vector<std::thread> ioc_threads_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> startup_failed_{false};   // 시작 시 백엔드 구성 확인에서 거절됨
+
+    std::vector<std::vector<std::unique_ptr<Backend>>> partitions_;
+    Backend* writer_ = nullptr;
+    std::unique_ptr<Backend> writer_owned_;   // writer가 검색 백엔드 목록에 없을 때
+    LatencyWindow partition_latency_;
+
+    std::atomic<uint64_t> total_requests_{0};
+    std::atomic<uint64_t> total_queries_{0};
+    std::atomic<uint64_t> total_failed_{0};
+    std::atomic<uint64_t> total_partial_{0};
+    std::atomic<uint64_t> total_hedges_{0};
+    std::atomic<uint64_t> total_hedge_wins_{0};
+    std::atomic<uint64_t> total_retries_{0};
+
+public:
+    explicit SearchCoordinator(const CoordinatorConfig& config);
+    ~SearchCoordinator();
+
+    bool initialize();
+    void start();
+    void stop();
+    bool startupFailed() const { return startup_failed_.load(); }
+
+    void handleRequest(http::request<http::string_body>&& req, HttpSendCallback send_callback);
+
+private:
+    // handleRequest가 예외를 잡고 부르는 실제 라우팅
+    void dispatchRequest(http::request<http::string_body>&& req, HttpSendCallback send_callback);
+    void startAccepting();
+    void onAccept(beast::error_code ec, tcp::socket socket);
+    // 시작 시 각 백엔드의 /api/status로 샤드 필터가 파티션 배치와 맞는지 확인 (불일치는 로그만)
+    // flat 티어 구성이 replica마다 다른 결과를 낼 수 있으면 coordinator를 종료 (startupFailed)
+    void probeBackends();
+
+    void handleSearchRequest(const http::request<http::string_body>& req, HttpSendCallback send_callback);
+    void handleBinarySearchRequest(const http::request<http::string_body>& req, HttpSendCallback send_callback);
+    void handleInsertRequest(const http::request<http::string_body>& req, HttpSendCallback send_callback);
+    http::response<http::string_body> handleStatusRequest(const http::request<http::string_body>& req);
+
+    void startFanout(const std::shared_ptr<Fanout>& fanout);
+    // 파티션의 아직 보내지 않은 replica 중 가장 한가한 곳으로 전송 (보낼 곳이 없으면 false, fanout 잠금 상태에서 호출)
+    bool sendToReplica(const std::shared_ptr<Fanout>& fanout, size_t partition);
+    void armHedgeTimer(const std::shared_ptr<Fanout>& fanout, size_t partition);
+    void onPartitionResponse(const std::shared_ptr<Fanout>& fanout, size_t partition, size_t attempt,
+                             bool ok, unsigned status, const std::string& body);
+    void finishFanout(const std::shared_ptr<Fanout>& fanout);
+    std::chrono::microseconds hedgeDelay() const;
+
+    http::response<http::string_body> errorResponse(http::status status, unsigned version,
+                                                    const std::string& message) const;
+};
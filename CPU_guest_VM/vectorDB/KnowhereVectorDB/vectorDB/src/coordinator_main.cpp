@@ -0,0 +1,101 @@
+#include "coordinator.h"
+#include <iostream>
+#include <csignal>
+#include <memory>
+#include <algorithm>
+
+std::unique_ptr<SearchCoordinator> g_coordinator;
+
+void signalHandler(int signal) {
+    std::cout << "\n시그널 수신: " << signal << std::endl;
+    if (g_coordinator) {
+        g_coordinator->stop();
+    }
+    exit(0);
+}
+
+void printUsage(const char* program) {
+    std::cout << "사용법: " << program << " --backends <spec> [옵션들]" << std::endl;
+    std::cout << "  --backends <spec>          파티션은 ',', 같은 파티션의 replica는 '|'로 구분" << std::endl;
+    std::cout << "                             (예: vm1:8081|vm2:8081,vm1:8082|vm2:8082)" << std::endl;
+    std::cout << "                             파티션 p의 백엔드는 --shard-filter p/<파티션 수>로 시작" << std::endl;
+    std::cout << "  --port <n>                 (기본값: 8090)" << std::endl;
+    std::cout << "  --writer <host:port>       삽입 전달 대상 (기본값: 첫 파티션의 첫 replica)" << std::endl;
+    std::cout << "  --dim <n>                  (기본값: 768)" << std::endl;
+    std::cout << "  --io-threads <n>           (기본값: 하드웨어 스레드 수)" << std::endl;
+    std::cout << "  --connections <n>          백엔드당 keep-alive 연결 수 (기본값: 16)" << std::endl;
+    std::cout << "  --hedge-us <n>             hedge 요청 지연 (기본값: 0 = 최근 p95)" << std::endl;
+    std::cout << "  --min-hedge-us <n>         적응형 hedge 지연 하한 (기본값: 1000)" << std::endl;
+    std::cout << "  --backend-timeout-ms <n>   (기본값: 2000)" << std::endl;
+    std::cout << "  --allow-partial            파티션 하나가 실패해도 나머지 결과로 응답" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    
+    std::cout << "=== VectorDB Coordinator 시작 ===" << std::endl;
+    
+    CoordinatorConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--backends" && i + 1 < argc) {
+            if (!parseBackendList(argv[++i], config.partitions)) {
+                std::cerr << "잘못된 백엔드 목록: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--writer" && i + 1 < argc) {
+            if (!parseEndpoint(argv[++i], config.writer)) {
+                std::cerr << "잘못된 writer 주소: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--port" && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "--dim" && i + 1 < argc) {
+            config.dim = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            config.io_threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--connections" && i + 1 < argc) {
+            config.connections_per_backend = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--hedge-us" && i + 1 < argc) {
+            config.hedge_delay = std::chrono::microseconds(std::atoll(argv[++i]));
+        } else if (arg == "--min-hedge-us" && i + 1 < argc) {
+            config.min_hedge_delay = std::chrono::microseconds(std::atoll(argv[++i]));
+        } else if (arg == "--backend-timeout-ms" && i + 1 < argc) {
+            config.backend_timeout = std::chrono::milliseconds(std::max(1LL, std::atoll(argv[++i])));
+        } else if (arg == "--allow-partial") {
+            config.allow_partial = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "알 수 없는 옵션: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (config.partitions.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    try {
+        g_coordinator = std::make_unique<SearchCoordinator>(config);
+        if (!g_coordinator->initialize()) {
+            std::cerr << "Coordinator 초기화 실패" << std::endl;
+            return 1;
+        }
+        g_coordinator->start();
+        if (g_coordinator->startupFailed()) {
+            std::cerr << "백엔드 구성이 coordinator 토폴로지와 맞지 않음" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "오류: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
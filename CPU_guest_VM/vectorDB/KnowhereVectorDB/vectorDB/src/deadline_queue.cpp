@@ -0,0 +1,26 @@
+#include "deadline_queue.h"
+#include <algorithm>
+
+void DeadlineQueue::reserve(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_.reserve(capacity);
+}
+
+void DeadlineQueue::push(uint32_t slot, Clock::time_point key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_.push_back(Entry{key, next_seq_++, slot});
+    std::push_heap(heap_.begin(), heap_.end(), later);
+    size_.store(heap_.size(), std::memory_order_relaxed);
+}
+
+bool DeadlineQueue::tryPop(uint32_t& slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heap_.empty()) {
+        return false;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    slot = heap_.back().slot;
+    heap_.pop_back();
+    size_.store(heap_.size(), std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 검색 슬롯 번호의 earliest-deadline-first 큐
+// - 정렬 키가 가장 이른 슬롯부터 꺼냄 (키가 같으면 먼저 넣은 순서)
+// - 과부하 시 FIFO는 이미 늦은 요청을 먼저 처리하느라 모두가 늦지만, EDF는 아직 제시간에 끝낼 수 있는 요청을 먼저 처리
+// - push/pop은 짧은 critical section 하나 (워커 수만큼의 경쟁이면 lock-free 큐와 latency 차이가 작음)
+class DeadlineQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 슬롯 수만큼 미리 확보 (큐 항목은 항상 슬롯 수 이하)
+    void reserve(size_t capacity);
+
+    void push(uint32_t slot, Clock::time_point key);
+    // 비어 있으면 false
+    bool tryPop(uint32_t& slot);
+
+    size_t size_approx() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        Clock::time_point key;
+        uint64_t seq;
+        uint32_t slot;
+    };
+    // std::push_heap은 max-heap이므로 "나중" 비교자로 min-heap을 만듦
+    static bool later(const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key > b.key : a.seq > b.seq;
+    }
+
+    std::mutex mutex_;
+    std::vector<Entry> heap_;
+    uint64_t next_seq_ = 0;
+    std::atomic<size_t> size_{0};
+};
@@ -0,0 +1,344 @@
+#include "distance_kernels.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <immintrin.h>
+
+namespace distance {
+
+namespace {
+
+using DotFn = float (*)(const float*, const float*, size_t);
+
+float dotScalar(const float* a, const float* b, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float dotAvx2(const float* a, const float* b, size_t dim) {
+    // 4개의 독립 누산기로 FMA latency를 숨김
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),      _mm256_loadu_ps(b + i),      acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),  _mm256_loadu_ps(b + i + 8),  acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= dim; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+
+    __m256 acc = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+    __m128 lo = _mm256_castps256_ps128(acc);
+    __m128 hi = _mm256_extractf128_ps(acc, 1);
+    __m128 sum4 = _mm_add_ps(lo, hi);
+    sum4 = _mm_hadd_ps(sum4, sum4);
+    sum4 = _mm_hadd_ps(sum4, sum4);
+    float sum = _mm_cvtss_f32(sum4);
+
+    for (; i < dim; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+float dotAvx512(const float* a, const float* b, size_t dim) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 64 <= dim; i += 64) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i),      _mm512_loadu_ps(b + i),      acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+        acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), acc2);
+        acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), acc3);
+    }
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (i < dim) {
+        // 남은 원소는 마스크 로드로 처리
+        __mmask16 mask = static_cast<__mmask16>((1u << (dim - i)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                               _mm512_maskz_loadu_ps(mask, b + i), acc1);
+    }
+
+    __m512 acc = _mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3));
+    return _mm512_reduce_add_ps(acc);
+}
+
+using DotFp16Fn = float (*)(const float*, const uint16_t*, size_t);
+using DotSq8Fn = float (*)(const float*, const uint8_t*, size_t);
+
+// F16C가 없는 CPU용 half → float 변환
+float halfToFloat(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // subnormal → 정규화
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// float → half (round-to-nearest-even, 범위 밖은 inf)
+uint16_t floatToHalf(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 0x1F) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+            ++half_mantissa;
+        }
+        return static_cast<uint16_t>(sign | half_mantissa);
+    }
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        ++half;  // 올림이 지수로 넘어가도 비트 표현상 맞음
+    }
+    return static_cast<uint16_t>(half);
+}
+
+float dotFp16Scalar(const float* q, const uint16_t* codes, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += q[i] * halfToFloat(codes[i]);
+    }
+    return sum;
+}
+
+float dotSq8Scalar(const float* q, const uint8_t* codes, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += q[i] * static_cast<float>(codes[i]);
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float horizontalSum256(__m256 acc) {
+    __m128 lo = _mm256_castps256_ps128(acc);
+    __m128 hi = _mm256_extractf128_ps(acc, 1);
+    __m128 sum4 = _mm_add_ps(lo, hi);
+    sum4 = _mm_hadd_ps(sum4, sum4);
+    sum4 = _mm_hadd_ps(sum4, sum4);
+    return _mm_cvtss_f32(sum4);
+}
+
+__attribute__((target("avx2,fma,f16c")))
+float dotFp16Avx2(const float* q, const uint16_t* codes, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        __m256 c0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i)));
+        __m256 c1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i + 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i), c0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i + 8), c1, acc1);
+    }
+    float sum = horizontalSum256(_mm256_add_ps(acc0, acc1));
+    for (; i < dim; ++i) {
+        sum += q[i] * halfToFloat(codes[i]);
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float dotSq8Avx2(const float* q, const uint8_t* codes, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+        __m256 c0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        __m256 c1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i), c0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i + 8), c1, acc1);
+    }
+    float sum = horizontalSum256(_mm256_add_ps(acc0, acc1));
+    for (; i < dim; ++i) {
+        sum += q[i] * static_cast<float>(codes[i]);
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+float dotFp16Avx512(const float* q, const uint16_t* codes, size_t dim) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        __m512 c0 = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + i)));
+        __m512 c1 = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + i + 16)));
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i), c0, acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i + 16), c1, acc1);
+    }
+    float sum = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    for (; i < dim; ++i) {
+        sum += q[i] * halfToFloat(codes[i]);
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+float dotSq8Avx512(const float* q, const uint8_t* codes, size_t dim) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        __m512 c0 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i))));
+        __m512 c1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i + 16))));
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i), c0, acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i + 16), c1, acc1);
+    }
+    float sum = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    for (; i < dim; ++i) {
+        sum += q[i] * static_cast<float>(codes[i]);
+    }
+    return sum;
+}
+
+DotFn selectDotKernel(const char** name) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "avx512";
+        return dotAvx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *name = "avx2";
+        return dotAvx2;
+    }
+    *name = "scalar";
+    return dotScalar;
+}
+
+const char* g_kernel_name = "scalar";
+const DotFn g_dot_kernel = selectDotKernel(&g_kernel_name);
+
+DotFp16Fn selectFp16Kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return dotFp16Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+        return dotFp16Avx2;
+    }
+    return dotFp16Scalar;
+}
+
+DotSq8Fn selectSq8Kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return dotSq8Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return dotSq8Avx2;
+    }
+    return dotSq8Scalar;
+}
+
+const DotFp16Fn g_fp16_kernel = selectFp16Kernel();
+const DotSq8Fn g_sq8_kernel = selectSq8Kernel();
+
+}  // namespace
+
+float dotProduct(const float* a, const float* b, size_t dim) {
+    return g_dot_kernel(a, b, dim);
+}
+
+float normSquared(const float* a, size_t dim) {
+    return g_dot_kernel(a, a, dim);
+}
+
+float normalizeInPlace(float* a, size_t dim) {
+    float norm = std::sqrt(normSquared(a, dim));
+    if (norm > 0.0f) {
+        float inv = 1.0f / norm;
+        for (size_t i = 0; i < dim; ++i) {
+            a[i] *= inv;
+        }
+    }
+    return norm;
+}
+
+const char* getKernelName() {
+    return g_kernel_name;
+}
+
+float dotFp16(const float* query, const uint16_t* codes, size_t dim) {
+    return g_fp16_kernel(query, codes, dim);
+}
+
+float dotSq8(const float* query, const uint8_t* codes, size_t dim) {
+    return g_sq8_kernel(query, codes, dim);
+}
+
+void encodeFp16(const float* a, uint16_t* codes, size_t dim) {
+    for (size_t i = 0; i < dim; ++i) {
+        codes[i] = floatToHalf(a[i]);
+    }
+}
+
+void encodeSq8(const float* a, uint8_t* codes, size_t dim, float& scale, float& bias) {
+    auto [min_it, max_it] = std::minmax_element(a, a + dim);
+    float lo = dim ? *min_it : 0.0f;
+    float hi = dim ? *max_it : 0.0f;
+    bias = lo;
+    scale = hi > lo ? (hi - lo) / 255.0f : 1.0f;
+    float inv = 1.0f / scale;
+    for (size_t i = 0; i < dim; ++i) {
+        float level = std::nearbyint((a[i] - lo) * inv);
+        codes[i] = static_cast<uint8_t>(std::clamp(level, 0.0f, 255.0f));
+    }
+}
+
+}  // namespace distance
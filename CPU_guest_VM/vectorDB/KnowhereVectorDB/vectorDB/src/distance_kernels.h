@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Flat 인덱스 스캔용 거리 계산 커널
+// 런타임에 CPU 기능을 확인하여 AVX-512 / AVX2(FMA) / scalar 구현 중 하나를 선택
+namespace distance {
+
+// 두 벡터의 내적
+float dotProduct(const float* a, const float* b, size_t dim);
+
+// L2 norm의 제곱 (= dotProduct(a, a))
+float normSquared(const float* a, size_t dim);
+
+// 벡터를 L2 norm 1로 정규화 (norm이 0이면 그대로 둠). 정규화 전 norm 반환
+float normalizeInPlace(float* a, size_t dim);
+
+// 선택된 커널 이름 ("avx512", "avx2", "scalar")
+const char* getKernelName();
+
+// 압축 코드 스캔 (flat 인덱스 v2)
+// FP16: IEEE half 코드와 float 쿼리의 내적
+float dotFp16(const float* query, const uint16_t* codes, size_t dim);
+// SQ8: uint8 코드와 float 쿼리의 내적 (row 복원: x[i] = bias + scale * code[i])
+//      실제 내적 = bias * sum(query) + scale * dotSq8(query, codes)
+float dotSq8(const float* query, const uint8_t* codes, size_t dim);
+
+// 인코딩
+void encodeFp16(const float* a, uint16_t* codes, size_t dim);
+// row별 [min, max] 구간을 256단계로 균등 양자화, scale/bias 반환
+void encodeSq8(const float* a, uint8_t* codes, size_t dim, float& scale, float& bias);
+
+}  // namespace distance
@@ -1,36 +1,156 @@
 #include "flat_index.h"
+#include "distance_kernels.h"
+#include "cache_flush.h"
 #include <algorithm>
+#include <thread>
 #include <omp.h>
 
+const char* flatCodeTypeName(FlatCodeType type) {
+    switch (type) {
+        case FlatCodeType::FP16: return "fp16";
+        case FlatCodeType::SQ8: return "sq8";
+        default: return "none";
+    }
+}
+
+bool parseFlatCodeType(const std::string& name, FlatCodeType& type) {
+    if (name == "none") {
+        type = FlatCodeType::None;
+    } else if (name == "fp16") {
+        type = FlatCodeType::FP16;
+    } else if (name == "sq8") {
+        type = FlatCodeType::SQ8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* flatSharingModeName(FlatSharingMode mode) {
+    switch (mode) {
+        case FlatSharingMode::Writer: return "writer";
+        case FlatSharingMode::Reader: return "reader";
+        default: return "local";
+    }
+}
+
+bool parseFlatSharingMode(const std::string& name, FlatSharingMode& mode) {
+    if (name == "local") {
+        mode = FlatSharingMode::Local;
+    } else if (name == "writer") {
+        mode = FlatSharingMode::Writer;
+    } else if (name == "reader") {
+        mode = FlatSharingMode::Reader;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 AppendOnlyFlatIndex::AppendOnlyFlatIndex(const std::string& file_path,
                                          size_t vector_dim,
-                                         size_t max_vectors)
+                                         size_t max_vectors,
+                                         const FlatIndexOptions& options)
     : file_path_(file_path), fd_(-1), 
       mapped_header_(nullptr), mapped_data_(nullptr), mapped_ids_(nullptr),
-      vector_dim_(vector_dim), max_capacity_(max_vectors) {
+      mapped_codes_(nullptr), mapped_params_(nullptr), mapped_size_(0),
+      vector_dim_(vector_dim), max_capacity_(max_vectors), options_(options),
+      code_type_(FlatCodeType::None), code_bytes_(0), reserved_count_(0),
+      visible_count_(0), seen_epoch_(0), id_index_rows_(0) {
+    options_.rerank_factor = std::max<size_t>(1, options_.rerank_factor);
 }
 
 AppendOnlyFlatIndex::~AppendOnlyFlatIndex() {
     cleanup();
 }
 
-bool AppendOnlyFlatIndex::initialize() {
-    // 파일 크기 계산: 헤더 + 벡터 데이터 + ID 데이터
-    size_t header_size = sizeof(FlatIndexHeader);
-    size_t vector_data_size = max_capacity_ * vector_dim_ * sizeof(float);
-    size_t id_data_size = max_capacity_ * sizeof(uint64_t);
-    size_t total_size = header_size + vector_data_size + id_data_size;
+FlatIndexLayoutV2 AppendOnlyFlatIndex::makeLayout(FlatCodeType code_type, size_t vector_dim, size_t max_vectors) {
+    auto align = [](size_t bytes) {
+        return (bytes + V2_REGION_ALIGN - 1) / V2_REGION_ALIGN * V2_REGION_ALIGN;
+    };
     
+    FlatIndexLayoutV2 layout{};
+    layout.code_type = static_cast<uint64_t>(code_type);
+    layout.code_bytes = code_type == FlatCodeType::FP16 ? vector_dim * sizeof(uint16_t) : vector_dim;
+    layout.codes_offset = V2_REGION_ALIGN;
+    layout.params_offset = layout.codes_offset + align(max_vectors * layout.code_bytes);
+    layout.rows_offset = layout.params_offset + align(max_vectors * 2 * sizeof(float));
+    layout.ids_offset = layout.rows_offset + align(max_vectors * vector_dim * sizeof(float));
+    layout.file_size = layout.ids_offset + align(max_vectors * sizeof(uint64_t));
+    return layout;
+}
+
+bool AppendOnlyFlatIndex::initialize() {
     // 파일이 존재하는지 확인
     bool file_exists = std::filesystem::exists(file_path_);
+    bool read_only = options_.sharing == FlatSharingMode::Reader;
+    if (read_only && !file_exists) {
+        std::cerr << "Shared flat index reader needs an existing file (start the writer first): "
+                  << file_path_ << std::endl;
+        return false;
+    }
     
-    // 파일 열기 (읽기/쓰기, 없으면 생성)
-    fd_ = open(file_path_.c_str(), O_RDWR | O_CREAT, 0644);
+    // 파일 열기 (읽기/쓰기, 없으면 생성 / reader는 읽기 전용)
+    fd_ = read_only ? open(file_path_.c_str(), O_RDONLY) : open(file_path_.c_str(), O_RDWR | O_CREAT, 0644);
     if (fd_ == -1) {
         std::cerr << "Failed to open flat index file: " << file_path_ << std::endl;
         return false;
     }
     
+    // 레이아웃 결정: 새 파일은 옵션의 코드 타입, 기존 파일은 헤더의 버전을 따름
+    FlatIndexHeader file_header{};
+    FlatIndexLayoutV2 layout{};
+    uint64_t version = options_.code_type == FlatCodeType::None ? VERSION : VERSION_CODES;
+    if (file_exists) {
+        if (pread(fd_, &file_header, sizeof(file_header), 0) != static_cast<ssize_t>(sizeof(file_header))) {
+            std::cerr << "Failed to read flat index header: " << file_path_ << std::endl;
+            close(fd_);
+            return false;
+        }
+        version = file_header.version;
+        if (version == VERSION_CODES &&
+            pread(fd_, &layout, sizeof(layout), sizeof(FlatIndexHeader)) != static_cast<ssize_t>(sizeof(layout))) {
+            std::cerr << "Failed to read flat index layout: " << file_path_ << std::endl;
+            close(fd_);
+            return false;
+        }
+    } else if (version == VERSION_CODES) {
+        layout = makeLayout(options_.code_type, vector_dim_, max_capacity_);
+    }
+    
+    if (file_header.magic_number != MAGIC_NUMBER && file_exists) {
+        std::cerr << "Invalid flat index file: wrong magic number" << std::endl;
+        close(fd_);
+        return false;
+    }
+    
+    if (version != VERSION && version != VERSION_CODES) {
+        std::cerr << "Unsupported flat index version: " << version << std::endl;
+        close(fd_);
+        return false;
+    }
+    
+    // 파일 크기 계산
+    // v1: 헤더 + 벡터 데이터 + ID 데이터, v2: 레이아웃에 기록된 페이지 정렬 영역들
+    size_t total_size = v1FileSize(vector_dim_, max_capacity_);
+    if (version == VERSION_CODES) {
+        FlatIndexLayoutV2 expected = makeLayout(static_cast<FlatCodeType>(layout.code_type),
+                                                vector_dim_, max_capacity_);
+        if (std::memcmp(&layout, &expected, sizeof(layout)) != 0) {
+            std::cerr << "Flat index layout mismatch (dimension/capacity/code type changed?)" << std::endl;
+            close(fd_);
+            return false;
+        }
+        total_size = layout.file_size;
+        code_type_ = static_cast<FlatCodeType>(layout.code_type);
+        code_bytes_ = layout.code_bytes;
+    }
+    
+    if (file_exists && options_.code_type != FlatCodeType::None && code_type_ != options_.code_type) {
+        std::cout << "Flat index file uses scan codes '" << flatCodeTypeName(code_type_)
+                  << "', ignoring requested '" << flatCodeTypeName(options_.code_type) << "'" << std::endl;
+    }
+    
     // 새 파일인 경우 크기 설정
     if (!file_exists) {
         if (ftruncate(fd_, total_size) == -1) {
@@ -42,76 +162,122 @@ bool AppendOnlyFlatIndex::initialize() {
     }
     
     // mmap으로 파일 매핑
-    void* mapped_ptr = mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    int prot = read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* mapped_ptr = mmap(nullptr, total_size, prot, MAP_SHARED, fd_, 0);
     if (mapped_ptr == MAP_FAILED) {
         std::cerr << "Failed to mmap flat index file" << std::endl;
         close(fd_);
         return false;
     }
+    mapped_size_ = total_size;
     
     // 포인터 설정
+    char* base = static_cast<char*>(mapped_ptr);
     mapped_header_ = static_cast<FlatIndexHeader*>(mapped_ptr);
-    mapped_data_ = reinterpret_cast<float*>(
-        static_cast<char*>(mapped_ptr) + header_size);
-    mapped_ids_ = reinterpret_cast<uint64_t*>(
-        static_cast<char*>(mapped_ptr) + header_size + vector_data_size);
+    if (read_only) {
+        // 이 호스트 캐시에 남은 헤더/레이아웃 라인을 버리고 writer가 내려보낸 값으로 검증
+        cacheline::invalidate(base, sizeof(FlatIndexHeader) + sizeof(FlatIndexLayoutV2));
+    }
+    if (version == VERSION_CODES) {
+        mapped_codes_ = reinterpret_cast<uint8_t*>(base + layout.codes_offset);
+        mapped_params_ = reinterpret_cast<float*>(base + layout.params_offset);
+        mapped_data_ = reinterpret_cast<float*>(base + layout.rows_offset);
+        mapped_ids_ = reinterpret_cast<uint64_t*>(base + layout.ids_offset);
+    } else {
+        size_t header_size = sizeof(FlatIndexHeader);
+        size_t vector_data_size = max_capacity_ * vector_dim_ * sizeof(float);
+        mapped_data_ = reinterpret_cast<float*>(base + header_size);
+        mapped_ids_ = reinterpret_cast<uint64_t*>(base + header_size + vector_data_size);
+    }
     
     // 새 파일인 경우 헤더 초기화
     if (!file_exists) {
         mapped_header_->magic_number = MAGIC_NUMBER;
-        mapped_header_->version = VERSION;
+        mapped_header_->version = version;
         mapped_header_->vector_dim = vector_dim_;
         mapped_header_->max_vectors = max_capacity_;
         mapped_header_->current_count = 0;
-        for (int i = 0; i < 3; ++i) {
-            mapped_header_->reserved[i] = 0;
+        mapped_header_->flags = FLAT_FLAG_NORMALIZED;
+        mapped_header_->next_id = 0;
+        mapped_header_->publish_epoch = 0;
+        if (version == VERSION_CODES) {
+            std::memcpy(base + sizeof(FlatIndexHeader), &layout, sizeof(layout));
         }
         
         // 헤더 동기화
-        msync(mapped_header_, sizeof(FlatIndexHeader), MS_SYNC);
+        msync(mapped_header_, V2_REGION_ALIGN, MS_SYNC);
+        if (options_.sharing == FlatSharingMode::Writer) {
+            cacheline::writeBack(mapped_header_, sizeof(FlatIndexHeader) + sizeof(FlatIndexLayoutV2));
+        }
         
         std::cout << "Initialized new flat index:" << std::endl;
         std::cout << "  - Dimension: " << vector_dim_ << std::endl;
         std::cout << "  - Max vectors: " << max_capacity_ << std::endl;
     } else {
         // 기존 파일인 경우 헤더 검증
-        if (mapped_header_->magic_number != MAGIC_NUMBER) {
-            std::cerr << "Invalid flat index file: wrong magic number" << std::endl;
-            munmap(mapped_ptr, total_size);
-            close(fd_);
-            return false;
-        }
-        
-        if (mapped_header_->version != VERSION) {
-            std::cerr << "Unsupported flat index version: " << mapped_header_->version << std::endl;
-            munmap(mapped_ptr, total_size);
-            close(fd_);
-            return false;
-        }
-        
         if (mapped_header_->vector_dim != vector_dim_) {
             std::cerr << "Vector dimension mismatch: file has " << mapped_header_->vector_dim 
                       << ", expected " << vector_dim_ << std::endl;
-            munmap(mapped_ptr, total_size);
-            close(fd_);
+            cleanup();
             return false;
         }
         
         if (mapped_header_->max_vectors != max_capacity_) {
             std::cerr << "Max vectors mismatch: file has " << mapped_header_->max_vectors 
                       << ", expected " << max_capacity_ << std::endl;
-            munmap(mapped_ptr, total_size);
-            close(fd_);
+            cleanup();
             return false;
         }
         
+        if ((mapped_header_->flags & FLAT_FLAG_NORMALIZED) == 0) {
+            if (read_only) {
+                std::cerr << "Shared flat index is not normalized yet (open it once as writer first)" << std::endl;
+                cleanup();
+                return false;
+            }
+            migrateToNormalized();
+        }
+        
+        // 이전 writer가 공개 도중 죽었으면 seqlock을 짝수로 닫아서 reader가 계속 진행하게 함
+        if (options_.sharing == FlatSharingMode::Writer && (mapped_header_->publish_epoch & 1) != 0) {
+            endPublish();
+        }
+        
         std::cout << "Loaded existing flat index:" << std::endl;
         std::cout << "  - Dimension: " << mapped_header_->vector_dim << std::endl;
         std::cout << "  - Max vectors: " << mapped_header_->max_vectors << std::endl;
         std::cout << "  - Current count: " << mapped_header_->current_count << std::endl;
     }
     
-    std::cout << "Flat index initialized successfully" << std::endl;
+    reserved_count_.store(mapped_header_->current_count);
+    
+    // 삭제 표시 파일 (writer가 만들고, 공유 reader는 읽기 전용으로 매핑)
+    std::string tombstone_path = file_path_ + ".tomb";
+    if (!tombstones_.open(tombstone_path, max_capacity_, read_only,
+                          options_.sharing == FlatSharingMode::Writer)) {
+        std::cerr << "Failed to open flat tombstones: " << tombstone_path << std::endl;
+        cleanup();
+        return false;
+    }
+    
+    // reader는 writer가 공개한 prefix 전체를 invalidate한 뒤부터 검색에 노출
+    if (read_only) {
+        FlatPublishedState state;
+        if (!readPublished(state)) {
+            std::cerr << "Shared flat index writer did not finish publishing, try again" << std::endl;
+            cleanup();
+            return false;
+        }
+        applyPublished(state);
+    }
+    
+    std::cout << "Flat index initialized successfully (distance kernel: "
+              << distance::getKernelName() << ", scan codes: " << flatCodeTypeName(code_type_)
+              << ", " << getScanBytesPerRow() << " B/row, sharing: " << flatSharingModeName(options_.sharing);
+    if (options_.sharing != FlatSharingMode::Local) {
+        std::cout << ", cache line " << (read_only ? cacheline::getInvalidateName() : cacheline::getWriteBackName());
+    }
+    std::cout << ")" << std::endl;
     return true;
 }
 
@@ -122,99 +288,589 @@ bool AppendOnlyFlatIndex::insert(const VectorData& vector_data) {
         return false;
     }
     
-    std::lock_guard<std::mutex> lock(write_mutex_);
+    return insertBatch(vector_data.vector.data(), 1, &vector_data.id);
+}
+
+bool AppendOnlyFlatIndex::reserveSlots(size_t count, size_t& first) {
+    size_t current = reserved_count_.load(std::memory_order_relaxed);
+    do {
+        if (current + count > max_capacity_) {
+            return false;
+        }
+    } while (!reserved_count_.compare_exchange_weak(current, current + count,
+                                                    std::memory_order_relaxed));
+    first = current;
+    return true;
+}
+
+bool AppendOnlyFlatIndex::insertBatch(const float* vectors, size_t count, const uint64_t* ids) {
+    if (count == 0) {
+        return true;
+    }
+    if (isReadOnly()) {
+        std::cerr << "Shared flat index reader cannot insert (only the writer appends)" << std::endl;
+        return false;
+    }
     
-    size_t current_idx = mapped_header_->current_count;
-    if (current_idx >= max_capacity_) {
-        std::cerr << "Flat index is full" << std::endl;
+    // 1. 슬롯 범위 예약 (lock 없음, 여러 writer가 서로 다른 범위를 병렬로 채움)
+    size_t current_idx = 0;
+    if (!reserveSlots(count, current_idx)) {
+        std::cerr << "Flat index is full (" << reserved_count_.load() << " + " << count
+                  << " > " << max_capacity_ << ")" << std::endl;
         return false;
     }
     
-    // 벡터 데이터 복사
-    std::memcpy(&mapped_data_[current_idx * vector_dim_], 
-                vector_data.vector.data(), 
-                vector_dim_ * sizeof(float));
+    // 2. 벡터 데이터를 한 번에 복사 후 정규화 (검색 시 row당 내적 한 번으로 COSINE 계산)
+    float* rows = &mapped_data_[current_idx * vector_dim_];
+    std::memcpy(rows, vectors, count * vector_dim_ * sizeof(float));
+    for (size_t i = 0; i < count; ++i) {
+        distance::normalizeInPlace(rows + i * vector_dim_, vector_dim_);
+    }
+    
+    encodeRows(current_idx, count);
     
     // ID 저장
-    mapped_ids_[current_idx] = vector_data.id;
+    std::memcpy(&mapped_ids_[current_idx], ids, count * sizeof(uint64_t));
     
-    // 카운트 증가
-    mapped_header_->current_count = current_idx + 1;
+    // 데이터와 ID를 먼저 내구화한 뒤 카운트를 공개 (중간에 죽어도 미완성 row가 보이지 않음,
+    // Writer 모드에서는 다른 호스트의 reader도 카운트보다 row를 먼저 메모리에서 보게 됨)
+    persistRows(current_idx, count);
     
-    // 메모리 동기화
-    msync(&mapped_data_[current_idx * vector_dim_], vector_dim_ * sizeof(float), MS_ASYNC);
-    msync(&mapped_ids_[current_idx], sizeof(uint64_t), MS_ASYNC);
-    msync(mapped_header_, sizeof(FlatIndexHeader), MS_ASYNC);
+    // 영구 ID 워터마크 갱신 (flat이 비워진 뒤 재시작해도 ID가 재사용되지 않도록)
+    // 카운트 공개 전에 올려 두어 Writer 모드의 헤더 write-back 한 번에 같이 내려감
+    uint64_t batch_next_id = *std::max_element(ids, ids + count) + 1;
+    std::atomic_ref<uint64_t> next_id(mapped_header_->next_id);
+    uint64_t prev_next_id = next_id.load();
+    while (prev_next_id < batch_next_id && !next_id.compare_exchange_weak(prev_next_id, batch_next_id)) {
+    }
+    
+    // 3. 앞선 범위들이 모두 공개될 때까지 기다린 뒤 순서대로 watermark 공개
+    //    (release: 위의 row/ID 쓰기가 acquire로 카운트를 읽은 reader에게 보임)
+    auto committed = committedCount();
+    uint64_t expected = committed.load(std::memory_order_acquire);
+    while (expected != current_idx) {
+        committed.wait(expected, std::memory_order_acquire);
+        expected = committed.load(std::memory_order_acquire);
+    }
+    if (options_.sharing == FlatSharingMode::Writer) {
+        std::lock_guard<std::mutex> publish_lock(publish_mutex_);
+        beginPublish();
+        committed.store(current_idx + count, std::memory_order_release);
+        endPublish();
+    } else {
+        committed.store(current_idx + count, std::memory_order_release);
+    }
+    committed.notify_all();
+    
+    if (options_.sharing == FlatSharingMode::Local) {
+        syncRange(mapped_header_, sizeof(FlatIndexHeader), MS_SYNC);
+    }
     
     return true;
 }
 
+void AppendOnlyFlatIndex::encodeRows(size_t first, size_t count) {
+    if (!mapped_codes_) {
+        return;
+    }
+    
+    for (size_t i = first; i < first + count; ++i) {
+        const float* row = &mapped_data_[i * vector_dim_];
+        uint8_t* codes = mapped_codes_ + i * code_bytes_;
+        float* params = &mapped_params_[i * 2];
+        if (code_type_ == FlatCodeType::FP16) {
+            distance::encodeFp16(row, reinterpret_cast<uint16_t*>(codes), vector_dim_);
+            params[0] = 1.0f;
+            params[1] = 0.0f;
+        } else {
+            distance::encodeSq8(row, codes, vector_dim_, params[0], params[1]);
+        }
+    }
+}
+
+bool AppendOnlyFlatIndex::discardPrefix(size_t count) {
+    if (isReadOnly()) {
+        std::cerr << "Shared flat index reader cannot discard vectors" << std::endl;
+        return false;
+    }
+    size_t current = getCurrentCount();
+    if (count > current) {
+        std::cerr << "Cannot discard " << count << " of " << current << " flat vectors" << std::endl;
+        return false;
+    }
+    
+    // Writer 모드: 옮기기 전에 세대를 올려서 이동 중에 스캔한 reader가 결과를 버리게 함
+    // (publish_mutex_는 끝까지 잡아서 이동 중에 삽입/삭제 공개가 epoch를 닫지 않도록)
+    std::unique_lock<std::mutex> publish_lock(publish_mutex_, std::defer_lock);
+    if (options_.sharing == FlatSharingMode::Writer) {
+        publish_lock.lock();
+        beginPublish(true);
+    }
+    
+    // compaction 중에 새로 들어온 뒤쪽 벡터들만 앞으로 이동
+    size_t remaining = current - count;
+    if (remaining > 0) {
+        std::memmove(mapped_data_, &mapped_data_[count * vector_dim_],
+                     remaining * vector_dim_ * sizeof(float));
+        std::memmove(mapped_ids_, &mapped_ids_[count], remaining * sizeof(uint64_t));
+        if (mapped_codes_) {
+            std::memmove(mapped_codes_, mapped_codes_ + count * code_bytes_, remaining * code_bytes_);
+            std::memmove(mapped_params_, &mapped_params_[count * 2], remaining * 2 * sizeof(float));
+        }
+        persistRows(0, remaining);
+    }
+    tombstones_.shiftDown(count, current);
+    
+    // 역색인에서 제거된 row를 빼고 남은 row 번호를 당김 (정렬 순서는 그대로)
+    {
+        std::lock_guard<std::mutex> delete_lock(delete_mutex_);
+        std::erase_if(id_index_, [count](const auto& entry) { return entry.second < count; });
+        for (auto& entry : id_index_) {
+            entry.second -= count;
+        }
+        id_index_rows_ = id_index_rows_ > count ? id_index_rows_ - count : 0;
+    }
+    
+    // Writer 모드는 올린 세대로 reader가 이미 보던 prefix까지 다시 읽게 함
+    if (options_.sharing == FlatSharingMode::Writer) {
+        committedCount().store(remaining, std::memory_order_release);
+        endPublish();
+    } else {
+        committedCount().store(remaining, std::memory_order_release);
+        syncRange(mapped_header_, sizeof(FlatIndexHeader), MS_SYNC);
+    }
+    reserved_count_.store(remaining);
+    
+    std::cout << "Flat index compacted: discarded " << count << " vectors, "
+              << remaining << " remaining" << std::endl;
+    return true;
+}
+
+void AppendOnlyFlatIndex::updateIdIndex(size_t rows) {
+    if (rows <= id_index_rows_) {
+        return;
+    }
+    size_t old_size = id_index_.size();
+    id_index_.reserve(old_size + rows - id_index_rows_);
+    for (size_t row = id_index_rows_; row < rows; ++row) {
+        id_index_.emplace_back(mapped_ids_[row], row);
+    }
+    std::sort(id_index_.begin() + old_size, id_index_.end());
+    // 서버가 ID를 순서대로 발급하므로 대부분 이미 정렬된 뒤에 붙음
+    if (old_size > 0 && id_index_[old_size] < id_index_[old_size - 1]) {
+        std::inplace_merge(id_index_.begin(), id_index_.begin() + old_size, id_index_.end());
+    }
+    id_index_rows_ = rows;
+}
+
+size_t AppendOnlyFlatIndex::markDeleted(const uint64_t* ids, size_t count, std::vector<bool>& found) {
+    found.assign(count, false);
+    if (isReadOnly()) {
+        std::cerr << "Shared flat index reader cannot delete vectors" << std::endl;
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> delete_lock(delete_mutex_);
+    updateIdIndex(getCurrentCount());
+    
+    // 같은 ID의 row 중 아직 살아 있는 첫 row를 지움
+    std::vector<size_t> rows;
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < count; ++i) {
+        auto it = std::lower_bound(id_index_.begin(), id_index_.end(), std::make_pair(ids[i], uint64_t{0}));
+        for (; it != id_index_.end() && it->first == ids[i]; ++it) {
+            if (!tombstones_.test(it->second)) {
+                rows.push_back(it->second);
+                positions.push_back(i);
+                break;
+            }
+        }
+    }
+    
+    // 바뀐 bit는 요청당 한 번만 내구화 (같은 ID가 여러 번 오면 첫 번째만 새로 설정됨)
+    std::vector<bool> newly_set;
+    size_t deleted = tombstones_.setBatch(rows, newly_set);
+    for (size_t j = 0; j < rows.size(); ++j) {
+        if (newly_set[j]) {
+            found[positions[j]] = true;
+        }
+    }
+    
+    // 공유 reader가 삭제를 보도록 row 수는 그대로 두고 epoch만 올림
+    if (deleted > 0 && options_.sharing == FlatSharingMode::Writer) {
+        std::lock_guard<std::mutex> publish_lock(publish_mutex_);
+        beginPublish();
+        endPublish();
+    }
+    return deleted;
+}
+
+uint64_t AppendOnlyFlatIndex::getMaxId() const {
+    uint64_t max_id = 0;
+    size_t count = getCurrentCount();
+    for (size_t i = 0; i < count; ++i) {
+        max_id = std::max(max_id, mapped_ids_[i]);
+    }
+    return max_id;
+}
+
+std::vector<SearchResult> AppendOnlyFlatIndex::rerank(
+    const float* query, TopKSelector& candidates, size_t k) const {
+    
+    TopKSelector reranked(k);
+    for (const auto& candidate : candidates.extractSorted()) {
+        size_t row = static_cast<size_t>(candidate.id);
+        float dist = 1.0f - distance::dotProduct(query, &mapped_data_[row * vector_dim_], vector_dim_);
+        reranked.push(mapped_ids_[row], dist);
+    }
+    return reranked.extractSorted();
+}
+
 std::vector<SearchResult> AppendOnlyFlatIndex::bruteForceSearch(
-    const std::vector<float>& query, int k) const {
+    const std::vector<float>& query, int k, bool exact) const {
+    
+    // Reader 모드: writer의 prefix 이동과 겹친 스캔은 버림 (poller가 새 세대를 반영할 때까지 flat 결과 없음)
+    if (options_.sharing == FlatSharingMode::Reader && !readerViewCurrent()) {
+        return {};
+    }
+    auto results = scanRows(query, k, exact);
+    if (options_.sharing == FlatSharingMode::Reader && !readerViewCurrent()) {
+        return {};
+    }
+    return results;
+}
+
+std::vector<SearchResult> AppendOnlyFlatIndex::scanRows(
+    const std::vector<float>& query, int k, bool exact) const {
     
     if (query.size() != vector_dim_) {
         std::cerr << "Query dimension mismatch" << std::endl;
         return {};
     }
     
-    size_t count = mapped_header_->current_count;
+    size_t count = getCurrentCount();
     if (count == 0) {
         return {};
     }
     
-    std::vector<SearchResult> results(count);
+    // 쿼리는 한 번만 정규화, 저장된 벡터는 이미 정규화되어 있음
+    std::vector<float> normalized_query(query);
+    distance::normalizeInPlace(normalized_query.data(), vector_dim_);
+    const float* query_ptr = normalized_query.data();
+    // 삭제가 없으면 row마다 bitset을 보지 않음
+    bool has_deleted = tombstones_.count() > 0;
     
-    // 모든 벡터와의 거리 계산 (COSINE 거리)
-    #pragma omp parallel for
-    for (size_t i = 0; i < count; ++i) {
-        float dot_product = 0.0f;
-        float norm_query = 0.0f;
-        float norm_data = 0.0f;
+    // 압축 코드 스캔: row 인덱스로 후보를 모은 뒤 float32 row로 rerank
+    if (mapped_codes_ && !exact && k > 0) {
+        size_t top_k = static_cast<size_t>(k);
+        size_t candidates_k = rerankCandidates(top_k);
+        float query_sum = 0.0f;
+        for (size_t d = 0; d < vector_dim_; ++d) {
+            query_sum += query_ptr[d];
+        }
         
-        const float* data_vector_ptr = &mapped_data_[i * vector_dim_];
+        TopKSelector candidates(candidates_k);
         
-        for (size_t j = 0; j < vector_dim_; ++j) {
-            float query_val = query[j];
-            float data_val = data_vector_ptr[j];
+        #pragma omp parallel num_threads(scanThreads())
+        {
+            TopKSelector local(candidates_k);
+            
+            #pragma omp for schedule(static) nowait
+            for (size_t i = 0; i < count; ++i) {
+                if (has_deleted && tombstones_.test(i)) {
+                    continue;
+                }
+                local.push(i, codeDistance(query_ptr, query_sum, i));
+            }
             
-            dot_product += query_val * data_val;
-            norm_query += query_val * query_val;
-            norm_data += data_val * data_val;
+            #pragma omp critical
+            candidates.merge(local);
         }
         
-        float cosine_sim = dot_product / (std::sqrt(norm_query) * std::sqrt(norm_data) + 1e-10f);
-        float distance = 1.0f - cosine_sim;
+        return rerank(query_ptr, candidates, top_k);
+    }
+    
+    // 스레드별 bounded top-k만 유지 (전체 거리 배열을 만들지 않음)
+    TopKSelector merged(static_cast<size_t>(std::max(k, 0)));
+    
+    #pragma omp parallel num_threads(scanThreads())
+    {
+        TopKSelector local(static_cast<size_t>(std::max(k, 0)));
+        
+        // 모든 벡터와의 거리 계산 (COSINE 거리 = 1 - 내적)
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < count; ++i) {
+            if (has_deleted && tombstones_.test(i)) {
+                continue;
+            }
+            const float* data_vector_ptr = &mapped_data_[i * vector_dim_];
+            float cosine_sim = distance::dotProduct(query_ptr, data_vector_ptr, vector_dim_);
+            local.push(mapped_ids_[i], 1.0f - cosine_sim);
+        }
         
-        results[i] = SearchResult(mapped_ids_[i], distance);
+        #pragma omp critical
+        merged.merge(local);
     }
     
-    // 거리에 따라 정렬
-    std::partial_sort(results.begin(), 
-                     results.begin() + std::min(k, static_cast<int>(results.size())),
-                     results.end(),
-                     [](const SearchResult& a, const SearchResult& b) {
-                         return a.distance < b.distance;
-                     });
+    // 거리 오름차순 상위 k개
+    return merged.extractSorted();
+}
+
+std::vector<std::vector<SearchResult>> AppendOnlyFlatIndex::bruteForceSearchBatch(
+    const std::vector<std::vector<float>>& queries, int k, bool exact) const {
+    
+    size_t num_queries = queries.size();
+    if (num_queries == 0) {
+        return {};
+    }
+    
+    for (const auto& query : queries) {
+        if (query.size() != vector_dim_) {
+            std::cerr << "Query dimension mismatch in flat batch search" << std::endl;
+            return std::vector<std::vector<SearchResult>>(num_queries);
+        }
+    }
     
-    // 상위 k개만 반환
-    if (static_cast<int>(results.size()) > k) {
-        results.resize(k);
+    std::vector<float> packed_queries;
+    packed_queries.reserve(num_queries * vector_dim_);
+    for (const auto& query : queries) {
+        packed_queries.insert(packed_queries.end(), query.begin(), query.end());
     }
+    return bruteForceSearchBatch(packed_queries.data(), num_queries, k, exact);
+}
+
+std::vector<std::vector<SearchResult>> AppendOnlyFlatIndex::bruteForceSearchBatch(
+    const float* queries, size_t num_queries, int k, bool exact) const {
     
+    if (options_.sharing == FlatSharingMode::Reader && !readerViewCurrent()) {
+        return std::vector<std::vector<SearchResult>>(num_queries);
+    }
+    auto results = scanRowsBatch(queries, num_queries, k, exact);
+    if (options_.sharing == FlatSharingMode::Reader && !readerViewCurrent()) {
+        return std::vector<std::vector<SearchResult>>(num_queries);
+    }
     return results;
 }
 
+std::vector<std::vector<SearchResult>> AppendOnlyFlatIndex::scanRowsBatch(
+    const float* queries, size_t num_queries, int k, bool exact) const {
+    
+    std::vector<std::vector<SearchResult>> final_results(num_queries);
+    size_t count = getCurrentCount();
+    if (num_queries == 0 || count == 0 || k <= 0) {
+        return final_results;
+    }
+    
+    // 쿼리들을 정규화하여 연속 버퍼에 배치
+    std::vector<float> normalized_queries(num_queries * vector_dim_);
+    for (size_t q = 0; q < num_queries; ++q) {
+        float* dst = &normalized_queries[q * vector_dim_];
+        std::memcpy(dst, queries + q * vector_dim_, vector_dim_ * sizeof(float));
+        distance::normalizeInPlace(dst, vector_dim_);
+    }
+    
+    size_t top_k = static_cast<size_t>(k);
+    size_t num_blocks = (count + SCAN_BLOCK_ROWS - 1) / SCAN_BLOCK_ROWS;
+    bool use_codes = mapped_codes_ && !exact;
+    // 압축 코드 스캔이면 후보(id 필드 = row 인덱스)를 넉넉히 모아서 마지막에 rerank
+    size_t scan_k = use_codes ? rerankCandidates(top_k) : top_k;
+    std::vector<float> query_sums(num_queries, 0.0f);
+    if (use_codes) {
+        for (size_t q = 0; q < num_queries; ++q) {
+            const float* query_ptr = &normalized_queries[q * vector_dim_];
+            for (size_t d = 0; d < vector_dim_; ++d) {
+                query_sums[q] += query_ptr[d];
+            }
+        }
+    }
+    std::vector<TopKSelector> merged(num_queries, TopKSelector(scan_k));
+    // 삭제가 없으면 row마다 bitset을 보지 않음
+    bool has_deleted = tombstones_.count() > 0;
+    
+    #pragma omp parallel num_threads(scanThreads())
+    {
+        // 스레드별로 쿼리마다 bounded top-k 유지
+        std::vector<TopKSelector> local(num_queries, TopKSelector(scan_k));
+        
+        #pragma omp for schedule(static) nowait
+        for (size_t block = 0; block < num_blocks; ++block) {
+            size_t row_begin = block * SCAN_BLOCK_ROWS;
+            size_t row_end = std::min(row_begin + SCAN_BLOCK_ROWS, count);
+            
+            // 블록이 캐시에 있는 동안 배치의 모든 쿼리를 계산
+            for (size_t q = 0; q < num_queries; ++q) {
+                const float* query_ptr = &normalized_queries[q * vector_dim_];
+                auto& selector = local[q];
+                
+                if (use_codes) {
+                    for (size_t i = row_begin; i < row_end; ++i) {
+                        if (has_deleted && tombstones_.test(i)) {
+                            continue;
+                        }
+                        selector.push(i, codeDistance(query_ptr, query_sums[q], i));
+                    }
+                    continue;
+                }
+                
+                for (size_t i = row_begin; i < row_end; ++i) {
+                    if (has_deleted && tombstones_.test(i)) {
+                        continue;
+                    }
+                    float dist = 1.0f - distance::dotProduct(query_ptr, &mapped_data_[i * vector_dim_], vector_dim_);
+                    selector.push(mapped_ids_[i], dist);
+                }
+            }
+        }
+        
+        #pragma omp critical
+        {
+            for (size_t q = 0; q < num_queries; ++q) {
+                merged[q].merge(local[q]);
+            }
+        }
+    }
+    
+    if (use_codes) {
+        #pragma omp parallel for schedule(dynamic) num_threads(scanThreads())
+        for (size_t q = 0; q < num_queries; ++q) {
+            final_results[q] = rerank(&normalized_queries[q * vector_dim_], merged[q], top_k);
+        }
+        return final_results;
+    }
+    
+    for (size_t q = 0; q < num_queries; ++q) {
+        final_results[q] = merged[q].extractSorted();
+    }
+    
+    return final_results;
+}
+
+void AppendOnlyFlatIndex::migrateToNormalized() {
+    size_t count = getCurrentCount();
+    std::cout << "Normalizing " << count << " stored vectors (one-time flat index migration)..." << std::endl;
+    
+    #pragma omp parallel for num_threads(scanThreads())
+    for (size_t i = 0; i < count; ++i) {
+        distance::normalizeInPlace(&mapped_data_[i * vector_dim_], vector_dim_);
+    }
+    
+    if (count > 0) {
+        persistRange(mapped_data_, count * vector_dim_ * sizeof(float));
+    }
+    mapped_header_->flags |= FLAT_FLAG_NORMALIZED;
+    persistRange(mapped_header_, sizeof(FlatIndexHeader));
+}
+
+bool AppendOnlyFlatIndex::readPublished(FlatPublishedState& state) const {
+    std::atomic_ref<uint64_t> epoch(mapped_header_->publish_epoch);
+    for (size_t attempt = 0; attempt < PUBLISH_READ_RETRIES; ++attempt) {
+        // seqlock 읽기: 헤더 라인을 메모리에서 다시 읽고, 값을 읽은 뒤 epoch가 그대로인지 확인
+        cacheline::invalidate(mapped_header_, sizeof(FlatIndexHeader));
+        uint64_t begin = epoch.load(std::memory_order_acquire);
+        if ((begin & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint64_t count = committedCount().load(std::memory_order_acquire);
+        cacheline::invalidate(mapped_header_, sizeof(FlatIndexHeader));
+        if (epoch.load(std::memory_order_acquire) != begin) {
+            continue;
+        }
+        if (count > max_capacity_) {
+            std::cerr << "Shared flat index header is corrupt (count " << count << " > capacity "
+                      << max_capacity_ << ")" << std::endl;
+            return false;
+        }
+        state.epoch = begin;
+        state.count = count;
+        return true;
+    }
+    return false;
+}
+
+size_t AppendOnlyFlatIndex::applyPublished(const FlatPublishedState& state) {
+    size_t visible = getCurrentCount();
+    bool reset = isPrefixReset(state);
+    // 아직 노출하지 않은 범위는 prefetch로 stale 라인이 들어와 있을 수 있으므로 노출 전에 버림
+    size_t first = reset ? 0 : visible;
+    if (state.count > first) {
+        invalidateRows(first, state.count - first);
+    }
+    tombstones_.invalidate(state.count);
+    visible_count_.store(state.count, std::memory_order_release);
+    seen_epoch_.store(state.epoch, std::memory_order_release);
+    return reset ? state.count : state.count - visible;
+}
+
+void AppendOnlyFlatIndex::beginPublish(bool prefix_reset) {
+    // 같은 캐시 라인 안의 store는 순서대로 보이므로(TSO), 중간에 라인이 내려가도
+    // 카운트가 바뀐 라인에는 항상 홀수 epoch가 같이 실림
+    std::atomic_ref<uint64_t> epoch(mapped_header_->publish_epoch);
+    uint64_t current = epoch.load(std::memory_order_relaxed);
+    if (!prefix_reset) {
+        epoch.store(current + 1, std::memory_order_release);
+        return;
+    }
+    // 새 세대의 홀수 epoch를 row 이동 전에 메모리까지 내려보냄 (write-back 뒤의 fence가 이동 store보다 앞섬)
+    epoch.store((((current >> 32) + 1) << 32) | 1, std::memory_order_release);
+    cacheline::writeBack(mapped_header_, sizeof(FlatIndexHeader));
+}
+
+void AppendOnlyFlatIndex::endPublish() {
+    std::atomic_ref<uint64_t> epoch(mapped_header_->publish_epoch);
+    epoch.store((epoch.load(std::memory_order_relaxed) | 1) + 1, std::memory_order_release);
+    cacheline::writeBack(mapped_header_, sizeof(FlatIndexHeader));
+}
+
+bool AppendOnlyFlatIndex::readerViewCurrent() const {
+    // 헤더 라인을 메모리에서 다시 읽음 (스캔 뒤 호출에서는 스캔한 row보다 나중에 읽힘)
+    cacheline::invalidate(mapped_header_, sizeof(FlatIndexHeader));
+    uint64_t epoch = std::atomic_ref<uint64_t>(mapped_header_->publish_epoch).load(std::memory_order_acquire);
+    return (epoch >> 32) == (seenEpoch() >> 32);
+}
+
+void AppendOnlyFlatIndex::persistRange(const void* addr, size_t len) const {
+    if (options_.sharing == FlatSharingMode::Writer) {
+        cacheline::writeBack(addr, len);
+    } else {
+        syncRange(addr, len, MS_SYNC);
+    }
+}
+
+void AppendOnlyFlatIndex::persistRows(size_t first, size_t count) const {
+    persistRange(&mapped_data_[first * vector_dim_], count * vector_dim_ * sizeof(float));
+    persistRange(&mapped_ids_[first], count * sizeof(uint64_t));
+    if (mapped_codes_) {
+        persistRange(mapped_codes_ + first * code_bytes_, count * code_bytes_);
+        persistRange(&mapped_params_[first * 2], count * 2 * sizeof(float));
+    }
+}
+
+void AppendOnlyFlatIndex::invalidateRows(size_t first, size_t count) const {
+    cacheline::invalidate(&mapped_data_[first * vector_dim_], count * vector_dim_ * sizeof(float));
+    cacheline::invalidate(&mapped_ids_[first], count * sizeof(uint64_t));
+    if (mapped_codes_) {
+        cacheline::invalidate(mapped_codes_ + first * code_bytes_, count * code_bytes_);
+        cacheline::invalidate(&mapped_params_[first * 2], count * 2 * sizeof(float));
+    }
+}
+
+void AppendOnlyFlatIndex::syncRange(const void* addr, size_t len, int flags) {
+    static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page_size - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(addr) + len;
+    msync(reinterpret_cast<void*>(begin), end - begin, flags);
+}
+
 void AppendOnlyFlatIndex::cleanup() {
+    tombstones_.close();
     if (mapped_header_ != nullptr) {
-        size_t header_size = sizeof(FlatIndexHeader);
-        size_t vector_data_size = max_capacity_ * vector_dim_ * sizeof(float);
-        size_t id_data_size = max_capacity_ * sizeof(uint64_t);
-        size_t total_size = header_size + vector_data_size + id_data_size;
-        
-        munmap(mapped_header_, total_size);
+        munmap(mapped_header_, mapped_size_);
         mapped_header_ = nullptr;
         mapped_data_ = nullptr;
         mapped_ids_ = nullptr;
+        mapped_codes_ = nullptr;
+        mapped_params_ = nullptr;
     }
     
     if (fd_ != -1) {
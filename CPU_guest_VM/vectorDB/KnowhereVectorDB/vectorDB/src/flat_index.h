@@ -3,8 +3,8 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <mutex>
 #include <atomic>
+#include <mutex>
 #include <cstring>
 #include <cmath>
 #include <filesystem>
@@ -12,15 +12,12 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <omp.h>
+
+#include "search_result.h"
+#include "distance_kernels.h"
+#include "tombstone_bitset.h"
 
-// 검색 결과 구조 (vector_db.h와 공유)
-struct SearchResult {
-    uint64_t id;
-    float distance;
-    
-    SearchResult() : id(0), distance(0.0f) {}
-    SearchResult(uint64_t vector_id, float dist) : id(vector_id), distance(dist) {}
-};
 
 // 벡터 데이터 구조
 struct VectorData {
@@ -35,51 +32,276 @@ struct VectorData {
 // mmap 파일 헤더 구조
 struct FlatIndexHeader {
     uint64_t magic_number;    // 파일 포맷 식별자 (0x4649445800000000 = "FIDX")
-    uint64_t version;         // 파일 포맷 버전 (현재 1)
+    uint64_t version;         // 파일 포맷 버전 (1: float32만, 2: 압축 코드 + float32 rerank 영역)
     uint64_t vector_dim;      // 벡터 차원
     uint64_t max_vectors;     // 최대 벡터 개수
     uint64_t current_count;   // 현재 저장된 벡터 개수
-    uint64_t reserved[3];     // 미래 확장용 (총 64바이트)
+    uint64_t flags;           // FLAT_FLAG_* 비트 플래그
+    uint64_t next_id;         // 지금까지 삽입된 최대 ID + 1 (compaction으로 비워져도 유지)
+    uint64_t publish_epoch;   // 공유 writer의 seqlock (상위 32비트: prefix 제거 세대, 하위 32비트: 홀수면 공개 중)
+                              // 세대는 prefix 이동을 시작할 때 올림 (reader 스캔이 이동과 겹쳤는지 확인)
+};                            // 총 64바이트 (캐시 라인 하나)
+
+// FlatIndexHeader::flags
+// 저장된 벡터가 L2 norm 1로 정규화되어 있음 (COSINE 거리 = 1 - 내적)
+constexpr uint64_t FLAT_FLAG_NORMALIZED = 1ULL << 0;
+
+// flat 인덱스 스캔용 압축 코드 (v2 파일)
+enum class FlatCodeType : uint64_t {
+    None = 0,   // float32 row를 그대로 스캔 (v1 포맷)
+    FP16 = 1,   // row당 dim × 2바이트
+    SQ8 = 2,    // row당 dim바이트 + {scale, bias}
+};
+
+const char* flatCodeTypeName(FlatCodeType type);
+bool parseFlatCodeType(const std::string& name, FlatCodeType& type);
+
+// v2 레이아웃 (파일 오프셋 64, FlatIndexHeader 바로 뒤)
+// 각 영역은 페이지 정렬: [헤더 페이지][codes][params][float32 rows][ids]
+// 스캔은 codes/params만 순차로 읽고, rows는 rerank 후보만 임의 접근
+struct FlatIndexLayoutV2 {
+    uint64_t code_type;       // FlatCodeType
+    uint64_t code_bytes;      // row당 코드 바이트
+    uint64_t codes_offset;
+    uint64_t params_offset;   // row당 float 2개 {scale, bias} (SQ8만 사용)
+    uint64_t rows_offset;     // 정규화된 float32 원본 (rerank, compaction용)
+    uint64_t ids_offset;
+    uint64_t file_size;
+    uint64_t reserved[1];     // 미래 확장용 (총 64바이트)
+};
+
+// flat 인덱스 생성 옵션 (기존 파일은 헤더에 기록된 포맷을 따름)
+// 여러 호스트(VM)가 비일관 CXL 위의 같은 파일을 MAP_SHARED로 열 때의 역할
+enum class FlatSharingMode : uint8_t {
+    Local,    // 한 호스트만 사용 (msync로 내구화, 캐시 라인 관리 없음)
+    Writer,   // 유일한 writer: 쓴 라인을 write-back한 뒤 헤더 seqlock으로 공개
+    Reader,   // 읽기 전용: writer가 새로 공개한 범위만 invalidate 후 다시 읽음
+};
+
+const char* flatSharingModeName(FlatSharingMode mode);
+bool parseFlatSharingMode(const std::string& name, FlatSharingMode& mode);
+
+struct FlatIndexOptions {
+    FlatCodeType code_type = FlatCodeType::None;  // 새 파일의 스캔 코드
+    size_t rerank_factor = 4;                     // 압축 코드 스캔에서 k × factor개 후보를 float32로 rerank
+    FlatSharingMode sharing = FlatSharingMode::Local;
+    size_t scan_threads = 0;                      // 스캔 OpenMP 스레드 수 (0이면 OpenMP 기본값)
+};
+
+// seqlock으로 일관되게 읽은 writer의 공개 상태 (Reader 모드)
+struct FlatPublishedState {
+    uint64_t epoch = 0;
+    uint64_t count = 0;
 };
 
 // Append-only flat 인덱스 클래스
 class AppendOnlyFlatIndex {
 private:
     static constexpr uint64_t MAGIC_NUMBER = 0x4649445800000000ULL;  // "FIDX"
-    static constexpr uint64_t VERSION = 1;
+    static constexpr uint64_t VERSION = 1;       // 압축 코드 없는 파일
+    static constexpr uint64_t VERSION_CODES = 2; // 압축 코드 + rerank 영역
+    static constexpr size_t V2_REGION_ALIGN = 4096;
     static constexpr size_t DEFAULT_MAX_VECTORS = 1000000;
     static constexpr size_t DEFAULT_VECTOR_DIM = 768;
+    // 배치 스캔 시 한 번에 L2에 올려 두고 모든 쿼리를 계산할 row 수 (768차원 기준 384KB)
+    static constexpr size_t SCAN_BLOCK_ROWS = 128;
+    // Reader 모드에서 writer가 공개 중(홀수 epoch)일 때 헤더를 다시 읽어 볼 횟수
+    static constexpr size_t PUBLISH_READ_RETRIES = 64;
     
     std::string file_path_;
     int fd_;
     FlatIndexHeader* mapped_header_;  // mmap된 헤더
     float* mapped_data_;              // mmap된 벡터 데이터
     uint64_t* mapped_ids_;            // mmap된 ID 데이터
+    uint8_t* mapped_codes_;           // mmap된 압축 코드 (v2, 아니면 nullptr)
+    float* mapped_params_;            // mmap된 row별 {scale, bias} (v2)
+    size_t mapped_size_;
     size_t vector_dim_;               // 벡터 차원 (런타임)
     size_t max_capacity_;             // 최대 용량 (런타임)
-    std::mutex write_mutex_;
+    FlatIndexOptions options_;
+    FlatCodeType code_type_;          // 실제 파일의 코드 타입
+    size_t code_bytes_;
+    
+    // 쓰기 동시성: writer는 reserved_count_에서 슬롯 범위를 원자적으로 예약하고 병렬로 채움.
+    // 채운 뒤에는 자기 앞 범위가 모두 공개될 때까지 기다렸다가 헤더의 current_count
+    // (committed watermark)를 release로 올림. reader는 acquire로 읽은 만큼만 스캔하므로
+    // 항상 완전히 기록된 prefix만 보게 됨.
+    std::atomic<size_t> reserved_count_;
+    
+    // Reader 모드: 다른 호스트의 writer가 공개한 헤더는 그대로 믿지 않고, 새 범위를
+    // invalidate한 뒤에만 visible_count_를 올림. 검색은 헤더 대신 이 값만 보고 스캔함
+    std::atomic<size_t> visible_count_;
+    // 마지막으로 반영한 publish_epoch (세대 비트는 배타적 tier 락 안에서만 바뀌지만 검색 중에도 읽으므로 atomic)
+    std::atomic<uint64_t> seen_epoch_;
+    
+    // row 단위 삭제 표시 (<file>.tomb), 스캔이 건너뛰고 compaction이 회수
+    TombstoneBitset tombstones_;
+    // Writer 모드 seqlock 공개(삽입 watermark / 삭제)를 직렬화
+    std::mutex publish_mutex_;
+    
+    // 삭제용 ID 역색인 ({id, row}를 id 순으로 정렬, 첫 삭제 때 만들고 이후에는 새 row만 병합)
+    // markDeleted가 매번 CXL의 ID 배열 전체를 스캔하지 않도록 DRAM에 둠
+    std::vector<std::pair<uint64_t, uint64_t>> id_index_;
+    size_t id_index_rows_;            // id_index_에 반영된 row 수
+    std::mutex delete_mutex_;         // markDeleted와 id_index_ 갱신을 직렬화
 
 public:
     AppendOnlyFlatIndex(const std::string& file_path,
                         size_t vector_dim = DEFAULT_VECTOR_DIM,
-                        size_t max_vectors = DEFAULT_MAX_VECTORS);
+                        size_t max_vectors = DEFAULT_MAX_VECTORS,
+                        const FlatIndexOptions& options = FlatIndexOptions());
     ~AppendOnlyFlatIndex();
     
     bool initialize();
     bool insert(const VectorData& vector_data);
-    std::vector<SearchResult> bruteForceSearch(const std::vector<float>& query, int k) const;
+    
+    // 여러 벡터를 하나의 연속 append로 삽입하고 그룹당 한 번만 flush (group commit)
+    // vectors: count × vector_dim_ 연속 배열, ids: count개
+    bool insertBatch(const float* vectors, size_t count, const uint64_t* ids);
+    
+    // 압축 코드가 있으면 코드를 스캔한 뒤 상위 후보를 float32로 rerank
+    // exact면 코드를 쓰지 않고 float32 row를 전부 스캔
+    std::vector<SearchResult> bruteForceSearch(const std::vector<float>& query, int k,
+                                               bool exact = false) const;
+    
+    // 배치 brute-force 검색: 저장된 벡터를 블록 단위로 한 번만 읽으면서 모든 쿼리를 계산
+    std::vector<std::vector<SearchResult>> bruteForceSearchBatch(
+        const std::vector<std::vector<float>>& queries, int k, bool exact = false) const;
+    // queries: num_queries × vector_dim_ 연속 배열
+    std::vector<std::vector<SearchResult>> bruteForceSearchBatch(
+        const float* queries, size_t num_queries, int k, bool exact = false) const;
+    
+    // Reader 모드: writer의 헤더 라인을 invalidate하고 seqlock으로 공개 상태를 읽음
+    // (writer가 공개 중이면 몇 번 재시도한 뒤 false)
+    bool readPublished(FlatPublishedState& state) const;
+    // 지난 반영 이후 writer가 prefix를 제거(compaction)했는지 (이미 보이는 row가 바뀜)
+    bool isPrefixReset(const FlatPublishedState& state) const {
+        return (state.epoch >> 32) != (seenEpoch() >> 32) || state.count < getCurrentCount();
+    }
+    // 새로 공개된 범위만 invalidate하고 visible count를 올림, 새로 보이게 된 row 수 반환
+    // (prefix reset이면 [0, count) 전체를 invalidate, 이때는 동시에 검색이 실행되면 안 됨)
+    // 삭제 표시는 매번 [0, count) 전체를 다시 읽음
+    size_t applyPublished(const FlatPublishedState& state);
+    // 지난 반영 이후 writer가 무언가 공개했는지 (row 수가 같아도 삭제만 공개됐을 수 있음)
+    bool isNewPublish(const FlatPublishedState& state) const { return state.epoch != seenEpoch(); }
+    
+    // ID가 ids인 row들에 삭제 표시 (found[i]: ids[i]가 이 flat에 살아 있었는지), 새로 삭제한 수 반환
+    // 검색과 동시에 호출 가능, discardPrefix와는 동시에 호출하면 안 됨
+    size_t markDeleted(const uint64_t* ids, size_t count, std::vector<bool>& found);
+    bool isDeleted(size_t row) const { return tombstones_.test(row); }
+    // [0, getCurrentCount()) 중 삭제된 row 수
+    size_t getDeletedCount() const { return tombstones_.countRange(0, getCurrentCount()); }
     
     // 상태 조회
+    // 공개된(완전히 기록된) 벡터 개수 (Reader 모드는 invalidate까지 끝난 개수)
     size_t getCurrentCount() const { 
-        return mapped_header_ ? mapped_header_->current_count : 0; 
+        if (!mapped_header_) {
+            return 0;
+        }
+        return options_.sharing == FlatSharingMode::Reader
+             ? visible_count_.load(std::memory_order_acquire)
+             : committedCount().load(std::memory_order_acquire); 
     }
     
     bool isFull() const { 
-        return mapped_header_ && mapped_header_->current_count >= max_capacity_; 
+        return mapped_header_ && reserved_count_.load(std::memory_order_relaxed) >= max_capacity_; 
     }
+    bool isReadOnly() const { return options_.sharing == FlatSharingMode::Reader; }
+    FlatSharingMode getSharingMode() const { return options_.sharing; }
     
     size_t getVectorDim() const { return vector_dim_; }
+    uint64_t getMaxId() const;
+    uint64_t getNextId() const { 
+        return mapped_header_ ? std::atomic_ref<uint64_t>(mapped_header_->next_id).load() : 0; 
+    }
+    
+    // 저장된 (정규화된) 벡터와 ID 배열, [0, getCurrentCount())가 유효
+    const float* getVectorData() const { return mapped_data_; }
+    const uint64_t* getIdData() const { return mapped_ids_; }
+    
+    // 앞쪽 count개 벡터를 제거하고 나머지를 앞으로 당김 (compaction 후 flat 티어 비우기)
+    // 삭제 표시도 같이 당김 (제거된 prefix의 표시는 사라짐)
+    // 동시에 insert/검색이 실행되면 안 됨 (호출 측에서 배타적 접근 보장)
+    bool discardPrefix(size_t count);
     size_t getMaxCapacity() const { return max_capacity_; }
+    FlatCodeType getCodeType() const { return code_type_; }
+    // 스캔 시 row당 읽는 바이트 (float32 스캔이면 dim × 4)
+    size_t getScanBytesPerRow() const {
+        return code_type_ == FlatCodeType::None ? vector_dim_ * sizeof(float)
+             : code_bytes_ + (code_type_ == FlatCodeType::SQ8 ? 2 * sizeof(float) : 0);
+    }
     
     void cleanup();
+
+private:
+    // 헤더의 current_count를 committed watermark로 원자적으로 접근
+    std::atomic_ref<uint64_t> committedCount() const {
+        return std::atomic_ref<uint64_t>(mapped_header_->current_count);
+    }
+    
+    // [first, first + count) 슬롯 예약 (용량 초과 시 false)
+    bool reserveSlots(size_t count, size_t& first);
+    
+    // 정규화되지 않은 기존 파일(flags == 0)의 벡터들을 제자리에서 정규화
+    void migrateToNormalized();
+    
+    // code_type으로 만들 파일의 레이아웃 (None이면 사용 안 함)
+    static FlatIndexLayoutV2 makeLayout(FlatCodeType code_type, size_t vector_dim, size_t max_vectors);
+    static size_t v1FileSize(size_t vector_dim, size_t max_vectors) {
+        return sizeof(FlatIndexHeader) + max_vectors * (vector_dim * sizeof(float) + sizeof(uint64_t));
+    }
+    
+    // 정규화된 row [first, first + count)의 압축 코드 생성
+    void encodeRows(size_t first, size_t count);
+    
+    // 압축 코드 기준 COSINE 거리 근사 (query_sum은 SQ8 bias 보정용 sum(query))
+    float codeDistance(const float* query, float query_sum, size_t row) const {
+        const uint8_t* codes = mapped_codes_ + row * code_bytes_;
+        if (code_type_ == FlatCodeType::FP16) {
+            return 1.0f - distance::dotFp16(query, reinterpret_cast<const uint16_t*>(codes), vector_dim_);
+        }
+        const float* params = &mapped_params_[row * 2];
+        return 1.0f - (params[1] * query_sum + params[0] * distance::dotSq8(query, codes, vector_dim_));
+    }
+    
+    // 스캔 parallel 영역의 스레드 수 (num_threads 절, 호출 스레드별 ICV와 무관하게 예산을 따름)
+    int scanThreads() const {
+        return options_.scan_threads ? static_cast<int>(options_.scan_threads) : omp_get_max_threads();
+    }
+    
+    // 코드 스캔 후보 수
+    size_t rerankCandidates(size_t k) const {
+        return std::max(k, k * options_.rerank_factor);
+    }
+    
+    // row 인덱스 후보(id 필드 = row)를 float32로 다시 계산해서 상위 k개 (id 필드 = 외부 ID)
+    std::vector<SearchResult> rerank(const float* query, TopKSelector& candidates, size_t k) const;
+    
+    // msync는 페이지 정렬된 주소를 요구하므로 범위를 페이지 경계로 확장하여 호출
+    static void syncRange(const void* addr, size_t len, int flags);
+    
+    // 쓴 범위를 내구화 (Writer 모드는 msync 대신 캐시 라인 write-back, famfs DAX에서는 이것이 곧 내구화)
+    void persistRange(const void* addr, size_t len) const;
+    // [first, first + count) row의 모든 영역 (rows, ids, codes, params)을 persist / invalidate
+    void persistRows(size_t first, size_t count) const;
+    void invalidateRows(size_t first, size_t count) const;
+    
+    // Writer 모드 seqlock: publish_epoch를 홀수로 올리고 header에 쓴 뒤 짝수로 닫음
+    // (한 번에 한 스레드만 호출, insertBatch에서는 watermark 순서 대기 뒤라 직렬화됨)
+    // prefix_reset이면 row를 옮기기 전에 세대를 올리고 헤더를 write-back (reader 스캔이 이동을 감지)
+    void beginPublish(bool prefix_reset = false);
+    void endPublish();
+    
+    // [id_index_rows_, rows)를 id_index_에 병합 (delete_mutex_ 보유 상태에서 호출)
+    void updateIdIndex(size_t rows);
+    
+    uint64_t seenEpoch() const { return seen_epoch_.load(std::memory_order_acquire); }
+    // Reader 모드 스캔 전후 확인: writer가 prefix 이동을 시작한 세대를 아직 반영하지 않았으면 false
+    // (이미 보이는 row가 옮겨지는 중이거나 옮겨졌으므로 스캔 결과를 쓰면 안 됨)
+    bool readerViewCurrent() const;
+    
+    // 실제 스캔 (bruteForceSearch / bruteForceSearchBatch가 Reader 모드 확인으로 감쌈)
+    std::vector<SearchResult> scanRows(const std::vector<float>& query, int k, bool exact) const;
+    std::vector<std::vector<SearchResult>> scanRowsBatch(const float* queries, size_t num_queries,
+                                                         int k, bool exact) const;
 };
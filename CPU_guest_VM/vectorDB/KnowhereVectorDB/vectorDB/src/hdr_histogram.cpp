@@ -0,0 +1,147 @@
+#include "hdr_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+HdrHistogram::HdrHistogram(uint64_t highest_trackable)
+    : highest_trackable_(std::max<uint64_t>(highest_trackable, SUB_BUCKET_MASK)) {
+    // 가장 큰 sub-bucket 값이 highest_trackable을 덮을 때까지 bucket 추가
+    bucket_count_ = 1;
+    uint64_t largest = SUB_BUCKET_MASK;
+    while (largest < highest_trackable_) {
+        largest = (largest << 1) | 1;
+        ++bucket_count_;
+    }
+    counts_.assign(static_cast<size_t>(bucket_count_ + 1) * SUB_BUCKET_HALF_COUNT, 0);
+}
+
+size_t HdrHistogram::indexOf(uint64_t value) const {
+    int pow2_ceiling = 64 - __builtin_clzll(value | SUB_BUCKET_MASK);
+    int bucket_index = pow2_ceiling - (SUB_BUCKET_HALF_MAGNITUDE + 1);
+    uint64_t sub_bucket_index = value >> bucket_index;
+    return (static_cast<size_t>(bucket_index + 1) << SUB_BUCKET_HALF_MAGNITUDE)
+           + (sub_bucket_index - SUB_BUCKET_HALF_COUNT);
+}
+
+uint64_t HdrHistogram::valueAt(size_t index) const {
+    int bucket_index = static_cast<int>(index >> SUB_BUCKET_HALF_MAGNITUDE) - 1;
+    uint64_t sub_bucket_index = (index & (SUB_BUCKET_HALF_COUNT - 1)) + SUB_BUCKET_HALF_COUNT;
+    if (bucket_index < 0) {
+        sub_bucket_index -= SUB_BUCKET_HALF_COUNT;
+        bucket_index = 0;
+    }
+    return sub_bucket_index << bucket_index;
+}
+
+uint64_t HdrHistogram::highestEquivalentValue(size_t index) const {
+    int bucket_index = std::max(0, static_cast<int>(index >> SUB_BUCKET_HALF_MAGNITUDE) - 1);
+    return valueAt(index) + (1ULL << bucket_index) - 1;
+}
+
+void HdrHistogram::record(uint64_t value, uint64_t count) {
+    value = std::min(value, highest_trackable_);
+    counts_[indexOf(value)] += count;
+    total_count_ += count;
+    min_value_ = std::min(min_value_, value);
+    max_value_ = std::max(max_value_, value);
+    sum_ += static_cast<double>(value) * count;
+    sum_sq_ += static_cast<double>(value) * value * count;
+}
+
+void HdrHistogram::add(const HdrHistogram& other) {
+    // 범위가 다르면 값 단위로 다시 기록
+    if (other.counts_.size() != counts_.size()) {
+        for (size_t i = 0; i < other.counts_.size(); ++i) {
+            if (other.counts_[i]) {
+                record(other.valueAt(i), other.counts_[i]);
+            }
+        }
+        return;
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    min_value_ = std::min(min_value_, other.min_value_);
+    max_value_ = std::max(max_value_, other.max_value_);
+    sum_ += other.sum_;
+    sum_sq_ += other.sum_sq_;
+}
+
+void HdrHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_count_ = 0;
+    min_value_ = UINT64_MAX;
+    max_value_ = 0;
+    sum_ = 0.0;
+    sum_sq_ = 0.0;
+}
+
+double HdrHistogram::stddev() const {
+    if (total_count_ == 0) {
+        return 0.0;
+    }
+    double m = mean();
+    return std::sqrt(std::max(0.0, sum_sq_ / total_count_ - m * m));
+}
+
+uint64_t HdrHistogram::valueAtPercentile(double percentile) const {
+    if (total_count_ == 0) {
+        return 0;
+    }
+    double clamped = std::clamp(percentile, 0.0, 100.0);
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * total_count_)));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        cumulative += counts_[i];
+        if (cumulative >= target) {
+            return std::min(highestEquivalentValue(i), max_value_);
+        }
+    }
+    return max_value_;
+}
+
+void HdrHistogram::writePercentiles(std::ostream& out, double value_scale, int ticks_per_half_distance) const {
+    char line[160];
+    out << "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+    
+    // 0%부터 시작해서 남은 구간을 반씩 줄여 가며 ticks_per_half_distance개씩 보고
+    // (HdrHistogram outputPercentileDistribution과 같은 간격)
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    double percentile = 0.0;
+    while (total_count_ > 0) {
+        double target = percentile / 100.0 * total_count_;
+        while (index < counts_.size() && (cumulative == 0 || static_cast<double>(cumulative) < target)) {
+            cumulative += counts_[index++];
+        }
+        uint64_t value = std::min(highestEquivalentValue(index ? index - 1 : 0), max_value_);
+        double reported = static_cast<double>(cumulative) / total_count_;
+        if (reported >= 1.0) {
+            std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu\n",
+                          value / value_scale, 1.0, static_cast<unsigned long long>(cumulative));
+            out << line;
+            break;
+        }
+        std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu %14.2f\n",
+                      value / value_scale, reported, static_cast<unsigned long long>(cumulative),
+                      1.0 / (1.0 - reported));
+        out << line;
+        
+        double remaining = 100.0 - percentile;
+        double half_distance = std::pow(2.0, std::floor(std::log2(100.0 / remaining)) + 1);
+        percentile += 100.0 / (half_distance * ticks_per_half_distance);
+        // reported가 이미 다음 보고 지점을 지났으면 건너뜀
+        percentile = std::max(percentile, std::min(100.0, reported * 100.0 + 1e-9));
+    }
+    
+    std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n",
+                  mean() / value_scale, stddev() / value_scale);
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Max     = %12.3f, Total count    = %12llu]\n",
+                  max_value_ / value_scale, static_cast<unsigned long long>(total_count_));
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Buckets = %12d, SubBuckets     = %12llu]\n",
+                  bucket_count_, static_cast<unsigned long long>(SUB_BUCKET_MASK + 1));
+    out << line;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <ostream>
+
+// HdrHistogram 방식의 log-linear 히스토그램 (유효숫자 3자리, 정수 값)
+// - 2^k 구간마다 1024개의 선형 sub-bucket이라 모든 값이 상대오차 0.1% 이내로 기록됨
+// - 단일 스레드용: 스레드마다 하나씩 두고 add()로 합침
+// - writePercentiles()는 HdrHistogram .hgrm 형식 (HdrHistogram 플로터에서 바로 읽힘)
+class HdrHistogram {
+private:
+    static constexpr int SUB_BUCKET_HALF_MAGNITUDE = 10;
+    static constexpr uint64_t SUB_BUCKET_HALF_COUNT = 1ULL << SUB_BUCKET_HALF_MAGNITUDE;  // 1024
+    static constexpr uint64_t SUB_BUCKET_MASK = (SUB_BUCKET_HALF_COUNT << 1) - 1;          // 2047
+    
+    uint64_t highest_trackable_;
+    int bucket_count_;
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t min_value_ = UINT64_MAX;
+    uint64_t max_value_ = 0;
+    double sum_ = 0.0;
+    double sum_sq_ = 0.0;
+    
+    size_t indexOf(uint64_t value) const;
+    uint64_t valueAt(size_t index) const;
+    // index 구간의 가장 큰 값 (percentile 보고 기준)
+    uint64_t highestEquivalentValue(size_t index) const;
+
+public:
+    // [1, highest_trackable] 범위 (넘는 값은 highest_trackable로 기록)
+    explicit HdrHistogram(uint64_t highest_trackable = 60ULL * 1000 * 1000);
+    
+    void record(uint64_t value, uint64_t count = 1);
+    void add(const HdrHistogram& other);
+    void reset();
+    
+    uint64_t count() const { return total_count_; }
+    uint64_t min() const { return total_count_ ? min_value_ : 0; }
+    uint64_t max() const { return max_value_; }
+    double mean() const { return total_count_ ? sum_ / total_count_ : 0.0; }
+    double stddev() const;
+    // percentile: 0~100
+    uint64_t valueAtPercentile(double percentile) const;
+    
+    // .hgrm percentile 분포 (value_scale로 나눈 단위로 출력, 예: us → ms면 1000)
+    void writePercentiles(std::ostream& out, double value_scale = 1.0, int ticks_per_half_distance = 5) const;
+};
@@ -0,0 +1,163 @@
+#include "hnsw_builder.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+HNSWBuilder::HNSWBuilder(const HNSWBuildParams& params)
+    : params_(params), added_count_(0) {
+    config_[knowhere::meta::DIM] = params_.dim;
+    config_[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
+    config_[knowhere::indexparam::HNSW_M] = params_.m;
+    config_[knowhere::indexparam::EFCONSTRUCTION] = params_.ef_construction;
+    config_[knowhere::indexparam::EF] = params_.ef;
+    config_[knowhere::meta::TOPK] = params_.topk;
+    
+    // mmap 지원 활성화
+    config_["enable_mmap"] = true;
+}
+
+bool HNSWBuilder::train(const float* data, size_t count) {
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>("HNSW", version);
+    if (!index.has_value()) {
+        std::cerr << "HNSW 인덱스 생성 실패" << std::endl;
+        return false;
+    }
+    index_.emplace(std::move(index.value()));
+    
+    auto dataset = knowhere::GenDataSet(static_cast<int64_t>(count), params_.dim, data);
+    auto status = index_->Train(dataset, config_);
+    if (status != knowhere::Status::success) {
+        std::cerr << "인덱스 Train 실패, status: " << static_cast<int>(status) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool HNSWBuilder::add(const float* data, size_t count) {
+    if (!index_) {
+        std::cerr << "HNSW add called before train" << std::endl;
+        return false;
+    }
+    
+    auto dataset = knowhere::GenDataSet(static_cast<int64_t>(count), params_.dim, data);
+    auto status = index_->Add(dataset, config_);
+    if (status != knowhere::Status::success) {
+        std::cerr << "인덱스 Add 실패, status: " << static_cast<int>(status) << std::endl;
+        return false;
+    }
+    added_count_ += static_cast<int64_t>(count);
+    return true;
+}
+
+bool HNSWBuilder::save(const std::string& filename, const HNSWSaveOptions& options) {
+    if (!index_) {
+        std::cerr << "HNSW save called before train" << std::endl;
+        return false;
+    }
+    
+    // 1. BinarySet으로 직렬화 (표준 방식, Knowhere가 메모리 버퍼 하나에 씀)
+    knowhere::BinarySet binary_set;
+    auto status = index_->Serialize(binary_set);
+    if (status != knowhere::Status::success) {
+        std::cerr << "Failed to serialize index" << std::endl;
+        return false;
+    }
+    
+    // 2. HNSW 네이티브 바이너리 데이터 추출
+    auto hnsw_binary = binary_set.GetByName("HNSW");
+    if (!hnsw_binary) {
+        std::cerr << "Failed to get HNSW binary data" << std::endl;
+        return false;
+    }
+    
+    // 직렬화 버퍼는 BinarySet이 따로 소유하므로, 기록 전에 인덱스를 놓아도 됨
+    if (options.release_index) {
+        index_.reset();
+    }
+    
+    // 3. 네이티브 HNSW 포맷으로 파일에 직접 저장 (mmap 호환)
+    int flags = options.mmap_output ? O_RDWR | O_CREAT : O_WRONLY | O_CREAT | O_TRUNC;
+    int fd = open(filename.c_str(), flags, 0644);
+    if (fd == -1) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    const char* data = reinterpret_cast<const char*>(hnsw_binary->data.get());
+    size_t size = static_cast<size_t>(hnsw_binary->size);
+    bool ok = options.mmap_output ? writeMapped(fd, data, size, options, filename)
+                                  : writeSequential(fd, data, size, filename);
+    
+    // 온라인 compaction은 이 파일을 rename으로 공개하므로 내용이 먼저 내구화되어야 함
+    if (ok && fsync(fd) != 0) {
+        std::cerr << "Failed to fsync index file: " << filename << std::endl;
+        ok = false;
+    }
+    close(fd);
+    return ok;
+}
+
+bool HNSWBuilder::writeSequential(int fd, const char* data, size_t size, const std::string& filename) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written <= 0) {
+            std::cerr << "Failed to write index file: " << filename << std::endl;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool HNSWBuilder::writeMapped(int fd, const char* data, size_t size, const HNSWSaveOptions& options,
+                              const std::string& filename) {
+    // 크기가 이미 맞으면 그대로 사용 (famfs 파일은 미리 할당되며 크기를 바꿀 수 없음)
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Failed to stat index file: " << filename << std::endl;
+        return false;
+    }
+    if (static_cast<size_t>(st.st_size) != size && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to size index file to " << size << " bytes (preallocate it with this size): "
+                  << filename << std::endl;
+        return false;
+    }
+    // 블록을 미리 확보해서 매핑에 쓰다가 공간 부족으로 SIGBUS가 나지 않게 함 (지원하지 않는 fs는 무시)
+    int rc = posix_fallocate(fd, 0, static_cast<off_t>(size));
+    if (rc != 0 && rc != EOPNOTSUPP && rc != EINVAL) {
+        std::cerr << "Failed to allocate " << size << " bytes for index file: " << filename << std::endl;
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+    
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to mmap index file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    char* dst = static_cast<char*>(mapped);
+    size_t chunk = std::max<size_t>(options.sync_chunk_bytes, 1) / SYNC_ALIGN * SYNC_ALIGN;
+    chunk = std::max<size_t>(chunk, SYNC_ALIGN);
+    bool ok = true;
+    for (size_t offset = 0; offset < size && ok; offset += chunk) {
+        size_t len = std::min(chunk, size - offset);
+        std::memcpy(dst + offset, data + offset, len);
+        // 내려쓴 구간은 매핑을 놓아서 page cache가 clean 상태로 회수될 수 있게 함
+        ok = msync(dst + offset, len, MS_SYNC) == 0;
+        madvise(dst + offset, len, MADV_DONTNEED);
+    }
+    munmap(mapped, size);
+    if (!ok) {
+        std::cerr << "Failed to msync index file: " << filename << std::endl;
+    }
+    return ok;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <optional>
+
+// Knowhere headers
+#include <knowhere/index/index_factory.h>
+#include <knowhere/dataset.h>
+#include <knowhere/config.h>
+#include <knowhere/comp/index_param.h>
+#include <knowhere/version.h>
+
+// HNSW 빌드 파라미터 (build_vectorDB와 온라인 compaction이 공유)
+struct HNSWBuildParams {
+    int dim = 768;
+    int m = 64;                  // 메모리 사용량 줄이기
+    int ef_construction = 200;   // 적절한 품질 유지
+    int ef = 100;                // 검색 품질
+    int topk = 10;
+};
+
+// 직렬화된 인덱스를 파일에 쓰는 방식
+struct HNSWSaveOptions {
+    // 파일을 직렬화 크기로 미리 할당하고 mmap해서 바로 복사 (famfs처럼 미리 할당된 DAX 파일에 적합)
+    // false면 write()로 순차 기록
+    bool mmap_output = false;
+    // 직렬화가 끝나면 기록 전에 인덱스(그래프 + 벡터)를 해제해서 peak 메모리를 낮춤
+    // (이후 index()/add()는 사용할 수 없음)
+    bool release_index = false;
+    // mmap 기록 시 이만큼 복사할 때마다 msync 후 매핑을 놓아 dirty page가 쌓이지 않게 함
+    size_t sync_chunk_bytes = 256ULL * 1024 * 1024;
+};
+
+// Knowhere HNSW 인덱스 빌드 (Train → Add → 네이티브 HNSW 파일로 저장)
+// 저장된 파일은 HNSWIndexManager가 DeserializeFromFile(enable_mmap)로 바로 로드할 수 있음
+class HNSWBuilder {
+private:
+    static constexpr size_t SYNC_ALIGN = 4096;   // msync 구간 정렬 (페이지)
+    HNSWBuildParams params_;
+    knowhere::Json config_;
+    std::optional<knowhere::Index<knowhere::IndexNode>> index_;
+    int64_t added_count_;
+    
+    static bool writeSequential(int fd, const char* data, size_t size, const std::string& filename);
+    static bool writeMapped(int fd, const char* data, size_t size, const HNSWSaveOptions& options,
+                            const std::string& filename);
+
+public:
+    explicit HNSWBuilder(const HNSWBuildParams& params = HNSWBuildParams());
+    
+    // 인덱스 생성 후 Train (data: count × dim 연속 배열)
+    bool train(const float* data, size_t count);
+    
+    // Train 이후 벡터 추가 (label은 추가된 순서대로 0부터 부여)
+    bool add(const float* data, size_t count);
+    
+    // Serialize 후 "HNSW" 바이너리를 파일에 기록하고 fsync
+    bool save(const std::string& filename, const HNSWSaveOptions& options = HNSWSaveOptions());
+    
+    // HNSW 레코드 기준 벡터당 메모리 추정치 (level0 링크 + 벡터 + label, 상위 레벨은 무시)
+    static size_t estimateBytesPerVector(const HNSWBuildParams& params) {
+        return static_cast<size_t>(params.m) * 2 * sizeof(uint32_t) + sizeof(uint32_t) +
+               static_cast<size_t>(params.dim) * sizeof(float) + sizeof(int64_t);
+    }
+    
+    knowhere::Index<knowhere::IndexNode>& index() { return *index_; }
+    bool hasIndex() const { return index_.has_value(); }
+    const knowhere::Json& getConfig() const { return config_; }
+    int64_t getAddedCount() const { return added_count_; }
+};
@@ -1,9 +1,25 @@
 #include "hnsw_index.h"
-#include "flat_index.h"  // SearchResult 정의를 위해
-#include "knowhere/comp/brute_force.h"  // BruteForce::Search를 위해
+#include "shard_executor.h"
+#include "hnsw_layout.h"
+#include "distance_kernels.h"
+#include <fstream>
+#include <cmath>
+#include <omp.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-HNSWIndexManager::HNSWIndexManager(const std::string& index_dir, size_t vector_dim)
-    : vector_dim_(vector_dim), index_dir_(index_dir) {
+HNSWIndexManager::HNSWIndexManager(const std::string& index_dir, size_t vector_dim,
+                                   const ShardLoadOptions& load_options)
+    : vector_dim_(vector_dim), index_dir_(index_dir), load_options_(load_options),
+      replica_budget_left_(load_options.dram_replica_bytes), executor_(nullptr), executor_queue_count_(1),
+      metrics_(nullptr) {
 }
 
 HNSWIndexManager::~HNSWIndexManager() {
@@ -13,10 +29,12 @@ HNSWIndexManager::~HNSWIndexManager() {
 bool HNSWIndexManager::initialize() {
     std::cout << "=== HNSW Index Manager 초기화 ===" << std::endl;
     
-    // Knowhere 스레드 풀 크기 설정
-    setenv("KNOWHERE_BUILD_THREAD_POOL_SIZE", "64", 1);
-    setenv("KNOWHERE_SEARCH_THREAD_POOL_SIZE", "64", 1);
-    std::cout << "Knowhere 스레드 풀 크기를 64로 설정했습니다." << std::endl;
+    // Knowhere 스레드 풀 크기 설정 (스레드 예산이 있으면 검색 코어 수)
+    std::string pool_size = std::to_string(load_options_.compute_threads ? load_options_.compute_threads
+                                                                         : DEFAULT_KNOWHERE_POOL_SIZE);
+    setenv("KNOWHERE_BUILD_THREAD_POOL_SIZE", pool_size.c_str(), 1);
+    setenv("KNOWHERE_SEARCH_THREAD_POOL_SIZE", pool_size.c_str(), 1);
+    std::cout << "Knowhere 스레드 풀 크기를 " << pool_size << "로 설정했습니다." << std::endl;
     
     // 인덱스 로드
     if (!loadIndices()) {
@@ -44,7 +62,7 @@ bool HNSWIndexManager::loadIndices() {
     for (const auto& entry : std::filesystem::directory_iterator(index_dir_)) {
         if (entry.is_regular_file()) {
             std::string filename = entry.path().filename().string();
-            if (filename.find("hnsw_index_") == 0 && filename.find(".bin") != std::string::npos) {
+            if (filename.starts_with("hnsw_index_") && filename.ends_with(".bin")) {
                 index_files.push_back(entry.path().string());
             }
         }
@@ -63,71 +81,497 @@ bool HNSWIndexManager::loadIndices() {
         std::cout << "  " << file << std::endl;
     }
     
+    // 샤드 필터: 오프셋 ID는 건너뛴 샤드까지 포함한 전체 순서로 계산해야 백엔드 간 ID가 겹치지 않음
+    std::vector<int> beg_ids;
+    if (load_options_.shard_filter_count > 1) {
+        std::vector<std::string> selected;
+        int beg_id = 0;
+        for (size_t pos = 0; pos < index_files.size(); ++pos) {
+            bool has_id_map = std::filesystem::exists(std::filesystem::path(index_files[pos]).replace_extension(".ids"));
+            if (pos % load_options_.shard_filter_count == load_options_.shard_filter_index) {
+                selected.push_back(index_files[pos]);
+                beg_ids.push_back(has_id_map ? -1 : beg_id);
+            }
+            if (!has_id_map) {
+                size_t element_count = 0;
+                if (!readHNSWElementCount(index_files[pos], element_count)) {
+                    std::cerr << "Cannot read HNSW header for offset IDs: " << index_files[pos] << std::endl;
+                    return false;
+                }
+                beg_id += static_cast<int>(element_count);
+            }
+        }
+        std::cout << "Shard filter " << load_options_.shard_filter_index << "/" << load_options_.shard_filter_count
+                  << ": loading " << selected.size() << " of " << index_files.size() << " shards" << std::endl;
+        index_files = std::move(selected);
+        if (index_files.empty()) {
+            std::cerr << "Shard filter selects no shards" << std::endl;
+            return false;
+        }
+    }
+    
     // 각 인덱스 파일을 로드
     indices_.clear();
     index_paths_.clear();
     index_beg_ids_.clear();
+    index_id_maps_.clear();
+    index_tombstones_.clear();
+    index_id_map_contiguous_.clear();
+    index_reverse_ids_.clear();
+    index_routings_.clear();
+    index_load_stats_.clear();
     
-    int beg_id = 0;
-    for (const auto& index_path : index_files) {
-        std::cout << "\nLoading HNSW index: " << index_path << std::endl;
-        
-        // 인덱스 생성
-        auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
-        auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>("HNSW", version);
-        
-        if (!index.has_value()) {
-            std::cerr << "Failed to create HNSW index instance for " << index_path << std::endl;
+    // 샤드들을 병렬로 역직렬화 + 워밍업 (샤드 간 의존성 없음, famfs/CXL 대역폭을 동시에 사용)
+    size_t num_threads = load_options_.load_threads;
+    if (num_threads == 0 || num_threads > index_files.size()) {
+        num_threads = index_files.size();
+    }
+    std::cout << "Loading " << index_files.size() << " shards with " << num_threads
+              << " threads (warmup: " << shardWarmupName(load_options_.warmup)
+              << ", engine: " << shardEngineName(load_options_.engine) << ")" << std::endl;
+    
+    auto load_start = std::chrono::steady_clock::now();
+    std::vector<std::optional<LoadedHNSWIndex>> loaded(index_files.size());
+    std::atomic<size_t> next_file{0};
+    std::vector<std::thread> loaders;
+    for (size_t t = 0; t < num_threads; ++t) {
+        loaders.emplace_back([this, &index_files, &loaded, &next_file]() {
+            for (size_t i = next_file.fetch_add(1); i < index_files.size(); i = next_file.fetch_add(1)) {
+                loaded[i] = loadIndex(index_files[i]);
+            }
+        });
+    }
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    
+    std::vector<LoadedHNSWIndex*> shards;
+    for (size_t i = 0; i < index_files.size(); ++i) {
+        if (!loaded[i]) {
+            std::cerr << "Failed to load HNSW shard: " << index_files[i] << std::endl;
             return false;
         }
-        
-        // config 설정
-        knowhere::Json config;
-        config[knowhere::meta::DIM] = vector_dim_;
-        config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
-        config["enable_mmap"] = true;
-        
-        // DeserializeFromFile로 로드
-        auto status = index.value().DeserializeFromFile(index_path, config);
-        if (status != knowhere::Status::success) {
-            std::cerr << "Failed to deserialize HNSW index from file: " << index_path 
-                      << ", status: " << static_cast<int>(status) << std::endl;
+        shards.push_back(&*loaded[i]);
+    }
+    replicateHotRegions(shards);
+    
+    // 오프셋 ID가 파일명 순서로 결정되도록 정렬된 순서대로 추가
+    for (size_t i = 0; i < index_files.size(); ++i) {
+        if (!beg_ids.empty()) {
+            loaded[i]->beg_id = beg_ids[i];
+        }
+        addIndex(std::move(*loaded[i]));
+    }
+    
+    auto load_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - load_start);
+    std::cout << "\nAll HNSW indices loaded successfully (" << indices_.size() << " indices, "
+              << load_elapsed.count() << "ms)" << std::endl;
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        const auto& stats = index_load_stats_[i];
+        std::cout << "  [" << i << "] " << std::filesystem::path(index_paths_[i]).filename().string()
+                  << ": load " << static_cast<int64_t>(stats.load_ms) << "ms, warmup "
+                  << static_cast<int64_t>(stats.warmup_ms) << "ms, file "
+                  << stats.file_bytes / 1024 / 1024 << "MB, resident "
+                  << residentBytes(stats.mapping) / 1024 / 1024 << "MB";
+        if (stats.replica.replicated_bytes > 0) {
+            std::cout << ", DRAM replica " << stats.replica.replicated_bytes / 1024 / 1024 << "MB ("
+                      << stats.replica.runs << " runs, " << static_cast<int64_t>(stats.replica_ms) << "ms)";
+        }
+        if (index_routings_[i]) {
+            std::cout << ", IVF routing " << stats.routing_bytes / 1024 / 1024 << "MB ("
+                      << index_routings_[i]->listCount() << " lists, " << static_cast<int64_t>(stats.routing_ms) << "ms)";
+        }
+        std::cout << std::endl;
+    }
+    return true;
+}
+
+void HNSWIndexManager::replicateHotRegions(const std::vector<LoadedHNSWIndex*>& shards) {
+    if (load_options_.dram_replica_bytes == 0 || shards.empty()) {
+        return;
+    }
+    // IVF 라우팅은 그래프를 타지 않으므로 상위 레이어 복제가 쓰이지 않음 (DRAM은 라우팅 인덱스가 씀)
+    if (load_options_.engine == ShardEngine::IVFSQ8) {
+        std::cout << "Skipping DRAM replica of HNSW regions (engine: ivf_sq8)" << std::endl;
+        return;
+    }
+    
+    std::vector<HNSWReplicaPlan> plans;
+    plans.reserve(shards.size());
+    for (auto* shard : shards) {
+        plans.emplace_back(shard->stats.mapping, vector_dim_);
+        if (!plans.back().valid()) {
+            std::cerr << "Cannot parse HNSW layout, skipping DRAM replica: " << shard->path << std::endl;
+        }
+    }
+    
+    // tier 단위로 샤드 간에 균등 분배, 한 샤드가 다 쓰지 못한 몫은 다음 샤드로 이월
+    size_t budget = replica_budget_left_.load();
+    auto distribute = [&plans, &budget](size_t (HNSWReplicaPlan::*select)(size_t)) {
+        for (size_t i = 0; i < plans.size(); ++i) {
+            size_t share = budget / (plans.size() - i);
+            budget -= (plans[i].*select)(share);
+        }
+    };
+    distribute(&HNSWReplicaPlan::selectUpperLayers);
+    distribute(&HNSWReplicaPlan::selectUpperNodeRecords);
+    if (load_options_.replicate_level0_neighbors) {
+        distribute(&HNSWReplicaPlan::selectLevel0Neighbors);
+    }
+    
+    // run 병합 gap도 같은 예산에서 차감
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (!plans[i].valid()) {
+            continue;
+        }
+        auto replica_start = std::chrono::steady_clock::now();
+        if (!plans[i].apply(budget)) {
+            std::cerr << "DRAM replica partially applied for " << shards[i]->path << std::endl;
+        }
+        shards[i]->stats.replica_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - replica_start).count();
+        shards[i]->stats.replica = plans[i].stats();
+    }
+    replica_budget_left_.store(budget);
+}
+
+size_t HNSWIndexManager::releaseReplicas() {
+    size_t released = 0;
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        const auto& stats = index_load_stats_[i];
+        if (stats.replica.runs == 0 || stats.mapping.addr == nullptr) {
+            continue;
+        }
+        // 샤드 구간 전체를 파일로 다시 매핑 (복제 run이 덮은 익명 페이지는 이때 해제됨)
+        int fd = ::open(index_paths_[i].c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "Cannot reopen " << index_paths_[i] << " to release its DRAM replica: "
+                      << std::strerror(errno) << std::endl;
+            continue;
+        }
+        void* remapped = mmap(stats.mapping.addr, stats.mapping.length, stats.mapping.prot ? stats.mapping.prot : PROT_READ,
+                              MAP_SHARED | MAP_FIXED, fd, 0);
+        ::close(fd);
+        if (remapped == MAP_FAILED) {
+            std::cerr << "Failed to release DRAM replica of " << index_paths_[i] << ": "
+                      << std::strerror(errno) << std::endl;
+            continue;
+        }
+        released += stats.replica.replicated_bytes;
+    }
+    replica_budget_left_.store(0);
+    return released;
+}
+
+std::optional<LoadedHNSWIndex> HNSWIndexManager::loadIndex(const std::string& index_path) const {
+    std::cout << "\nLoading HNSW index: " << index_path << std::endl;
+    
+    // 인덱스 생성
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>("HNSW", version);
+    
+    if (!index.has_value()) {
+        std::cerr << "Failed to create HNSW index instance for " << index_path << std::endl;
+        return std::nullopt;
+    }
+    
+    // config 설정
+    knowhere::Json config;
+    config[knowhere::meta::DIM] = vector_dim_;
+    config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
+    config["enable_mmap"] = true;
+    
+    ShardLoadStats stats;
+    std::error_code ec;
+    stats.file_bytes = std::filesystem::file_size(index_path, ec);
+    auto load_start = std::chrono::steady_clock::now();
+    
+    // DeserializeFromFile로 로드
+    auto status = index.value().DeserializeFromFile(index_path, config);
+    if (status != knowhere::Status::success) {
+        std::cerr << "Failed to deserialize HNSW index from file: " << index_path 
+                  << ", status: " << static_cast<int>(status) << std::endl;
+        return std::nullopt;
+    }
+    
+    int64_t count = index.value().Count();
+    std::cout << "Index loaded successfully, vector count: " << count << std::endl;
+    
+    // ID 매핑 사이드카 (hnsw_index_xxx.bin → hnsw_index_xxx.ids, label 순서의 uint64 배열)
+    std::vector<uint64_t> id_map;
+    std::filesystem::path ids_path = std::filesystem::path(index_path).replace_extension(".ids");
+    if (std::filesystem::exists(ids_path)) {
+        std::ifstream ifs(ids_path, std::ios::binary);
+        id_map.resize(static_cast<size_t>(count));
+        ifs.read(reinterpret_cast<char*>(id_map.data()), count * sizeof(uint64_t));
+        if (!ifs) {
+            std::cerr << "ID map " << ids_path << " does not match index count " << count << std::endl;
+            return std::nullopt;
+        }
+        std::cout << "Using ID map: " << ids_path << std::endl;
+    }
+    
+    // 워밍업 (Knowhere가 매핑한 영역에 직접 적용해야 해당 매핑의 page table이 채워짐)
+    double deserialize_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - load_start).count();
+    if (!findFileMapping(index_path, stats.mapping)) {
+        if (load_options_.warmup != ShardWarmup::None) {
+            std::cerr << "Shard is not file-mapped, skipping warmup: " << index_path << std::endl;
+        }
+    } else if (load_options_.warmup != ShardWarmup::None) {
+        auto warmup_start = std::chrono::steady_clock::now();
+        stats.warmed_bytes = warmMapping(stats.mapping, load_options_.warmup, vector_dim_);
+        stats.warmup_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - warmup_start).count();
+    }
+    auto dummy_start = std::chrono::steady_clock::now();
+    
+    // 더미 검색으로 내부 구조 초기화
+    std::vector<float> dummy_query(vector_dim_, 0.0f);
+    auto dummy_dataset = knowhere::GenDataSet(1, vector_dim_, dummy_query.data());
+    
+    knowhere::Json search_config;
+    search_config[knowhere::meta::DIM] = vector_dim_;
+    search_config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
+    search_config[knowhere::indexparam::EF] = 200;
+    search_config[knowhere::meta::TOPK] = 10;
+
+    auto dummy_result = index.value().Search(dummy_dataset, search_config, knowhere::BitsetView());
+    
+    if (dummy_result.has_value()) {
+        std::cout << "Dummy search successful for " << index_path << std::endl;
+    } else {
+        std::cout << "Dummy search failed for " << index_path << std::endl;
+    }
+    
+    stats.load_ms = deserialize_ms + std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - dummy_start).count();
+    
+    std::unique_ptr<IVFRoutingIndex> routing;
+    if (load_options_.engine == ShardEngine::IVFSQ8) {
+        routing = prepareRouting(index_path, stats);
+    }
+    
+    LoadedHNSWIndex loaded{std::move(index.value()), index_path, std::move(id_map), stats};
+    loaded.routing = std::move(routing);
+    
+    // 삭제 표시 (hnsw_index_xxx.bin → hnsw_index_xxx.tomb, 없으면 생성)
+    std::filesystem::path tomb_path = std::filesystem::path(index_path).replace_extension(".tomb");
+    loaded.tombstones = std::make_unique<TombstoneBitset>();
+    if (!loaded.tombstones->open(tomb_path.string(), static_cast<size_t>(count))) {
+        std::cerr << "Deletes disabled for " << index_path << " (cannot open " << tomb_path << ")" << std::endl;
+        loaded.tombstones.reset();
+    } else if (loaded.tombstones->count() > 0) {
+        std::cout << "Tombstones: " << loaded.tombstones->count() << " deleted vectors" << std::endl;
+    }
+    return loaded;
+}
+
+bool HNSWIndexManager::reserveRoutingBudget(size_t bytes) const {
+    if (load_options_.dram_replica_bytes == 0) {
+        return true;
+    }
+    size_t left = replica_budget_left_.load();
+    do {
+        if (left < bytes) {
             return false;
         }
-        
-        int64_t count = index.value().Count();
-        std::cout << "Index loaded successfully, vector count: " << count << std::endl;
-        
-        // 더미 검색으로 내부 구조 초기화
-        std::vector<float> dummy_query(vector_dim_, 0.0f);
-        auto dummy_dataset = knowhere::GenDataSet(1, vector_dim_, dummy_query.data());
-        
-        knowhere::Json search_config;
-        search_config[knowhere::meta::DIM] = vector_dim_;
-        search_config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
-        search_config[knowhere::indexparam::EF] = 200;
-        search_config[knowhere::meta::TOPK] = 10;
+    } while (!replica_budget_left_.compare_exchange_weak(left, left - bytes));
+    return true;
+}
 
-        auto dummy_result = index.value().Search(dummy_dataset, search_config, knowhere::BitsetView());
-        
-        if (dummy_result.has_value()) {
-            std::cout << "Dummy search successful for " << index_path << std::endl;
-        } else {
-            std::cout << "Dummy search failed for " << index_path << std::endl;
+void HNSWIndexManager::releaseRoutingBudget(size_t bytes) const {
+    if (load_options_.dram_replica_bytes > 0) {
+        replica_budget_left_.fetch_add(bytes);
+    }
+}
+
+std::unique_ptr<IVFRoutingIndex> HNSWIndexManager::prepareRouting(const std::string& index_path,
+                                                                  ShardLoadStats& stats) const {
+    RawVectorView records;
+    if (!makeRawVectorView(stats.mapping, vector_dim_, records)) {
+        std::cerr << "Cannot parse HNSW record layout, searching with HNSW: " << index_path << std::endl;
+        return nullptr;
+    }
+    
+    // 사이드카의 nlist는 옵션과 다를 수 있으므로 최대 nlist 기준으로 잡고, 만든 뒤 실제 크기와의 차이를 돌려줌
+    size_t reserved = IVFRoutingIndex::maxDramBytes(records.count, vector_dim_);
+    if (!reserveRoutingBudget(reserved)) {
+        std::cerr << "IVF routing for " << index_path << " needs up to " << reserved / 1024 / 1024
+                  << "MB, over the remaining DRAM budget, searching with HNSW" << std::endl;
+        return nullptr;
+    }
+    
+    // 샤드 파일이 바뀌면 (재빌드, 재배치) row 순서가 달라지므로 크기와 mtime으로 사이드카를 확인
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(index_path, ec);
+    int64_t mtime_ns = ec ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    std::string ivf_path = std::filesystem::path(index_path).replace_extension(".ivf").string();
+    
+    auto routing_start = std::chrono::steady_clock::now();
+    auto routing = std::make_unique<IVFRoutingIndex>();
+    if (routing->load(ivf_path, records, vector_dim_, stats.file_bytes, mtime_ns)) {
+        std::cout << "Using IVF routing: " << ivf_path << std::endl;
+    } else {
+        std::cout << "Building IVF routing for " << index_path << " (" << records.count << " vectors)" << std::endl;
+        IVFRoutingOptions build_options = load_options_.ivf;
+        if (build_options.build_threads == 0 && load_options_.compute_threads > 0) {
+            build_options.build_threads = load_options_.compute_threads;
         }
-        
-        // 인덱스를 벡터에 추가
-        indices_.push_back(std::move(index.value()));
-        index_paths_.push_back(index_path);
-        index_beg_ids_.push_back(beg_id);
-        
-        beg_id += count;
+        if (!routing->build(records, vector_dim_, build_options)) {
+            std::cerr << "Failed to build IVF routing, searching with HNSW: " << index_path << std::endl;
+            releaseRoutingBudget(reserved);
+            return nullptr;
+        }
+        if (!routing->save(ivf_path, stats.file_bytes, mtime_ns)) {
+            std::cerr << "Cannot write " << ivf_path << ", routing will be rebuilt on next load" << std::endl;
+        }
+    }
+    routing->setSearchOptions(load_options_.ivf.nprobe, load_options_.ivf.rerank_factor);
+    stats.routing_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - routing_start).count();
+    stats.routing_bytes = routing->dramBytes();
+    releaseRoutingBudget(reserved - std::min(reserved, stats.routing_bytes));
+    return routing;
+}
+
+bool parseShardFilter(const std::string& value, size_t& index, size_t& count) {
+    size_t slash = value.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long long i = std::strtoull(value.c_str(), &end, 10);
+    if (end != value.c_str() + slash) {
+        return false;
+    }
+    unsigned long long n = std::strtoull(value.c_str() + slash + 1, &end, 10);
+    if (*end != '\0' || n == 0 || i >= n) {
+        return false;
+    }
+    index = static_cast<size_t>(i);
+    count = static_cast<size_t>(n);
+    return true;
+}
+
+int HNSWIndexManager::nextBegId() const {
+    // 사이드카 ID 매핑이 있는 샤드는 오프셋 ID 공간을 차지하지 않음
+    int beg_id = 0;
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        if (index_id_maps_[i].empty()) {
+            beg_id = index_beg_ids_[i] + static_cast<int>(indices_[i].Count());
+        }
+    }
+    return beg_id;
+}
+
+void HNSWIndexManager::addIndex(LoadedHNSWIndex&& loaded) {
+    int beg_id = loaded.beg_id >= 0 ? loaded.beg_id : nextBegId();
+    indices_.push_back(std::move(loaded.index));
+    index_paths_.push_back(std::move(loaded.path));
+    index_beg_ids_.push_back(beg_id);
+    const auto& id_map = loaded.id_map;
+    bool contiguous = true;
+    for (size_t i = 1; i < id_map.size() && contiguous; ++i) {
+        contiguous = id_map[i] == id_map[0] + i;
+    }
+    index_id_map_contiguous_.push_back(contiguous);
+    index_id_maps_.push_back(std::move(loaded.id_map));
+    index_tombstones_.push_back(std::move(loaded.tombstones));
+    index_reverse_ids_.emplace_back();
+    index_routings_.push_back(std::move(loaded.routing));
+    index_load_stats_.push_back(loaded.stats);
+}
+
+bool HNSWIndexManager::findLabel(size_t index_idx, uint64_t id, int64_t& label) {
+    const auto& id_map = index_id_maps_[index_idx];
+    uint64_t count = static_cast<uint64_t>(indices_[index_idx].Count());
+    if (id_map.empty()) {
+        int64_t offset = static_cast<int64_t>(id) - index_beg_ids_[index_idx];
+        if (offset < 0 || static_cast<uint64_t>(offset) >= count) {
+            return false;
+        }
+        label = offset;
+        return true;
+    }
+    if (index_id_map_contiguous_[index_idx]) {
+        if (id < id_map[0] || id - id_map[0] >= id_map.size()) {
+            return false;
+        }
+        label = static_cast<int64_t>(id - id_map[0]);
+        return true;
     }
     
-    std::cout << "\nAll HNSW indices loaded successfully (" << indices_.size() << " indices)" << std::endl;
+    auto& reverse = index_reverse_ids_[index_idx];
+    if (reverse.empty()) {
+        reverse.resize(id_map.size());
+        for (uint32_t i = 0; i < reverse.size(); ++i) {
+            reverse[i] = i;
+        }
+        std::sort(reverse.begin(), reverse.end(),
+                  [&id_map](uint32_t a, uint32_t b) { return id_map[a] < id_map[b]; });
+    }
+    auto it = std::lower_bound(reverse.begin(), reverse.end(), id,
+                               [&id_map](uint32_t l, uint64_t value) { return id_map[l] < value; });
+    if (it == reverse.end() || id_map[*it] != id) {
+        return false;
+    }
+    label = *it;
     return true;
 }
 
+size_t HNSWIndexManager::markDeleted(const std::vector<uint64_t>& ids, std::vector<bool>& found) {
+    std::lock_guard<std::mutex> lock(delete_mutex_);
+    found.assign(ids.size(), false);
+    // 샤드별로 label을 모은 뒤 샤드당 한 번만 내구화 (bit마다 msync하지 않음)
+    std::vector<std::vector<size_t>> labels(indices_.size());
+    std::vector<std::vector<size_t>> positions(indices_.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        for (size_t idx = 0; idx < indices_.size(); ++idx) {
+            int64_t label = 0;
+            if (!index_tombstones_[idx] || !findLabel(idx, ids[i], label)) {
+                continue;
+            }
+            labels[idx].push_back(static_cast<size_t>(label));
+            positions[idx].push_back(i);
+            break;
+        }
+    }
+    
+    size_t deleted = 0;
+    std::vector<bool> newly_set;
+    for (size_t idx = 0; idx < indices_.size(); ++idx) {
+        if (labels[idx].empty()) {
+            continue;
+        }
+        deleted += index_tombstones_[idx]->setBatch(labels[idx], newly_set);
+        for (size_t j = 0; j < newly_set.size(); ++j) {
+            if (newly_set[j]) {
+                found[positions[idx][j]] = true;
+            }
+        }
+    }
+    return deleted;
+}
+
+bool HNSWIndexManager::refreshSharedTombstones() {
+    bool changed = false;
+    for (auto& tombstones : index_tombstones_) {
+        if (tombstones && tombstones->refreshShared()) {
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+size_t HNSWIndexManager::getDeletedCount() const {
+    size_t total = 0;
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        total += getIndexDeletedCount(i);
+    }
+    return total;
+}
+
 size_t HNSWIndexManager::getTotalVectorCount() const {
     size_t total = 0;
     for (const auto& index : indices_) {
@@ -136,22 +580,72 @@ size_t HNSWIndexManager::getTotalVectorCount() const {
     return total;
 }
 
+void HNSWIndexManager::forEachIndex(const std::function<void(size_t)>& fn) const {
+    auto timed = [this, &fn](size_t i) {
+        auto start = std::chrono::steady_clock::now();
+        fn(i);
+        if (metrics_) {
+            metrics_->shard(i).observeSince(start);
+        }
+    };
+    
+    if (executor_ == nullptr) {
+        for (size_t i = 0; i < indices_.size(); ++i) {
+            timed(i);
+        }
+        return;
+    }
+    
+    // 각 인덱스 작업을 해당 샤드 큐에 넣고 모두 끝날 때까지 대기
+    // (작업이 무엇을 던지든 count_down해야 함: 빠지면 호출 스레드가 영원히 대기하고 latch가 스택에 남음)
+    std::latch done(static_cast<std::ptrdiff_t>(indices_.size()));
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        try {
+            executor_->submit(i % executor_queue_count_, [&timed, &done, i]() {
+                try {
+                    timed(i);
+                } catch (const std::exception& e) {
+                    std::cerr << "HNSW shard " << i << " search failed: " << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "HNSW shard " << i << " search failed with a non-standard exception" << std::endl;
+                }
+                done.count_down();
+            });
+        } catch (...) {
+            // 넣지 못한 작업 몫을 세고, 이미 넣은 작업이 스택의 done/timed를 다 쓸 때까지 기다린 뒤 전달
+            done.count_down(static_cast<std::ptrdiff_t>(indices_.size() - i));
+            done.wait();
+            throw;
+        }
+    }
+    done.wait();
+}
+
 std::vector<SearchResult> HNSWIndexManager::searchSingleIndex(
     size_t index_idx, 
     const std::vector<float>& query, 
-    int k) const {
+    int k,
+    int ef) const {
     
     std::vector<SearchResult> results;
     
+    if (const auto& routing = index_routings_[index_idx]) {
+        results = routing->search(query.data(), static_cast<size_t>(std::max(k, 0)), index_tombstones_[index_idx].get());
+        for (auto& result : results) {
+            result.id = toExternalId(index_idx, static_cast<int64_t>(result.id));
+        }
+        return results;
+    }
+    
     // 스레드별로 독립적인 데이터셋과 설정을 생성
     auto local_query_dataset = knowhere::GenDataSet(1, vector_dim_, query.data());
     knowhere::Json local_config;
     local_config[knowhere::meta::DIM] = vector_dim_;
     local_config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
-    local_config[knowhere::indexparam::EF] = std::max(DEFAULT_EF, k * 2);
+    local_config[knowhere::indexparam::EF] = resolveEf(k, ef);
     local_config[knowhere::meta::TOPK] = static_cast<int64_t>(k);
 
-    auto result = indices_[index_idx].Search(local_query_dataset, local_config, knowhere::BitsetView());
+    auto result = indices_[index_idx].Search(local_query_dataset, local_config, tombstoneView(index_idx));
 
     if (result.has_value()) {
         auto ids = result.value()->GetIds();
@@ -160,10 +654,7 @@ std::vector<SearchResult> HNSWIndexManager::searchSingleIndex(
 
         for (int64_t j = 0; j < num_results; ++j) {
             if (ids[j] >= 0) {
-                results.emplace_back(
-                    static_cast<uint64_t>(ids[j] + index_beg_ids_[index_idx]), 
-                    distances[j]
-                );
+                results.emplace_back(toExternalId(index_idx, ids[j]), distances[j]);
             }
         }
     }
@@ -172,28 +663,23 @@ std::vector<SearchResult> HNSWIndexManager::searchSingleIndex(
 }
 
 std::vector<SearchResult> HNSWIndexManager::search(
-    const std::vector<float>& query, int k) const {
+    const std::vector<float>& query, int k, int ef) const {
     
     if (query.size() != vector_dim_) {
         std::cerr << "Query dimension mismatch in HNSW search" << std::endl;
         return {};
     }
     
-    // 각 HNSW 검색 작업을 비동기적으로 실행
-    std::vector<std::future<std::vector<SearchResult>>> futures;
-    
-    for (size_t i = 0; i < indices_.size(); ++i) {
-        futures.emplace_back(std::async(std::launch::async, 
-            [this, i, &query, k]() {
-                return searchSingleIndex(i, query, k);
-            }
-        ));
-    }
+    // 각 HNSW 검색 작업을 샤드 executor에서 병렬로 실행
+    std::vector<std::vector<SearchResult>> per_index_results(indices_.size());
+    forEachIndex([this, &query, k, ef, &per_index_results](size_t i) {
+        per_index_results[i] = searchSingleIndex(i, query, k, ef);
+    });
     
     // 모든 결과 수집
+    auto merge_start = std::chrono::steady_clock::now();
     std::vector<SearchResult> all_results;
-    for (auto& fut : futures) {
-        auto single_results = fut.get();
+    for (const auto& single_results : per_index_results) {
         all_results.insert(all_results.end(), single_results.begin(), single_results.end());
     }
     
@@ -209,6 +695,9 @@ std::vector<SearchResult> HNSWIndexManager::search(
     if (static_cast<int>(all_results.size()) > k) {
         all_results.resize(k);
     }
+    if (metrics_) {
+        metrics_->shard_merge_us.observeSince(merge_start);
+    }
     
     return all_results;
 }
@@ -216,7 +705,8 @@ std::vector<SearchResult> HNSWIndexManager::search(
 std::vector<std::vector<SearchResult>> HNSWIndexManager::searchBatch(
     const std::vector<std::vector<float>>& queries, 
     int k,
-    std::vector<float>& reused_batch_buffer) const {
+    std::vector<float>& reused_batch_buffer,
+    int ef) const {
     
     if (queries.empty()) {
         return {};
@@ -241,54 +731,65 @@ std::vector<std::vector<SearchResult>> HNSWIndexManager::searchBatch(
         reused_batch_buffer.insert(reused_batch_buffer.end(), query.begin(), query.end());
     }
     
-    // 각 인덱스를 병렬로 검색
-    std::vector<std::future<std::vector<std::vector<SearchResult>>>> futures;
+    return searchBatch(reused_batch_buffer.data(), batch_size, k, ef);
+}
+
+std::vector<std::vector<SearchResult>> HNSWIndexManager::searchBatch(
+    const float* queries, size_t batch_size, int k, int ef) const {
     
-    for (size_t i = 0; i < indices_.size(); ++i) {
-        futures.emplace_back(std::async(std::launch::async, 
-            [this, i, &reused_batch_buffer, batch_size, k]() {
-                std::vector<std::vector<SearchResult>> batch_results(batch_size);
-                
-                // 배치 데이터셋 생성
-                auto batch_dataset = knowhere::GenDataSet(batch_size, vector_dim_, reused_batch_buffer.data());
-                
-                knowhere::Json batch_config;
-                batch_config[knowhere::meta::DIM] = vector_dim_;
-                batch_config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
-                batch_config[knowhere::indexparam::EF] = std::max(DEFAULT_EF, k * 2);
-                batch_config[knowhere::meta::TOPK] = static_cast<int64_t>(k);
-                
-                auto result = indices_[i].Search(batch_dataset, batch_config, knowhere::BitsetView());
-                
-                if (result.has_value()) {
-                    auto rows = result.value()->GetRows();
-                    auto ids = result.value()->GetIds();
-                    auto distances = result.value()->GetDistance();
-                    auto dimension = result.value()->GetDim();
-                    
-                    for (int64_t row = 0; row < rows; ++row) {
-                        for (int64_t j = 0; j < dimension; ++j) {
-                            int64_t idx = row * dimension + j;
-                            batch_results[row].emplace_back(
-                                static_cast<uint64_t>(ids[idx] + index_beg_ids_[i]), 
-                                distances[idx]
-                            );
-                        }
+    if (batch_size == 0) {
+        return {};
+    }
+    
+    // 각 인덱스를 샤드 executor에서 병렬로 검색
+    std::vector<std::vector<std::vector<SearchResult>>> all_index_results(
+        indices_.size(), std::vector<std::vector<SearchResult>>(batch_size));
+    
+    forEachIndex([this, queries, batch_size, k, ef, &all_index_results](size_t i) {
+        auto& batch_results = all_index_results[i];
+        
+        // IVF 라우팅 샤드: 쿼리마다 DRAM 스캔 + CXL rerank
+        if (const auto& routing = index_routings_[i]) {
+            for (size_t row = 0; row < batch_size; ++row) {
+                batch_results[row] = routing->search(&queries[row * vector_dim_], static_cast<size_t>(std::max(k, 0)),
+                                                     index_tombstones_[i].get());
+                for (auto& result : batch_results[row]) {
+                    result.id = toExternalId(i, static_cast<int64_t>(result.id));
+                }
+            }
+            return;
+        }
+        
+        // 배치 데이터셋 생성
+        auto batch_dataset = knowhere::GenDataSet(batch_size, vector_dim_, queries);
+        
+        knowhere::Json batch_config;
+        batch_config[knowhere::meta::DIM] = vector_dim_;
+        batch_config[knowhere::meta::METRIC_TYPE] = knowhere::metric::COSINE;
+        batch_config[knowhere::indexparam::EF] = resolveEf(k, ef);
+        batch_config[knowhere::meta::TOPK] = static_cast<int64_t>(k);
+        
+        auto result = indices_[i].Search(batch_dataset, batch_config, tombstoneView(i));
+        
+        if (result.has_value()) {
+            auto rows = result.value()->GetRows();
+            auto ids = result.value()->GetIds();
+            auto distances = result.value()->GetDistance();
+            auto dimension = result.value()->GetDim();
+            
+            for (int64_t row = 0; row < rows; ++row) {
+                for (int64_t j = 0; j < dimension; ++j) {
+                    int64_t idx = row * dimension + j;
+                    if (ids[idx] >= 0) {
+                        batch_results[row].emplace_back(toExternalId(i, ids[idx]), distances[idx]);
                     }
                 }
-                
-                return batch_results;
             }
-        ));
-    }
-    
-    // 모든 인덱스 결과 수집
-    std::vector<std::vector<std::vector<SearchResult>>> all_index_results;
-    for (auto& fut : futures) {
-        all_index_results.push_back(fut.get());
-    }
+        }
+    });
     
     // 각 쿼리별로 결과 병합
+    auto merge_start = std::chrono::steady_clock::now();
     std::vector<std::vector<SearchResult>> final_results(batch_size);
     for (size_t query_idx = 0; query_idx < batch_size; ++query_idx) {
         std::vector<SearchResult> merged;
@@ -315,6 +816,9 @@ std::vector<std::vector<SearchResult>> HNSWIndexManager::searchBatch(
         
         final_results[query_idx] = std::move(merged);
     }
+    if (metrics_) {
+        metrics_->shard_merge_us.observeSince(merge_start);
+    }
     
     return final_results;
 }
@@ -328,184 +832,202 @@ bool HNSWIndexManager::hasRawData() const {
     return indices_[0].HasRawData(knowhere::metric::COSINE);
 }
 
-std::vector<SearchResult> HNSWIndexManager::exactSearch(
-    const std::vector<float>& query, int k) const {
-    
-    if (query.size() != vector_dim_) {
-        std::cerr << "Query dimension mismatch in exact search" << std::endl;
-        return {};
-    }
-    
-    // Raw data 확인
-    if (!hasRawData()) {
-        std::cerr << "HNSW indices do not contain raw data for exact search" << std::endl;
-        return {};
+bool HNSWIndexManager::getRawVectorView(size_t index_idx, RawVectorView& view) const {
+    return makeRawVectorView(index_load_stats_[index_idx].mapping, vector_dim_, view);
+}
+
+bool HNSWIndexManager::makeRawVectorView(const FileMapping& mapping, size_t vector_dim, RawVectorView& view) {
+    HNSWFileLayout layout;
+    if (mapping.addr == nullptr || !parseHNSWFileLayout(mapping.addr, mapping.length, vector_dim, layout)) {
+        return false;
     }
     
-    std::cout << "Performing HNSW exact search using BruteForce::Search (CHUNK-BASED)..." << std::endl;
+    view.records = mapping.addr + layout.level0_offset;
+    view.count = layout.element_count;
+    view.stride = layout.size_data_per_element;
+    view.vector_offset = layout.offset_data;
+    view.label_offset = layout.label_offset;
     
-    // 청크 크기 설정 - 디버깅: 일단 1개만 시도
-    const int64_t CHUNK_SIZE = 1;
+    // 앞쪽 몇 개 row의 norm으로 저장 시 정규화 여부 판단 (아니면 row마다 norm으로 나눔)
+    view.normalized = true;
+    for (size_t row = 0; row < std::min<size_t>(view.count, 64); ++row) {
+        float norm_sq = distance::normSquared(view.vector(row), vector_dim);
+        if (std::fabs(norm_sq - 1.0f) > 1e-3f) {
+            view.normalized = false;
+            break;
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<SearchResult>> HNSWIndexManager::exactScan(
+    const float* normalized_queries, size_t num_queries, int k,
+    ExactScanCursor& cursor, size_t index_end, size_t max_rows, size_t& scanned_rows) const {
     
-    std::cout << "DEBUG: Testing with chunk size = " << CHUNK_SIZE << std::endl;
+    std::vector<std::vector<SearchResult>> final_results(num_queries);
+    scanned_rows = 0;
+    index_end = std::min(index_end, indices_.size());
+    if (num_queries == 0 || k <= 0) {
+        cursor = {index_end, 0};
+        return final_results;
+    }
+    size_t top_k = static_cast<size_t>(k);
     
-    std::vector<SearchResult> all_results;
-    int global_id_offset = 0;
+    // 이번 구간에 들어가는 샤드별 row 범위, 레이아웃을 모르는 샤드는 느린 경로로
+    std::vector<RawVectorView> views(index_end);
+    struct ScanBlock {
+        uint32_t index_idx;
+        size_t row_begin;
+        size_t row_end;
+    };
+    std::vector<ScanBlock> blocks;
+    std::vector<ScanBlock> fallback_ranges;
+    while (cursor.index_idx < index_end && scanned_rows < max_rows) {
+        size_t idx = cursor.index_idx;
+        bool has_view = getRawVectorView(idx, views[idx]);
+        size_t count = has_view ? views[idx].count : static_cast<size_t>(indices_[idx].Count());
+        size_t row_end = cursor.row + std::min(count - std::min(count, cursor.row), max_rows - scanned_rows);
+        if (!has_view && row_end > cursor.row) {
+            fallback_ranges.push_back({static_cast<uint32_t>(idx), cursor.row, row_end});
+        }
+        for (size_t row = cursor.row; has_view && row < row_end; row += EXACT_SCAN_BLOCK_ROWS) {
+            blocks.push_back({static_cast<uint32_t>(idx), row, std::min(row + EXACT_SCAN_BLOCK_ROWS, row_end)});
+        }
+        scanned_rows += row_end - std::min(row_end, cursor.row);
+        if (row_end >= count) {
+            cursor = {idx + 1, 0};
+        } else {
+            cursor.row = row_end;
+        }
+    }
     
-    // query_dataset 생성 (한 번만)
-    auto query_dataset = knowhere::GenDataSet(1, vector_dim_, query.data());
+    std::vector<TopKSelector> merged(num_queries, TopKSelector(top_k));
     
-    // 각 인덱스에서 청크 단위로 처리
-    for (size_t idx = 0; idx < indices_.size(); ++idx) {
-        std::cout << "Processing index " << idx << "..." << std::endl;
-        int64_t count = indices_[idx].Count();
-        std::cout << "  Total vectors: " << count << std::endl;
+    #pragma omp parallel num_threads(exactThreads())
+    {
+        std::vector<TopKSelector> local(num_queries, TopKSelector(top_k));
         
-        // GetVectorByIds가 작동하는지 먼저 테스트
-        std::cout << "  Testing GetVectorByIds with ID 0..." << std::endl;
-        try {
-            std::vector<int64_t> test_id = {0};
-            auto test_id_dataset = knowhere::GenDataSet(1, 1, test_id.data());
-            std::cout << "    Dataset created, calling GetVectorByIds..." << std::endl;
-            
-            // 실제 호출 - 여기서 크래시 나는지 확인
-            auto test_result = indices_[idx].GetVectorByIds(test_id_dataset);
-            
-            std::cout << "    GetVectorByIds SUCCESS!" << std::endl;
-            if (!test_result.has_value()) {
-                std::cout << "    But returned empty result - raw data might not exist" << std::endl;
-                global_id_offset += count;
-                continue;
-            }
-        } catch (const std::exception& e) {
-            std::cout << "    GetVectorByIds threw exception: " << e.what() << std::endl;
-            global_id_offset += count;
-            continue;
-        } catch (...) {
-            std::cout << "    GetVectorByIds threw unknown exception" << std::endl;
-            global_id_offset += count;
-            continue;
-        }
-        
-        std::cout << "  GetVectorByIds verified working. Proceeding with exact search..." << std::endl;
-        
-        // 청크 개수 계산
-        int64_t num_chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
-        std::cout << "  Processing in " << num_chunks << " chunks of ~" << CHUNK_SIZE << " vectors" << std::endl;
-        
-        // 각 청크 처리
-        for (int64_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx) {
-            int64_t chunk_start = chunk_idx * CHUNK_SIZE;
-            int64_t chunk_end = std::min(chunk_start + CHUNK_SIZE, count);
-            int64_t chunk_size = chunk_end - chunk_start;
-            
-            std::cout << "    Chunk " << (chunk_idx + 1) << "/" << num_chunks 
-                      << ": vectors [" << chunk_start << ", " << chunk_end << ")" << std::endl;
-            
-            std::cout << "      Creating ID list..." << std::endl;
-            
-            // 현재 청크의 ID 생성
-            std::vector<int64_t> chunk_ids(chunk_size);
-            for (int64_t j = 0; j < chunk_size; ++j) {
-                chunk_ids[j] = chunk_start + j;
-            }
-            
-            std::cout << "      Creating ID dataset..." << std::endl;
-            
-            // ID 데이터셋 생성
-            auto id_dataset = knowhere::GenDataSet(chunk_size, 1, chunk_ids.data());
+        // 모든 샤드의 블록을 한 목록으로 나눠 처리 (샤드 크기가 달라도 스레드가 놀지 않음)
+        #pragma omp for schedule(dynamic, 16) nowait
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            const ScanBlock& block = blocks[b];
+            const RawVectorView& view = views[block.index_idx];
             
-            std::cout << "      Calling GetVectorByIds for " << chunk_size << " vectors..." << std::endl;
+            size_t rows = block.row_end - block.row_begin;
             
-            // 벡터 추출
-            auto result = indices_[idx].GetVectorByIds(id_dataset);
-            
-            std::cout << "      GetVectorByIds returned" << std::endl;
-            
-            if (!result.has_value()) {
-                std::cerr << "    ERROR: Failed to extract chunk from index " << idx << std::endl;
-                continue;
-            }
-            
-            std::cout << "      Creating DataSet from extracted data..." << std::endl;
-            
-            // 추출된 데이터로 DataSet 생성
-            auto extracted_dataset = result.value();
-            const float* data_ptr = reinterpret_cast<const float*>(extracted_dataset->GetTensor());
-            
-            std::cout << "      Creating base_dataset..." << std::endl;
-            auto base_dataset = knowhere::GenDataSet(chunk_size, vector_dim_, data_ptr);
-            
-            std::cout << "      Setting up BruteForce config..." << std::endl;
-            
-            // BruteForce 검색 설정
-            knowhere::Json config;
-            config["metric_type"] = "COSINE";
-            config["k"] = k;
-            
-            std::cout << "      Calling BruteForce::Search..." << std::endl;
-            
-            // BruteForce::Search 호출
-            auto search_result = knowhere::BruteForce::Search<knowhere::fp32>(
-                base_dataset, query_dataset, config, knowhere::BitsetView());
-            
-            std::cout << "      BruteForce::Search returned" << std::endl;
-            
-            if (!search_result.has_value()) {
-                std::cerr << "    ERROR: BruteForce search failed for chunk" << std::endl;
-                continue;
+            // 블록 row들의 외부 ID와 1/norm을 먼저 구해 두고, 블록이 캐시에 있는 동안 모든 쿼리를 계산
+            // 삭제된 row는 inv_norm을 음수로 표시해서 건너뜀
+            uint64_t external_ids[EXACT_SCAN_BLOCK_ROWS];
+            float inv_norms[EXACT_SCAN_BLOCK_ROWS];
+            for (size_t r = 0; r < rows; ++r) {
+                size_t row = block.row_begin + r;
+                int64_t label = static_cast<int64_t>(view.label(row));
+                if (isDeletedLabel(block.index_idx, label)) {
+                    inv_norms[r] = -1.0f;
+                    continue;
+                }
+                external_ids[r] = toExternalId(block.index_idx, label);
+                inv_norms[r] = 1.0f;
+                if (!view.normalized) {
+                    float norm_sq = distance::normSquared(view.vector(row), vector_dim_);
+                    inv_norms[r] = norm_sq > 0.0f ? 1.0f / std::sqrt(norm_sq) : 0.0f;
+                }
             }
             
-            // 결과 파싱 및 저장
-            auto result_dataset = search_result.value();
-            auto result_ids = result_dataset->GetIds();
-            auto result_dists = result_dataset->GetDistance();
-            int result_k = result_dataset->GetDim();
-            
-            for (int i = 0; i < result_k; ++i) {
-                if (result_ids[i] != -1) {
-                    // 청크 내 로컬 ID를 글로벌 ID로 변환
-                    int64_t local_id = result_ids[i];
-                    int64_t global_id = global_id_offset + chunk_start + local_id;
-                    
-                    all_results.emplace_back(
-                        static_cast<uint64_t>(global_id),
-                        result_dists[i]
-                    );
+            for (size_t q = 0; q < num_queries; ++q) {
+                const float* query = &normalized_queries[q * vector_dim_];
+                auto& selector = local[q];
+                for (size_t r = 0; r < rows; ++r) {
+                    if (inv_norms[r] < 0.0f) {
+                        continue;
+                    }
+                    float cosine_sim = distance::dotProduct(query, view.vector(block.row_begin + r), vector_dim_);
+                    selector.push(external_ids[r], 1.0f - cosine_sim * inv_norms[r]);
                 }
             }
-            
-            std::cout << "    Chunk completed, found " << result_k << " results" << std::endl;
         }
         
-        global_id_offset += count;
-        std::cout << "  Index " << idx << " completed" << std::endl;
+        #pragma omp critical
+        {
+            for (size_t q = 0; q < num_queries; ++q) {
+                merged[q].merge(local[q]);
+            }
+        }
     }
     
-    std::cout << "Sorting " << all_results.size() << " total results..." << std::endl;
-    
-    // 거리에 따라 정렬
-    std::partial_sort(all_results.begin(), 
-                     all_results.begin() + std::min(k, static_cast<int>(all_results.size())),
-                     all_results.end(),
-                     [](const SearchResult& a, const SearchResult& b) {
-                         return a.distance < b.distance;
-                     });
+    for (const auto& range : fallback_ranges) {
+        std::cerr << "Shard " << index_paths_[range.index_idx] << ": raw layout not recognized, "
+                  << "falling back to GetVectorByIds" << std::endl;
+        exactScanByIds(range.index_idx, range.row_begin, range.row_end, normalized_queries, num_queries, merged);
+    }
     
-    // 상위 k개만 반환
-    if (static_cast<int>(all_results.size()) > k) {
-        all_results.resize(k);
+    for (size_t q = 0; q < num_queries; ++q) {
+        final_results[q] = merged[q].extractSorted();
     }
+    return final_results;
+}
+
+void HNSWIndexManager::exactScanByIds(size_t index_idx, size_t row_begin, size_t row_end,
+                                      const float* normalized_queries, size_t num_queries,
+                                      std::vector<TopKSelector>& selectors) const {
+    int64_t count = static_cast<int64_t>(row_end);
+    std::vector<int64_t> chunk_ids;
     
-    std::cout << "HNSW exact search completed, found " << all_results.size() << " results" << std::endl;
+    for (int64_t chunk_start = static_cast<int64_t>(row_begin); chunk_start < count;
+         chunk_start += EXACT_FALLBACK_CHUNK) {
+        int64_t chunk_size = std::min(EXACT_FALLBACK_CHUNK, count - chunk_start);
+        chunk_ids.resize(chunk_size);
+        for (int64_t j = 0; j < chunk_size; ++j) {
+            chunk_ids[j] = chunk_start + j;
+        }
+        
+        auto id_dataset = knowhere::GenDataSet(chunk_size, 1, chunk_ids.data());
+        auto result = indices_[index_idx].GetVectorByIds(id_dataset);
+        if (!result.has_value()) {
+            std::cerr << "Failed to extract vectors [" << chunk_start << ", " << chunk_start + chunk_size
+                      << ") from index " << index_idx << std::endl;
+            return;
+        }
+        const float* data = reinterpret_cast<const float*>(result.value()->GetTensor());
+        
+        // 청크 안에서는 쿼리별로 병렬 (쿼리마다 selector가 하나라 동기화 없음)
+        #pragma omp parallel for schedule(dynamic) num_threads(exactThreads())
+        for (size_t q = 0; q < num_queries; ++q) {
+            const float* query = &normalized_queries[q * vector_dim_];
+            for (int64_t j = 0; j < chunk_size; ++j) {
+                if (isDeletedLabel(index_idx, chunk_start + j)) {
+                    continue;
+                }
+                const float* vector = data + j * vector_dim_;
+                float norm_sq = distance::normSquared(vector, vector_dim_);
+                float inv_norm = norm_sq > 0.0f ? 1.0f / std::sqrt(norm_sq) : 0.0f;
+                float cosine_sim = distance::dotProduct(query, vector, vector_dim_) * inv_norm;
+                selectors[q].push(toExternalId(index_idx, chunk_start + j), 1.0f - cosine_sim);
+            }
+        }
+    }
+}
+
+std::vector<SearchResult> HNSWIndexManager::exactSearch(
+    const std::vector<float>& query, int k) const {
     
-    return all_results;
+    auto results = exactSearchBatch({query}, k);
+    return results.empty() ? std::vector<SearchResult>() : std::move(results.front());
 }
 
 std::vector<std::vector<SearchResult>> HNSWIndexManager::exactSearchBatch(
     const std::vector<std::vector<float>>& queries, int k) const {
     
+    ExactScanCursor cursor;
+    return exactSearchBatch(queries, k, cursor, indices_.size(), std::numeric_limits<size_t>::max());
+}
+
+std::vector<std::vector<SearchResult>> HNSWIndexManager::exactSearchBatch(
+    const std::vector<std::vector<float>>& queries, int k,
+    ExactScanCursor& cursor, size_t index_end, size_t max_rows) const {
+    
     if (queries.empty()) {
+        cursor = {index_end, 0};
         return {};
     }
     
@@ -515,6 +1037,7 @@ std::vector<std::vector<SearchResult>> HNSWIndexManager::exactSearchBatch(
     for (const auto& query : queries) {
         if (query.size() != vector_dim_) {
             std::cerr << "Query dimension mismatch in exact batch search" << std::endl;
+            cursor = {index_end, 0};
             return std::vector<std::vector<SearchResult>>(batch_size);
         }
     }
@@ -522,20 +1045,25 @@ std::vector<std::vector<SearchResult>> HNSWIndexManager::exactSearchBatch(
     // Raw data 확인
     if (!hasRawData()) {
         std::cerr << "HNSW indices do not contain raw data for exact search" << std::endl;
+        cursor = {index_end, 0};
         return std::vector<std::vector<SearchResult>>(batch_size);
     }
     
-    std::cout << "Performing HNSW exact batch search on " << batch_size << " queries..." << std::endl;
-    
-    // 각 쿼리에 대해 개별적으로 exact search 수행 (병렬)
-    std::vector<std::vector<SearchResult>> batch_results(batch_size);
-    
-    #pragma omp parallel for
-    for (size_t i = 0; i < batch_size; ++i) {
-        batch_results[i] = exactSearch(queries[i], k);
+    // 쿼리들을 정규화하여 연속 버퍼에 배치 (COSINE 거리 = 1 - 내적, flat 티어와 같은 기준)
+    std::vector<float> normalized_queries(batch_size * vector_dim_);
+    for (size_t q = 0; q < batch_size; ++q) {
+        float* dst = &normalized_queries[q * vector_dim_];
+        std::memcpy(dst, queries[q].data(), vector_dim_ * sizeof(float));
+        distance::normalizeInPlace(dst, vector_dim_);
     }
     
-    std::cout << "HNSW exact batch search completed" << std::endl;
+    auto start_time = std::chrono::steady_clock::now();
+    size_t scanned_rows = 0;
+    auto batch_results = exactScan(normalized_queries.data(), batch_size, k, cursor, index_end, max_rows, scanned_rows);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    
+    std::cout << "HNSW exact search: " << batch_size << " queries over " << scanned_rows
+              << " vectors in " << elapsed_ms << " ms" << std::endl;
     
     return batch_results;
 }
@@ -6,8 +6,13 @@
 #include <memory>
 #include <algorithm>
 #include <filesystem>
-#include <future>
 #include <cstdlib>
+#include <functional>
+#include <optional>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <omp.h>
 
 // Knowhere headers
 #include <knowhere/index/index_factory.h>
@@ -16,30 +21,163 @@
 #include <knowhere/comp/index_param.h>
 #include <knowhere/version.h>
 
-// 검색 결과 구조 (flat_index.h와 공유)
-struct SearchResult;
+#include "search_result.h"
+#include "shard_warmup.h"
+#include "hnsw_replica.h"
+#include "metrics.h"
+#include "tombstone_bitset.h"
+#include "ivf_routing.h"
+
+class ShardExecutor;
+
+// 샤드 로드 옵션
+struct ShardLoadOptions {
+    size_t load_threads = 0;                   // 동시에 로드할 샤드 수 (0이면 샤드 수만큼)
+    ShardWarmup warmup = ShardWarmup::None;    // 로드 직후 워밍업 방식
+    // 전체 샤드의 DRAM 예산: hnsw는 hot 구간 복제 (0이면 복제 안 함), ivf_sq8은 라우팅 인덱스 (0이면 제한 없음)
+    size_t dram_replica_bytes = 0;
+    bool replicate_level0_neighbors = false;   // 상위 노드의 level0 이웃 레코드까지 복제
+    // 파일명 순서에서 position % shard_filter_count == shard_filter_index인 샤드만 로드
+    // (coordinator 뒤의 백엔드들이 샤드를 나눠 가짐, 오프셋 ID는 전체 샤드 기준으로 유지)
+    size_t shard_filter_index = 0;
+    size_t shard_filter_count = 1;
+    // Knowhere build/search 스레드 풀과 exact 스캔 OpenMP 스레드 수 (0이면 Knowhere 64, OpenMP 기본값)
+    size_t compute_threads = 0;
+    // 샤드 검색 엔진 (IVFSQ8이면 샤드마다 DRAM 라우팅 인덱스를 만들고 HNSW 그래프는 검색에 쓰지 않음)
+    ShardEngine engine = ShardEngine::HNSW;
+    IVFRoutingOptions ivf;
+};
+
+// "i/n" 형식의 샤드 필터 파싱 (0 <= i < n)
+bool parseShardFilter(const std::string& value, size_t& index, size_t& count);
+
+// 샤드별 로드 통계
+struct ShardLoadStats {
+    double load_ms = 0.0;       // DeserializeFromFile + 더미 검색
+    double warmup_ms = 0.0;
+    size_t file_bytes = 0;
+    size_t warmed_bytes = 0;    // 워밍업으로 접근(advise)한 바이트
+    FileMapping mapping;        // Knowhere가 매핑한 파일 영역 (찾지 못하면 addr == nullptr)
+    double replica_ms = 0.0;
+    ReplicaStats replica;       // DRAM 복제 결과
+    double routing_ms = 0.0;    // IVF 라우팅 인덱스 로드 또는 생성
+    size_t routing_bytes = 0;   // IVF 라우팅 인덱스의 DRAM 크기 (0이면 HNSW로 검색)
+};
+
+// 파일에서 로드했지만 아직 매니저에 추가되지 않은 HNSW 샤드
+struct LoadedHNSWIndex {
+    knowhere::Index<knowhere::IndexNode> index;
+    std::string path;
+    std::vector<uint64_t> id_map;  // .ids 사이드카 (없으면 비어 있음)
+    ShardLoadStats stats;
+    // <shard>.tomb 삭제 표시 (label 단위, 열지 못하면 nullptr이고 이 샤드에서는 삭제 불가)
+    std::unique_ptr<TombstoneBitset> tombstones = nullptr;
+    // --engine ivf_sq8의 DRAM 라우팅 인덱스 (만들지 못하면 nullptr이고 이 샤드는 HNSW로 검색)
+    std::unique_ptr<IVFRoutingIndex> routing = nullptr;
+    int beg_id = -1;               // 오프셋 ID 시작 (-1이면 이미 추가된 샤드들 뒤에 이어서 부여)
+};
+
+// 구간 단위 exact search의 다음 위치 (샤드 index_idx의 row부터)
+struct ExactScanCursor {
+    size_t index_idx = 0;
+    size_t row = 0;
+};
 
 // HNSW 인덱스 관리 클래스
 class HNSWIndexManager {
 private:
     static constexpr size_t DEFAULT_VECTOR_DIM = 768;
     static constexpr int DEFAULT_EF = 400;
+    // exact search: 스레드가 한 번에 가져가는 row 블록 (블록이 L2에 있는 동안 모든 쿼리를 계산)
+    static constexpr size_t EXACT_SCAN_BLOCK_ROWS = 256;
+    // 레이아웃을 파싱하지 못한 샤드는 GetVectorByIds로 이만큼씩 꺼내서 스캔
+    static constexpr int64_t EXACT_FALLBACK_CHUNK = 65536;
+    // 스레드 예산이 없을 때의 Knowhere 스레드 풀 크기
+    static constexpr size_t DEFAULT_KNOWHERE_POOL_SIZE = 64;
+    
+    // mmap된 hnswlib level0 레코드에서 바로 읽는 샤드 raw 벡터
+    using RawVectorView = HNSWRecordView;
     
     std::vector<knowhere::Index<knowhere::IndexNode>> indices_;
     std::vector<std::string> index_paths_;
     std::vector<int> index_beg_ids_;  // 각 인덱스의 시작 ID 오프셋
+    // 인덱스별 label → 외부 ID 매핑 (<shard>.ids 사이드카, 비어 있으면 beg_id 오프셋 사용)
+    // flat 티어를 compaction해서 만든 샤드는 flat에서 부여된 ID를 그대로 유지해야 함
+    std::vector<std::vector<uint64_t>> index_id_maps_;
+    // 인덱스별 삭제 표시 (Knowhere 검색에 BitsetView로 전달, exact 스캔도 건너뜀)
+    std::vector<std::unique_ptr<TombstoneBitset>> index_tombstones_;
+    // ID 매핑이 연속(id_map[i] == id_map[0] + i)이면 외부 ID → label을 바로 계산
+    std::vector<bool> index_id_map_contiguous_;
+    // 재번호 등으로 연속이 아닌 ID 매핑의 역색인 (id_map 값 순으로 정렬한 label, 첫 삭제 때 생성)
+    std::vector<std::vector<uint32_t>> index_reverse_ids_;
+    std::mutex delete_mutex_;
+    // 인덱스별 IVF 라우팅 (nullptr이면 Knowhere HNSW 검색)
+    std::vector<std::unique_ptr<IVFRoutingIndex>> index_routings_;
+    std::vector<ShardLoadStats> index_load_stats_;
     size_t vector_dim_;
     std::string index_dir_;
+    ShardLoadOptions load_options_;
+    // 아직 쓰지 않은 DRAM 예산 (hot 구간 복제 또는 IVF 라우팅, compaction 샤드도 사용)
+    // 라우팅은 const인 loadIndex 안에서 샤드별로 동시에 잡으므로 mutable
+    mutable std::atomic<size_t> replica_budget_left_;
+    ShardExecutor* executor_;         // 샤드 fan-out용 (nullptr이면 호출 스레드에서 순차 실행)
+    size_t executor_queue_count_;     // 샤드 검색에 쓸 executor 큐 개수 (인덱스 i → 큐 i % count)
+    SearchMetrics* metrics_;          // 샤드별 검색 시간 기록 (nullptr이면 기록 안 함)
 
 public:
-    HNSWIndexManager(const std::string& index_dir, size_t vector_dim = DEFAULT_VECTOR_DIM);
+    HNSWIndexManager(const std::string& index_dir, size_t vector_dim = DEFAULT_VECTOR_DIM,
+                     const ShardLoadOptions& load_options = ShardLoadOptions());
     ~HNSWIndexManager();
     
     // 초기화
     bool initialize();
     
-    // 단일 쿼리 검색 (모든 인덱스 검색 후 병합)
-    std::vector<SearchResult> search(const std::vector<float>& query, int k) const;
+    // 샤드 검색을 실행할 executor 지정 (큐 [0, queue_count)를 인덱스들이 나눠 씀)
+    void setExecutor(ShardExecutor* executor, size_t queue_count) {
+        executor_ = executor;
+        executor_queue_count_ = std::max<size_t>(1, queue_count);
+    }
+    
+    void setMetrics(SearchMetrics* metrics) { metrics_ = metrics; }
+    
+    // 샤드 파일 로드 (같은 stem의 .ids 사이드카가 있으면 ID 매핑으로 사용)
+    // 매니저 상태를 바꾸지 않으므로 검색과 동시에 호출 가능
+    std::optional<LoadedHNSWIndex> loadIndex(const std::string& index_path) const;
+    
+    // 남은 DRAM 복제 예산으로 샤드의 hot 구간을 DRAM에 복제 (결과는 loaded.stats.replica)
+    // 교체가 원자적이라 검색과 동시에 호출 가능하지만, 매니저 예산을 쓰므로 한 스레드에서만 호출
+    void replicateHotRegions(const std::vector<LoadedHNSWIndex*>& shards);
+    
+    // DRAM 복제 구간을 샤드 파일 매핑으로 되돌려 복제 메모리를 해제, 해제한 바이트 반환
+    // (reload가 새 세트를 복제하기 전에 이전 세트의 예산을 비우는 용도, 이후 이 매니저에는 복제 안 함)
+    // MAP_FIXED 교체도 원자적이라 검색과 동시에 호출 가능, 이후 해당 구간은 CXL에서 읽음
+    size_t releaseReplicas();
+    
+    // 공개하지 못하고 버리는 샤드의 IVF 라우팅 예산 반환 (loaded.stats.routing_bytes)
+    void releaseRoutingBudget(size_t bytes) const;
+    
+    // 로드된 샤드를 검색 대상에 추가
+    // 검색과 동시에 호출하면 안 됨 (호출 측에서 배타적 접근 보장)
+    void addIndex(LoadedHNSWIndex&& loaded);
+    
+    // 외부 ID들에 삭제 표시 (found[i]: ids[i]가 어느 샤드에 살아 있었는지), 새로 삭제한 수 반환
+    // bit 쓰기만 하므로 검색과 동시에 호출 가능, addIndex와는 동시에 호출하면 안 됨
+    size_t markDeleted(const std::vector<uint64_t>& ids, std::vector<bool>& found);
+    // 공유 flat reader 호스트: 다른 호스트의 writer가 .tomb에 쓴 삭제 표시를 다시 읽음
+    // (바뀐 샤드가 있으면 true, 검색과 동시에 호출 가능, addIndex와는 동시에 호출하면 안 됨)
+    bool refreshSharedTombstones();
+    size_t getDeletedCount() const;
+    size_t getIndexDeletedCount(size_t index_idx) const {
+        return index_tombstones_[index_idx] ? index_tombstones_[index_idx]->count() : 0;
+    }
+    
+    // 인덱스의 label → 외부 ID 매핑 (오프셋 방식 인덱스면 nullptr)
+    const std::vector<uint64_t>* getIdMap(size_t index_idx) const {
+        return index_id_maps_[index_idx].empty() ? nullptr : &index_id_maps_[index_idx];
+    }
+    
+    // 단일 쿼리 검색 (모든 인덱스 검색 후 병합, ef가 0이면 기본값 사용)
+    std::vector<SearchResult> search(const std::vector<float>& query, int k, int ef = 0) const;
     
     // 단일 쿼리 Exact Search (BruteForce)
     std::vector<SearchResult> exactSearch(const std::vector<float>& query, int k) const;
@@ -48,24 +186,95 @@ public:
     std::vector<std::vector<SearchResult>> searchBatch(
         const std::vector<std::vector<float>>& queries, 
         int k,
-        std::vector<float>& reused_batch_buffer) const;
+        std::vector<float>& reused_batch_buffer,
+        int ef = 0) const;
+    
+    // 연속 배열(batch_size × vector_dim) 배치 검색, Knowhere 데이터셋이 queries를 그대로 참조
+    std::vector<std::vector<SearchResult>> searchBatch(
+        const float* queries, size_t batch_size, int k, int ef = 0) const;
     
     // 배치 쿼리 Exact Search
     std::vector<std::vector<SearchResult>> exactSearchBatch(
         const std::vector<std::vector<float>>& queries,
         int k) const;
     
+    // cursor부터 최대 max_rows개 row만 exact 스캔하고 cursor를 다음 위치로 옮김
+    // (호출자가 구간 사이에 tier 락을 풀 수 있도록, 샤드 [0, index_end)를 다 보면 cursor.index_idx == index_end)
+    std::vector<std::vector<SearchResult>> exactSearchBatch(
+        const std::vector<std::vector<float>>& queries,
+        int k,
+        ExactScanCursor& cursor,
+        size_t index_end,
+        size_t max_rows) const;
+    
     // 상태 조회
     size_t getIndexCount() const { return indices_.size(); }
     size_t getTotalVectorCount() const;
+    size_t getIndexVectorCount(size_t index_idx) const { return indices_[index_idx].Count(); }
     const std::vector<std::string>& getIndexPaths() const { return index_paths_; }
+    const ShardLoadStats& getLoadStats(size_t index_idx) const { return index_load_stats_[index_idx]; }
+    const ShardLoadOptions& getLoadOptions() const { return load_options_; }
     
     // Raw 데이터 확인
     bool hasRawData() const;
     
+    // 요청 ef 결정: 0이면 max(DEFAULT_EF, 2k), 아니면 최소 k
+    static int resolveEf(int k, int ef) {
+        return ef > 0 ? std::max(ef, k) : std::max(DEFAULT_EF, k * 2);
+    }
+    
 private:
     bool loadIndices();
+    int nextBegId() const;
+    
+    uint64_t toExternalId(size_t index_idx, int64_t label) const {
+        const auto& id_map = index_id_maps_[index_idx];
+        if (!id_map.empty()) {
+            return id_map[static_cast<size_t>(label)];
+        }
+        return static_cast<uint64_t>(label + index_beg_ids_[index_idx]);
+    }
+    void forEachIndex(const std::function<void(size_t)>& fn) const;
+    
+    // 삭제가 있으면 삭제 표시, 없으면 빈 BitsetView (Knowhere가 필터 경로를 타지 않음)
+    knowhere::BitsetView tombstoneView(size_t index_idx) const {
+        const auto& tombstones = index_tombstones_[index_idx];
+        if (!tombstones || tombstones->count() == 0) {
+            return knowhere::BitsetView();
+        }
+        return knowhere::BitsetView(tombstones->data(), tombstones->capacity(), tombstones->count());
+    }
+    bool isDeletedLabel(size_t index_idx, int64_t label) const {
+        const auto& tombstones = index_tombstones_[index_idx];
+        return tombstones && tombstones->test(static_cast<size_t>(label));
+    }
+    // 외부 ID의 label (이 인덱스에 없으면 false, 역색인이 필요하면 delete_mutex_를 잡고 호출)
+    bool findLabel(size_t index_idx, uint64_t id, int64_t& label);
+    
+    // 샤드 파일 매핑에서 raw 벡터 레코드 위치를 찾음 (레이아웃 파싱 실패 시 false)
+    bool getRawVectorView(size_t index_idx, RawVectorView& view) const;
+    static bool makeRawVectorView(const FileMapping& mapping, size_t vector_dim, RawVectorView& view);
+    // <shard>.ivf 사이드카를 읽거나, 없거나 샤드 파일과 맞지 않으면 새로 만들어 저장
+    // (DRAM 예산에 들어가지 않으면 nullptr이고 이 샤드는 HNSW로 검색)
+    std::unique_ptr<IVFRoutingIndex> prepareRouting(const std::string& index_path, ShardLoadStats& stats) const;
+    // IVF 라우팅용 DRAM 예산을 잡음 (dram_replica_bytes가 0이면 제한 없음)
+    bool reserveRoutingBudget(size_t bytes) const;
+    // 정규화된 쿼리들(num_queries × vector_dim_)로 cursor부터 최대 max_rows개 row를 한 번만 스캔
+    // (샤드 × row 블록을 OpenMP 스레드들이 나눠 처리, 스레드별·쿼리별 top-k 후 병합)
+    std::vector<std::vector<SearchResult>> exactScan(const float* normalized_queries, size_t num_queries, int k,
+                                                     ExactScanCursor& cursor, size_t index_end,
+                                                     size_t max_rows, size_t& scanned_rows) const;
+    // 레이아웃을 모르는 샤드: [row_begin, row_end)를 GetVectorByIds 큰 청크 단위로 스캔
+    void exactScanByIds(size_t index_idx, size_t row_begin, size_t row_end,
+                        const float* normalized_queries, size_t num_queries,
+                        std::vector<TopKSelector>& selectors) const;
+    // exact 스캔 parallel 영역의 스레드 수 (num_threads 절)
+    int exactThreads() const {
+        return load_options_.compute_threads ? static_cast<int>(load_options_.compute_threads)
+                                             : omp_get_max_threads();
+    }
     std::vector<SearchResult> searchSingleIndex(size_t index_idx, 
                                                 const std::vector<float>& query, 
-                                                int k) const;
+                                                int k,
+                                                int ef) const;
 };
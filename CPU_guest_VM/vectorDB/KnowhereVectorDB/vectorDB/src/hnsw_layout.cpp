@@ -0,0 +1,118 @@
+#include "hnsw_layout.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// hnswlib saveIndex()의 고정 헤더 (size_t 6개, int, uint32, size_t 3개, double, size_t)
+constexpr size_t BASE_HEADER_SIZE = 6 * sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint32_t)
+                                  + 3 * sizeof(uint64_t) + sizeof(double) + sizeof(uint64_t);
+// 버전별로 헤더 뒤에 붙을 수 있는 추가 필드 크기 후보
+constexpr size_t EXTRA_HEADER_CANDIDATES[] = {0, 4, 8, 16};
+
+template <typename T>
+T readPOD(const uint8_t* data, size_t& offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+}  // namespace
+
+bool parseHNSWFileLayout(const uint8_t* data, size_t size, size_t dim, HNSWFileLayout& layout) {
+    if (data == nullptr || size < BASE_HEADER_SIZE) {
+        return false;
+    }
+    
+    size_t offset = 0;
+    HNSWFileLayout parsed;
+    size_t offset_level0 = readPOD<uint64_t>(data, offset);
+    parsed.max_elements = readPOD<uint64_t>(data, offset);
+    parsed.element_count = readPOD<uint64_t>(data, offset);
+    parsed.size_data_per_element = readPOD<uint64_t>(data, offset);
+    parsed.label_offset = readPOD<uint64_t>(data, offset);
+    parsed.offset_data = readPOD<uint64_t>(data, offset);
+    parsed.max_level = readPOD<int32_t>(data, offset);
+    parsed.entry_point = readPOD<uint32_t>(data, offset);
+    parsed.max_m = readPOD<uint64_t>(data, offset);
+    parsed.max_m0 = readPOD<uint64_t>(data, offset);
+    readPOD<uint64_t>(data, offset);  // M
+    readPOD<double>(data, offset);    // mult
+    readPOD<uint64_t>(data, offset);  // ef_construction
+    
+    // level0 레코드 = (uint32 link count + maxM0 links) + fp32 벡터 + uint64 label
+    size_t links_level0 = parsed.max_m0 * sizeof(uint32_t) + sizeof(uint32_t);
+    if (offset_level0 != 0 ||
+        parsed.element_count == 0 || parsed.element_count > parsed.max_elements ||
+        parsed.offset_data != links_level0 ||
+        parsed.label_offset != links_level0 + dim * sizeof(float) ||
+        parsed.size_data_per_element != parsed.label_offset + sizeof(uint64_t) ||
+        parsed.entry_point >= parsed.element_count ||
+        parsed.max_level < 0 || parsed.max_level > 64) {
+        return false;
+    }
+    
+    size_t level0_bytes = parsed.element_count * parsed.size_data_per_element;
+    size_t links_per_level = parsed.max_m * sizeof(uint32_t) + sizeof(uint32_t);
+    
+    for (size_t extra : EXTRA_HEADER_CANDIDATES) {
+        size_t header_size = BASE_HEADER_SIZE + extra;
+        size_t pos = header_size + level0_bytes;
+        if (pos > size) {
+            continue;
+        }
+        
+        // 상위 레이어 구간을 끝까지 걸으며 크기 검증
+        std::vector<uint32_t> upper_nodes;
+        std::vector<uint8_t> upper_levels;
+        bool valid = true;
+        for (size_t id = 0; id < parsed.element_count; ++id) {
+            if (pos + sizeof(uint32_t) > size) {
+                valid = false;
+                break;
+            }
+            uint32_t link_list_size = readPOD<uint32_t>(data, pos);
+            if (link_list_size == 0) {
+                continue;
+            }
+            if (link_list_size % links_per_level != 0 ||
+                link_list_size / links_per_level > static_cast<size_t>(parsed.max_level) ||
+                pos + link_list_size > size) {
+                valid = false;
+                break;
+            }
+            upper_nodes.push_back(static_cast<uint32_t>(id));
+            upper_levels.push_back(static_cast<uint8_t>(link_list_size / links_per_level));
+            pos += link_list_size;
+        }
+        
+        if (valid && pos == size) {
+            parsed.header_size = header_size;
+            parsed.level0_offset = header_size;
+            parsed.upper_offset = header_size + level0_bytes;
+            parsed.upper_nodes = std::move(upper_nodes);
+            parsed.upper_levels = std::move(upper_levels);
+            layout = std::move(parsed);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool readHNSWElementCount(const std::string& path, size_t& element_count) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    uint64_t header[3];  // offsetLevel0, max_elements, cur_element_count
+    ssize_t read_bytes = pread(fd, header, sizeof(header), 0);
+    close(fd);
+    if (read_bytes != static_cast<ssize_t>(sizeof(header)) || header[0] != 0 || header[2] > header[1]) {
+        return false;
+    }
+    element_count = header[2];
+    return true;
+}
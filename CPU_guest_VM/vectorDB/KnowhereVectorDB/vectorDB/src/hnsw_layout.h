@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <string>
+
+// Knowhere가 저장하는 네이티브 HNSW(hnswlib) 파일 레이아웃
+//
+// [헤더: offsetLevel0, max_elements, cur_element_count, size_data_per_element,
+//        label_offset, offsetData, maxlevel, enterpoint_node, maxM, maxM0, M, mult, ef_construction (+ 버전별 추가 필드)]
+// [level0 레코드 × cur_element_count: (link count + maxM0 links) + 벡터 + label]
+// [노드별 상위 레이어: uint32 linkListSize + linkListSize 바이트]
+//
+// 헤더는 버전마다 뒤에 필드가 더 붙을 수 있으므로, 상위 레이어 구간을 끝까지 걸어서
+// 파일 크기와 정확히 맞는 헤더 크기를 찾은 경우에만 파싱 성공으로 봄
+struct HNSWFileLayout {
+    size_t header_size = 0;
+    size_t max_elements = 0;
+    size_t element_count = 0;
+    size_t size_data_per_element = 0;   // level0 레코드 크기
+    size_t label_offset = 0;
+    size_t offset_data = 0;
+    int max_level = 0;
+    uint32_t entry_point = 0;
+    size_t max_m = 0;
+    size_t max_m0 = 0;
+    
+    size_t level0_offset = 0;           // level0 레코드 시작 (파일 오프셋)
+    size_t upper_offset = 0;            // 상위 레이어 구간 시작 (파일 오프셋)
+    std::vector<uint32_t> upper_nodes;  // level > 0 인 노드들의 내부 ID
+    std::vector<uint8_t> upper_levels;  // upper_nodes와 같은 순서의 노드 level
+    
+    // 노드 id의 level0 레코드 파일 오프셋
+    size_t level0RecordOffset(uint32_t id) const {
+        return level0_offset + static_cast<size_t>(id) * size_data_per_element;
+    }
+    
+    // level0 링크 목록 크기 (레코드 앞부분: uint32 link count + maxM0 links)
+    size_t level0LinksSize() const { return offset_data; }
+};
+
+// mmap된 level0 레코드에서 바로 읽는 raw 벡터 (row = hnswlib 내부 ID)
+struct HNSWRecordView {
+    const uint8_t* records = nullptr;  // level0 레코드 시작
+    size_t count = 0;
+    size_t stride = 0;                 // 레코드 크기
+    size_t vector_offset = 0;          // 레코드 안 fp32 벡터 위치
+    size_t label_offset = 0;           // 레코드 안 label(uint64) 위치
+    bool normalized = false;           // 저장된 벡터가 이미 unit norm (COSINE)
+    
+    const float* vector(size_t row) const {
+        return reinterpret_cast<const float*>(records + row * stride + vector_offset);
+    }
+    uint64_t label(size_t row) const {
+        uint64_t value;
+        std::memcpy(&value, records + row * stride + label_offset, sizeof(value));
+        return value;
+    }
+};
+
+// data/size: 파일 전체 (mmap된 메모리), dim: 벡터 차원 (fp32 기준으로 레코드 크기 검증)
+// 형식이 맞지 않으면 false
+bool parseHNSWFileLayout(const uint8_t* data, size_t size, size_t dim, HNSWFileLayout& layout);
+
+// 파일 헤더만 읽어서 벡터 수 확인 (샤드를 로드하지 않고 오프셋 ID 공간을 계산할 때)
+bool readHNSWElementCount(const std::string& path, size_t& element_count);
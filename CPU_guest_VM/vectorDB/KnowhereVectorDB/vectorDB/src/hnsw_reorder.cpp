@@ -0,0 +1,353 @@
+#include "hnsw_reorder.h"
+#include "hnsw_layout.h"
+#include "tombstone_bitset.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t PAGE_SIZE = 4096;
+constexpr size_t WRITE_BUFFER_BYTES = 4ULL * 1024 * 1024;
+constexpr size_t LOCALITY_SAMPLES = 100000;
+// 헤더에서 enterpoint_node 위치 (offsetLevel0, max_elements, cur_element_count,
+// size_data_per_element, label_offset, offsetData, maxlevel 다음)
+constexpr size_t ENTRY_POINT_OFFSET = 6 * sizeof(uint64_t) + sizeof(int32_t);
+
+// hnswlib 링크 목록 헤더의 하위 16비트가 링크 수 (상위 비트는 삭제 표시 등 플래그)
+inline size_t linkCount(const uint8_t* list) {
+    uint16_t count;
+    std::memcpy(&count, list, sizeof(count));
+    return count;
+}
+
+inline uint32_t readLink(const uint8_t* list, size_t i) {
+    uint32_t id;
+    std::memcpy(&id, list + sizeof(uint32_t) + i * sizeof(uint32_t), sizeof(id));
+    return id;
+}
+
+inline void writeLink(uint8_t* list, size_t i, uint32_t id) {
+    std::memcpy(list + sizeof(uint32_t) + i * sizeof(uint32_t), &id, sizeof(id));
+}
+
+// level0 이웃 수 (maxM0로 잘라서 손상된 레코드가 범위를 벗어나지 않게 함)
+inline size_t level0Degree(const uint8_t* data, const HNSWFileLayout& layout, uint32_t id) {
+    return std::min(linkCount(data + layout.level0RecordOffset(id)), layout.max_m0);
+}
+
+// 새 순서 (order[new_id] = old_id) 계산
+std::vector<uint32_t> computeOrder(const uint8_t* data, const HNSWFileLayout& layout,
+                                   HNSWReorderMethod method) {
+    size_t n = layout.element_count;
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<bool> visited(n, false);
+    std::vector<uint32_t> neighbors;
+    
+    auto bfsFrom = [&](uint32_t root) {
+        size_t head = order.size();
+        order.push_back(root);
+        visited[root] = true;
+        while (head < order.size()) {
+            uint32_t id = order[head++];
+            const uint8_t* list = data + layout.level0RecordOffset(id);
+            size_t count = level0Degree(data, layout, id);
+            neighbors.clear();
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t neighbor = readLink(list, i);
+                if (neighbor < n && !visited[neighbor]) {
+                    visited[neighbor] = true;
+                    neighbors.push_back(neighbor);
+                }
+            }
+            if (method == HNSWReorderMethod::Rcm) {
+                std::stable_sort(neighbors.begin(), neighbors.end(), [&](uint32_t a, uint32_t b) {
+                    return level0Degree(data, layout, a) < level0Degree(data, layout, b);
+                });
+            }
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    };
+    
+    // entry point에서 닿지 않는 노드(연결이 끊긴 구간)는 남은 노드 중 앞에서부터 다시 BFS
+    bfsFrom(layout.entry_point);
+    for (uint32_t id = 0; id < n; ++id) {
+        if (!visited[id]) {
+            bfsFrom(id);
+        }
+    }
+    if (method == HNSWReorderMethod::Rcm) {
+        std::reverse(order.begin(), order.end());
+    }
+    return order;
+}
+
+// 노드 표본마다 level0 이웃 레코드가 걸친 서로 다른 페이지 수 (position[old_id] = 새 위치)
+double pagesPerHop(const uint8_t* data, const HNSWFileLayout& layout, const std::vector<uint32_t>* position) {
+    size_t n = layout.element_count;
+    size_t step = std::max<size_t>(1, n / LOCALITY_SAMPLES);
+    size_t samples = 0;
+    size_t total_pages = 0;
+    std::vector<size_t> pages;
+    for (size_t id = 0; id < n; id += step) {
+        const uint8_t* list = data + layout.level0RecordOffset(static_cast<uint32_t>(id));
+        size_t count = level0Degree(data, layout, static_cast<uint32_t>(id));
+        pages.clear();
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t neighbor = readLink(list, i);
+            if (neighbor >= n) {
+                continue;
+            }
+            uint32_t slot = position ? (*position)[neighbor] : neighbor;
+            pages.push_back(layout.level0RecordOffset(slot) / PAGE_SIZE);
+        }
+        std::sort(pages.begin(), pages.end());
+        total_pages += std::unique(pages.begin(), pages.end()) - pages.begin();
+        ++samples;
+    }
+    return samples ? static_cast<double>(total_pages) / samples : 0.0;
+}
+
+// 순차 write() 버퍼
+class BufferedWriter {
+private:
+    int fd_;
+    std::vector<uint8_t> buffer_;
+    bool ok_ = true;
+
+public:
+    explicit BufferedWriter(int fd) : fd_(fd) { buffer_.reserve(WRITE_BUFFER_BYTES); }
+    
+    void append(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        if (buffer_.size() + size > WRITE_BUFFER_BYTES) {
+            flush();
+        }
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+    
+    bool flush() {
+        size_t written = 0;
+        while (ok_ && written < buffer_.size()) {
+            ssize_t rc = write(fd_, buffer_.data() + written, buffer_.size() - written);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok_ = false;
+                break;
+            }
+            written += static_cast<size_t>(rc);
+        }
+        buffer_.clear();
+        return ok_;
+    }
+};
+
+}  // namespace
+
+bool parseHNSWReorderMethod(const std::string& name, HNSWReorderMethod& method) {
+    if (name == "none") {
+        method = HNSWReorderMethod::None;
+    } else if (name == "bfs") {
+        method = HNSWReorderMethod::Bfs;
+    } else if (name == "rcm") {
+        method = HNSWReorderMethod::Rcm;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* hnswReorderMethodName(HNSWReorderMethod method) {
+    switch (method) {
+        case HNSWReorderMethod::Bfs: return "bfs";
+        case HNSWReorderMethod::Rcm: return "rcm";
+        default: return "none";
+    }
+}
+
+bool reorderHNSWFile(const std::string& path, size_t dim, HNSWReorderMethod method,
+                     HNSWReorderStats& stats, uint64_t beg_id) {
+    auto start = std::chrono::steady_clock::now();
+    
+    // tombstone은 label 단위라 재번호하면 다른 벡터를 가리키게 됨
+    // (서버는 연 샤드마다 .tomb을 만들어 두므로 파일이 있어도 삭제된 label이 없으면 진행)
+    std::filesystem::path tomb_path = std::filesystem::path(path).replace_extension(".tomb");
+    if (std::filesystem::exists(tomb_path)) {
+        size_t deleted = 0;
+        if (!TombstoneBitset::readDeletedCount(tomb_path.string(), deleted)) {
+            std::cerr << "Cannot read tombstone file " << tomb_path << ", skipping reorder: " << path << std::endl;
+            return false;
+        }
+        if (deleted > 0) {
+            std::cerr << "Shard has " << deleted << " deleted vectors in " << tomb_path
+                      << ", skipping reorder: " << path << std::endl;
+            return false;
+        }
+    }
+    
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Failed to open HNSW file for reorder: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map HNSW file for reorder: " << path << std::endl;
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(mapped);
+    // 재번호는 파일 전체를 한 번씩 훑으므로 readahead를 크게 잡음
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    
+    HNSWFileLayout layout;
+    if (!parseHNSWFileLayout(data, size, dim, layout)) {
+        std::cerr << "Unrecognized HNSW file layout, skipping reorder: " << path << std::endl;
+        munmap(mapped, size);
+        return false;
+    }
+    size_t n = layout.element_count;
+    stats.element_count = n;
+    
+    // 기존 ID 매핑 (label 순서), 없으면 label 자체
+    std::filesystem::path ids_path = std::filesystem::path(path).replace_extension(".ids");
+    std::vector<uint64_t> old_ids;
+    if (std::filesystem::exists(ids_path)) {
+        std::ifstream ifs(ids_path, std::ios::binary);
+        old_ids.resize(n);
+        ifs.read(reinterpret_cast<char*>(old_ids.data()), n * sizeof(uint64_t));
+        if (!ifs) {
+            std::cerr << "ID map " << ids_path << " does not match index count " << n << std::endl;
+            munmap(mapped, size);
+            return false;
+        }
+    }
+    
+    std::vector<uint32_t> order = computeOrder(data, layout, method);
+    std::vector<uint32_t> position(n);
+    for (uint32_t new_id = 0; new_id < n; ++new_id) {
+        position[order[new_id]] = new_id;
+    }
+    stats.pages_per_hop_before = pagesPerHop(data, layout, nullptr);
+    stats.pages_per_hop_after = pagesPerHop(data, layout, &position);
+    
+    std::string tmp_path = path + ".reorder.tmp";
+    int out = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out == -1) {
+        std::cerr << "Failed to create " << tmp_path << std::endl;
+        munmap(mapped, size);
+        return false;
+    }
+    BufferedWriter writer(out);
+    
+    // 헤더 (entry point만 새 ID로)
+    std::vector<uint8_t> header(data, data + layout.header_size);
+    uint32_t entry_point = position[layout.entry_point];
+    std::memcpy(header.data() + ENTRY_POINT_OFFSET, &entry_point, sizeof(entry_point));
+    writer.append(header.data(), header.size());
+    
+    // level0 레코드 (새 순서로, 링크와 label을 새 ID로)
+    std::vector<uint8_t> record(layout.size_data_per_element);
+    std::vector<uint64_t> new_ids(old_ids.empty() ? 0 : n);
+    for (uint32_t new_id = 0; new_id < n; ++new_id) {
+        uint32_t old_id = order[new_id];
+        std::memcpy(record.data(), data + layout.level0RecordOffset(old_id), record.size());
+        size_t count = std::min(linkCount(record.data()), layout.max_m0);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t neighbor = readLink(record.data(), i);
+            if (neighbor < n) {
+                writeLink(record.data(), i, position[neighbor]);
+            }
+        }
+        uint64_t old_label;
+        std::memcpy(&old_label, record.data() + layout.label_offset, sizeof(old_label));
+        uint64_t new_label = new_id;
+        std::memcpy(record.data() + layout.label_offset, &new_label, sizeof(new_label));
+        if (!old_ids.empty()) {
+            new_ids[new_id] = old_label < n ? old_ids[old_label] : old_label;
+        } else {
+            new_ids.push_back(beg_id + old_label);
+        }
+        writer.append(record.data(), record.size());
+    }
+    
+    // 상위 레이어 (노드별 linkListSize + 레벨별 링크 목록, 새 순서로)
+    std::vector<size_t> upper_offsets(n, 0);
+    size_t pos = layout.upper_offset;
+    for (uint32_t id = 0; id < n; ++id) {
+        upper_offsets[id] = pos;
+        uint32_t link_list_size;
+        std::memcpy(&link_list_size, data + pos, sizeof(link_list_size));
+        pos += sizeof(uint32_t) + link_list_size;
+    }
+    size_t links_per_level = layout.max_m * sizeof(uint32_t) + sizeof(uint32_t);
+    std::vector<uint8_t> lists;
+    for (uint32_t new_id = 0; new_id < n; ++new_id) {
+        size_t offset = upper_offsets[order[new_id]];
+        uint32_t link_list_size;
+        std::memcpy(&link_list_size, data + offset, sizeof(link_list_size));
+        writer.append(&link_list_size, sizeof(link_list_size));
+        if (link_list_size == 0) {
+            continue;
+        }
+        lists.assign(data + offset + sizeof(uint32_t), data + offset + sizeof(uint32_t) + link_list_size);
+        for (size_t level = 0; level < link_list_size / links_per_level; ++level) {
+            uint8_t* list = lists.data() + level * links_per_level;
+            size_t count = std::min(linkCount(list), layout.max_m);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t neighbor = readLink(list, i);
+                if (neighbor < n) {
+                    writeLink(list, i, position[neighbor]);
+                }
+            }
+        }
+        writer.append(lists.data(), lists.size());
+    }
+    munmap(mapped, size);
+    
+    bool ok = writer.flush() && fsync(out) == 0;
+    close(out);
+    if (!ok) {
+        std::cerr << "Failed to write reordered HNSW file: " << tmp_path << std::endl;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    
+    // 둘 다 임시 파일로 다 쓴 뒤 rename (두 rename 사이에 죽으면 인덱스와 .ids가 어긋나므로 다시 빌드해야 함)
+    std::string ids_tmp = ids_path.string() + ".reorder.tmp";
+    {
+        std::ofstream ofs(ids_tmp, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(new_ids.data()), new_ids.size() * sizeof(uint64_t));
+        if (!ofs) {
+            std::cerr << "Failed to write ID map: " << ids_tmp << std::endl;
+            unlink(tmp_path.c_str());
+            unlink(ids_tmp.c_str());
+            return false;
+        }
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) != 0 || rename(ids_tmp.c_str(), ids_path.c_str()) != 0) {
+        std::cerr << "Failed to replace " << path << " with reordered file" << std::endl;
+        return false;
+    }
+    
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// HNSW 샤드 파일의 노드 재번호 (locality 최적화)
+// build_vectorDB로 만든 샤드는 ingest 순서(chunk_id 순서)로 저장되어 level0 이웃이 파일 전체에 흩어짐
+// level0 그래프를 entry point부터 BFS한 순서로 노드를 다시 배치하면 탐색 중 이웃 hop이
+// 같은 페이지에 떨어질 확률이 높아져 쿼리당 page fault / CXL 접근 수가 줄어듦
+// - Bfs: 링크 순서대로 BFS (entry point와 상위 레이어 근처 노드가 파일 앞쪽에 모임)
+// - Rcm: reverse Cuthill-McKee (BFS 중 이웃을 degree 오름차순으로 방문한 뒤 순서를 뒤집음)
+enum class HNSWReorderMethod {
+    None,
+    Bfs,
+    Rcm,
+};
+
+bool parseHNSWReorderMethod(const std::string& name, HNSWReorderMethod& method);
+const char* hnswReorderMethodName(HNSWReorderMethod method);
+
+struct HNSWReorderStats {
+    size_t element_count = 0;
+    // 노드 하나의 level0 이웃 레코드들이 걸친 서로 다른 4KB 페이지 수 평균 (표본 기준)
+    double pages_per_hop_before = 0.0;
+    double pages_per_hop_after = 0.0;
+    double elapsed_ms = 0.0;
+};
+
+// path의 샤드를 재번호한 파일로 교체 (같은 디렉토리의 임시 파일에 쓴 뒤 rename)
+// - 새 내부 ID 순서로 level0 레코드와 상위 레이어 링크를 다시 쓰고, 링크와 entry point를 새 ID로 바꿈
+// - label은 새 내부 ID로 다시 매김 (Knowhere가 label == 내부 ID를 가정하는 경로가 있으므로 유지)
+// - 원래 ID는 .ids 사이드카(label 순서의 uint64 배열)로 기록하고 서버가 검색 결과를 변환
+//   (기존 .ids가 있으면 합성, 없으면 서버의 오프셋 ID인 beg_id + 원래 label을 ID로 씀)
+// - beg_id: .ids가 없는 샤드의 오프셋 ID 시작 (파일명 순서로 앞선 .ids 없는 샤드들의 벡터 수 합,
+//   HNSWIndexManager::loadIndices와 같은 규칙)
+// 파일 형식이 맞지 않거나 기록에 실패하면 false (원본은 그대로 남음)
+bool reorderHNSWFile(const std::string& path, size_t dim, HNSWReorderMethod method,
+                     HNSWReorderStats& stats, uint64_t beg_id = 0);
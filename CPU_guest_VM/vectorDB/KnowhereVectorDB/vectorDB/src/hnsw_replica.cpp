@@ -0,0 +1,207 @@
+#include "hnsw_replica.h"
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+HNSWReplicaPlan::HNSWReplicaPlan(const FileMapping& mapping, size_t dim)
+    : mapping_(mapping), page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {
+    if (mapping_.addr == nullptr) {
+        return;
+    }
+    stats_.layout_ok = parseHNSWFileLayout(mapping_.addr, mapping_.length, dim, layout_);
+    if (stats_.layout_ok) {
+        selected_.assign((mapping_.length + page_size_ - 1) / page_size_, false);
+    }
+}
+
+size_t HNSWReplicaPlan::selectRange(size_t offset, size_t len, size_t& budget, bool allow_partial) {
+    size_t first = offset / page_size_;
+    size_t last = std::min(selected_.size(), (offset + len + page_size_ - 1) / page_size_);
+    
+    size_t new_pages = 0;
+    for (size_t p = first; p < last; ++p) {
+        new_pages += selected_[p] ? 0 : 1;
+    }
+    if (new_pages * page_size_ > budget) {
+        if (!allow_partial) {
+            return 0;
+        }
+        new_pages = budget / page_size_;
+    }
+    
+    size_t taken = 0;
+    for (size_t p = first; p < last && taken < new_pages; ++p) {
+        if (!selected_[p]) {
+            selected_[p] = true;
+            ++taken;
+        }
+    }
+    budget -= taken * page_size_;
+    return taken * page_size_;
+}
+
+std::vector<uint32_t> HNSWReplicaPlan::hotNodes() const {
+    std::vector<size_t> order(layout_.upper_nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return layout_.upper_levels[a] > layout_.upper_levels[b];
+    });
+    
+    std::vector<uint32_t> nodes;
+    nodes.reserve(order.size() + 1);
+    nodes.push_back(layout_.entry_point);
+    for (size_t i : order) {
+        nodes.push_back(layout_.upper_nodes[i]);
+    }
+    return nodes;
+}
+
+size_t HNSWReplicaPlan::selectUpperLayers(size_t budget) {
+    if (!valid()) {
+        return 0;
+    }
+    size_t bytes = selectRange(layout_.upper_offset, mapping_.length - layout_.upper_offset, budget, true);
+    stats_.upper_bytes += bytes;
+    return bytes;
+}
+
+size_t HNSWReplicaPlan::selectUpperNodeRecords(size_t budget) {
+    if (!valid()) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (uint32_t id : hotNodes()) {
+        bytes += selectRange(layout_.level0RecordOffset(id), layout_.size_data_per_element, budget, false);
+        if (budget < page_size_) {
+            break;
+        }
+    }
+    stats_.record_bytes += bytes;
+    return bytes;
+}
+
+size_t HNSWReplicaPlan::selectLevel0Neighbors(size_t budget) {
+    if (!valid()) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (uint32_t id : hotNodes()) {
+        // level0 링크 목록: 하위 16비트가 이웃 수, 이어서 uint32 이웃 ID 배열
+        const uint8_t* links = mapping_.addr + layout_.level0RecordOffset(id);
+        uint32_t header;
+        std::memcpy(&header, links, sizeof(header));
+        size_t count = std::min<size_t>(header & 0xFFFF, layout_.max_m0);
+        
+        for (size_t j = 0; j < count && budget >= page_size_; ++j) {
+            uint32_t neighbor;
+            std::memcpy(&neighbor, links + sizeof(uint32_t) * (j + 1), sizeof(neighbor));
+            if (neighbor >= layout_.element_count) {
+                continue;
+            }
+            bytes += selectRange(layout_.level0RecordOffset(neighbor), layout_.size_data_per_element,
+                                 budget, false);
+        }
+        if (budget < page_size_) {
+            break;
+        }
+    }
+    stats_.neighbor_bytes += bytes;
+    return bytes;
+}
+
+bool HNSWReplicaPlan::apply(size_t& budget) {
+    if (!valid()) {
+        return false;
+    }
+    
+    // 선택된 페이지를 연속 run으로 묶음
+    struct Run { size_t first; size_t last; };
+    std::vector<Run> runs;
+    for (size_t p = 0; p < selected_.size(); ++p) {
+        if (!selected_[p]) continue;
+        if (!runs.empty() && runs.back().last == p) {
+            runs.back().last = p + 1;
+        } else {
+            runs.push_back({p, p + 1});
+        }
+    }
+    
+    // run이 너무 많으면 gap이 작은 것부터 병합 (gap 페이지도 함께 복제되므로 남은 예산 안에서만)
+    if (runs.size() > MAX_RUNS_PER_SHARD) {
+        std::vector<size_t> gap_order(runs.size() - 1);
+        std::iota(gap_order.begin(), gap_order.end(), 0);
+        std::sort(gap_order.begin(), gap_order.end(), [&runs](size_t a, size_t b) {
+            return runs[a + 1].first - runs[a].last < runs[b + 1].first - runs[b].last;
+        });
+        std::vector<bool> merge_with_next(runs.size(), false);
+        for (size_t i = 0; i < runs.size() - MAX_RUNS_PER_SHARD; ++i) {
+            size_t gap_bytes = (runs[gap_order[i] + 1].first - runs[gap_order[i]].last) * page_size_;
+            if (gap_bytes > budget) {
+                break;   // gap이 오름차순이라 뒤의 gap도 들어가지 않음
+            }
+            budget -= gap_bytes;
+            merge_with_next[gap_order[i]] = true;
+        }
+        std::vector<Run> merged;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (!merged.empty() && merge_with_next[i - 1]) {
+                merged.back().last = runs[i].last;
+            } else {
+                merged.push_back(runs[i]);
+            }
+        }
+        runs = std::move(merged);
+        
+        // 예산이 모자라 아직 많으면 작은 run부터 포기 (앞쪽 주소 순서는 유지)
+        if (runs.size() > MAX_RUNS_PER_SHARD) {
+            std::vector<size_t> by_size(runs.size());
+            std::iota(by_size.begin(), by_size.end(), 0);
+            std::sort(by_size.begin(), by_size.end(), [&runs](size_t a, size_t b) {
+                return runs[a].last - runs[a].first < runs[b].last - runs[b].first;
+            });
+            std::vector<bool> dropped(runs.size(), false);
+            for (size_t i = 0; i < runs.size() - MAX_RUNS_PER_SHARD; ++i) {
+                dropped[by_size[i]] = true;
+                budget += (runs[by_size[i]].last - runs[by_size[i]].first) * page_size_;
+            }
+            std::vector<Run> kept;
+            kept.reserve(MAX_RUNS_PER_SHARD);
+            for (size_t i = 0; i < runs.size(); ++i) {
+                if (!dropped[i]) {
+                    kept.push_back(runs[i]);
+                }
+            }
+            std::cerr << "DRAM replica: budget too small to merge gaps, skipping "
+                      << runs.size() - kept.size() << " small runs" << std::endl;
+            runs = std::move(kept);
+        }
+    }
+    
+    for (const auto& run : runs) {
+        uint8_t* target = mapping_.addr + run.first * page_size_;
+        size_t len = (run.last - run.first) * page_size_;
+        
+        // 1. 익명 DRAM에 복사 (first-touch로 복제하는 스레드의 NUMA 노드에 할당됨)
+        void* replica = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (replica == MAP_FAILED) {
+            std::cerr << "DRAM replica allocation failed (" << len << " bytes)" << std::endl;
+            return false;
+        }
+        std::memcpy(replica, target, len);
+        mprotect(replica, len, mapping_.prot ? mapping_.prot : PROT_READ);
+        
+        // 2. 원래 주소에 원자적으로 덮어씀 (기존 CXL 페이지 매핑은 이 구간만 해제됨)
+        if (mremap(replica, len, len, MREMAP_MAYMOVE | MREMAP_FIXED, target) == MAP_FAILED) {
+            std::cerr << "mremap of DRAM replica failed: " << std::strerror(errno) << std::endl;
+            munmap(replica, len);
+            return false;
+        }
+        
+        stats_.replicated_bytes += len;
+        stats_.runs += 1;
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "hnsw_layout.h"
+#include "shard_warmup.h"
+
+// HNSW 샤드의 hot 구간을 CXL(famfs) 매핑에서 로컬 DRAM으로 복제
+//
+// 선택된 페이지들을 익명 메모리에 복사한 뒤 mremap(MREMAP_FIXED)으로 Knowhere가 매핑한
+// 주소에 그대로 덮어씀. Knowhere의 포인터는 그대로이고 교체는 원자적이므로 검색 중에도
+// 안전함 (샤드 파일은 서빙 중 읽기 전용). 나머지 구간은 계속 CXL 매핑을 사용.
+//
+// 우선순위 (tier):
+//   1. 상위 레이어 링크 구간 (파일 끝쪽 연속 구간)
+//   2. entry point와 상위 레이어 노드들의 level0 레코드 (level 높은 순)
+//   3. (선택) 상위 레이어 노드들의 level0 이웃 레코드 (level0 탐색이 처음 확장하는 노드들)
+
+// 샤드별 복제 통계
+struct ReplicaStats {
+    bool layout_ok = false;
+    size_t upper_bytes = 0;       // tier 1
+    size_t record_bytes = 0;      // tier 2
+    size_t neighbor_bytes = 0;    // tier 3
+    size_t replicated_bytes = 0;  // 실제로 DRAM으로 옮긴 바이트 (run 병합으로 생긴 gap 포함)
+    size_t runs = 0;              // mremap 호출 수 (= 추가로 생긴 VMA 수)
+};
+
+class HNSWReplicaPlan {
+private:
+    // 페이지가 너무 잘게 흩어지면 VMA 수가 vm.max_map_count를 넘으므로 run 수를 제한
+    static constexpr size_t MAX_RUNS_PER_SHARD = 4096;
+    
+    FileMapping mapping_;
+    HNSWFileLayout layout_;
+    size_t page_size_;
+    std::vector<bool> selected_;  // 페이지별 선택 여부
+    ReplicaStats stats_;
+
+public:
+    HNSWReplicaPlan(const FileMapping& mapping, size_t dim);
+    
+    bool valid() const { return stats_.layout_ok; }
+    
+    // 각 tier에서 budget 안에 들어가는 만큼 페이지 선택, 새로 선택한 바이트 반환
+    size_t selectUpperLayers(size_t budget);
+    size_t selectUpperNodeRecords(size_t budget);
+    size_t selectLevel0Neighbors(size_t budget);
+    
+    // 선택된 페이지를 DRAM으로 복제
+    // run 병합으로 함께 복제되는 gap 페이지는 budget에서 차감하고, 예산이 모자라 run 수를 줄이지 못하면
+    // 작은 run부터 복제하지 않고 그 바이트를 budget으로 돌려줌
+    bool apply(size_t& budget);
+    
+    const ReplicaStats& stats() const { return stats_; }
+
+private:
+    // [offset, offset + len) 을 덮는 페이지 선택 (allow_partial이면 budget만큼 앞부분만)
+    size_t selectRange(size_t offset, size_t len, size_t& budget, bool allow_partial);
+    // level 높은 순으로 정렬된 (entry point 포함) 상위 노드 목록
+    std::vector<uint32_t> hotNodes() const;
+};
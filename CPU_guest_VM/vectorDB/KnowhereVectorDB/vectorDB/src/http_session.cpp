@@ -0,0 +1,118 @@
+#include "http_session.h"
+#include <iostream>
+
+// HttpSession 구현
+HttpSession::HttpSession(tcp::socket&& socket, HttpRequestHandler handler)
+    : stream_(std::move(socket)), handler_(std::move(handler)) {
+}
+
+void HttpSession::run() {
+    net::dispatch(stream_.get_executor(),
+                  beast::bind_front_handler(&HttpSession::doRead,
+                                            shared_from_this()));
+}
+
+void HttpSession::doRead() {
+    req_ = {};
+    parser_.emplace();
+    parser_->body_limit(HTTP_BODY_LIMIT);
+    
+    stream_.expires_after(std::chrono::seconds(30));
+    
+    http::async_read(stream_, buffer_, *parser_,
+                     beast::bind_front_handler(&HttpSession::onRead,
+                                               shared_from_this()));
+}
+
+void HttpSession::onRead(beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+    
+    if (ec == http::error::end_of_stream) {
+        return doClose();
+    }
+    
+    if (ec == http::error::body_limit) {
+        // 연결을 그냥 끊지 않고 413으로 알린 뒤 닫음 (남은 body는 읽지 않으므로 keep-alive 불가)
+        http::response<http::string_body> res{http::status::payload_too_large, parser_->get().version()};
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Request body exceeds " + std::to_string(HTTP_BODY_LIMIT) + " bytes";
+        res.prepare_payload();
+        req_.keep_alive(false);
+        return sendResponse(std::move(res));
+    }
+    
+    if (ec) {
+        std::cerr << "Read error: " << ec.message() << std::endl;
+        return;
+    }
+    req_ = parser_->release();
+    
+    // [수정] handleRequest 호출 방식 변경
+    // handleRequest는 이제 즉시 반환되며, 작업이 완료되면 아래 람다 콜백이 호출됩니다.
+    handler_(std::move(req_), 
+        // [self = shared_from_this()] 를 통해 비동기 작업 중 HttpSession 객체가 살아있도록 보장
+        [self = shared_from_this()](http::response<http::string_body>&& res) {
+            self->sendResponse(std::move(res));
+        });
+}
+
+// [신규] 응답을 받아 비동기 쓰기를 시작하는 함수
+void HttpSession::sendResponse(http::response<http::string_body>&& res) {
+    res_ = std::move(res);
+
+    // 응답을 보내기 전에 keep_alive 상태를 설정합니다.
+    res_.keep_alive(req_.keep_alive());
+
+    // std::cout << "Sending response, size: " << res_.body().size() << " bytes" << std::endl;
+    
+    http::async_write(
+        stream_,
+        res_,
+        beast::bind_front_handler(
+            &HttpSession::onWrite,
+            shared_from_this(),
+            res_.need_eof() // keep_alive가 아니면 연결을 닫도록 설정
+        )
+    );
+}
+
+void HttpSession::onWrite(bool close, beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+    
+    if (ec) {
+        std::cerr << "Write error: " << ec.message() << std::endl;
+        return;
+    }
+    
+    // std::cout << "Response sent successfully, " << bytes_transferred << " bytes transferred" << std::endl;
+    
+    if (close) {
+        std::cout << "Closing connection" << std::endl;
+        return doClose();
+    }
+    
+    // 다음 요청을 위해 응답 객체 초기화
+    res_ = {};
+    
+    // std::cout << "Keep-alive connection, reading next request" << std::endl;
+    doRead();
+}
+
+void HttpSession::doClose() {
+    std::cout << "Closing HTTP session" << std::endl;
+    beast::error_code ec;
+    
+    // 소켓 shutdown 시도
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+    
+    if (ec) {
+        std::cerr << "Socket shutdown error: " << ec.message() << std::endl;
+    }
+    
+    // 소켓 닫기
+    stream_.socket().close(ec);
+    
+    if (ec) {
+        std::cerr << "Socket close error: " << ec.message() << std::endl;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/config.hpp>
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = boost::asio::ip::tcp;
+
+// 응답 전송 콜백 (비동기 핸들러가 완료 시 한 번 호출)
+using HttpSendCallback = std::function<void(http::response<http::string_body>&&)>;
+// 요청 하나를 처리하는 서버 측 핸들러 (VectorDBServer, SearchCoordinator)
+using HttpRequestHandler = std::function<void(http::request<http::string_body>&&, HttpSendCallback)>;
+
+// 요청/백엔드 응답 body 상한 (Beast 기본값은 요청 1MB, 응답 8MB)
+// 가장 큰 요청은 1024개 벡터 JSON 삽입/exact-search 배치 (768차원 기준 약 16MB),
+// 가장 큰 응답은 1024 쿼리 × k=1000 바이너리 결과 (약 12MB)로, 더 큰 차원까지 여유를 둠
+constexpr uint64_t HTTP_BODY_LIMIT = 64ULL * 1024 * 1024;
+
+// HTTP 세션 클래스 (keep-alive 연결 하나, 요청마다 handler 호출)
+class HttpSession : public std::enable_shared_from_this<HttpSession> {
+private:
+    beast::tcp_stream stream_;
+    beast::flat_buffer buffer_;
+    std::optional<http::request_parser<http::string_body>> parser_;  // 요청마다 새로 만들어 body 상한 설정
+    http::request<http::string_body> req_;
+    http::response<http::string_body> res_;  // 응답 객체를 멤버로 유지
+    HttpRequestHandler handler_;
+
+public:
+    HttpSession(tcp::socket&& socket, HttpRequestHandler handler);
+    void run();
+
+private:
+    void doRead();
+    void onRead(beast::error_code ec, std::size_t bytes_transferred);
+
+    void sendResponse(http::response<http::string_body>&& response);
+
+    void onWrite(bool close, beast::error_code ec, std::size_t bytes_transferred);
+    void doClose();
+};
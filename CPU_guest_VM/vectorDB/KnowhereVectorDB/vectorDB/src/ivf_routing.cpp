@@ -0,0 +1,309 @@
+#include "ivf_routing.h"
+#include "distance_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <omp.h>
+#include <unistd.h>
+
+bool parseShardEngine(const std::string& name, ShardEngine& engine) {
+    if (name == "hnsw") {
+        engine = ShardEngine::HNSW;
+    } else if (name == "ivf_sq8") {
+        engine = ShardEngine::IVFSQ8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* shardEngineName(ShardEngine engine) {
+    switch (engine) {
+        case ShardEngine::IVFSQ8: return "ivf_sq8";
+        default: return "hnsw";
+    }
+}
+
+void IVFRoutingIndex::setSearchOptions(size_t nprobe, size_t rerank_factor) {
+    nprobe_ = std::max<size_t>(1, nprobe);
+    rerank_factor_ = std::max<size_t>(1, rerank_factor);
+}
+
+size_t IVFRoutingIndex::dramBytes() const {
+    return centroids_.size() * sizeof(float) + list_offsets_.size() * sizeof(uint64_t) +
+           rows_.size() * sizeof(uint32_t) + labels_.size() * sizeof(uint32_t) +
+           params_.size() * sizeof(float) + codes_.size();
+}
+
+size_t IVFRoutingIndex::maxDramBytes(size_t count, size_t dim) {
+    size_t nlist = std::min(MAX_NLIST, std::max<size_t>(count, 1));
+    return nlist * dim * sizeof(float) + (nlist + 1) * sizeof(uint64_t) +
+           count * (2 * sizeof(uint32_t) + 2 * sizeof(float) + dim);
+}
+
+void IVFRoutingIndex::normalizedRow(size_t row, float* out) const {
+    std::memcpy(out, records_.vector(row), dim_ * sizeof(float));
+    if (!records_.normalized) {
+        distance::normalizeInPlace(out, dim_);
+    }
+}
+
+size_t IVFRoutingIndex::nearestList(const float* normalized) const {
+    size_t best = 0;
+    float best_sim = -std::numeric_limits<float>::infinity();
+    for (size_t list = 0; list < nlist_; ++list) {
+        float sim = distance::dotProduct(normalized, &centroids_[list * dim_], dim_);
+        if (sim > best_sim) {
+            best_sim = sim;
+            best = list;
+        }
+    }
+    return best;
+}
+
+void IVFRoutingIndex::trainCentroids(size_t num_threads, size_t iterations) {
+    // 균등 간격 샘플 (샤드 파일 순서가 삽입/재배치 순서라 간격 샘플이면 분포가 치우치지 않음)
+    size_t n = records_.count;
+    size_t num_samples = std::min({n, nlist_ * TRAIN_SAMPLES_PER_LIST, MAX_TRAIN_SAMPLES});
+    num_samples = std::max(num_samples, nlist_);
+    std::vector<float> samples(num_samples * dim_);
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (size_t i = 0; i < num_samples; ++i) {
+        normalizedRow(i * n / num_samples, &samples[i * dim_]);
+    }
+
+    centroids_.resize(nlist_ * dim_);
+    for (size_t list = 0; list < nlist_; ++list) {
+        size_t sample = list * num_samples / nlist_;
+        std::memcpy(&centroids_[list * dim_], &samples[sample * dim_], dim_ * sizeof(float));
+    }
+
+    // spherical k-means: 내적 최대 centroid에 배정, 평균을 다시 unit norm으로
+    std::vector<uint32_t> assign(num_samples);
+    std::vector<double> sums(nlist_ * dim_);
+    std::vector<size_t> counts(nlist_);
+    for (size_t iter = 0; iter < iterations; ++iter) {
+        #pragma omp parallel for schedule(static) num_threads(num_threads)
+        for (size_t i = 0; i < num_samples; ++i) {
+            assign[i] = static_cast<uint32_t>(nearestList(&samples[i * dim_]));
+        }
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < num_samples; ++i) {
+            double* sum = &sums[assign[i] * dim_];
+            const float* sample = &samples[i * dim_];
+            for (size_t d = 0; d < dim_; ++d) {
+                sum[d] += sample[d];
+            }
+            ++counts[assign[i]];
+        }
+
+        for (size_t list = 0; list < nlist_; ++list) {
+            float* centroid = &centroids_[list * dim_];
+            if (counts[list] == 0) {
+                // 빈 리스트는 다른 샘플로 다시 시작 (반복마다 다른 위치)
+                size_t sample = (list * 7919 + iter * 104729) % num_samples;
+                std::memcpy(centroid, &samples[sample * dim_], dim_ * sizeof(float));
+                continue;
+            }
+            for (size_t d = 0; d < dim_; ++d) {
+                centroid[d] = static_cast<float>(sums[list * dim_ + d]);
+            }
+            distance::normalizeInPlace(centroid, dim_);
+        }
+    }
+}
+
+bool IVFRoutingIndex::build(const HNSWRecordView& records, size_t dim, const IVFRoutingOptions& options) {
+    size_t n = records.count;
+    if (n == 0 || n > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << "Cannot build IVF routing for " << n << " vectors" << std::endl;
+        return false;
+    }
+    records_ = records;
+    dim_ = dim;
+    setSearchOptions(options.nprobe, options.rerank_factor);
+    nlist_ = options.nlist ? options.nlist : static_cast<size_t>(std::sqrt(static_cast<double>(n)));
+    nlist_ = std::min(std::clamp(nlist_, MIN_NLIST, MAX_NLIST), n);
+    size_t num_threads = options.build_threads ? options.build_threads : omp_get_max_threads();
+
+    trainCentroids(num_threads, options.train_iterations);
+
+    // 1. 모든 row 배정 (CXL 레코드를 한 번 순차로 읽음)
+    std::vector<uint32_t> assign(n);
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<float> row_buffer(dim_);
+        #pragma omp for schedule(static)
+        for (size_t row = 0; row < n; ++row) {
+            normalizedRow(row, row_buffer.data());
+            assign[row] = static_cast<uint32_t>(nearestList(row_buffer.data()));
+        }
+    }
+
+    // 2. 리스트 순서 위치 (counting sort)
+    list_offsets_.assign(nlist_ + 1, 0);
+    for (size_t row = 0; row < n; ++row) {
+        ++list_offsets_[assign[row] + 1];
+    }
+    for (size_t list = 0; list < nlist_; ++list) {
+        list_offsets_[list + 1] += list_offsets_[list];
+    }
+    std::vector<uint64_t> next(list_offsets_.begin(), list_offsets_.end() - 1);
+    rows_.resize(n);
+    labels_.resize(n);
+    for (size_t row = 0; row < n; ++row) {
+        uint64_t pos = next[assign[row]]++;
+        rows_[pos] = static_cast<uint32_t>(row);
+        labels_[pos] = static_cast<uint32_t>(records_.label(row));
+    }
+
+    // 3. 리스트 순서로 SQ8 인코딩 (CXL 레코드를 한 번 더 읽음)
+    params_.resize(n * 2);
+    codes_.resize(n * dim_);
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<float> row_buffer(dim_);
+        #pragma omp for schedule(static)
+        for (size_t pos = 0; pos < n; ++pos) {
+            normalizedRow(rows_[pos], row_buffer.data());
+            distance::encodeSq8(row_buffer.data(), &codes_[pos * dim_], dim_, params_[pos * 2], params_[pos * 2 + 1]);
+        }
+    }
+    return true;
+}
+
+bool IVFRoutingIndex::save(const std::string& path, uint64_t source_size, int64_t source_mtime_ns) const {
+    // 임시 파일에 다 쓴 뒤 rename (중간에 죽어도 불완전한 사이드카가 남지 않음)
+    // 공유 디렉토리에서 여러 호스트/프로세스가 같은 샤드를 동시에 로드할 수 있으므로 임시 이름에 호스트와 pid를 붙임
+    char host[256] = "host";
+    gethostname(host, sizeof(host) - 1);
+    std::string tmp_path = path + "." + host + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        Header header{MAGIC_NUMBER, FORMAT_VERSION, dim_, rows_.size(), nlist_, source_size, source_mtime_ns, 0};
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        auto write = [&ofs](const auto& values) {
+            ofs.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+        };
+        write(centroids_);
+        write(list_offsets_);
+        write(rows_);
+        write(labels_);
+        write(params_);
+        write(codes_);
+        if (!ofs) {
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+bool IVFRoutingIndex::load(const std::string& path, const HNSWRecordView& records, size_t dim,
+                           uint64_t source_size, int64_t source_mtime_ns) {
+    std::ifstream ifs(path, std::ios::binary);
+    Header header{};
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (header.magic_number != MAGIC_NUMBER || header.version != FORMAT_VERSION || header.dim != dim ||
+        header.count != records.count || header.source_size != source_size ||
+        header.source_mtime_ns != source_mtime_ns || header.nlist == 0 || header.nlist > MAX_NLIST) {
+        return false;
+    }
+
+    size_t n = header.count;
+    nlist_ = header.nlist;
+    dim_ = dim;
+    records_ = records;
+    centroids_.resize(nlist_ * dim_);
+    list_offsets_.resize(nlist_ + 1);
+    rows_.resize(n);
+    labels_.resize(n);
+    params_.resize(n * 2);
+    codes_.resize(n * dim_);
+    auto read = [&ifs](auto& values) {
+        ifs.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(values[0]));
+    };
+    read(centroids_);
+    read(list_offsets_);
+    read(rows_);
+    read(labels_);
+    read(params_);
+    read(codes_);
+    if (!ifs || list_offsets_.front() != 0 || list_offsets_.back() != n) {
+        return false;
+    }
+    // 검색이 범위 확인 없이 인덱싱하므로 리스트 구간과 row/label이 샤드 안에 있는지 확인
+    for (size_t list = 0; list < nlist_; ++list) {
+        if (list_offsets_[list] > list_offsets_[list + 1]) {
+            return false;
+        }
+    }
+    for (size_t pos = 0; pos < n; ++pos) {
+        if (rows_[pos] >= records.count || labels_[pos] >= records.count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<SearchResult> IVFRoutingIndex::search(const float* query, size_t k,
+                                                  const TombstoneBitset* tombstones) const {
+    if (k == 0 || rows_.empty()) {
+        return {};
+    }
+
+    std::vector<float> normalized(query, query + dim_);
+    distance::normalizeInPlace(normalized.data(), dim_);
+    const float* query_ptr = normalized.data();
+    float query_sum = 0.0f;
+    for (size_t d = 0; d < dim_; ++d) {
+        query_sum += query_ptr[d];
+    }
+
+    // 1. centroid 라우팅 (DRAM)
+    size_t nprobe = std::min(nprobe_, nlist_);
+    std::vector<std::pair<float, uint32_t>> lists(nlist_);
+    for (size_t list = 0; list < nlist_; ++list) {
+        lists[list] = {distance::dotProduct(query_ptr, &centroids_[list * dim_], dim_), static_cast<uint32_t>(list)};
+    }
+    std::partial_sort(lists.begin(), lists.begin() + nprobe, lists.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    // 2. 선택된 리스트의 SQ8 코드 스캔 (DRAM), 후보 id 필드 = 리스트 순서 위치
+    bool has_deleted = tombstones && tombstones->count() > 0;
+    TopKSelector candidates(std::max(k, k * rerank_factor_));
+    for (size_t p = 0; p < nprobe; ++p) {
+        uint32_t list = lists[p].second;
+        for (uint64_t pos = list_offsets_[list]; pos < list_offsets_[list + 1]; ++pos) {
+            if (has_deleted && tombstones->test(labels_[pos])) {
+                continue;
+            }
+            const float* params = &params_[pos * 2];
+            float sim = params[1] * query_sum + params[0] * distance::dotSq8(query_ptr, &codes_[pos * dim_], dim_);
+            candidates.push(pos, 1.0f - sim);
+        }
+    }
+
+    // 3. 후보만 CXL의 fp32 레코드로 rerank
+    TopKSelector top(k);
+    for (const auto& candidate : candidates.extractSorted()) {
+        const float* vector = records_.vector(rows_[candidate.id]);
+        float sim = distance::dotProduct(query_ptr, vector, dim_);
+        if (!records_.normalized) {
+            float norm_sq = distance::normSquared(vector, dim_);
+            sim = norm_sq > 0.0f ? sim / std::sqrt(norm_sq) : 0.0f;
+        }
+        top.push(labels_[candidate.id], 1.0f - sim);
+    }
+    return top.extractSorted();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hnsw_layout.h"
+#include "search_result.h"
+#include "tombstone_bitset.h"
+
+// 샤드 검색 엔진
+// - HNSW:   Knowhere HNSW 그래프 탐색 (방문 노드마다 CXL의 level0 레코드와 벡터를 읽음)
+// - IVFSQ8: DRAM의 IVF 라우팅 + SQ8 코드로 후보를 고르고, 마지막 후보만 CXL의 fp32 벡터로 rerank
+enum class ShardEngine {
+    HNSW,
+    IVFSQ8,
+};
+
+bool parseShardEngine(const std::string& name, ShardEngine& engine);
+const char* shardEngineName(ShardEngine engine);
+
+struct IVFRoutingOptions {
+    size_t nlist = 0;              // 리스트 수 (0이면 sqrt(n), [MIN_NLIST, MAX_NLIST])
+    size_t nprobe = 16;            // 쿼리당 스캔할 리스트 수
+    size_t rerank_factor = 4;      // 상위 k * rerank_factor 후보를 fp32로 rerank (flat 티어와 같은 의미)
+    size_t train_iterations = 10;  // spherical k-means 반복 수
+    size_t build_threads = 0;      // 학습/인코딩 OpenMP 스레드 수 (0이면 기본값)
+};
+
+// 샤드 하나의 DRAM 라우팅 인덱스
+// - centroid와 row별 SQ8 코드(dim바이트 + {scale, bias}), row/label을 리스트 순서로 DRAM에 연속 배치
+// - CXL에서는 rerank 후보의 fp32 벡터만 읽으므로 쿼리당 CXL 접근이 k * rerank_factor 레코드로 줄어듦
+// - 샤드 파일 옆 <shard>.ivf 사이드카에 저장해두고 다음 로드 때 재사용 (샤드 파일 크기/mtime이 다르면 다시 만듦)
+class IVFRoutingIndex {
+public:
+    static constexpr size_t MIN_NLIST = 16;
+    static constexpr size_t MAX_NLIST = 4096;
+
+    // records의 모든 row로 학습 + 인코딩 (records는 샤드 매핑이 살아 있는 동안 rerank에 계속 사용)
+    bool build(const HNSWRecordView& records, size_t dim, const IVFRoutingOptions& options);
+
+    // 사이드카 저장/로드, source_size/source_mtime_ns는 샤드 파일 기준
+    bool save(const std::string& path, uint64_t source_size, int64_t source_mtime_ns) const;
+    bool load(const std::string& path, const HNSWRecordView& records, size_t dim,
+              uint64_t source_size, int64_t source_mtime_ns);
+
+    // 쿼리 하나 검색, 결과 id 필드 = label (tombstones가 있으면 삭제된 label은 건너뜀)
+    // 스레드 안전 (상태를 바꾸지 않음), nprobe/rerank_factor는 로드 옵션을 따름
+    std::vector<SearchResult> search(const float* query, size_t k, const TombstoneBitset* tombstones) const;
+
+    void setSearchOptions(size_t nprobe, size_t rerank_factor);
+
+    size_t listCount() const { return nlist_; }
+    size_t size() const { return rows_.size(); }
+    // DRAM에 올린 라우팅 구조 크기
+    size_t dramBytes() const;
+    // count개 row 샤드의 라우팅 구조가 차지할 수 있는 최대 크기 (nlist = MAX_NLIST 기준, 예산 확인용)
+    static size_t maxDramBytes(size_t count, size_t dim);
+
+private:
+    static constexpr uint64_t MAGIC_NUMBER = 0x4956465351380000ULL;  // "IVFSQ8"
+    static constexpr uint64_t FORMAT_VERSION = 1;
+    // 학습에 쓰는 최대 샘플 수 (리스트당 TRAIN_SAMPLES_PER_LIST개)
+    static constexpr size_t MAX_TRAIN_SAMPLES = 65536;
+    static constexpr size_t TRAIN_SAMPLES_PER_LIST = 64;
+
+    struct Header {
+        uint64_t magic_number;
+        uint64_t version;
+        uint64_t dim;
+        uint64_t count;
+        uint64_t nlist;
+        uint64_t source_size;
+        int64_t source_mtime_ns;
+        uint64_t reserved;
+    };
+
+    HNSWRecordView records_;
+    size_t dim_ = 0;
+    size_t nlist_ = 0;
+    size_t nprobe_ = 16;
+    size_t rerank_factor_ = 4;
+    std::vector<float> centroids_;       // nlist × dim, unit norm
+    std::vector<uint64_t> list_offsets_;  // nlist + 1, 아래 배열들의 리스트 구간
+    std::vector<uint32_t> rows_;         // 레코드 row (rerank 때 CXL에서 읽을 위치)
+    std::vector<uint32_t> labels_;       // tombstone 확인과 결과 ID용
+    std::vector<float> params_;          // row당 {scale, bias}
+    std::vector<uint8_t> codes_;         // row당 dim바이트
+
+    // row의 정규화된 벡터를 out에 복사
+    void normalizedRow(size_t row, float* out) const;
+    // 내적이 가장 큰 centroid
+    size_t nearestList(const float* normalized) const;
+    void trainCentroids(size_t num_threads, size_t iterations);
+};
@@ -0,0 +1,656 @@
+// Open-loop 검색 부하 생성기 (vector_db_loadgen)
+//
+// - 실제 임베딩(extract_pubmed_data.py의 embeddings.bin)을 쿼리로 재생
+// - Poisson 도착: 요청마다 예정 시각을 미리 정하고, latency = 응답 완료 - 예정 시각
+//   (연결이 모두 바빠서 늦게 보낸 시간도 포함 → coordinated omission 보정)
+// - 목표 RPS를 단계별로 올리며 측정, 단계마다 HdrHistogram .hgrm 파일 기록
+// - 실패/미완료 요청도 latency에서 빠지지 않도록 성공만 담은 분포와 전체 요청 분포를 함께 보고
+//   (실패는 응답까지, 미완료는 단계 종료까지의 시간으로 기록하므로 전체 분포의 꼬리는 하한값)
+// - epoll + keep-alive HTTP/1.1, 요청 바이트는 시작 시 전부 미리 만들어 둠
+
+#include "binary_protocol.h"
+#include "hdr_histogram.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadGenOptions {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::string queries_path;        // float32 row 배열 (embeddings.bin)
+    size_t dim = 768;
+    size_t num_queries = 10000;      // 읽어 둘 쿼리 수
+    size_t query_offset = 0;         // 앞쪽 row 건너뛰기 (인덱스에 들어간 벡터를 피할 때)
+    int k = 10;
+    int ef = 0;
+    bool json = false;               // /api/search (기본은 /api/search/bin)
+    int deadline_ms = 0;             // X-Request-Deadline-Ms 헤더 (0이면 보내지 않음, 거절/만료는 errors로 집계)
+    size_t threads = 4;
+    size_t connections = 64;         // 전체 연결 수 (스레드에 나눔)
+    double rps_start = 1000;
+    double rps_step = 1000;
+    double rps_max = 1000;           // start == max면 단일 단계
+    double duration_s = 10;
+    double warmup_s = 2;             // 단계 시작 후 이 시간 동안의 요청은 기록하지 않음
+    double slo_p99_ms = 0;           // 0이면 p99 조건 없이 처리량 미달 시에만 sweep 중단
+    double min_achieved = 0.95;      // 달성 RPS / 목표 RPS가 이보다 낮으면 포화로 판단
+    std::string output_prefix;       // <prefix>_<rps>.hgrm, <prefix>_summary.csv
+    uint64_t seed = 42;
+};
+
+// 단계 하나의 결과
+struct StepResult {
+    double target_rps = 0;
+    double achieved_rps = 0;
+    HdrHistogram latency_us;       // 200으로 끝난 요청
+    HdrHistogram all_latency_us;   // 측정 구간의 모든 요청 (오류, 미완료 포함, SLO 판단 기준)
+    uint64_t errors = 0;
+    uint64_t unfinished = 0;   // 단계가 끝날 때까지 완료되지 않은 요청 (포화 신호)
+};
+
+// ---------------------------------------------------------------------------
+// 요청 준비
+
+bool loadQueries(const LoadGenOptions& options, std::vector<float>& queries) {
+    int fd = open(options.queries_path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Failed to open queries file: " << options.queries_path << std::endl;
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    size_t row_bytes = options.dim * sizeof(float);
+    size_t total_rows = static_cast<size_t>(st.st_size) / row_bytes;
+    if (options.query_offset >= total_rows) {
+        std::cerr << "Query offset " << options.query_offset << " beyond " << total_rows << " rows" << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t rows = std::min(options.num_queries, total_rows - options.query_offset);
+
+    queries.resize(rows * options.dim);
+    ssize_t read_bytes = pread(fd, queries.data(), rows * row_bytes,
+                               static_cast<off_t>(options.query_offset * row_bytes));
+    close(fd);
+    if (read_bytes != static_cast<ssize_t>(rows * row_bytes)) {
+        std::cerr << "Failed to read " << rows << " queries" << std::endl;
+        return false;
+    }
+    std::cout << "Loaded " << rows << " query embeddings (dim " << options.dim << ") from "
+              << options.queries_path << std::endl;
+    return true;
+}
+
+// 쿼리마다 완성된 HTTP 요청 바이트 (헤더 + 본문)
+std::vector<std::string> buildRequests(const LoadGenOptions& options, const std::vector<float>& queries) {
+    size_t rows = queries.size() / options.dim;
+    std::vector<std::string> requests;
+    requests.reserve(rows);
+
+    for (size_t row = 0; row < rows; ++row) {
+        const float* query = &queries[row * options.dim];
+        std::string body;
+        const char* target;
+        const char* content_type;
+
+        if (options.json) {
+            std::ostringstream json;
+            json.precision(9);
+            json << "{\"k\":" << options.k;
+            if (options.ef > 0) {
+                json << ",\"ef\":" << options.ef;
+            }
+            json << ",\"vector\":[";
+            for (size_t d = 0; d < options.dim; ++d) {
+                json << (d ? "," : "") << query[d];
+            }
+            json << "]}";
+            body = json.str();
+            target = "/api/search";
+            content_type = "application/json";
+        } else {
+            binproto::SearchRequestHeader header{binproto::REQUEST_MAGIC, static_cast<uint32_t>(options.k),
+                                                 static_cast<uint32_t>(options.ef), 1,
+                                                 static_cast<uint32_t>(options.dim), 0};
+            body.resize(binproto::requestSize(1, header.dim));
+            std::memcpy(body.data(), &header, sizeof(header));
+            std::memcpy(body.data() + sizeof(header), query, options.dim * sizeof(float));
+            target = "/api/search/bin";
+            content_type = "application/octet-stream";
+        }
+
+        std::string request = std::string("POST ") + target + " HTTP/1.1\r\n"
+                            + "Host: " + options.host + "\r\n"
+                            + "Content-Type: " + content_type + "\r\n"
+                            + "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        if (options.deadline_ms > 0) {
+            request += "X-Request-Deadline-Ms: " + std::to_string(options.deadline_ms) + "\r\n";
+        }
+        request += "Connection: keep-alive\r\n\r\n";
+        request += body;
+        requests.push_back(std::move(request));
+    }
+    return requests;
+}
+
+// ---------------------------------------------------------------------------
+// HTTP 연결
+
+int connectTo(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        return -1;
+    }
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd != -1 && connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd == -1) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+struct Connection {
+    int fd = -1;
+    bool busy = false;
+    const std::string* request = nullptr;
+    size_t sent = 0;
+    Clock::time_point intended;      // 요청의 예정 시각 (latency 기준)
+    bool record = false;             // warmup 이후 예정된 요청만 기록
+    std::string recv_buffer;
+};
+
+// 완성된 응답이 버퍼에 있으면 상태 코드를 돌려주고 소비 (아직이면 0, 형식 오류면 -1)
+int takeResponse(std::string& buffer) {
+    size_t header_end = buffer.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return 0;
+    }
+    if (buffer.compare(0, 9, "HTTP/1.1 ") != 0 && buffer.compare(0, 9, "HTTP/1.0 ") != 0) {
+        return -1;
+    }
+    int status = std::atoi(buffer.c_str() + 9);
+
+    size_t content_length = 0;
+    size_t pos = 0;
+    while (pos < header_end) {
+        size_t line_end = buffer.find("\r\n", pos);
+        if (line_end - pos > 15 && strncasecmp(buffer.c_str() + pos, "content-length:", 15) == 0) {
+            content_length = std::strtoull(buffer.c_str() + pos + 15, nullptr, 10);
+        }
+        pos = line_end + 2;
+    }
+
+    size_t total = header_end + 4 + content_length;
+    if (buffer.size() < total) {
+        return 0;
+    }
+    buffer.erase(0, total);
+    return status;
+}
+
+// ---------------------------------------------------------------------------
+// 단계 실행 (스레드 하나: 자기 몫의 도착 과정 + 연결들)
+
+struct ThreadResult {
+    HdrHistogram latency_us;
+    HdrHistogram all_latency_us;
+    uint64_t completed = 0;       // 측정 구간 안에 예정되어 완료된 요청
+    uint64_t errors = 0;
+    uint64_t unfinished = 0;
+};
+
+void runStepThread(const LoadGenOptions& options, const std::vector<std::string>& requests,
+                   double thread_rps, size_t num_connections, uint64_t seed,
+                   Clock::time_point start, ThreadResult& result) {
+    std::mt19937_64 rng(seed);
+    std::exponential_distribution<double> inter_arrival(thread_rps);
+    std::uniform_int_distribution<size_t> pick(0, requests.size() - 1);
+
+    auto measure_begin = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.warmup_s));
+    auto arrivals_end = measure_begin + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.duration_s));
+    // 단계가 끝난 뒤 남은 요청을 기다리는 최대 시간
+    auto drain_deadline = arrivals_end + std::chrono::seconds(2);
+
+    int epoll_fd = epoll_create1(0);
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    epoll_event timer_event{};
+    timer_event.events = EPOLLIN;
+    timer_event.data.u64 = UINT64_MAX;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &timer_event);
+
+    std::vector<Connection> connections(num_connections);
+    auto openConnection = [&](size_t i) {
+        Connection& conn = connections[i];
+        conn.fd = connectTo(options.host, options.port);
+        conn.busy = false;
+        conn.recv_buffer.clear();
+        if (conn.fd == -1) {
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, conn.fd, &event);
+        return true;
+    };
+    std::vector<size_t> idle;
+    for (size_t i = 0; i < num_connections; ++i) {
+        if (openConnection(i)) {
+            idle.push_back(i);
+        }
+    }
+    if (idle.empty()) {
+        std::cerr << "Could not connect to " << options.host << ":" << options.port << std::endl;
+        result.errors = 1;
+        close(timer_fd);
+        close(epoll_fd);
+        return;
+    }
+
+    // 예정 시각이 지났지만 빈 연결이 없어 아직 못 보낸 요청
+    struct Pending {
+        Clock::time_point intended;
+        const std::string* request;
+    };
+    std::deque<Pending> pending;
+    auto next_arrival = start;
+    size_t in_flight = 0;
+
+    auto recordAll = [&](Clock::time_point intended, Clock::time_point end) {
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(end - intended);
+        uint64_t us = static_cast<uint64_t>(std::max<int64_t>(1, latency.count()));
+        result.all_latency_us.record(us);
+        return us;
+    };
+
+    auto finish = [&](Connection& conn, bool ok) {
+        if (conn.record) {
+            uint64_t us = recordAll(conn.intended, Clock::now());
+            if (ok) {
+                result.latency_us.record(us);
+                ++result.completed;
+            } else {
+                ++result.errors;
+            }
+        }
+        conn.busy = false;
+        --in_flight;
+    };
+
+    auto sendMore = [&](size_t i) {
+        Connection& conn = connections[i];
+        while (conn.sent < conn.request->size()) {
+            ssize_t n = send(conn.fd, conn.request->data() + conn.sent, conn.request->size() - conn.sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                conn.sent += static_cast<size_t>(n);
+                continue;
+            }
+            if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLOUT;
+                event.data.u64 = i;
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn.fd, &event);
+                return true;
+            }
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn.fd, &event);
+        return true;
+    };
+
+    auto reconnect = [&](size_t i) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connections[i].fd, nullptr);
+        close(connections[i].fd);
+        if (openConnection(i)) {
+            idle.push_back(i);
+        }
+    };
+
+    std::vector<epoll_event> events(num_connections + 1);
+    char read_buffer[65536];
+
+    while (true) {
+        auto now = Clock::now();
+
+        // 1. 예정 시각이 된 도착을 pending으로
+        while (next_arrival <= now && next_arrival < arrivals_end) {
+            pending.push_back({next_arrival, &requests[pick(rng)]});
+            next_arrival += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(inter_arrival(rng)));
+        }
+
+        // 2. 빈 연결에 pending 요청 배정
+        while (!pending.empty() && !idle.empty()) {
+            size_t i = idle.back();
+            idle.pop_back();
+            Connection& conn = connections[i];
+            conn.busy = true;
+            conn.request = pending.front().request;
+            conn.intended = pending.front().intended;
+            conn.record = conn.intended >= measure_begin;
+            conn.sent = 0;
+            pending.pop_front();
+            ++in_flight;
+            if (!sendMore(i)) {
+                finish(conn, false);
+                reconnect(i);
+            }
+        }
+
+        if (now >= arrivals_end && (in_flight == 0 || now >= drain_deadline)) {
+            break;
+        }
+
+        // 3. 다음 도착 시각에 timerfd를 맞추고 이벤트 대기
+        if (next_arrival < arrivals_end) {
+            itimerspec spec{};
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next_arrival.time_since_epoch()).count();
+            spec.it_value.tv_sec = ns / 1000000000;
+            spec.it_value.tv_nsec = ns % 1000000000;
+            timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+        }
+        int timeout_ms = next_arrival < arrivals_end ? -1 : 100;
+        int ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout_ms);
+
+        for (int e = 0; e < ready; ++e) {
+            uint64_t tag = events[e].data.u64;
+            if (tag == UINT64_MAX) {
+                uint64_t expirations;
+                while (read(timer_fd, &expirations, sizeof(expirations)) > 0) {
+                }
+                continue;
+            }
+
+            size_t i = static_cast<size_t>(tag);
+            Connection& conn = connections[i];
+            bool broken = (events[e].events & (EPOLLERR | EPOLLHUP)) != 0;
+
+            if (!broken && (events[e].events & EPOLLOUT) && conn.busy) {
+                broken = !sendMore(i);
+            }
+
+            if (!broken && (events[e].events & EPOLLIN)) {
+                while (true) {
+                    ssize_t n = recv(conn.fd, read_buffer, sizeof(read_buffer), 0);
+                    if (n > 0) {
+                        conn.recv_buffer.append(read_buffer, static_cast<size_t>(n));
+                        continue;
+                    }
+                    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        broken = true;
+                    }
+                    break;
+                }
+
+                int status = conn.busy ? takeResponse(conn.recv_buffer) : 0;
+                if (status > 0) {
+                    finish(conn, status == 200);
+                    idle.push_back(i);
+                } else if (status < 0) {
+                    broken = true;
+                }
+            }
+
+            if (broken) {
+                if (conn.busy) {
+                    finish(conn, false);
+                }
+                reconnect(i);
+            }
+        }
+    }
+
+    // 끝나지 않은 요청은 지금까지 기다린 시간으로 전체 분포에 기록 (실제 latency는 이보다 길다)
+    auto end = Clock::now();
+    for (const auto& p : pending) {
+        if (p.intended >= measure_begin) {
+            recordAll(p.intended, end);
+            ++result.unfinished;
+        }
+    }
+    for (auto& conn : connections) {
+        if (conn.busy && conn.record) {
+            recordAll(conn.intended, end);
+            ++result.unfinished;
+        }
+        if (conn.fd != -1) {
+            close(conn.fd);
+        }
+    }
+    close(timer_fd);
+    close(epoll_fd);
+}
+
+StepResult runStep(const LoadGenOptions& options, const std::vector<std::string>& requests, double target_rps,
+                   uint64_t step_seed) {
+    size_t threads = std::max<size_t>(1, options.threads);
+    std::vector<ThreadResult> results(threads);
+    std::vector<std::thread> workers;
+
+    // 모든 스레드가 같은 시작 시각 기준으로 도착을 생성 (스레드 생성 지연이 latency에 섞이지 않도록 약간 뒤)
+    auto start = Clock::now() + std::chrono::milliseconds(100);
+    for (size_t t = 0; t < threads; ++t) {
+        size_t conns = options.connections / threads + (t < options.connections % threads ? 1 : 0);
+        workers.emplace_back(runStepThread, std::cref(options), std::cref(requests), target_rps / threads,
+                             std::max<size_t>(1, conns), step_seed * 1000003 + t, start, std::ref(results[t]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    StepResult step;
+    step.target_rps = target_rps;
+    uint64_t completed = 0;
+    for (const auto& result : results) {
+        step.latency_us.add(result.latency_us);
+        step.all_latency_us.add(result.all_latency_us);
+        completed += result.completed;
+        step.errors += result.errors;
+        step.unfinished += result.unfinished;
+    }
+    step.achieved_rps = completed / options.duration_s;
+    return step;
+}
+
+// ---------------------------------------------------------------------------
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " --queries <embeddings.bin> [options]\n"
+              << "  --host <addr>            (default 127.0.0.1)\n"
+              << "  --port <n>               (default 8080)\n"
+              << "  --dim <n>                (default 768)\n"
+              << "  --num-queries <n>        query embeddings to load (default 10000)\n"
+              << "  --query-offset <n>       skip the first n rows (default 0)\n"
+              << "  --k <n> / --ef <n>       search parameters (default 10 / server default)\n"
+              << "  --json                   use /api/search instead of /api/search/bin\n"
+              << "  --deadline-ms <ms>       send a per-request deadline (503/504 count as errors)\n"
+              << "  --threads <n>            client threads (default 4)\n"
+              << "  --connections <n>        total keep-alive connections (default 64)\n"
+              << "  --rps <r>                single step at r requests/s\n"
+              << "  --sweep <start:step:max> increase target RPS until saturation\n"
+              << "  --duration <s>           measured seconds per step (default 10)\n"
+              << "  --warmup <s>             unmeasured seconds per step (default 2)\n"
+              << "  --slo-p99-ms <ms>        stop the sweep when p99 of all requests (errors included) exceeds this\n"
+              << "  --output <prefix>        write <prefix>_<rps>.hgrm, <prefix>_<rps>_all.hgrm and <prefix>_summary.csv\n"
+              << "  --seed <n>\n";
+}
+
+bool parseSweep(const std::string& spec, LoadGenOptions& options) {
+    double start, step, max;
+    if (std::sscanf(spec.c_str(), "%lf:%lf:%lf", &start, &step, &max) != 3 || start <= 0 || step <= 0 || max < start) {
+        return false;
+    }
+    options.rps_start = start;
+    options.rps_step = step;
+    options.rps_max = max;
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    LoadGenOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+
+        if (arg == "--host") {
+            options.host = next();
+        } else if (arg == "--port") {
+            options.port = std::atoi(next());
+        } else if (arg == "--queries") {
+            options.queries_path = next();
+        } else if (arg == "--dim") {
+            options.dim = std::strtoull(next(), nullptr, 10);
+        } else if (arg == "--num-queries") {
+            options.num_queries = std::strtoull(next(), nullptr, 10);
+        } else if (arg == "--query-offset") {
+            options.query_offset = std::strtoull(next(), nullptr, 10);
+        } else if (arg == "--k") {
+            options.k = std::atoi(next());
+        } else if (arg == "--ef") {
+            options.ef = std::atoi(next());
+        } else if (arg == "--deadline-ms") {
+            options.deadline_ms = std::max(0, std::atoi(next()));
+        } else if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(next(), nullptr, 10);
+        } else if (arg == "--connections") {
+            options.connections = std::strtoull(next(), nullptr, 10);
+        } else if (arg == "--rps") {
+            options.rps_start = options.rps_max = std::strtod(next(), nullptr);
+        } else if (arg == "--sweep") {
+            if (!parseSweep(next(), options)) {
+                std::cerr << "Invalid --sweep (expected start:step:max)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--duration") {
+            options.duration_s = std::strtod(next(), nullptr);
+        } else if (arg == "--warmup") {
+            options.warmup_s = std::strtod(next(), nullptr);
+        } else if (arg == "--slo-p99-ms") {
+            options.slo_p99_ms = std::strtod(next(), nullptr);
+        } else if (arg == "--output") {
+            options.output_prefix = next();
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(next(), nullptr, 10);
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.queries_path.empty() || options.rps_start <= 0 || options.duration_s <= 0 ||
+        options.k <= 0 || options.dim == 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    options.connections = std::max(options.connections, options.threads);
+
+    std::vector<float> queries;
+    if (!loadQueries(options, queries)) {
+        return 1;
+    }
+    std::vector<std::string> requests = buildRequests(options, queries);
+    if (requests.empty()) {
+        std::cerr << "No queries loaded" << std::endl;
+        return 1;
+    }
+
+    std::ofstream summary;
+    if (!options.output_prefix.empty()) {
+        summary.open(options.output_prefix + "_summary.csv");
+        summary << "target_rps,achieved_rps,p50_us,p90_us,p99_us,p999_us,max_us,errors,unfinished,"
+                   "all_p99_us,all_p999_us,all_max_us\n";
+    }
+
+    // p*_ms는 200 응답만, all_*는 오류와 미완료 요청까지 포함
+    std::printf("%12s %12s %10s %10s %10s %10s %10s %8s %10s %10s %10s\n", "target_rps", "achieved", "p50_ms", "p90_ms",
+                "p99_ms", "p99.9_ms", "max_ms", "errors", "unfinished", "all_p99", "all_p99.9");
+
+    uint64_t step_index = 0;
+    for (double rps = options.rps_start; rps <= options.rps_max + 1e-9; rps += options.rps_step, ++step_index) {
+        StepResult step = runStep(options, requests, rps, options.seed + step_index);
+        const auto& h = step.latency_us;
+        const auto& all = step.all_latency_us;
+
+        std::printf("%12.0f %12.1f %10.3f %10.3f %10.3f %10.3f %10.3f %8llu %10llu %10.3f %10.3f\n", step.target_rps,
+                    step.achieved_rps, h.valueAtPercentile(50) / 1000.0, h.valueAtPercentile(90) / 1000.0,
+                    h.valueAtPercentile(99) / 1000.0, h.valueAtPercentile(99.9) / 1000.0, h.max() / 1000.0,
+                    static_cast<unsigned long long>(step.errors), static_cast<unsigned long long>(step.unfinished),
+                    all.valueAtPercentile(99) / 1000.0, all.valueAtPercentile(99.9) / 1000.0);
+        std::fflush(stdout);
+
+        if (!options.output_prefix.empty()) {
+            std::string step_prefix = options.output_prefix + "_" + std::to_string(static_cast<long long>(rps));
+            std::ofstream hgrm(step_prefix + ".hgrm");
+            h.writePercentiles(hgrm, 1000.0);
+            std::ofstream all_hgrm(step_prefix + "_all.hgrm");
+            all.writePercentiles(all_hgrm, 1000.0);
+            summary << step.target_rps << "," << step.achieved_rps << "," << h.valueAtPercentile(50) << ","
+                    << h.valueAtPercentile(90) << "," << h.valueAtPercentile(99) << ","
+                    << h.valueAtPercentile(99.9) << "," << h.max() << "," << step.errors << ","
+                    << step.unfinished << "," << all.valueAtPercentile(99) << ","
+                    << all.valueAtPercentile(99.9) << "," << all.max() << "\n";
+            summary.flush();
+        }
+
+        // 서버가 목표를 못 따라가거나 SLO를 넘으면 그 이상은 의미 없음
+        bool saturated = step.achieved_rps < step.target_rps * options.min_achieved;
+        // 실패가 빠진 분포로 판단하면 거절/만료가 늘수록 p99가 오히려 좋아 보이므로 전체 분포 기준
+        bool slo_violated = options.slo_p99_ms > 0 && all.valueAtPercentile(99) / 1000.0 > options.slo_p99_ms;
+        if (saturated || slo_violated) {
+            std::cout << "Stopping sweep at " << rps << " RPS ("
+                      << (saturated ? "throughput saturated" : "p99 above SLO") << ")" << std::endl;
+            break;
+        }
+    }
+
+    return 0;
+}
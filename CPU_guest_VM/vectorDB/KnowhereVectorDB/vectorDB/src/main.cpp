@@ -2,6 +2,7 @@
 #include <iostream>
 #include <csignal>
 #include <memory>
+#include <algorithm>
 
 std::unique_ptr<VectorDBServer> g_server;
 
@@ -23,27 +24,144 @@ int main(int argc, char* argv[]) {
     // 기본 파라미터
     std::string hnsw_dir = "../knowhere_cpp";
     std::string flat_path = "flat_index.bin";
-    int port = 8080;
+    ServerConfig config;
     
-    // 명령행 인수 처리
-    if (argc >= 2) {
-        hnsw_dir = argv[1];
-    }
-    if (argc >= 3) {
-        flat_path = argv[2];
-    }
-    if (argc >= 4) {
-        port = std::atoi(argv[3]);
+    // 명령행 인수 처리: [hnsw_dir] [flat_path] [port] [--옵션 값 ...]
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--shard-threads" && i + 1 < argc) {
+            config.db.shard_threads_per_queue = std::atoi(argv[++i]);
+        } else if (arg == "--shard-cpus" && i + 1 < argc) {
+            config.db.shard_cpus = ShardExecutor::parseCpuList(argv[++i]);
+        } else if (arg == "--cpus" && i + 1 < argc) {
+            config.threads.cpus = ShardExecutor::parseCpuList(argv[++i]);
+            if (config.threads.cpus.empty()) {
+                return 1;
+            }
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            config.threads.io_threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--search-node" && i + 1 < argc) {
+            config.threads.search_node = std::atoi(argv[++i]);
+        } else if (arg == "--pin-threads") {
+            config.threads.pin = true;
+        } else if (arg == "--compute-threads" && i + 1 < argc) {
+            config.db.compute_threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            config.search_workers = std::atoi(argv[++i]);
+        } else if (arg == "--max-batch" && i + 1 < argc) {
+            config.max_batch_size = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--search-slots" && i + 1 < argc) {
+            config.search_slots = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--batch-wait-us" && i + 1 < argc) {
+            config.max_batch_wait = std::chrono::microseconds(std::atoll(argv[++i]));
+        } else if (arg == "--latency-target-us" && i + 1 < argc) {
+            config.batch_latency_target = std::chrono::microseconds(std::atoll(argv[++i]));
+        } else if (arg == "--default-deadline-ms" && i + 1 < argc) {
+            config.default_deadline = std::chrono::milliseconds(std::max(0LL, std::atoll(argv[++i])));
+        } else if (arg == "--no-admission-control") {
+            config.admission_control = false;
+        } else if (arg == "--auto-tune") {
+            config.auto_tune = true;
+        } else if (arg == "--tune-p99-us" && i + 1 < argc) {
+            config.tuning.p99_bound = std::chrono::microseconds(std::max(1LL, std::atoll(argv[++i])));
+        } else if (arg == "--tune-interval-ms" && i + 1 < argc) {
+            config.tuning.interval = std::chrono::milliseconds(std::max(100LL, std::atoll(argv[++i])));
+        } else if (arg == "--tune-max-batch" && i + 1 < argc) {
+            config.tuning.max_batch_limit = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--tune-max-wait-us" && i + 1 < argc) {
+            config.tuning.max_batch_wait_us = std::max(0LL, std::atoll(argv[++i]));
+        } else if (arg == "--adaptive-ef-depth" && i + 1 < argc) {
+            config.adaptive_ef_queue_depth = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--min-adaptive-ef" && i + 1 < argc) {
+            config.min_adaptive_ef = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--query-cache" && i + 1 < argc) {
+            config.query_cache_entries = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--query-cache-quantize" && i + 1 < argc) {
+            config.query_cache_quantize = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--load-threads" && i + 1 < argc) {
+            config.db.shard_load.load_threads = std::atoi(argv[++i]);
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            if (!parseShardWarmup(argv[++i], config.db.shard_load.warmup)) {
+                std::cerr << "알 수 없는 warmup 모드: " << argv[i] << " (none|willneed|touch)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--dram-replica-mb" && i + 1 < argc) {
+            config.db.shard_load.dram_replica_bytes = std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        } else if (arg == "--shard-filter" && i + 1 < argc) {
+            if (!parseShardFilter(argv[++i], config.db.shard_load.shard_filter_index,
+                                  config.db.shard_load.shard_filter_count)) {
+                std::cerr << "잘못된 샤드 필터: " << argv[i] << " (i/n, 0 <= i < n)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--engine" && i + 1 < argc) {
+            if (!parseShardEngine(argv[++i], config.db.shard_load.engine)) {
+                std::cerr << "알 수 없는 검색 엔진: " << argv[i] << " (hnsw|ivf_sq8)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--ivf-nlist" && i + 1 < argc) {
+            config.db.shard_load.ivf.nlist = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--ivf-nprobe" && i + 1 < argc) {
+            config.db.shard_load.ivf.nprobe = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--ivf-rerank" && i + 1 < argc) {
+            config.db.shard_load.ivf.rerank_factor = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--replicate-neighbors") {
+            config.db.shard_load.replicate_level0_neighbors = true;
+        } else if (arg == "--trace-pages") {
+            config.db.trace_pages = true;
+        } else if (arg == "--trace-granule-kb" && i + 1 < argc) {
+            config.db.page_trace.granule_bytes = std::strtoull(argv[++i], nullptr, 10) * 1024;
+        } else if (arg == "--trace-sample" && i + 1 < argc) {
+            config.db.page_trace.sample_granules = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--trace-interval-ms" && i + 1 < argc) {
+            config.db.page_trace.interval = std::chrono::milliseconds(std::atoll(argv[++i]));
+        } else if (arg == "--trace-output" && i + 1 < argc) {
+            config.db.trace_output = argv[++i];
+        } else if (arg == "--compact-threshold" && i + 1 < argc) {
+            config.db.compact_threshold = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-compaction") {
+            config.db.enable_compaction = false;
+        } else if (arg == "--flat-codes" && i + 1 < argc) {
+            if (!parseFlatCodeType(argv[++i], config.db.flat.code_type)) {
+                std::cerr << "알 수 없는 flat 코드 타입: " << argv[i] << " (none|fp16|sq8)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--flat-sharing" && i + 1 < argc) {
+            if (!parseFlatSharingMode(argv[++i], config.db.flat.sharing)) {
+                std::cerr << "알 수 없는 flat 공유 역할: " << argv[i] << " (local|writer|reader)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--flat-poll-ms" && i + 1 < argc) {
+            config.db.flat_poll_interval = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--flat-rerank" && i + 1 < argc) {
+            config.db.flat.rerank_factor = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "알 수 없는 옵션: " << arg << std::endl;
+            return 1;
+        } else if (positional == 0) {
+            hnsw_dir = arg;
+            ++positional;
+        } else if (positional == 1) {
+            flat_path = arg;
+            ++positional;
+        } else if (positional == 2) {
+            config.port = std::atoi(arg.c_str());
+            ++positional;
+        }
     }
     
     std::cout << "설정:" << std::endl;
     std::cout << "  HNSW 인덱스 디렉토리: " << hnsw_dir << std::endl;
     std::cout << "  Flat 인덱스: " << flat_path << std::endl;
-    std::cout << "  포트: " << port << std::endl;
+    std::cout << "  포트: " << config.port << std::endl;
+    std::cout << "  샤드 큐당 스레드: "
+              << (config.db.shard_threads_per_queue ? std::to_string(config.db.shard_threads_per_queue) : "auto")
+              << std::endl;
     
     try {
         // 서버 생성 및 초기화
-        g_server = std::make_unique<VectorDBServer>(hnsw_dir, flat_path, port);
+        g_server = std::make_unique<VectorDBServer>(hnsw_dir, flat_path, config);
         
         if (!g_server->initialize()) {
             std::cerr << "서버 초기화 실패" << std::endl;
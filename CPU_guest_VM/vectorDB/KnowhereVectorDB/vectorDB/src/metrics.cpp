@@ -0,0 +1,141 @@
+#include "metrics.h"
+#include <algorithm>
+
+namespace {
+
+// 스레드마다 고정된 stripe 번호 (처음 기록할 때 순서대로 배정)
+size_t threadStripe(size_t num_stripes) {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed);
+    return stripe % num_stripes;
+}
+
+}  // namespace
+
+Histogram::Histogram(std::vector<uint64_t> bounds)
+    : bounds_(std::move(bounds)), stripes_(std::make_unique<Stripe[]>(NUM_STRIPES)) {
+    for (size_t s = 0; s < NUM_STRIPES; ++s) {
+        stripes_[s].buckets = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+    }
+}
+
+void Histogram::observe(uint64_t value) {
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    Stripe& stripe = stripes_[threadStripe(NUM_STRIPES)];
+    stripe.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    stripe.count.fetch_add(1, std::memory_order_relaxed);
+    stripe.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::count() const {
+    uint64_t total = 0;
+    for (size_t s = 0; s < NUM_STRIPES; ++s) {
+        total += stripes_[s].count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<uint64_t> Histogram::bucketCounts() const {
+    std::vector<uint64_t> buckets(bounds_.size() + 1, 0);
+    for (size_t s = 0; s < NUM_STRIPES; ++s) {
+        for (size_t b = 0; b <= bounds_.size(); ++b) {
+            buckets[b] += stripes_[s].buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+    return buckets;
+}
+
+uint64_t Histogram::percentile(const std::vector<uint64_t>& counts, double q) const {
+    uint64_t total = 0;
+    for (uint64_t c : counts) {
+        total += c;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    
+    double rank = q * static_cast<double>(total);
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b < counts.size(); ++b) {
+        if (counts[b] == 0 || static_cast<double>(cumulative + counts[b]) < rank) {
+            cumulative += counts[b];
+            continue;
+        }
+        // +Inf 버킷은 마지막 상한으로 보고
+        if (b >= bounds_.size()) {
+            return bounds_.empty() ? 0 : bounds_.back();
+        }
+        double lower = b == 0 ? 0.0 : static_cast<double>(bounds_[b - 1]);
+        double fraction = (rank - static_cast<double>(cumulative)) / static_cast<double>(counts[b]);
+        return static_cast<uint64_t>(lower + fraction * (static_cast<double>(bounds_[b]) - lower));
+    }
+    return bounds_.empty() ? 0 : bounds_.back();
+}
+
+void Histogram::render(std::ostream& out, const std::string& name, const std::string& labels) const {
+    std::vector<uint64_t> buckets = bucketCounts();
+    uint64_t sum = 0;
+    for (size_t s = 0; s < NUM_STRIPES; ++s) {
+        sum += stripes_[s].sum.load(std::memory_order_relaxed);
+    }
+    
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b < bounds_.size(); ++b) {
+        cumulative += buckets[b];
+        out << name << "_bucket{" << prefix << "le=\"" << bounds_[b] << "\"} " << cumulative << "\n";
+    }
+    cumulative += buckets[bounds_.size()];
+    // 합산 도중 기록이 들어와도 +Inf 버킷과 count가 어긋나지 않도록 누적값을 count로 사용
+    out << name << "_bucket{" << prefix << "le=\"+Inf\"} " << cumulative << "\n";
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    out << name << "_sum" << suffix << " " << sum << "\n";
+    out << name << "_count" << suffix << " " << cumulative << "\n";
+}
+
+std::vector<uint64_t> Histogram::latencyBucketsUs() {
+    std::vector<uint64_t> bounds;
+    for (uint64_t decade = 10; decade <= 1000000; decade *= 10) {
+        bounds.push_back(decade);
+        bounds.push_back(decade * 5 / 2);
+        bounds.push_back(decade * 5);
+    }
+    bounds.push_back(10000000);
+    return bounds;
+}
+
+std::vector<uint64_t> Histogram::sizeBuckets() {
+    std::vector<uint64_t> bounds;
+    for (uint64_t size = 1; size <= 4096; size *= 2) {
+        bounds.push_back(size);
+    }
+    return bounds;
+}
+
+SearchMetrics::SearchMetrics()
+    : flat_scan_us(Histogram::latencyBucketsUs()), shard_merge_us(Histogram::latencyBucketsUs()),
+      tier_merge_us(Histogram::latencyBucketsUs()) {
+    for (size_t i = 0; i < MAX_TRACKED_SHARDS; ++i) {
+        hnsw_shard_us.push_back(std::make_unique<Histogram>(Histogram::latencyBucketsUs()));
+    }
+}
+
+void SearchMetrics::render(std::ostream& out, size_t shard_count) const {
+    renderMetricHeader(out, "vectordb_hnsw_shard_search_us", "histogram",
+                       "HNSW search time per shard and batch in microseconds");
+    for (size_t i = 0; i < std::min(shard_count, MAX_TRACKED_SHARDS); ++i) {
+        hnsw_shard_us[i]->render(out, "vectordb_hnsw_shard_search_us", "shard=\"" + std::to_string(i) + "\"");
+    }
+    renderMetricHeader(out, "vectordb_flat_scan_us", "histogram",
+                       "Flat index brute-force scan time per batch in microseconds");
+    flat_scan_us.render(out, "vectordb_flat_scan_us");
+    renderMetricHeader(out, "vectordb_merge_us", "histogram",
+                       "Result merge time per batch in microseconds (stage: shards, tiers)");
+    shard_merge_us.render(out, "vectordb_merge_us", "stage=\"shards\"");
+    tier_merge_us.render(out, "vectordb_merge_us", "stage=\"tiers\"");
+}
+
+void renderMetricHeader(std::ostream& out, const std::string& name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
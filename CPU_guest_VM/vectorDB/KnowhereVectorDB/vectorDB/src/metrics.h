@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+// Prometheus exposition용 히스토그램
+//
+// 기록은 스레드별 stripe에 relaxed atomic으로만 하므로 락이 없고, 같은 cache line을
+// 여러 스레드가 두드리지 않음. 렌더링할 때 stripe들을 합산 (근사 스냅샷).
+class Histogram {
+private:
+    static constexpr size_t NUM_STRIPES = 16;
+    
+    struct alignas(64) Stripe {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;  // bounds_.size() + 1 (마지막은 +Inf)
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+    };
+    
+    std::vector<uint64_t> bounds_;  // 버킷 상한 (오름차순)
+    std::unique_ptr<Stripe[]> stripes_;
+
+public:
+    explicit Histogram(std::vector<uint64_t> bounds);
+    
+    void observe(uint64_t value);
+    
+    // 시작 시점부터 지금까지의 경과 시간(us) 기록
+    void observeSince(std::chrono::steady_clock::time_point start) {
+        observe(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+    
+    uint64_t count() const;
+    
+    // 버킷별 (비누적) count 스냅샷, 두 스냅샷의 차이로 구간 분포를 구함
+    std::vector<uint64_t> bucketCounts() const;
+    // bucketCounts() 형태의 분포에서 q 분위수 (버킷 안은 선형 보간, 비어 있으면 0)
+    uint64_t percentile(const std::vector<uint64_t>& counts, double q) const;
+    
+    // name_bucket{labels,le="..."} / name_sum / name_count 출력 (labels는 `shard="0"` 형태 또는 빈 문자열)
+    void render(std::ostream& out, const std::string& name, const std::string& labels = "") const;
+    
+    // 10us ~ 10s 구간의 latency 버킷 (1-2.5-5 간격)
+    static std::vector<uint64_t> latencyBucketsUs();
+    // 1 ~ 4096 구간의 2의 거듭제곱 버킷 (배치 크기 등)
+    static std::vector<uint64_t> sizeBuckets();
+};
+
+// 검색 경로 단계별 latency (VectorDB / HNSWIndexManager에서 기록)
+struct SearchMetrics {
+    static constexpr size_t MAX_TRACKED_SHARDS = 64;  // 이보다 많은 샤드는 마지막 히스토그램에 합산
+    
+    std::vector<std::unique_ptr<Histogram>> hnsw_shard_us;  // 샤드별 검색 시간 (배치 단위)
+    Histogram flat_scan_us;
+    Histogram shard_merge_us;   // HNSW 샤드 결과 병합
+    Histogram tier_merge_us;    // HNSW 결과와 flat 결과 병합
+    
+    SearchMetrics();
+    
+    Histogram& shard(size_t index_idx) {
+        return *hnsw_shard_us[std::min(index_idx, MAX_TRACKED_SHARDS - 1)];
+    }
+    
+    void render(std::ostream& out, size_t shard_count) const;
+};
+
+// "# HELP" / "# TYPE" 헤더
+void renderMetricHeader(std::ostream& out, const std::string& name, const char* type, const char* help);
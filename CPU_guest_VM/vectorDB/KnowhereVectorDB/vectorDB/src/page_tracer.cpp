@@ -0,0 +1,447 @@
+#include "page_tracer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+std::atomic<PageAccessTracer*> PageAccessTracer::active_{nullptr};
+
+namespace {
+
+// damo_yamls와 같은 천 단위 구분 표기 ("104,155,054,080")
+std::string withCommas(uint64_t value) {
+    std::string digits = std::to_string(value);
+    std::string out;
+    for (size_t i = 0; i < digits.size(); ++i) {
+        if (i > 0 && (digits.size() - i) % 3 == 0) {
+            out += ',';
+        }
+        out += digits[i];
+    }
+    return out;
+}
+
+}  // namespace
+
+PageAccessTracer::PageAccessTracer(const PageTracerOptions& options)
+    : options_(options), region_count_(0), stop_(false), running_(false),
+      epochs_(0), faults_(0), queries_(0) {
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    options_.granule_bytes = std::max(page_size, options_.granule_bytes / page_size * page_size);
+    options_.sample_granules = std::max<size_t>(1, options_.sample_granules);
+}
+
+PageAccessTracer::~PageAccessTracer() {
+    stop();
+}
+
+bool PageAccessTracer::addRegion(const std::string& name, const FileMapping& mapping) {
+    size_t idx = region_count_.load();
+    if (running_.load() || idx >= MAX_REGIONS || mapping.addr == nullptr || mapping.length == 0) {
+        return false;
+    }
+    Region& region = regions_[idx];
+    region.name = name;
+    region.addr = mapping.addr;
+    region.length = mapping.length;
+    region.prot = mapping.prot ? mapping.prot : PROT_READ;
+    region.granules = (mapping.length + options_.granule_bytes - 1) / options_.granule_bytes;
+    region.armed = std::make_unique<std::atomic<uint8_t>[]>(region.granules);
+    region.samples = std::make_unique<std::atomic<uint32_t>[]>(region.granules);
+    region.hits = std::make_unique<std::atomic<uint32_t>[]>(region.granules);
+    region_count_.store(idx + 1);
+    return true;
+}
+
+size_t PageAccessTracer::granuleLength(const Region& region, size_t granule) const {
+    size_t offset = granule * options_.granule_bytes;
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t len = std::min(options_.granule_bytes, region.length - offset);
+    return (len + page_size - 1) / page_size * page_size;
+}
+
+bool PageAccessTracer::start() {
+    if (running_.load() || region_count_.load() == 0) {
+        return false;
+    }
+    PageAccessTracer* expected = nullptr;
+    if (!active_.compare_exchange_strong(expected, this)) {
+        std::cerr << "Another page access tracer is already running" << std::endl;
+        return false;
+    }
+    
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = &PageAccessTracer::onFault;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGSEGV, &action, &previous_action_) != 0) {
+        active_.store(nullptr);
+        return false;
+    }
+    
+    stop_ = false;
+    running_.store(true);
+    sampler_ = std::thread([this] { samplerLoop(); });
+    
+    size_t total_bytes = 0;
+    for (size_t r = 0; r < region_count_.load(); ++r) {
+        total_bytes += regions_[r].length;
+    }
+    std::cout << "Page access tracing started: " << region_count_.load() << " regions, "
+              << total_bytes / 1024 / 1024 << "MB, granule " << options_.granule_bytes / 1024
+              << "KB, " << options_.sample_granules << " granules per " << options_.interval.count()
+              << "ms epoch" << std::endl;
+    return true;
+}
+
+void PageAccessTracer::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        stop_ = true;
+    }
+    sampler_cv_.notify_all();
+    if (sampler_.joinable()) {
+        sampler_.join();
+    }
+    
+    // 남은 감시 granule 복구 후 handler 해제
+    for (size_t r = 0; r < region_count_.load(); ++r) {
+        for (size_t g = 0; g < regions_[r].granules; ++g) {
+            disarm(regions_[r], g);
+        }
+    }
+    sigaction(SIGSEGV, &previous_action_, nullptr);
+    active_.store(nullptr);
+    running_.store(false);
+    std::cout << "Page access tracing stopped: " << epochs_.load() << " epochs, "
+              << faults_.load() << " sampled accesses" << std::endl;
+}
+
+void PageAccessTracer::disarm(Region& region, size_t granule) {
+    if (region.armed[granule].exchange(0) == 1) {
+        mprotect(granuleAddr(region, granule), granuleLength(region, granule), region.prot);
+    }
+}
+
+void PageAccessTracer::samplerLoop() {
+    std::mt19937_64 rng(std::random_device{}());
+    
+    // granule 번호를 전체 영역에 걸쳐 균등하게 뽑기 위한 누적 합
+    size_t region_count = region_count_.load();
+    std::vector<size_t> prefix(region_count + 1, 0);
+    for (size_t r = 0; r < region_count; ++r) {
+        prefix[r + 1] = prefix[r] + regions_[r].granules;
+    }
+    std::uniform_int_distribution<size_t> pick(0, prefix.back() - 1);
+    
+    std::vector<std::pair<size_t, size_t>> armed;
+    armed.reserve(options_.sample_granules);
+    
+    while (true) {
+        // 1. 이전 epoch에 감시했지만 접근되지 않은 granule 복구 (hit 없이 sample만 남음)
+        for (const auto& [r, g] : armed) {
+            disarm(regions_[r], g);
+        }
+        armed.clear();
+        
+        {
+            std::unique_lock<std::mutex> lock(sampler_mutex_);
+            if (stop_) {
+                break;
+            }
+        }
+        
+        // 2. 새 granule들을 PROT_NONE으로 감시
+        for (size_t i = 0; i < options_.sample_granules; ++i) {
+            size_t global = pick(rng);
+            size_t r = std::upper_bound(prefix.begin(), prefix.end(), global) - prefix.begin() - 1;
+            size_t g = global - prefix[r];
+            Region& region = regions_[r];
+            if (region.armed[g].exchange(1) != 0) {
+                continue;
+            }
+            if (mprotect(granuleAddr(region, g), granuleLength(region, g), PROT_NONE) != 0) {
+                // VMA 한도(ENOMEM) 등: 이번 epoch은 여기까지만 감시
+                region.armed[g].store(0);
+                break;
+            }
+            region.samples[g].fetch_add(1, std::memory_order_relaxed);
+            armed.emplace_back(r, g);
+        }
+        epochs_.fetch_add(1, std::memory_order_relaxed);
+        
+        std::unique_lock<std::mutex> lock(sampler_mutex_);
+        sampler_cv_.wait_for(lock, options_.interval, [this] { return stop_; });
+    }
+}
+
+void PageAccessTracer::onFault(int signo, siginfo_t* info, void* context) {
+    PageAccessTracer* tracer = active_.load(std::memory_order_acquire);
+    uint8_t* addr = static_cast<uint8_t*>(info->si_addr);
+    
+    if (tracer != nullptr) {
+        size_t region_count = tracer->region_count_.load(std::memory_order_acquire);
+        for (size_t r = 0; r < region_count; ++r) {
+            Region& region = tracer->regions_[r];
+            if (addr < region.addr || addr >= region.addr + region.length) {
+                continue;
+            }
+            size_t g = static_cast<size_t>(addr - region.addr) / tracer->options_.granule_bytes;
+            if (region.armed[g].exchange(0) == 1) {
+                region.hits[g].fetch_add(1, std::memory_order_relaxed);
+                tracer->faults_.fetch_add(1, std::memory_order_relaxed);
+                mprotect(tracer->granuleAddr(region, g), tracer->granuleLength(region, g), region.prot);
+            }
+            // 다른 스레드가 먼저 복구 중이면 그대로 반환 → 복구될 때까지 재시도
+            return;
+        }
+        
+        // 추적 영역 밖의 진짜 segfault: 이전 handler로 되돌리고 반환하면 같은 명령이 다시
+        // fault를 일으켜 원래 동작(core dump 등)을 그대로 얻음
+        sigaction(SIGSEGV, &tracer->previous_action_, nullptr);
+        return;
+    }
+    
+    (void)context;
+    signal(signo, SIG_DFL);
+}
+
+bool PageAccessTracer::writeHeatmap(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open heatmap file: " << path << std::endl;
+        return false;
+    }
+    
+    out << "# page access heatmap\n";
+    out << "# granule_bytes\t" << options_.granule_bytes << "\n";
+    out << "# interval_ms\t" << options_.interval.count() << "\n";
+    out << "# epochs\t" << epochs_.load() << "\n";
+    out << "# sampled_accesses\t" << faults_.load() << "\n";
+    out << "# queries\t" << queries_.load() << "\n";
+    
+    // 영역별 접근률 히스토그램: 샘플된 granule 비율로 전체 바이트를 추정
+    out << "# histogram: region\tsampled_granules\tbucket(rate)\tgranules\testimated_bytes\n";
+    for (size_t r = 0; r < region_count_.load(); ++r) {
+        const Region& region = regions_[r];
+        size_t sampled = 0;
+        size_t buckets[HISTOGRAM_BUCKETS + 1] = {};
+        for (size_t g = 0; g < region.granules; ++g) {
+            uint32_t samples = region.samples[g].load();
+            if (samples == 0) continue;
+            double rate = static_cast<double>(region.hits[g].load()) / samples;
+            ++sampled;
+            // bucket 0은 한 번도 접근되지 않은 granule, 1..N은 (i-1)/N < rate <= i/N
+            int bucket = rate <= 0.0 ? 0 : std::min<int>(HISTOGRAM_BUCKETS,
+                static_cast<int>(rate * HISTOGRAM_BUCKETS + 0.999999));
+            ++buckets[bucket];
+        }
+        for (int b = 0; b <= HISTOGRAM_BUCKETS; ++b) {
+            double estimated = sampled ? static_cast<double>(buckets[b]) / sampled * region.length : 0.0;
+            out << "# " << region.name << "\t" << sampled << "\t";
+            if (b == 0) {
+                out << "0";
+            } else {
+                out << static_cast<double>(b - 1) / HISTOGRAM_BUCKETS << "-"
+                    << static_cast<double>(b) / HISTOGRAM_BUCKETS;
+            }
+            out << "\t" << buckets[b] << "\t" << static_cast<uint64_t>(estimated) << "\n";
+        }
+    }
+    
+    out << "region\toffset\tsamples\thits\trate\n";
+    for (size_t r = 0; r < region_count_.load(); ++r) {
+        const Region& region = regions_[r];
+        for (size_t g = 0; g < region.granules; ++g) {
+            uint32_t samples = region.samples[g].load();
+            if (samples == 0) continue;
+            uint32_t hits = region.hits[g].load();
+            out << region.name << "\t" << g * options_.granule_bytes << "\t" << samples << "\t"
+                << hits << "\t" << static_cast<double>(hits) / samples << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool PageAccessTracer::isDamonAction(const std::string& action) {
+    static constexpr const char* ACTIONS[] = {
+        "willneed", "cold", "pageout", "hugepage", "nohugepage", "lru_prio", "lru_deprio",
+        "migrate_hot", "migrate_cold", "stat", "replicate", "evict",
+    };
+    return std::find(std::begin(ACTIONS), std::end(ACTIONS), action) != std::end(ACTIONS);
+}
+
+bool PageAccessTracer::writeDamonScheme(const std::string& path, double min_rate,
+                                        const std::string& action) const {
+    // action은 JSON 문자열에 그대로 들어가므로 알려진 이름만 허용
+    if (!isDamonAction(action)) {
+        std::cerr << "Unknown DAMOS action: " << action << std::endl;
+        return false;
+    }
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    
+    // hot granule들의 가상 주소 범위
+    std::vector<std::pair<uintptr_t, uintptr_t>> hot;
+    for (size_t r = 0; r < region_count_.load(); ++r) {
+        const Region& region = regions_[r];
+        for (size_t g = 0; g < region.granules; ++g) {
+            uint32_t samples = region.samples[g].load();
+            if (samples == 0 || static_cast<double>(region.hits[g].load()) / samples < min_rate) {
+                continue;
+            }
+            uintptr_t begin = reinterpret_cast<uintptr_t>(granuleAddr(region, g));
+            hot.emplace_back(begin, begin + granuleLength(region, g));
+        }
+    }
+    
+    // 물리 주소로 변환 (pagemap의 PFN은 CAP_SYS_ADMIN 없이는 0으로 보임)
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    bool physical = true;
+    int pagemap = open("/proc/self/pagemap", O_RDONLY);
+    if (pagemap < 0) {
+        physical = false;
+    }
+    for (const auto& [begin, end] : hot) {
+        if (!physical) break;
+        for (uintptr_t va = begin; va < end; va += page_size) {
+            uint64_t entry = 0;
+            if (pread(pagemap, &entry, sizeof(entry), (va / page_size) * sizeof(entry)) != sizeof(entry)) {
+                physical = false;
+                break;
+            }
+            uint64_t pfn = entry & ((1ULL << 55) - 1);
+            if (!(entry & (1ULL << 63)) || pfn == 0) {
+                // 아직 fault-in 되지 않은 페이지는 건너뛰고, PFN 자체를 볼 수 없으면 vaddr로 전환
+                if (entry & (1ULL << 63)) physical = false;
+                continue;
+            }
+            ranges.emplace_back(pfn * page_size, pfn * page_size + page_size);
+        }
+    }
+    if (pagemap >= 0) {
+        close(pagemap);
+    }
+    if (!physical || ranges.empty()) {
+        physical = false;
+        ranges.assign(hot.begin(), hot.end());
+    }
+    
+    // 인접 범위 병합
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<uint64_t, uint64_t>> merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && merged.back().second >= range.first) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open DAMON scheme file: " << path << std::endl;
+        return false;
+    }
+    
+    uint64_t total = 0;
+    std::ostringstream regions;
+    for (size_t i = 0; i < merged.size(); ++i) {
+        total += merged[i].second - merged[i].first;
+        regions << "                                {\n"
+                << "                                    \"start\": \"" << withCommas(merged[i].first) << "\",\n"
+                << "                                    \"end\": \"" << withCommas(merged[i].second - 1) << "\"\n"
+                << "                                }" << (i + 1 < merged.size() ? "," : "") << "\n";
+    }
+    
+    // damo_yamls/replicate_all.yaml과 같은 구조, target region만 hot 구간으로 한정
+    out << "{\n"
+        << "    \"kdamonds\": [\n"
+        << "        {\n"
+        << "            \"refresh_ms\": 0,\n"
+        << "            \"contexts\": [\n"
+        << "                {\n"
+        << "                    \"ops\": \"" << (physical ? "paddr" : "vaddr") << "\",\n"
+        << "                    \"targets\": [\n"
+        << "                        {\n"
+        << "                            \"pid\": " << (physical ? std::string("null") : std::to_string(getpid())) << ",\n"
+        << "                            \"obsolete\": false,\n"
+        << "                            \"regions\": [\n"
+        << regions.str()
+        << "                            ]\n"
+        << "                        }\n"
+        << "                    ],\n"
+        << "                    \"intervals\": {\n"
+        << "                        \"sample_us\": \"100 ms\",\n"
+        << "                        \"aggr_us\": \"2 s\",\n"
+        << "                        \"ops_update_us\": \"20 s\",\n"
+        << "                        \"intervals_goal\": {\n"
+        << "                            \"access_bp\": \"0 %\",\n"
+        << "                            \"aggrs\": \"0\",\n"
+        << "                            \"min_sample_us\": \"0 ns\",\n"
+        << "                            \"max_sample_us\": \"0 ns\"\n"
+        << "                        }\n"
+        << "                    },\n"
+        << "                    \"nr_regions\": {\n"
+        << "                        \"min\": \"" << withCommas(std::max<size_t>(10, std::min<size_t>(merged.size(), 10000))) << "\",\n"
+        << "                        \"max\": \"" << withCommas(std::max<size_t>(1000, merged.size() * 10)) << "\"\n"
+        << "                    },\n"
+        << "                    \"schemes\": [\n"
+        << "                        {\n"
+        << "                            \"action\": \"" << action << "\",\n"
+        << "                            \"dests\": [],\n"
+        << "                            \"access_pattern\": {\n"
+        << "                                \"sz_bytes\": {\n"
+        << "                                    \"min\": \"0 B\",\n"
+        << "                                    \"max\": \"max\"\n"
+        << "                                },\n"
+        << "                                \"nr_accesses\": {\n"
+        << "                                    \"min\": \"0 %\",\n"
+        << "                                    \"max\": \"100 %\"\n"
+        << "                                },\n"
+        << "                                \"age\": {\n"
+        << "                                    \"min\": \"0 ns\",\n"
+        << "                                    \"max\": \"max\"\n"
+        << "                                }\n"
+        << "                            },\n"
+        << "                            \"apply_interval_us\": \"0 ns\",\n"
+        << "                            \"quotas\": {\n"
+        << "                                \"time_ms\": \"100 ms\",\n"
+        << "                                \"sz_bytes\": \"0 B\",\n"
+        << "                                \"reset_interval_ms\": \"max\",\n"
+        << "                                \"goals\": [],\n"
+        << "                                \"effective_sz_bytes\": \"0 B\",\n"
+        << "                                \"weights\": {\n"
+        << "                                    \"sz_permil\": \"0 %\",\n"
+        << "                                    \"nr_accesses_permil\": \"0 %\",\n"
+        << "                                    \"age_permil\": \"0 %\"\n"
+        << "                                }\n"
+        << "                            },\n"
+        << "                            \"watermarks\": {\n"
+        << "                                \"metric\": \"none\",\n"
+        << "                                \"interval_us\": \"0 ns\",\n"
+        << "                                \"high_permil\": \"0 %\",\n"
+        << "                                \"mid_permil\": \"0 %\",\n"
+        << "                                \"low_permil\": \"0 %\"\n"
+        << "                            },\n"
+        << "                            \"filters\": []\n"
+        << "                        }\n"
+        << "                    ]\n"
+        << "                }\n"
+        << "            ]\n"
+        << "        }\n"
+        << "    ]\n"
+        << "}";
+    
+    std::cout << "DAMON scheme written: " << path << " (" << merged.size() << " regions, "
+              << total / 1024 / 1024 << "MB, " << (physical ? "paddr" : "vaddr") << ")" << std::endl;
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include "shard_warmup.h"
+
+// 페이지 접근 추적 옵션
+struct PageTracerOptions {
+    size_t granule_bytes = 4096;                    // 추적 단위 (4KB 또는 2MB)
+    size_t sample_granules = 4096;                  // epoch마다 감시할 granule 수 (추가 VMA 수 제한)
+    std::chrono::milliseconds interval{100};        // epoch 길이
+};
+
+// mmap된 샤드/flat 영역의 페이지 접근 빈도를 샘플링 (DAMON과 같은 방식)
+//
+// epoch마다 임의의 granule들을 PROT_NONE으로 만들고, 그 epoch 동안 첫 접근에서 발생한
+// SIGSEGV를 잡아 hit를 기록한 뒤 원래 권한으로 복구함. granule별 hits / samples가
+// "한 epoch 동안 접근될 확률"의 추정치. 한 번에 감시하는 granule 수가 제한되어 있어
+// 전체를 보호할 때처럼 VMA가 vm.max_map_count를 넘지 않음.
+//
+// 영역 등록은 start() 전에만 가능 (signal handler가 락 없이 영역 테이블을 읽음).
+// 동시에 하나의 tracer만 실행 가능.
+class PageAccessTracer {
+private:
+    static constexpr size_t MAX_REGIONS = 256;
+    static constexpr int HISTOGRAM_BUCKETS = 10;
+    
+    struct Region {
+        std::string name;
+        uint8_t* addr = nullptr;
+        size_t length = 0;
+        int prot = PROT_READ;
+        size_t granules = 0;
+        std::unique_ptr<std::atomic<uint8_t>[]> armed;
+        std::unique_ptr<std::atomic<uint32_t>[]> samples;
+        std::unique_ptr<std::atomic<uint32_t>[]> hits;
+    };
+    
+    PageTracerOptions options_;
+    Region regions_[MAX_REGIONS];
+    std::atomic<size_t> region_count_;
+    
+    std::thread sampler_;
+    std::mutex sampler_mutex_;
+    std::condition_variable sampler_cv_;
+    bool stop_;
+    std::atomic<bool> running_;
+    
+    std::atomic<uint64_t> epochs_;
+    std::atomic<uint64_t> faults_;
+    std::atomic<uint64_t> queries_;
+    
+    struct sigaction previous_action_;
+    static std::atomic<PageAccessTracer*> active_;
+
+public:
+    explicit PageAccessTracer(const PageTracerOptions& options = PageTracerOptions());
+    ~PageAccessTracer();
+    
+    // 추적할 매핑 등록 (start 전에 호출)
+    bool addRegion(const std::string& name, const FileMapping& mapping);
+    
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+    
+    // 추적 중 처리한 쿼리 수 (출력의 쿼리당 접근 통계용)
+    void noteQueries(size_t count) { queries_.fetch_add(count, std::memory_order_relaxed); }
+    
+    uint64_t getEpochs() const { return epochs_.load(); }
+    uint64_t getFaults() const { return faults_.load(); }
+    uint64_t getQueries() const { return queries_.load(); }
+    
+    // 영역별 접근률 히스토그램 + 샘플된 granule별 hits/samples를 TSV로 기록
+    bool writeHeatmap(const std::string& path) const;
+    
+    // 접근률이 min_rate 이상인 granule들을 region으로 묶어 damo_yamls 형식의 scheme으로 기록
+    // /proc/self/pagemap으로 물리 주소를 얻을 수 있으면 paddr, 아니면 이 프로세스의 vaddr로 기록
+    // action이 DAMOS action 이름이 아니면 쓰지 않고 false
+    bool writeDamonScheme(const std::string& path, double min_rate, const std::string& action) const;
+    
+    // DAMOS action 이름인지 (커널 기본 action + damo_yamls/의 replicate, evict)
+    static bool isDamonAction(const std::string& action);
+
+private:
+    void samplerLoop();
+    void disarm(Region& region, size_t granule);
+    uint8_t* granuleAddr(const Region& region, size_t granule) const {
+        return region.addr + granule * options_.granule_bytes;
+    }
+    size_t granuleLength(const Region& region, size_t granule) const;
+    
+    static void onFault(int signo, siginfo_t* info, void* context);
+};
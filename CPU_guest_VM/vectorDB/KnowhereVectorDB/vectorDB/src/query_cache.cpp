@@ -0,0 +1,92 @@
+#include "query_cache.h"
+#include <cmath>
+#include <cstring>
+
+QueryResultCache::QueryResultCache(size_t capacity, float quantize_step)
+    : capacity_per_shard_(std::max<size_t>(1, (capacity + NUM_SHARDS - 1) / NUM_SHARDS)),
+      quantize_step_(quantize_step), shards_(std::make_unique<Shard[]>(NUM_SHARDS)) {
+}
+
+std::string QueryResultCache::makeKey(const std::vector<float>& query, int k, int ef) const {
+    std::string key;
+    makeKey(query.data(), query.size(), k, ef, key);
+    return key;
+}
+
+void QueryResultCache::makeKey(const float* query, size_t dim, int k, int ef, std::string& key) const {
+    key.resize(sizeof(int32_t) * (dim + 2));
+    char* out = key.data();
+    
+    int32_t params[2] = {k, ef};
+    std::memcpy(out, params, sizeof(params));
+    out += sizeof(params);
+    
+    if (quantize_step_ > 0.0f) {
+        // 거의 같은 임베딩(재시도, 같은 질문의 재임베딩)이 같은 키가 되도록 step 단위로 반올림
+        float inv_step = 1.0f / quantize_step_;
+        for (size_t i = 0; i < dim; ++i) {
+            int32_t q = static_cast<int32_t>(std::lround(query[i] * inv_step));
+            std::memcpy(out, &q, sizeof(q));
+            out += sizeof(q);
+        }
+    } else {
+        std::memcpy(out, query, dim * sizeof(float));
+    }
+}
+
+bool QueryResultCache::lookup(const std::string& key, uint64_t version, std::vector<SearchResult>& results) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (it->second->version != version) {
+        // 이후 삽입으로 결과가 바뀌었을 수 있음
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        stale_.fetch_add(1, std::memory_order_relaxed);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    results = it->second->results;
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void QueryResultCache::insert(std::string key, uint64_t version, const std::vector<SearchResult>& results) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // 더 새 버전의 결과만 덮어씀
+        if (it->second->version <= version) {
+            it->second->version = version;
+            it->second->results = results;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+    
+    shard.lru.push_front(Entry{std::move(key), version, results});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    
+    if (shard.lru.size() > capacity_per_shard_) {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+    }
+}
+
+size_t QueryResultCache::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        total += shards_[i].lru.size();
+    }
+    return total;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+#include "search_result.h"
+
+// 검색 결과 캐시 (샤드별 LRU)
+//
+// 키: 쿼리 벡터 (quantize_step > 0이면 step 단위로 반올림한 값, 아니면 float 비트 그대로) + k + ef
+// 값: 검색 결과와 검색 시작 시점의 데이터 버전 (VectorDB::getDataVersion)
+// 삽입 등으로 버전이 바뀌면 이전 버전 항목은 조회 시 무효 처리됨.
+// 히트는 DRAM의 결과를 그대로 돌려주므로 HNSW/flat 매핑(CXL)을 전혀 건드리지 않음.
+class QueryResultCache {
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+    
+    struct Entry {
+        std::string key;
+        uint64_t version;
+        std::vector<SearchResult> results;
+    };
+    
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // front가 가장 최근
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;  // key는 lru 항목의 string을 가리킴
+    };
+    
+    size_t capacity_per_shard_;
+    float quantize_step_;
+    std::unique_ptr<Shard[]> shards_;
+    
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stale_{0};
+
+public:
+    QueryResultCache(size_t capacity, float quantize_step = 0.0f);
+    
+    // 쿼리 벡터 + k + ef로 캐시 키 생성
+    std::string makeKey(const std::vector<float>& query, int k, int ef) const;
+    // key의 기존 용량을 재사용 (검색 슬롯마다 키 버퍼를 유지하면 할당 없음)
+    void makeKey(const float* query, size_t dim, int k, int ef, std::string& key) const;
+    
+    // version과 같은 버전의 항목이 있으면 results에 복사하고 true
+    bool lookup(const std::string& key, uint64_t version, std::vector<SearchResult>& results);
+    void insert(std::string key, uint64_t version, const std::vector<SearchResult>& results);
+    
+    size_t size() const;
+    size_t capacity() const { return capacity_per_shard_ * NUM_SHARDS; }
+    uint64_t getHits() const { return hits_.load(); }
+    uint64_t getMisses() const { return misses_.load(); }
+    uint64_t getStale() const { return stale_.load(); }
+
+private:
+    Shard& shardFor(const std::string& key) const {
+        return shards_[std::hash<std::string>{}(key) % NUM_SHARDS];
+    }
+};
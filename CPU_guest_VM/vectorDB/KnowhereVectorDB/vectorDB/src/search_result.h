@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+// 검색 결과 구조 (flat_index.h, hnsw_index.h, vector_db.h에서 공유)
+struct SearchResult {
+    uint64_t id;
+    float distance;
+    
+    SearchResult() : id(0), distance(0.0f) {}
+    SearchResult(uint64_t vector_id, float dist) : id(vector_id), distance(dist) {}
+};
+
+// 거리가 작은 상위 k개만 유지하는 bounded max-heap
+// brute-force 경로에서 전체 거리 배열을 만들지 않고 스트리밍으로 top-k를 선택
+// (스레드별로 하나씩 두고 마지막에 merge)
+class TopKSelector {
+private:
+    size_t k_;
+    std::vector<SearchResult> heap_;  // heap_.front()가 현재 k번째(가장 먼) 결과
+    
+    static bool farther(const SearchResult& a, const SearchResult& b) {
+        return a.distance < b.distance;
+    }
+
+public:
+    explicit TopKSelector(size_t k = 0) : k_(k) {
+        heap_.reserve(k);
+    }
+    
+    void reset(size_t k) {
+        k_ = k;
+        heap_.clear();
+        heap_.reserve(k);
+    }
+    
+    // 후보 추가 (k개가 찼으면 현재 최악보다 가까울 때만 교체)
+    void push(uint64_t id, float distance) {
+        if (heap_.size() < k_) {
+            heap_.emplace_back(id, distance);
+            std::push_heap(heap_.begin(), heap_.end(), farther);
+        } else if (k_ > 0 && distance < heap_.front().distance) {
+            std::pop_heap(heap_.begin(), heap_.end(), farther);
+            heap_.back() = SearchResult(id, distance);
+            std::push_heap(heap_.begin(), heap_.end(), farther);
+        }
+    }
+    
+    void merge(const TopKSelector& other) {
+        for (const auto& result : other.heap_) {
+            push(result.id, result.distance);
+        }
+    }
+    
+    template <typename Iterator>
+    void pushAll(Iterator begin, Iterator end) {
+        for (auto it = begin; it != end; ++it) {
+            push(it->id, it->distance);
+        }
+    }
+    
+    size_t size() const { return heap_.size(); }
+    bool full() const { return heap_.size() >= k_; }
+    
+    // 거리 오름차순으로 정렬된 결과를 꺼냄 (selector는 비워짐)
+    std::vector<SearchResult> extractSorted() {
+        std::sort_heap(heap_.begin(), heap_.end(), farther);
+        std::vector<SearchResult> results = std::move(heap_);
+        heap_.clear();
+        return results;
+    }
+};
@@ -0,0 +1,53 @@
+#include "search_slot_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+SearchSlotPool::SearchSlotPool(size_t slot_count, size_t dim)
+    : slot_count_(slot_count), dim_(dim) {
+    size_t floats_per_line = SLOT_ALIGNMENT / sizeof(float);
+    stride_ = (dim_ + floats_per_line - 1) / floats_per_line * floats_per_line;
+    
+    size_t bytes = std::max<size_t>(1, slot_count_ * stride_) * sizeof(float);
+    arena_ = static_cast<float*>(std::aligned_alloc(SLOT_ALIGNMENT, bytes));
+    if (!arena_) {
+        throw std::bad_alloc();
+    }
+    
+    free_slots_.reserve(slot_count_);
+    for (size_t i = slot_count_; i > 0; --i) {
+        free_slots_.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+SearchSlotPool::~SearchSlotPool() {
+    std::free(arena_);
+}
+
+bool SearchSlotPool::acquire(size_t count, uint32_t* slots) {
+    {
+        std::lock_guard<std::mutex> lock(free_mutex_);
+        if (free_slots_.size() < count) {
+            exhausted_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            slots[i] = free_slots_.back();
+            free_slots_.pop_back();
+        }
+    }
+    
+    size_t used = in_use_.fetch_add(count, std::memory_order_relaxed) + count;
+    size_t peak = peak_in_use_.load(std::memory_order_relaxed);
+    while (peak < used && !peak_in_use_.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+void SearchSlotPool::release(uint32_t slot) {
+    {
+        std::lock_guard<std::mutex> lock(free_mutex_);
+        free_slots_.push_back(slot);
+    }
+    in_use_.fetch_sub(1, std::memory_order_relaxed);
+}
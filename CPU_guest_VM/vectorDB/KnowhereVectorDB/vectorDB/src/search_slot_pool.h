@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+// 대기 중인 검색 쿼리를 담는 고정 크기 arena
+// - 서버 시작 시 slot_count × dim float를 한 번 할당하고, 요청 파싱 시 쿼리를 슬롯에 직접 기록
+// - 슬롯 번호가 곧 검색 큐의 항목이자 완료 handle (태스크마다 벡터/콜백을 힙에 만들지 않음)
+// - 각 슬롯은 64바이트 정렬 (SIMD 로드와 false sharing 방지)
+class SearchSlotPool {
+private:
+    static constexpr size_t SLOT_ALIGNMENT = 64;
+    
+    size_t slot_count_;
+    size_t dim_;
+    size_t stride_;             // 슬롯 간 float 간격 (dim을 정렬 단위로 올림)
+    float* arena_;
+    
+    std::mutex free_mutex_;
+    std::vector<uint32_t> free_slots_;  // LIFO: 최근에 쓴 (캐시에 남아 있는) 슬롯부터 재사용
+    std::atomic<size_t> in_use_{0};
+    std::atomic<size_t> peak_in_use_{0};
+    std::atomic<uint64_t> exhausted_{0};
+
+public:
+    SearchSlotPool(size_t slot_count, size_t dim);
+    ~SearchSlotPool();
+    
+    SearchSlotPool(const SearchSlotPool&) = delete;
+    SearchSlotPool& operator=(const SearchSlotPool&) = delete;
+    
+    // 슬롯 count개를 한 번에 확보 (모자라면 하나도 잡지 않고 false)
+    bool acquire(size_t count, uint32_t* slots);
+    bool acquire(uint32_t& slot) { return acquire(1, &slot); }
+    void release(uint32_t slot);
+    
+    float* query(uint32_t slot) { return arena_ + static_cast<size_t>(slot) * stride_; }
+    const float* query(uint32_t slot) const { return arena_ + static_cast<size_t>(slot) * stride_; }
+    
+    size_t capacity() const { return slot_count_; }
+    size_t inUse() const { return in_use_.load(std::memory_order_relaxed); }
+    size_t peakInUse() const { return peak_in_use_.load(std::memory_order_relaxed); }
+    uint64_t getExhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+};
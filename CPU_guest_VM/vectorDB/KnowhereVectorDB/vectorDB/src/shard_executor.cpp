@@ -0,0 +1,146 @@
+#include "shard_executor.h"
+#include "thread_layout.h"
+#include <sstream>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+ShardExecutor::ShardExecutor(size_t num_queues,
+                             size_t threads_per_queue,
+                             const std::vector<int>& cpu_ids)
+    : threads_per_queue_(std::max<size_t>(1, threads_per_queue)),
+      cpu_ids_(cpu_ids), queue_cpus_(num_queues), running_(false) {
+    queues_.reserve(num_queues);
+    for (size_t i = 0; i < num_queues; ++i) {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+}
+
+ShardExecutor::~ShardExecutor() {
+    stop();
+}
+
+void ShardExecutor::setQueueCpus(size_t queue_idx, const std::vector<int>& cpu_ids) {
+    queue_cpus_[queue_idx % queue_cpus_.size()] = cpu_ids;
+}
+
+void ShardExecutor::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    workers_.reserve(queues_.size() * threads_per_queue_);
+    for (size_t q = 0; q < queues_.size(); ++q) {
+        for (size_t t = 0; t < threads_per_queue_; ++t) {
+            size_t worker_idx = workers_.size();
+            workers_.emplace_back([this, q, worker_idx] {
+                if (!queue_cpus_[q].empty()) {
+                    pinCurrentThreadToCpus(queue_cpus_[q]);
+                } else if (!cpu_ids_.empty()) {
+                    pinCurrentThread(cpu_ids_[worker_idx % cpu_ids_.size()]);
+                }
+                workerLoop(q);
+            });
+        }
+    }
+
+    std::cout << "Shard executor started: " << queues_.size() << " queues x "
+              << threads_per_queue_ << " threads";
+    if (!cpu_ids_.empty()) {
+        std::cout << " (pinned to " << cpu_ids_.size() << " CPUs)";
+    }
+    std::cout << std::endl;
+}
+
+void ShardExecutor::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->cv.notify_all();
+    }
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+void ShardExecutor::submit(size_t queue_idx, std::function<void()> task) {
+    auto& queue = *queues_[queue_idx % queues_.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    queue.cv.notify_one();
+}
+
+void ShardExecutor::workerLoop(size_t queue_idx) {
+    auto& queue = *queues_[queue_idx];
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.cv.wait(lock, [this, &queue] {
+                return !queue.tasks.empty() || !running_.load();
+            });
+
+            // 종료 시에도 남은 작업은 모두 처리 (대기 중인 latch가 풀리도록)
+            if (queue.tasks.empty()) {
+                return;
+            }
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Shard executor task failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+bool ShardExecutor::pinCurrentThread(int cpu_id) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_id, &cpuset);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (rc != 0) {
+        std::cerr << "Failed to pin shard worker to CPU " << cpu_id << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> ShardExecutor::parseCpuList(const std::string& spec) {
+    std::vector<int> cpus;
+    std::stringstream ss(spec);
+    std::string token;
+
+    try {
+        while (std::getline(ss, token, ',')) {
+            if (token.empty()) continue;
+            auto dash = token.find('-');
+            if (dash == std::string::npos) {
+                cpus.push_back(std::stoi(token));
+            } else {
+                int first = std::stoi(token.substr(0, dash));
+                int last = std::stoi(token.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid CPU list: " << spec << std::endl;
+        return {};
+    }
+
+    return cpus;
+}
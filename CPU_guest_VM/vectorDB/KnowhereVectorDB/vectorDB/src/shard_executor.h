@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <latch>
+
+// 샤드 단위 검색 작업을 처리하는 long-lived 스레드 풀
+// - 큐 하나당 샤드 하나 (HNSW 샤드들 + flat 인덱스)
+// - 각 큐는 고정된 스레드 그룹이 처리하며, 필요 시 CPU에 pinning
+// - 호출 측은 submit()으로 작업을 넣고 std::latch로 완료를 기다림
+class ShardExecutor {
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    size_t threads_per_queue_;
+    std::vector<int> cpu_ids_;      // 비어 있으면 pinning하지 않음
+    // 큐별 CPU 집합 (비어 있지 않으면 그 큐의 스레드는 cpu_ids_ 대신 집합 전체에 pinning)
+    std::vector<std::vector<int>> queue_cpus_;
+    std::atomic<bool> running_;
+
+public:
+    ShardExecutor(size_t num_queues,
+                  size_t threads_per_queue,
+                  const std::vector<int>& cpu_ids = {});
+    ~ShardExecutor();
+
+    // start() 전에 호출: queue_idx 큐의 스레드를 CPU 하나가 아니라 집합에 pinning
+    // (작업 안에서 OpenMP 팀을 만드는 flat 큐용, 팀 스레드가 CPU 하나에 몰리지 않도록)
+    void setQueueCpus(size_t queue_idx, const std::vector<int>& cpu_ids);
+
+    void start();
+    void stop();
+
+    // queue_idx 큐에 작업 추가 (스레드 생성 없이 큐 push만 수행)
+    void submit(size_t queue_idx, std::function<void()> task);
+
+    size_t getQueueCount() const { return queues_.size(); }
+    size_t getThreadsPerQueue() const { return threads_per_queue_; }
+
+    // "0-3,8,10-11" 형식의 CPU 목록 파싱 (형식 오류 시 빈 벡터)
+    static std::vector<int> parseCpuList(const std::string& spec);
+
+private:
+    void workerLoop(size_t queue_idx);
+    static bool pinCurrentThread(int cpu_id);
+};
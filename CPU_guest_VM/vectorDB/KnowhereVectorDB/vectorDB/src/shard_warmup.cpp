@@ -0,0 +1,194 @@
+#include "shard_warmup.h"
+#include "hnsw_layout.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+struct MapsEntry {
+    uintptr_t start;
+    uintptr_t end;
+    uint64_t offset;
+    int prot;
+};
+
+// 한 페이지에 한 번씩 읽어서 fault-in
+size_t touchRange(const uint8_t* begin, const uint8_t* end, size_t page_size) {
+    if (begin >= end) {
+        return 0;
+    }
+    volatile uint8_t sink = 0;
+    for (const uint8_t* p = begin; p < end; p += page_size) {
+        sink = sink + *p;
+    }
+    sink = sink + *(end - 1);
+    return static_cast<size_t>(end - begin);
+}
+
+}  // namespace
+
+bool parseShardWarmup(const std::string& name, ShardWarmup& mode) {
+    if (name == "none") {
+        mode = ShardWarmup::None;
+    } else if (name == "willneed" || name == "populate") {
+        mode = ShardWarmup::WillNeed;
+    } else if (name == "touch") {
+        mode = ShardWarmup::Touch;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* shardWarmupName(ShardWarmup mode) {
+    switch (mode) {
+        case ShardWarmup::WillNeed: return "willneed";
+        case ShardWarmup::Touch: return "touch";
+        default: return "none";
+    }
+}
+
+bool findFileMapping(const std::string& path, FileMapping& mapping) {
+    std::error_code ec;
+    std::string canonical = std::filesystem::canonical(path, ec).string();
+    if (ec) {
+        return false;
+    }
+    
+    std::ifstream maps("/proc/self/maps");
+    std::vector<MapsEntry> entries;
+    std::string line;
+    while (std::getline(maps, line)) {
+        // "start-end perms offset dev inode   pathname"
+        std::istringstream iss(line);
+        std::string range, perms, offset, dev, inode, pathname;
+        if (!(iss >> range >> perms >> offset >> dev >> inode)) {
+            continue;
+        }
+        std::getline(iss >> std::ws, pathname);
+        if (pathname != canonical) {
+            continue;
+        }
+        auto dash = range.find('-');
+        int prot = (perms[0] == 'r' ? PROT_READ : 0) | (perms[1] == 'w' ? PROT_WRITE : 0) |
+                   (perms[2] == 'x' ? PROT_EXEC : 0);
+        entries.push_back({std::stoull(range.substr(0, dash), nullptr, 16),
+                           std::stoull(range.substr(dash + 1), nullptr, 16),
+                           std::stoull(offset, nullptr, 16), prot});
+    }
+    
+    std::sort(entries.begin(), entries.end(),
+              [](const MapsEntry& a, const MapsEntry& b) { return a.start < b.start; });
+    
+    // 오프셋 0에서 시작해 주소/오프셋이 함께 이어지는 구간을 하나로 합침
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].offset != 0) {
+            continue;
+        }
+        uintptr_t end = entries[i].end;
+        for (size_t j = i + 1; j < entries.size(); ++j) {
+            if (entries[j].start != end || entries[j].offset != end - entries[i].start) {
+                break;
+            }
+            end = entries[j].end;
+        }
+        mapping.addr = reinterpret_cast<uint8_t*>(entries[i].start);
+        mapping.length = end - entries[i].start;
+        mapping.prot = entries[i].prot;
+        
+        // 매핑은 페이지 단위로 올림되어 있으므로 실제 파일 크기로 자름
+        auto file_size = std::filesystem::file_size(canonical, ec);
+        if (!ec && file_size < mapping.length) {
+            mapping.length = file_size;
+        }
+        return true;
+    }
+    return false;
+}
+
+size_t residentBytes(const FileMapping& mapping) {
+    return residentBytes(std::vector<FileMapping>{mapping})[0];
+}
+
+std::vector<size_t> residentBytes(const std::vector<FileMapping>& mappings) {
+    std::vector<size_t> rss_kb(mappings.size(), 0);
+    bool any = std::any_of(mappings.begin(), mappings.end(),
+                           [](const FileMapping& m) { return m.addr != nullptr; });
+    if (!any) {
+        return rss_kb;
+    }
+    
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    size_t current = mappings.size();  // 현재 영역이 속한 매핑 (없으면 mappings.size())
+    while (std::getline(smaps, line)) {
+        // 영역 헤더 줄 ("start-end perms ...")과 "Key: value kB" 줄을 구분
+        auto dash = line.find('-');
+        auto space = line.find(' ');
+        if (dash != std::string::npos && space != std::string::npos && dash < space &&
+            line.find(':') > space) {
+            uintptr_t start = std::stoull(line.substr(0, dash), nullptr, 16);
+            current = mappings.size();
+            for (size_t i = 0; i < mappings.size(); ++i) {
+                uintptr_t begin = reinterpret_cast<uintptr_t>(mappings[i].addr);
+                if (mappings[i].addr != nullptr && start >= begin && start < begin + mappings[i].length) {
+                    current = i;
+                    break;
+                }
+            }
+        } else if (current < mappings.size() && line.rfind("Rss:", 0) == 0) {
+            rss_kb[current] += std::stoull(line.substr(4));
+        }
+    }
+    for (auto& kb : rss_kb) {
+        kb *= 1024;
+    }
+    return rss_kb;
+}
+
+size_t warmMapping(const FileMapping& mapping, ShardWarmup mode, size_t dim) {
+    if (mapping.addr == nullptr || mode == ShardWarmup::None) {
+        return 0;
+    }
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    
+    if (mode == ShardWarmup::WillNeed) {
+#ifdef MADV_POPULATE_READ
+        if (madvise(mapping.addr, mapping.length, MADV_POPULATE_READ) == 0) {
+            return mapping.length;
+        }
+#endif
+        if (madvise(mapping.addr, mapping.length, MADV_WILLNEED) != 0) {
+            std::cerr << "madvise(WILLNEED) failed" << std::endl;
+            return 0;
+        }
+        return mapping.length;
+    }
+    
+    // Touch: 레이아웃 파싱이 헤더와 상위 레이어 구간을 읽으면서 그 페이지들을 fault-in
+    HNSWFileLayout layout;
+    if (!parseHNSWFileLayout(mapping.addr, mapping.length, dim, layout)) {
+        std::cerr << "Unrecognized HNSW file layout, touching every page instead" << std::endl;
+        return touchRange(mapping.addr, mapping.addr + mapping.length, page_size);
+    }
+    
+    size_t touched = mapping.length - layout.upper_offset;
+    touchRange(mapping.addr + layout.upper_offset, mapping.addr + mapping.length, page_size);
+    
+    // 상위 레이어에 있는 노드와 entry point의 level0 레코드 (탐색이 항상 지나가는 구간)
+    auto touchRecord = [&](uint32_t id) {
+        const uint8_t* record = mapping.addr + layout.level0RecordOffset(id);
+        return touchRange(record, record + layout.size_data_per_element, page_size);
+    };
+    touched += touchRecord(layout.entry_point);
+    for (uint32_t id : layout.upper_nodes) {
+        touched += touchRecord(id);
+    }
+    return touched;
+}
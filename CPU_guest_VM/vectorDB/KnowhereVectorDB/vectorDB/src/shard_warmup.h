@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 샤드 로드 직후 워밍업 방식
+// - None:     아무것도 하지 않음 (첫 쿼리들이 page fault를 떠안음)
+// - WillNeed: 매핑 전체를 MADV_POPULATE_READ(없으면 MADV_WILLNEED)로 미리 fault-in (MAP_POPULATE와 동일 효과)
+// - Touch:    HNSW 파일 레이아웃을 파싱해 상위 레이어 링크 구간과 상위 노드/entry point의
+//             level0 레코드만 접근 (그래프 탐색 시작 구간만 데우고 메모리 사용은 최소화)
+enum class ShardWarmup {
+    None,
+    WillNeed,
+    Touch,
+};
+
+bool parseShardWarmup(const std::string& name, ShardWarmup& mode);
+const char* shardWarmupName(ShardWarmup mode);
+
+// 프로세스 주소 공간에 매핑된 파일 영역
+struct FileMapping {
+    uint8_t* addr = nullptr;
+    size_t length = 0;
+    int prot = 0;       // PROT_* (첫 번째 매핑 영역 기준)
+};
+
+// /proc/self/maps에서 파일 오프셋 0부터 연속으로 매핑된 영역 검색
+// (Knowhere가 enable_mmap으로 샤드 파일을 직접 매핑한 영역을 찾는 용도)
+bool findFileMapping(const std::string& path, FileMapping& mapping);
+
+// /proc/self/smaps의 Rss 합계 (해당 매핑 구간)
+size_t residentBytes(const FileMapping& mapping);
+
+// 여러 매핑의 Rss 합계를 smaps 한 번 파싱으로 계산 (mappings와 같은 순서)
+std::vector<size_t> residentBytes(const std::vector<FileMapping>& mappings);
+
+// 워밍업 실행, 접근(또는 advise)한 바이트 수 반환
+size_t warmMapping(const FileMapping& mapping, ShardWarmup mode, size_t dim);
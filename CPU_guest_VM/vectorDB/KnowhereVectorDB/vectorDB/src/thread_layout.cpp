@@ -0,0 +1,169 @@
+#include "thread_layout.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+std::vector<int> affinityCpus() {
+    std::vector<int> cpus;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuset)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// sysfs에 있는 NUMA 노드 번호 (오름차순, distance 파일의 열 순서와 같음)
+std::vector<int> numaNodes() {
+    std::vector<int> nodes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.starts_with("node") &&
+            std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            nodes.push_back(std::stoi(name.substr(4)));
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+// budget CPU 중 하나라도 있는 노드 가운데 node까지 거리가 가장 가까운 노드
+// (node 자신에 budget CPU가 있으면 그대로)
+int nearestCpuNode(int node, const std::vector<int>& cpus) {
+    std::vector<int> cpu_nodes;
+    for (int cpu : cpus) {
+        int cpu_node = cpuNumaNode(cpu);
+        if (cpu_node >= 0 && std::find(cpu_nodes.begin(), cpu_nodes.end(), cpu_node) == cpu_nodes.end()) {
+            cpu_nodes.push_back(cpu_node);
+        }
+    }
+    if (std::find(cpu_nodes.begin(), cpu_nodes.end(), node) != cpu_nodes.end()) {
+        return node;
+    }
+
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/distance");
+    std::vector<int> distances;
+    for (int distance; file >> distance;) {
+        distances.push_back(distance);
+    }
+    std::vector<int> nodes = numaNodes();
+    if (distances.size() != nodes.size()) {
+        return -1;
+    }
+
+    int best = -1;
+    int best_distance = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        bool has_cpus = std::find(cpu_nodes.begin(), cpu_nodes.end(), nodes[i]) != cpu_nodes.end();
+        if (has_cpus && (best < 0 || distances[i] < best_distance)) {
+            best = nodes[i];
+            best_distance = distances[i];
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+int cpuNumaNode(int cpu) {
+    std::error_code ec;
+    std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.starts_with("node") &&
+            std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return -1;
+}
+
+bool planThreadLayout(const ThreadBudgetOptions& options, ThreadLayout& layout) {
+    std::vector<int> cpus = options.cpus.empty() ? affinityCpus() : options.cpus;
+    if (cpus.empty()) {
+        std::cerr << "Thread budget has no CPUs" << std::endl;
+        return false;
+    }
+
+    // 검색 노드의 CPU를 앞에 두고, 검색 코어는 앞에서부터 / I/O 코어는 뒤에서부터 고름
+    layout.search_node = -1;
+    if (options.search_node >= 0) {
+        layout.search_node = nearestCpuNode(options.search_node, cpus);
+        if (layout.search_node < 0) {
+            std::cerr << "No budget CPU is near NUMA node " << options.search_node << std::endl;
+            return false;
+        }
+        std::stable_partition(cpus.begin(), cpus.end(),
+                              [&](int cpu) { return cpuNumaNode(cpu) == layout.search_node; });
+    }
+
+    size_t total = cpus.size();
+    size_t io = options.io_threads ? options.io_threads : std::max<size_t>(1, total / 8);
+    if (total == 1) {
+        // 코어 하나를 I/O와 검색이 같이 씀
+        layout.io_cpus = cpus;
+        layout.search_cpus = cpus;
+        layout.io_threads = io;
+        layout.search_threads = 1;
+        return true;
+    }
+    io = std::min(io, total - 1);
+
+    layout.search_cpus.assign(cpus.begin(), cpus.end() - io);
+    layout.io_cpus.assign(cpus.end() - io, cpus.end());
+    std::sort(layout.search_cpus.begin(), layout.search_cpus.end());
+    std::sort(layout.io_cpus.begin(), layout.io_cpus.end());
+    layout.io_threads = io;
+    layout.search_threads = layout.search_cpus.size();
+    return true;
+}
+
+bool pinCurrentThreadToCpus(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &cpuset);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (rc != 0) {
+        std::cerr << "Failed to pin thread to CPUs " << formatCpuList(cpus) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::vector<int> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    std::ostringstream out;
+    for (size_t i = 0; i < sorted.size();) {
+        size_t j = i;
+        while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1) {
+            ++j;
+        }
+        if (i > 0) {
+            out << ",";
+        }
+        out << sorted[i];
+        if (j > i) {
+            out << "-" << sorted[j];
+        }
+        i = j + 1;
+    }
+    return out.str();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 프로세스 전체 스레드 예산
+// 네트워크 I/O, 검색 워커, 샤드 executor, Knowhere 스레드 풀, OpenMP 스캔이 각자 코어 수만큼
+// 스레드를 만들면 작은 VM에서 과다 구독(context switch 폭주)이 생기므로, 하나의 CPU 집합을
+// I/O 코어와 검색 코어로 나누고 검색 쪽 스레드 수는 모두 검색 코어 수에서 유도함
+struct ThreadBudgetOptions {
+    std::vector<int> cpus;       // 예산 CPU 목록 (비어 있으면 프로세스의 affinity mask 전체)
+    size_t io_threads = 0;       // 네트워크 I/O 코어 수 (0이면 예산의 1/8, 최소 1)
+    // 검색 코어를 우선 고를 NUMA 노드 (-1이면 지정 안 함)
+    // CPU가 없는 메모리 노드(CXL expander)를 주면 그 노드까지 거리가 가장 가까운 CPU 노드를 씀
+    int search_node = -1;
+    bool pin = false;            // I/O/검색 스레드를 각자의 CPU 집합에 pinning
+};
+
+struct ThreadLayout {
+    std::vector<int> io_cpus;        // 예산이 1코어면 검색 코어와 같음
+    std::vector<int> search_cpus;
+    int search_node = -1;            // 실제로 검색 코어를 고른 CPU 노드 (-1이면 지정 안 함)
+    size_t io_threads = 1;
+    size_t search_threads = 1;       // 검색 워커 / Knowhere 풀 / OpenMP 스캔 스레드 수
+};
+
+// 예산을 I/O 코어와 검색 코어로 나눔 (CPU 목록이 비었거나 노드를 찾지 못하면 false)
+bool planThreadLayout(const ThreadBudgetOptions& options, ThreadLayout& layout);
+
+// 현재 스레드를 CPU 집합에 pinning (집합 안에서는 스케줄러가 자유롭게 배치,
+// 이후 이 스레드가 만드는 스레드(OpenMP 팀 등)도 같은 mask를 물려받음)
+bool pinCurrentThreadToCpus(const std::vector<int>& cpus);
+
+// CPU가 속한 NUMA 노드 (sysfs에서 찾지 못하면 -1)
+int cpuNumaNode(int cpu);
+
+// "0-3,8" 형식으로 출력
+std::string formatCpuList(const std::vector<int>& cpus);
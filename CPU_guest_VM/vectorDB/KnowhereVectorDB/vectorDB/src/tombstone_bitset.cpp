@@ -0,0 +1,255 @@
+#include "tombstone_bitset.h"
+#include "cache_flush.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TombstoneBitset::~TombstoneBitset() {
+    close();
+}
+
+bool TombstoneBitset::open(const std::string& path, size_t capacity, bool read_only,
+                           bool cache_line_persist) {
+    close();
+    read_only_ = read_only;
+    cache_line_persist_ = cache_line_persist;
+    
+    fd_ = read_only ? ::open(path.c_str(), O_RDONLY) : ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ == -1) {
+        std::cerr << "Failed to open tombstone file: " << path << std::endl;
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close();
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    bool created = file_size == 0;
+    
+    Header file_header{};
+    if (!created) {
+        if (pread(fd_, &file_header, sizeof(file_header), 0) != static_cast<ssize_t>(sizeof(file_header)) ||
+            file_header.magic_number != MAGIC_NUMBER) {
+            std::cerr << "Invalid tombstone file: " << path << std::endl;
+            close();
+            return false;
+        }
+        capacity = std::max<size_t>(capacity, file_header.capacity);
+    } else if (read_only) {
+        std::cerr << "Tombstone file is empty: " << path << std::endl;
+        close();
+        return false;
+    }
+    
+    size_t words = (capacity + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    size_t size = HEADER_SIZE + std::max<size_t>(1, words) * sizeof(uint64_t);
+    if (size > file_size) {
+        if (read_only) {
+            std::cerr << "Tombstone file is smaller than its capacity: " << path << std::endl;
+            close();
+            return false;
+        }
+        // 늘어난 구간은 0으로 채워짐 (삭제 없음)
+        if (ftruncate(fd_, size) != 0) {
+            std::cerr << "Failed to size tombstone file: " << path << std::endl;
+            close();
+            return false;
+        }
+    }
+    
+    int prot = read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    mapped_ = mmap(nullptr, size, prot, MAP_SHARED, fd_, 0);
+    if (mapped_ == MAP_FAILED) {
+        mapped_ = nullptr;
+        std::cerr << "Failed to mmap tombstone file: " << path << std::endl;
+        close();
+        return false;
+    }
+    mapped_size_ = size;
+    header_ = static_cast<Header*>(mapped_);
+    words_ = reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(mapped_) + HEADER_SIZE);
+    capacity_ = capacity;
+    
+    if (created || header_->capacity != capacity) {
+        header_->magic_number = MAGIC_NUMBER;
+        header_->capacity = capacity;
+        persist(header_, sizeof(Header));
+    }
+    seen_count_ = count();
+    return true;
+}
+
+bool TombstoneBitset::readDeletedCount(const std::string& path, size_t& deleted_count) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    Header file_header{};
+    bool ok = pread(fd, &file_header, sizeof(file_header), 0) == static_cast<ssize_t>(sizeof(file_header)) &&
+              file_header.magic_number == MAGIC_NUMBER;
+    ::close(fd);
+    if (ok) {
+        deleted_count = static_cast<size_t>(file_header.deleted_count);
+    }
+    return ok;
+}
+
+void TombstoneBitset::close() {
+    if (mapped_ != nullptr) {
+        munmap(mapped_, mapped_size_);
+        mapped_ = nullptr;
+        header_ = nullptr;
+        words_ = nullptr;
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    capacity_ = 0;
+}
+
+bool TombstoneBitset::set(size_t index) {
+    if (read_only_ || index >= capacity_) {
+        return false;
+    }
+    uint64_t* word = &words_[index / BITS_PER_WORD];
+    uint64_t mask = 1ULL << (index % BITS_PER_WORD);
+    uint64_t prev = std::atomic_ref<uint64_t>(*word).fetch_or(mask, std::memory_order_relaxed);
+    if (prev & mask) {
+        return false;
+    }
+    std::atomic_ref<uint64_t>(header_->deleted_count).fetch_add(1, std::memory_order_relaxed);
+    // bit를 먼저 내구화한 뒤 카운트 (카운트는 통계용이라 bit보다 작게 남아도 무방)
+    persist(word, sizeof(uint64_t));
+    persist(header_, sizeof(Header));
+    return true;
+}
+
+size_t TombstoneBitset::setBatch(const std::vector<size_t>& indices, std::vector<bool>& newly_set) {
+    newly_set.assign(indices.size(), false);
+    if (read_only_) {
+        return 0;
+    }
+    std::vector<size_t> dirty_words;
+    dirty_words.reserve(indices.size());
+    size_t added = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (indices[i] >= capacity_) {
+            continue;
+        }
+        uint64_t mask = 1ULL << (indices[i] % BITS_PER_WORD);
+        uint64_t prev = std::atomic_ref<uint64_t>(words_[indices[i] / BITS_PER_WORD]).fetch_or(mask, std::memory_order_relaxed);
+        if (prev & mask) {
+            continue;
+        }
+        newly_set[i] = true;
+        dirty_words.push_back(indices[i] / BITS_PER_WORD);
+        ++added;
+    }
+    if (added == 0) {
+        return 0;
+    }
+    std::atomic_ref<uint64_t>(header_->deleted_count).fetch_add(added, std::memory_order_relaxed);
+    
+    // 같은 내구화 단위(페이지 / 캐시 라인)에 든 word는 한 번에 (bit 먼저, 헤더는 마지막)
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t granule_words = (cache_line_persist_ ? cacheline::LINE_SIZE : page_size) / sizeof(uint64_t);
+    std::sort(dirty_words.begin(), dirty_words.end());
+    size_t run_begin = dirty_words.front();
+    size_t run_end = run_begin + 1;
+    for (size_t word : dirty_words) {
+        if (word / granule_words > (run_end - 1) / granule_words + 1) {
+            persist(&words_[run_begin], (run_end - run_begin) * sizeof(uint64_t));
+            run_begin = word;
+        }
+        run_end = word + 1;
+    }
+    persist(&words_[run_begin], (run_end - run_begin) * sizeof(uint64_t));
+    persist(header_, sizeof(Header));
+    return added;
+}
+
+size_t TombstoneBitset::countRange(size_t first, size_t end) const {
+    end = std::min(end, capacity_);
+    size_t total = 0;
+    for (size_t i = first; i < end;) {
+        size_t word_idx = i / BITS_PER_WORD;
+        size_t bit = i % BITS_PER_WORD;
+        size_t take = std::min(BITS_PER_WORD - bit, end - i);
+        uint64_t word = std::atomic_ref<uint64_t>(words_[word_idx]).load(std::memory_order_relaxed) >> bit;
+        if (take < BITS_PER_WORD) {
+            word &= (1ULL << take) - 1;
+        }
+        total += static_cast<size_t>(__builtin_popcountll(word));
+        i += take;
+    }
+    return total;
+}
+
+void TombstoneBitset::shiftDown(size_t shift, size_t end) {
+    if (read_only_ || shift == 0) {
+        return;
+    }
+    end = std::min(end, capacity_);
+    size_t remaining = end > shift ? end - shift : 0;
+    size_t words = (capacity_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    
+    // word 단위로 읽어서 bit 오프셋만큼 이어 붙임 (dst <= src이므로 앞에서부터 덮어써도 안전)
+    size_t word_shift = shift / BITS_PER_WORD;
+    size_t bit_shift = shift % BITS_PER_WORD;
+    size_t remaining_words = (remaining + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    for (size_t i = 0; i < remaining_words; ++i) {
+        size_t src = i + word_shift;
+        uint64_t low = src < words ? words_[src] : 0;
+        uint64_t high = src + 1 < words ? words_[src + 1] : 0;
+        words_[i] = bit_shift ? (low >> bit_shift) | (high << (BITS_PER_WORD - bit_shift)) : low;
+    }
+    if (remaining % BITS_PER_WORD != 0) {
+        words_[remaining_words - 1] &= (1ULL << (remaining % BITS_PER_WORD)) - 1;
+    }
+    std::memset(&words_[remaining_words], 0, (words - remaining_words) * sizeof(uint64_t));
+    
+    header_->deleted_count = countRange(0, remaining);
+    persist(words_, words * sizeof(uint64_t));
+    persist(header_, sizeof(Header));
+}
+
+void TombstoneBitset::invalidate(size_t bits) const {
+    if (!header_) {
+        return;
+    }
+    size_t words = (std::min(bits, capacity_) + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    cacheline::invalidate(header_, sizeof(Header));
+    cacheline::invalidate(words_, words * sizeof(uint64_t));
+}
+
+bool TombstoneBitset::refreshShared() {
+    if (!header_) {
+        return false;
+    }
+    cacheline::invalidate(header_, sizeof(Header));
+    size_t current = count();
+    if (current == seen_count_) {
+        return false;
+    }
+    seen_count_ = current;
+    cacheline::invalidate(words_, (capacity_ + BITS_PER_WORD - 1) / BITS_PER_WORD * sizeof(uint64_t));
+    return true;
+}
+
+void TombstoneBitset::persist(const void* addr, size_t len) const {
+    if (cache_line_persist_) {
+        cacheline::writeBack(addr, len);
+        return;
+    }
+    static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page_size - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(addr) + len;
+    msync(reinterpret_cast<void*>(begin), end - begin, MS_SYNC);
+}
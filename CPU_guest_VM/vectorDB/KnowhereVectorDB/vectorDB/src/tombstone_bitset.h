@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 삭제 표시용 영속 bitset (mmap된 파일, bit i = row/label i가 삭제됨)
+// 파일: [헤더 64B: magic, capacity(bit 수), deleted_count][uint64 word × ceil(capacity / 64)]
+// word 안의 bit 순서가 little-endian 바이트 순서와 같으므로 data()를 Knowhere BitsetView
+// (byte i >> 3의 bit i & 7, 1이면 검색에서 제외)에 그대로 넘길 수 있음
+// set()은 여러 스레드에서 동시에 호출해도 되고, 검색 중 test()와도 동시에 실행 가능
+class TombstoneBitset {
+private:
+    static constexpr uint64_t MAGIC_NUMBER = 0x544F4D4200000000ULL;  // "TOMB"
+    static constexpr size_t HEADER_SIZE = 64;
+    static constexpr size_t BITS_PER_WORD = 64;
+    
+    struct Header {
+        uint64_t magic_number;
+        uint64_t capacity;        // bit 수
+        uint64_t deleted_count;   // 1인 bit 수
+        uint64_t reserved[5];
+    };
+    
+    int fd_ = -1;
+    void* mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+    Header* header_ = nullptr;
+    uint64_t* words_ = nullptr;
+    size_t capacity_ = 0;
+    bool read_only_ = false;
+    bool cache_line_persist_ = false;
+    size_t seen_count_ = 0;   // refreshShared()가 마지막으로 읽은 deleted_count
+
+public:
+    TombstoneBitset() = default;
+    ~TombstoneBitset();
+    TombstoneBitset(const TombstoneBitset&) = delete;
+    TombstoneBitset& operator=(const TombstoneBitset&) = delete;
+    
+    // 파일을 열고 매핑 (없으면 생성, 기존 파일이 capacity보다 작으면 늘림)
+    // read_only면 기존 파일만 열고 쓰지 않음
+    // cache_line_persist면 msync 대신 캐시 라인 write-back으로 내구화 (공유 flat writer, famfs DAX)
+    bool open(const std::string& path, size_t capacity, bool read_only = false,
+              bool cache_line_persist = false);
+    // 매핑하지 않고 파일 헤더의 deleted_count만 읽음 (오프라인 도구용, 헤더가 잘못되면 false)
+    static bool readDeletedCount(const std::string& path, size_t& deleted_count);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+    
+    // bit 설정 (이미 1이었거나 범위 밖이면 false), 쓴 word와 헤더를 바로 내구화
+    bool set(size_t index);
+    // 여러 bit를 설정한 뒤 바뀐 word를 페이지(캐시 라인 모드는 라인) 단위로 묶어 한 번씩, 헤더는 마지막에 한 번 내구화
+    // newly_set[i]: indices[i]를 이번에 새로 설정했는지, 새로 설정한 수 반환
+    size_t setBatch(const std::vector<size_t>& indices, std::vector<bool>& newly_set);
+    
+    bool test(size_t index) const {
+        if (index >= capacity_) {
+            return false;
+        }
+        uint64_t word = std::atomic_ref<uint64_t>(words_[index / BITS_PER_WORD]).load(std::memory_order_relaxed);
+        return (word >> (index % BITS_PER_WORD)) & 1;
+    }
+    
+    size_t count() const {
+        return header_ ? std::atomic_ref<uint64_t>(header_->deleted_count).load(std::memory_order_relaxed) : 0;
+    }
+    size_t capacity() const { return capacity_; }
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(words_); }
+    
+    // [first, end) bit 범위에 든 1의 수
+    size_t countRange(size_t first, size_t end) const;
+    
+    // bit [shift, end)를 [0, end - shift)로 당기고 나머지는 0 (flat prefix 제거와 같이 호출)
+    // 동시에 set()/test()가 실행되면 안 됨
+    void shiftDown(size_t shift, size_t end);
+    
+    // 다른 호스트의 writer가 쓴 bit를 다시 읽도록 [0, bits) 구간과 헤더의 캐시 라인을 버림
+    void invalidate(size_t bits) const;
+    // 다른 호스트의 writer가 삭제 표시를 늘렸으면 bit 구간 전체를 버리고 true
+    // (헤더 라인만 먼저 버리고 카운트를 비교, writer는 bit를 헤더보다 먼저 내구화함)
+    // 한 스레드(poller)에서만 호출
+    bool refreshShared();
+
+private:
+    void persist(const void* addr, size_t len) const;
+};
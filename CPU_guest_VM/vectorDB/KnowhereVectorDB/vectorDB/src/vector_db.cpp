@@ -1,10 +1,18 @@
 #include "vector_db.h"
 #include <algorithm>
-#include <future>
+#include <cstring>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+#include "hnsw_builder.h"
 
 // VectorDB 구현
-VectorDB::VectorDB(const std::string& hnsw_dir, const std::string& flat_path)
-    : hnsw_index_dir_(hnsw_dir), flat_index_path_(flat_path), next_id_(100000000) {
+VectorDB::VectorDB(const std::string& hnsw_dir, const std::string& flat_path,
+                   const VectorDBOptions& options)
+    : hnsw_index_dir_(hnsw_dir), flat_index_path_(flat_path), options_(options),
+      flat_queue_idx_(0), next_id_(100000000), data_version_(0),
+      compact_threshold_(0), compact_requested_(false), compactor_stop_(false),
+      total_compactions_(0), total_flat_refreshes_(0) {
 }
 
 VectorDB::~VectorDB() {
@@ -14,26 +22,90 @@ VectorDB::~VectorDB() {
 bool VectorDB::initialize() {
     std::cout << "=== VectorDB 초기화 ===" << std::endl;
     
+    // 검색 연산 스레드 예산을 Knowhere 풀과 OpenMP 스캔에 전달
+    if (options_.compute_threads > 0) {
+        options_.shard_load.compute_threads = options_.compute_threads;
+        options_.flat.scan_threads = options_.compute_threads;
+    }
+    
     // HNSW 인덱스 매니저 초기화
-    hnsw_manager_ = std::make_unique<HNSWIndexManager>(hnsw_index_dir_, VECTOR_DIM);
-    if (!hnsw_manager_->initialize()) {
+    auto hnsw = std::make_shared<HNSWIndexManager>(hnsw_index_dir_, VECTOR_DIM, options_.shard_load);
+    hnsw->setMetrics(&search_metrics_);
+    if (!hnsw->initialize()) {
         std::cerr << "Failed to initialize HNSW index manager" << std::endl;
         return false;
     }
+    hnsw_manager_.store(hnsw, std::memory_order_release);
     
     // Flat 인덱스 초기화
-    flat_index_ = std::make_unique<AppendOnlyFlatIndex>(flat_index_path_, VECTOR_DIM, 1000000);
+    flat_index_ = std::make_unique<AppendOnlyFlatIndex>(flat_index_path_, VECTOR_DIM, FLAT_CAPACITY,
+                                                        options_.flat);
     if (!flat_index_->initialize()) {
         std::cerr << "Failed to initialize flat index" << std::endl;
         return false;
     }
+    
+    // 샤드 executor 시작 (HNSW 인덱스당 큐 하나 + flat 인덱스용 큐 하나)
+    size_t num_queues = hnsw->getIndexCount() + 1;
+    size_t threads_per_queue = options_.shard_threads_per_queue;
+    if (threads_per_queue == 0) {
+        size_t compute = options_.compute_threads ? options_.compute_threads : std::thread::hardware_concurrency();
+        threads_per_queue = std::max<size_t>(1, compute / num_queues);
+    }
+    shard_executor_ = std::make_unique<ShardExecutor>(num_queues, threads_per_queue, options_.shard_cpus);
+    flat_queue_idx_ = num_queues - 1;
+    // flat 스캔은 큐 스레드 안에서 OpenMP 팀을 만들므로 CPU 하나가 아니라 샤드 CPU 전체에 pinning
+    if (!options_.shard_cpus.empty()) {
+        shard_executor_->setQueueCpus(flat_queue_idx_, options_.shard_cpus);
+    }
+    shard_executor_->start();
+    // compaction으로 샤드가 늘어나면 flat 큐를 제외한 큐들을 나눠 씀
+    hnsw->setExecutor(shard_executor_.get(), flat_queue_idx_);
+    
+    // 공유 flat reader는 파일을 쓰지 않음 (compaction 복구/실행은 writer 호스트만)
+    bool flat_reader = flat_index_->isReadOnly();
+    if (!flat_reader) {
+        recoverCompaction();
+    }
+
+    // 재시작 시 기존 벡터와 ID가 겹치지 않도록 ID 생성기 복원
+    // (compaction으로 flat이 비워졌어도 헤더의 next_id가 남아 있음)
+    uint64_t restored_id = flat_index_->getNextId();
+    if (flat_index_->getCurrentCount() > 0) {
+        restored_id = std::max(restored_id, flat_index_->getMaxId() + 1);
+    }
+    if (restored_id > next_id_.load()) {
+        next_id_.store(restored_id);
+    }
+    
+    // 백그라운드 compactor 시작
+    if (options_.enable_compaction && !flat_reader) {
+        compact_threshold_ = options_.compact_threshold;
+        if (compact_threshold_ == 0 || compact_threshold_ > FLAT_CAPACITY) {
+            compact_threshold_ = FLAT_CAPACITY / 10 * 9;
+        }
+        compactor_ = std::thread([this] { compactionLoop(); });
+        std::cout << "- Flat compaction threshold: " << compact_threshold_ << " vectors" << std::endl;
+        maybeRequestCompaction();
+    }
+    
+    if (flat_reader) {
+        flat_poller_ = std::thread([this] { flatPollLoop(); });
+        std::cout << "- Shared flat reader: polling writer every "
+                  << options_.flat_poll_interval.count() << "ms" << std::endl;
+    }
+    
+    if (options_.trace_pages && !startPageTrace()) {
+        std::cerr << "Failed to start page access tracing" << std::endl;
+        return false;
+    }
 
     std::cout << "VectorDB 초기화 완료" << std::endl;
-    std::cout << "- HNSW 인덱스 개수: " << hnsw_manager_->getIndexCount() << std::endl;
-    for (size_t i = 0; i < hnsw_manager_->getIndexPaths().size(); ++i) {
-        std::cout << "  " << i << ": " << hnsw_manager_->getIndexPaths()[i] << std::endl;
+    std::cout << "- HNSW 인덱스 개수: " << hnsw->getIndexCount() << std::endl;
+    for (size_t i = 0; i < hnsw->getIndexPaths().size(); ++i) {
+        std::cout << "  " << i << ": " << hnsw->getIndexPaths()[i] << std::endl;
     }
-    std::cout << "- HNSW 전체 벡터 수: " << hnsw_manager_->getTotalVectorCount() << std::endl;
+    std::cout << "- HNSW 전체 벡터 수: " << hnsw->getTotalVectorCount() << std::endl;
     std::cout << "- Flat 인덱스: " << flat_index_path_ << " (" 
               << flat_index_->getCurrentCount() << " vectors)" << std::endl;
     
@@ -47,6 +119,11 @@ bool VectorDB::insertVector(const std::vector<float>& vector, uint64_t& assigned
         return false;
     }
     
+    if (flat_index_->isReadOnly()) {
+        std::cerr << "Flat index is a shared reader, insert on the writer host" << std::endl;
+        return false;
+    }
+    
     if (flat_index_->isFull()) {
         std::cerr << "Flat index is full, cannot insert more vectors" << std::endl;
         return false;
@@ -57,43 +134,157 @@ bool VectorDB::insertVector(const std::vector<float>& vector, uint64_t& assigned
     
     // Flat 인덱스에 삽입
     VectorData vector_data(vector, assigned_id);
-    bool success = flat_index_->insert(vector_data);
+    bool success;
+    {
+        std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+        success = flat_index_->insert(vector_data);
+    }
     
     if (success) {
+        data_version_.fetch_add(1, std::memory_order_release);
         std::cout << "Vector inserted with ID: " << assigned_id << std::endl;
+        maybeRequestCompaction();
     }
     
     return success;
 }
 
+bool VectorDB::insertVectors(const float* vectors, size_t count, std::vector<uint64_t>& assigned_ids) {
+    assigned_ids.clear();
+    if (count == 0) {
+        return true;
+    }
+    
+    if (flat_index_->isReadOnly()) {
+        std::cerr << "Flat index is a shared reader, insert on the writer host" << std::endl;
+        return false;
+    }
+    
+    if (flat_index_->getCurrentCount() + count > flat_index_->getMaxCapacity()) {
+        std::cerr << "Flat index cannot hold " << count << " more vectors" << std::endl;
+        return false;
+    }
+    
+    // 그룹 전체에 연속된 ID 할당
+    uint64_t first_id = next_id_.fetch_add(count);
+    assigned_ids.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        assigned_ids[i] = first_id + i;
+    }
+    
+    bool success;
+    {
+        std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+        success = flat_index_->insertBatch(vectors, count, assigned_ids.data());
+    }
+    if (!success) {
+        assigned_ids.clear();
+        return false;
+    }
+    data_version_.fetch_add(1, std::memory_order_release);
+    
+    maybeRequestCompaction();
+    return true;
+}
+
+bool VectorDB::deleteVectors(const std::vector<uint64_t>& ids, std::vector<bool>& found, size_t& deleted) {
+    found.assign(ids.size(), false);
+    deleted = 0;
+    if (ids.empty()) {
+        return true;
+    }
+    
+    // 공유 reader는 flat 파일을 쓸 수 없으므로 HNSW 쪽만 지우면 호스트 간 결과가 어긋남
+    if (flat_index_->isReadOnly()) {
+        std::cerr << "Flat index is a shared reader, delete on the writer host" << std::endl;
+        return false;
+    }
+    
+    {
+        // shared: compaction 공개와는 겹치지 않으므로 한 ID는 HNSW와 flat 중 한쪽에만 있음
+        std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+        std::vector<bool> hnsw_found;
+        deleted += hnswManager()->markDeleted(ids, hnsw_found);
+        
+        std::vector<uint64_t> remaining;
+        std::vector<size_t> remaining_pos;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (hnsw_found[i]) {
+                found[i] = true;
+            } else {
+                remaining.push_back(ids[i]);
+                remaining_pos.push_back(i);
+            }
+        }
+        
+        if (!remaining.empty()) {
+            std::vector<bool> flat_found;
+            deleted += flat_index_->markDeleted(remaining.data(), remaining.size(), flat_found);
+            for (size_t j = 0; j < remaining.size(); ++j) {
+                if (flat_found[j]) {
+                    found[remaining_pos[j]] = true;
+                }
+            }
+        }
+    }
+    
+    if (deleted > 0) {
+        data_version_.fetch_add(1, std::memory_order_release);
+        std::cout << "Deleted " << deleted << " vectors" << std::endl;
+    }
+    return true;
+}
+
 std::vector<SearchResult> VectorDB::searchVectors(const std::vector<float>& query, int k) {
     if (query.size() != VECTOR_DIM) {
         std::cerr << "Query dimension mismatch..." << std::endl;
         return {};
     }
 
-    // 1. HNSW 인덱스 검색 (비동기)
-    auto hnsw_future = std::async(std::launch::async, [this, &query, k]() {
-        return hnsw_manager_->search(query, k);
-    });
+    std::shared_lock<std::shared_mutex> tier_lock(tier_mutex_);
+    notePageTraceQueries(1);
 
-    // 2. Flat 인덱스 검색 (비동기)
-    auto flat_future = std::async(std::launch::async, [this, &query, k]() {
-        return flat_index_->bruteForceSearch(query, k);
+    // 1. Flat 인덱스 검색 (flat 전용 큐)
+    std::vector<SearchResult> flat_results;
+    std::latch flat_done(1);
+    shard_executor_->submit(flat_queue_idx_, [this, &query, k, &flat_results, &flat_done]() {
+        auto flat_start = std::chrono::steady_clock::now();
+        try {
+            flat_results = flat_index_->bruteForceSearch(query, k);
+        } catch (const std::exception& e) {
+            std::cerr << "Flat search failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Flat search failed with a non-standard exception" << std::endl;
+        }
+        search_metrics_.flat_scan_us.observeSince(flat_start);
+        flat_done.count_down();
     });
 
+    // 2. HNSW 인덱스 검색 (호출 스레드에서 샤드 큐로 fan-out 후 대기)
+    //    실패해도 flat 작업이 스택의 결과/latch를 다 쓸 때까지 기다린 뒤 전달
+    std::vector<SearchResult> hnsw_results;
+    try {
+        hnsw_results = hnswManager()->search(query, k);
+    } catch (...) {
+        flat_done.wait();
+        throw;
+    }
+
     // 3. 결과 수집
-    std::vector<SearchResult> hnsw_results = hnsw_future.get();
-    std::vector<SearchResult> flat_results = flat_future.get();
+    flat_done.wait();
 
     // 4. 결과 병합
-    return mergeSearchResults(hnsw_results, flat_results, k);
+    auto merge_start = std::chrono::steady_clock::now();
+    auto results = mergeSearchResults(hnsw_results, flat_results, k);
+    search_metrics_.tier_merge_us.observeSince(merge_start);
+    return results;
 }
 
 std::vector<std::vector<SearchResult>> VectorDB::searchVectorsBatch(
     const std::vector<std::vector<float>>& queries, 
     int k,
-    std::vector<float>& reused_batch_buffer) {
+    std::vector<float>& reused_batch_buffer,
+    int ef) {
     
     if (queries.empty()) {
         return {};
@@ -109,31 +300,61 @@ std::vector<std::vector<SearchResult>> VectorDB::searchVectorsBatch(
         }
     }
     
-    // 1. HNSW 배치 검색 (비동기)
-    auto hnsw_future = std::async(std::launch::async, [this, &queries, k, &reused_batch_buffer]() {
-        return hnsw_manager_->searchBatch(queries, k, reused_batch_buffer);
-    });
+    reused_batch_buffer.clear();
+    reused_batch_buffer.reserve(batch_size * VECTOR_DIM);
+    for (const auto& query : queries) {
+        reused_batch_buffer.insert(reused_batch_buffer.end(), query.begin(), query.end());
+    }
     
-    // 2. Flat 인덱스 배치 검색 (비동기)
-    auto flat_future = std::async(std::launch::async, [this, &queries, k]() {
-        std::vector<std::vector<SearchResult>> flat_results;
-        flat_results.reserve(queries.size());
-        
-        for (const auto& query : queries) {
-            flat_results.push_back(flat_index_->bruteForceSearch(query, k));
+    return searchVectorsBatch(reused_batch_buffer.data(), batch_size, k, ef);
+}
+
+std::vector<std::vector<SearchResult>> VectorDB::searchVectorsBatch(
+    const float* queries, size_t batch_size, int k, int ef) {
+    
+    if (batch_size == 0) {
+        return {};
+    }
+    
+    std::shared_lock<std::shared_mutex> tier_lock(tier_mutex_);
+    notePageTraceQueries(batch_size);
+    
+    // 1. Flat 인덱스 배치 검색 (flat 전용 큐)
+    std::vector<std::vector<SearchResult>> flat_results(batch_size);
+    std::latch flat_done(1);
+    shard_executor_->submit(flat_queue_idx_, [this, queries, batch_size, k, &flat_results, &flat_done]() {
+        auto flat_start = std::chrono::steady_clock::now();
+        try {
+            flat_results = flat_index_->bruteForceSearchBatch(queries, batch_size, k);
+        } catch (const std::exception& e) {
+            std::cerr << "Flat batch search failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Flat batch search failed with a non-standard exception" << std::endl;
         }
-        return flat_results;
+        search_metrics_.flat_scan_us.observeSince(flat_start);
+        flat_done.count_down();
     });
     
+    // 2. HNSW 배치 검색 (호출 스레드에서 샤드 큐로 fan-out 후 대기)
+    //    실패해도 flat 작업이 스택의 결과/latch를 다 쓸 때까지 기다린 뒤 전달
+    std::vector<std::vector<SearchResult>> hnsw_results;
+    try {
+        hnsw_results = hnswManager()->searchBatch(queries, batch_size, k, ef);
+    } catch (...) {
+        flat_done.wait();
+        throw;
+    }
+    
     // 3. 결과 수집
-    std::vector<std::vector<SearchResult>> hnsw_results = hnsw_future.get();
-    std::vector<std::vector<SearchResult>> flat_results = flat_future.get();
+    flat_done.wait();
     
     // 4. 각 쿼리별로 결과 병합
+    auto merge_start = std::chrono::steady_clock::now();
     std::vector<std::vector<SearchResult>> results(batch_size);
     for (size_t query_idx = 0; query_idx < batch_size; ++query_idx) {
         results[query_idx] = mergeSearchResults(hnsw_results[query_idx], flat_results[query_idx], k);
     }
+    search_metrics_.tier_merge_us.observeSince(merge_start);
     
     return results;
 }
@@ -146,25 +367,9 @@ std::vector<SearchResult> VectorDB::exactSearchVectors(const std::vector<float>&
 
     std::cout << "Performing exact search (brute-force)..." << std::endl;
 
-    // 1. HNSW 인덱스 Exact Search (비동기)
-    auto hnsw_future = std::async(std::launch::async, [this, &query, k]() {
-        return hnsw_manager_->exactSearch(query, k);
-    });
-
-    // 2. Flat 인덱스 검색 (이미 brute-force) (비동기)
-    auto flat_future = std::async(std::launch::async, [this, &query, k]() {
-        return flat_index_->bruteForceSearch(query, k);
-    });
-
-    // 3. 결과 수집
-    std::vector<SearchResult> hnsw_results = hnsw_future.get();
-    std::vector<SearchResult> flat_results = flat_future.get();
-
-    std::cout << "HNSW exact search: " << hnsw_results.size() << " results" << std::endl;
-    std::cout << "Flat search: " << flat_results.size() << " results" << std::endl;
-
-    // 4. 결과 병합
-    return mergeSearchResults(hnsw_results, flat_results, k);
+    // Exact search는 수 분 단위로 오래 걸리므로 샤드 executor 큐를 점유하지 않고 호출 스레드에서 실행
+    auto results = exactSearchVectorsBatch({query}, k);
+    return results.empty() ? std::vector<SearchResult>() : std::move(results.front());
 }
 
 std::vector<std::vector<SearchResult>> VectorDB::exactSearchVectorsBatch(
@@ -186,30 +391,32 @@ std::vector<std::vector<SearchResult>> VectorDB::exactSearchVectorsBatch(
     
     std::cout << "Performing exact batch search (brute-force) on " << batch_size << " queries..." << std::endl;
     
-    // 1. HNSW 인덱스 Exact Batch Search (비동기)
-    auto hnsw_future = std::async(std::launch::async, [this, &queries, k]() {
-        return hnsw_manager_->exactSearchBatch(queries, k);
-    });
-    
-    // 2. Flat 인덱스 배치 검색 (비동기)
-    auto flat_future = std::async(std::launch::async, [this, &queries, k]() {
-        std::vector<std::vector<SearchResult>> flat_results;
-        flat_results.reserve(queries.size());
+    // 두 스캔 모두 검색 코어 전체로 OpenMP 병렬이므로 동시에 돌리지 않고 차례로 실행 (과다 구독 방지)
+    // tier 락을 스캔 내내 잡고 있으면 대기 중인 compaction 공개(배타 락) 뒤로 새 ANN 검색이 모두 막히므로
+    // flat을 먼저 스캔하면서 샤드 세트와 샤드 수를 잡아 두고, 샤드는 EXACT_LOCK_WINDOW_ROWS씩 락을 다시 잡으며 스캔
+    // (그 사이 compaction이 붙인 샤드는 이미 스캔한 flat prefix에서 온 것이라 건너뛰어도 빠지는 벡터가 없음)
+    std::shared_ptr<HNSWIndexManager> hnsw;
+    size_t shard_count = 0;
+    std::vector<std::vector<SearchResult>> results;
+    {
+        std::shared_lock<std::shared_mutex> tier_lock(tier_mutex_);
+        hnsw = hnswManager();
+        shard_count = hnsw->getIndexCount();
         
-        for (const auto& query : queries) {
-            flat_results.push_back(flat_index_->bruteForceSearch(query, k));
-        }
-        return flat_results;
-    });
-    
-    // 3. 결과 수집
-    std::vector<std::vector<SearchResult>> hnsw_results = hnsw_future.get();
-    std::vector<std::vector<SearchResult>> flat_results = flat_future.get();
+        // 1. Flat 인덱스 배치 검색 (discardPrefix가 row를 옮기므로 한 번의 락 안에서)
+        results = flat_index_->bruteForceSearchBatch(queries, k, true);
+    }
     
-    // 4. 각 쿼리별로 결과 병합
-    std::vector<std::vector<SearchResult>> results(batch_size);
-    for (size_t query_idx = 0; query_idx < batch_size; ++query_idx) {
-        results[query_idx] = mergeSearchResults(hnsw_results[query_idx], flat_results[query_idx], k);
+    // 2. HNSW 인덱스 Exact Batch Search (구간마다 쿼리별로 결과 병합)
+    //    샤드는 추가만 되고 세트 교체는 새 매니저로 하므로 잡아 둔 매니저의 [0, shard_count)는 그대로 유지됨
+    ExactScanCursor cursor;
+    while (cursor.index_idx < shard_count) {
+        std::shared_lock<std::shared_mutex> tier_lock(tier_mutex_);
+        auto window_results = hnsw->exactSearchBatch(queries, k, cursor, shard_count, EXACT_LOCK_WINDOW_ROWS);
+        tier_lock.unlock();
+        for (size_t query_idx = 0; query_idx < batch_size; ++query_idx) {
+            results[query_idx] = mergeSearchResults(window_results[query_idx], results[query_idx], k);
+        }
     }
     
     std::cout << "Exact batch search completed" << std::endl;
@@ -220,7 +427,7 @@ std::vector<std::vector<SearchResult>> VectorDB::exactSearchVectorsBatch(
 std::vector<SearchResult> VectorDB::mergeSearchResults(
     const std::vector<SearchResult>& hnsw_results,
     const std::vector<SearchResult>& flat_results,
-    int k) const {
+    int k) {
     
     std::vector<SearchResult> merged_results;
     merged_results.reserve(hnsw_results.size() + flat_results.size());
@@ -257,9 +464,553 @@ bool VectorDB::isFlatIndexFull() const {
     return flat_index_->isFull();
 }
 
+size_t VectorDB::getHNSWIndexCount() const {
+    std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+    return hnswManager()->getIndexCount();
+}
+
+size_t VectorDB::getHNSWDeletedCount() const {
+    std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+    return hnswManager()->getDeletedCount();
+}
+
+std::vector<ShardInfo> VectorDB::getShardInfo() const {
+    std::vector<ShardInfo> shards;
+    std::vector<FileMapping> mappings;
+    std::shared_ptr<HNSWIndexManager> hnsw;
+    {
+        std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+        hnsw = hnswManager();
+        for (size_t i = 0; i < hnsw->getIndexCount(); ++i) {
+            const auto& stats = hnsw->getLoadStats(i);
+            shards.push_back({hnsw->getIndexPaths()[i], hnsw->getIndexVectorCount(i),
+                              hnsw->getIndexDeletedCount(i), stats, 0});
+            mappings.push_back(stats.mapping);
+        }
+    }
+    
+    // smaps 파싱은 락 밖에서 한 번만 (hnsw 참조가 매핑을 유지하므로 교체되어도 주소가 유효)
+    auto resident = residentBytes(mappings);
+    for (size_t i = 0; i < shards.size(); ++i) {
+        shards[i].resident_bytes = resident[i];
+    }
+    return shards;
+}
+
+void VectorDB::maybeRequestCompaction() {
+    if (compact_threshold_ == 0 || flat_index_->getCurrentCount() < compact_threshold_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+        compact_requested_ = true;
+    }
+    compact_cv_.notify_one();
+}
+
+void VectorDB::compactionLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(compact_mutex_);
+            compact_cv_.wait(lock, [this] { return compact_requested_ || compactor_stop_; });
+            if (compactor_stop_) {
+                return;
+            }
+            compact_requested_ = false;
+        }
+        
+        if (flat_index_->getCurrentCount() < compact_threshold_) {
+            continue;
+        }
+        
+        try {
+            compactFlatIndex();
+        } catch (const std::exception& e) {
+            std::cerr << "Flat compaction failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+void VectorDB::flatPollLoop() {
+    std::unique_lock<std::mutex> lock(compact_mutex_);
+    while (!compactor_stop_) {
+        compact_cv_.wait_for(lock, options_.flat_poll_interval, [this] { return compactor_stop_; });
+        if (compactor_stop_) {
+            return;
+        }
+        lock.unlock();
+        refreshSharedTombstones();
+        refreshSharedFlat();
+        lock.lock();
+    }
+}
+
+void VectorDB::refreshSharedTombstones() {
+    // writer 호스트의 HNSW 삭제는 .tomb 파일에만 기록되므로 헤더 카운트가 바뀐 샤드만 다시 읽음
+    // (shared: 샤드 세트를 바꾸는 addIndex/reload 교체와만 겹치지 않으면 됨)
+    std::shared_lock<std::shared_mutex> lock(tier_mutex_);
+    if (hnswManager()->refreshSharedTombstones()) {
+        data_version_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+bool VectorDB::refreshSharedFlat() {
+    FlatPublishedState state;
+    if (!flat_index_->readPublished(state)) {
+        return false;   // writer가 공개 중, 다음 주기에 다시 확인
+    }
+    
+    size_t added = 0;
+    if (flat_index_->isPrefixReset(state)) {
+        // writer가 compaction으로 prefix를 비움: writer가 만든 새 HNSW 샤드를 먼저 붙이고
+        // 검색을 막은 채 전체 재반영 (prefix의 벡터가 샤드와 flat 어느 쪽에서도 빠지지 않도록)
+        std::lock_guard<std::mutex> shard_set_lock(shard_set_mutex_);
+        auto hnsw = hnswManager();
+        std::vector<LoadedHNSWIndex> shards = loadWriterCompactedShards(*hnsw);
+        std::unique_lock<std::shared_mutex> lock(tier_mutex_);
+        for (auto& shard : shards) {
+            hnsw->addIndex(std::move(shard));
+        }
+        added = flat_index_->applyPublished(state);
+        std::cout << "Shared flat writer discarded a prefix, attached " << shards.size()
+                  << " compaction shards and re-read " << added << " vectors" << std::endl;
+    } else if (state.count > flat_index_->getCurrentCount()) {
+        // 새 범위만 invalidate 후 노출 (기존 범위를 스캔 중인 검색과 겹치지 않음)
+        added = flat_index_->applyPublished(state);
+    } else if (flat_index_->isNewPublish(state)) {
+        // row 수는 같고 writer가 삭제 표시만 공개함: tombstone만 다시 읽음
+        flat_index_->applyPublished(state);
+    } else {
+        return false;
+    }
+    
+    data_version_.fetch_add(1, std::memory_order_release);
+    total_flat_refreshes_.fetch_add(1);
+    return added > 0;
+}
+
+std::vector<LoadedHNSWIndex> VectorDB::loadWriterCompactedShards(HNSWIndexManager& hnsw) {
+    // writer는 rename으로 샤드를 공개한 뒤에 prefix를 제거하므로 세대가 바뀐 시점에는 파일이 이미 있음
+    std::set<std::string> attached;
+    for (const auto& path : hnsw.getIndexPaths()) {
+        attached.insert(std::filesystem::path(path).filename().string());
+    }
+    std::vector<std::string> new_paths;
+    for (const auto& entry : std::filesystem::directory_iterator(hnsw_index_dir_)) {
+        const auto& path = entry.path();
+        std::string filename = path.filename().string();
+        if (filename.starts_with("hnsw_index_compact_") && path.extension() == ".bin" &&
+            !attached.contains(filename)) {
+            new_paths.push_back(path.string());
+        }
+    }
+    std::sort(new_paths.begin(), new_paths.end());
+    
+    // 로드(역직렬화 + 더미 검색)는 tier 락 밖에서 수행
+    std::vector<LoadedHNSWIndex> shards;
+    for (const auto& path : new_paths) {
+        auto loaded = hnsw.loadIndex(path);
+        if (!loaded) {
+            std::cerr << "Failed to load writer compaction shard " << path << std::endl;
+            continue;
+        }
+        shards.push_back(std::move(*loaded));
+    }
+    std::vector<LoadedHNSWIndex*> pointers;
+    for (auto& shard : shards) {
+        pointers.push_back(&shard);
+    }
+    hnsw.replicateHotRegions(pointers);
+    return shards;
+}
+
+bool VectorDB::compactFlatIndex() {
+    // 샤드 세트 reload와 겹치지 않도록 (reload가 읽은 디렉토리에 없는 샤드가 추가되어 사라지는 일 방지)
+    std::lock_guard<std::mutex> shard_set_lock(shard_set_mutex_);
+    auto hnsw = hnswManager();
+    
+    // [0, count) 구간은 compactor만 제거할 수 있으므로 락 없이 읽어도 안전
+    size_t count = flat_index_->getCurrentCount();
+    if (count == 0) {
+        return true;
+    }
+    
+    std::cout << "=== Flat compaction 시작: " << count << " vectors ===" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    
+    // 1. 삭제되지 않은 row만 모음 (삭제가 없으면 flat 매핑을 그대로 사용)
+    const float* rows = flat_index_->getVectorData();
+    const uint64_t* row_ids = flat_index_->getIdData();
+    std::vector<size_t> live_rows;
+    std::vector<float> live_vectors;
+    std::vector<uint64_t> live_ids;
+    size_t deleted_before = flat_index_->getDeletedCount();
+    if (deleted_before > 0) {
+        live_rows.reserve(count - std::min(count, deleted_before));
+        for (size_t row = 0; row < count; ++row) {
+            if (!flat_index_->isDeleted(row)) {
+                live_rows.push_back(row);
+            }
+        }
+        live_vectors.resize(live_rows.size() * VECTOR_DIM);
+        live_ids.resize(live_rows.size());
+        for (size_t j = 0; j < live_rows.size(); ++j) {
+            std::memcpy(&live_vectors[j * VECTOR_DIM], rows + live_rows[j] * VECTOR_DIM,
+                        VECTOR_DIM * sizeof(float));
+            live_ids[j] = row_ids[live_rows[j]];
+        }
+        std::cout << "Flat compaction: dropping " << count - live_rows.size() << " deleted vectors" << std::endl;
+        rows = live_vectors.data();
+        row_ids = live_ids.data();
+    }
+    size_t live_count = deleted_before > 0 ? live_rows.size() : count;
+    
+    if (live_count == 0) {
+        // 전부 삭제됨: 샤드 없이 prefix만 제거
+        std::unique_lock<std::shared_mutex> lock(tier_mutex_);
+        flat_index_->discardPrefix(count);
+        data_version_.fetch_add(1, std::memory_order_release);
+        total_compactions_.fetch_add(1);
+        std::cout << "=== Flat compaction 완료: all " << count << " vectors were deleted ===" << std::endl;
+        return true;
+    }
+    
+    // 2. Train/Add로 HNSW 샤드 빌드 (flat 벡터는 이미 정규화되어 있음)
+    HNSWBuildParams params;
+    params.dim = static_cast<int>(VECTOR_DIM);
+    HNSWBuilder builder(params);
+    if (!builder.train(rows, live_count) || !builder.add(rows, live_count)) {
+        std::cerr << "Flat compaction: HNSW build failed" << std::endl;
+        return false;
+    }
+    
+    // 3. 임시 파일로 저장 (.tmp는 로더가 무시) + label → ID 사이드카
+    auto stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::filesystem::path base = std::filesystem::path(hnsw_index_dir_) /
+                                 ("hnsw_index_compact_" + std::to_string(stamp));
+    std::string tmp_path = base.string() + ".tmp";
+    std::string ids_path = base.string() + ".ids";
+    std::string final_path = base.string() + ".bin";
+    
+    if (!builder.save(tmp_path)) {
+        std::filesystem::remove(tmp_path);
+        return false;
+    }
+    
+    int ids_fd = open(ids_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    size_t ids_bytes = live_count * sizeof(uint64_t);
+    bool ids_ok = ids_fd != -1 &&
+                  write(ids_fd, row_ids, ids_bytes) == static_cast<ssize_t>(ids_bytes) &&
+                  fsync(ids_fd) == 0;
+    if (ids_fd != -1) {
+        close(ids_fd);
+    }
+    if (!ids_ok) {
+        std::cerr << "Flat compaction: failed to write ID map " << ids_path << std::endl;
+        std::filesystem::remove(tmp_path);
+        std::filesystem::remove(ids_path);
+        return false;
+    }
+    
+    // 4. 검색을 막지 않도록 로드(역직렬화 + 더미 검색)는 락 밖에서 수행
+    auto loaded = hnsw->loadIndex(tmp_path);
+    std::string tomb_path = std::filesystem::path(tmp_path).replace_extension(".tomb").string();
+    std::string ivf_path = std::filesystem::path(tmp_path).replace_extension(".ivf").string();
+    if (!loaded) {
+        std::filesystem::remove(tmp_path);
+        std::filesystem::remove(ids_path);
+        std::filesystem::remove(tomb_path);
+        std::filesystem::remove(ivf_path);
+        return false;
+    }
+    // 남은 DRAM 복제 예산이 있으면 공개 전에 hot 구간 복제
+    hnsw->replicateHotRegions({&*loaded});
+    
+    // 5. 샤드 공개와 flat prefix 제거를 한 번에 (검색이 중복/누락을 보지 않도록)
+    //    rename 후 discardPrefix 전에 죽으면 재시작 시 recoverCompaction()이 prefix를 제거
+    std::error_code rename_error;
+    {
+        std::unique_lock<std::shared_mutex> lock(tier_mutex_);
+        // 빌드 중에 삭제된 row는 새 샤드의 tombstone으로 옮김 (label = live row 순서)
+        if (flat_index_->getDeletedCount() != deleted_before && loaded->tombstones) {
+            for (size_t j = 0; j < live_count; ++j) {
+                size_t row = deleted_before > 0 ? live_rows[j] : j;
+                if (flat_index_->isDeleted(row)) {
+                    loaded->tombstones->set(j);
+                }
+            }
+        }
+        // 배타적 락을 잡은 채 예외가 나가지 않도록 error_code로 받음 (실패하면 샤드도 prefix도 그대로)
+        std::filesystem::rename(tmp_path, final_path, rename_error);
+        if (!rename_error) {
+            loaded->path = final_path;
+            hnsw->addIndex(std::move(*loaded));
+            flat_index_->discardPrefix(count);
+            data_version_.fetch_add(1, std::memory_order_release);
+        }
+    }
+    if (rename_error) {
+        std::cerr << "Flat compaction: failed to publish " << final_path << ": " << rename_error.message() << std::endl;
+        hnsw->releaseRoutingBudget(loaded->stats.routing_bytes);
+        loaded.reset();
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+        std::filesystem::remove(ids_path, ec);
+        std::filesystem::remove(tomb_path, ec);
+        std::filesystem::remove(ivf_path, ec);
+        return false;
+    }
+    
+    total_compactions_.fetch_add(1);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "=== Flat compaction 완료: " << final_path << " (" << live_count << " vectors, "
+              << elapsed.count() << "ms) ===" << std::endl;
+    return true;
+}
+
+void VectorDB::recoverCompaction() {
+    // 1. 공개되지 않은 임시 샤드와 짝 없는 ID/tombstone 사이드카 정리
+    for (const auto& entry : std::filesystem::directory_iterator(hnsw_index_dir_)) {
+        const auto& path = entry.path();
+        std::string filename = path.filename().string();
+        if (!filename.starts_with("hnsw_index_compact_")) {
+            continue;
+        }
+        bool orphan_ids = (path.extension() == ".ids" || path.extension() == ".tomb" || path.extension() == ".ivf") &&
+                          !std::filesystem::exists(std::filesystem::path(path).replace_extension(".bin"));
+        if (path.extension() == ".tmp" || orphan_ids) {
+            std::cout << "Removing incomplete compaction file: " << path << std::endl;
+            std::filesystem::remove(path);
+        }
+    }
+    
+    // 2. 샤드는 공개됐지만 flat prefix 제거 전에 죽은 경우: 마지막 compaction 샤드의
+    //    ID 매핑과 flat 앞부분(compaction이 건너뛴 삭제 row 제외)이 같으면 그 prefix를 제거
+    auto hnsw = hnswManager();
+    for (size_t i = hnsw->getIndexCount(); i-- > 0;) {
+        const auto* id_map = hnsw->getIdMap(i);
+        if (id_map == nullptr) {
+            continue;
+        }
+        const uint64_t* flat_ids = flat_index_->getIdData();
+        size_t flat_count = flat_index_->getCurrentCount();
+        size_t matched = 0;
+        size_t row = 0;
+        for (; row < flat_count && matched < id_map->size(); ++row) {
+            if (flat_ids[row] == (*id_map)[matched]) {
+                ++matched;
+            } else if (!flat_index_->isDeleted(row)) {
+                break;
+            }
+        }
+        if (!id_map->empty() && matched == id_map->size()) {
+            std::cout << "Recovering interrupted compaction of " << row << " vectors" << std::endl;
+            flat_index_->discardPrefix(row);
+        }
+        break;
+    }
+}
+
+bool VectorDB::startPageTrace() {
+    page_tracer_ = std::make_unique<PageAccessTracer>(options_.page_trace);
+    
+    auto hnsw = hnswManager();
+    for (size_t i = 0; i < hnsw->getIndexCount(); ++i) {
+        const auto& mapping = hnsw->getLoadStats(i).mapping;
+        std::string name = std::filesystem::path(hnsw->getIndexPaths()[i]).filename().string();
+        if (!page_tracer_->addRegion(name, mapping)) {
+            std::cerr << "Shard is not file-mapped, not traced: " << name << std::endl;
+        }
+    }
+    FileMapping flat_mapping;
+    if (!findFileMapping(flat_index_path_, flat_mapping) || !page_tracer_->addRegion("flat", flat_mapping)) {
+        std::cerr << "Flat index mapping not found, not traced: " << flat_index_path_ << std::endl;
+    }
+    
+    return page_tracer_->start();
+}
+
+bool VectorDB::dumpPageTrace(const std::string& prefix, double min_rate, const std::string& action) const {
+    if (!page_tracer_) {
+        return false;
+    }
+    return page_tracer_->writeHeatmap(prefix + ".heatmap.tsv") &&
+           page_tracer_->writeDamonScheme(prefix + ".damon.json", min_rate, action);
+}
+
+std::string VectorDB::getTraceOutputDir() const {
+    std::filesystem::path dir = std::filesystem::path(options_.trace_output).parent_path();
+    return dir.empty() ? std::string(".") : dir.string();
+}
+
+bool VectorDB::startShardReload(const std::string& dir, std::string& error) {
+    std::lock_guard<std::mutex> lock(reload_status_mutex_);
+    if (reload_status_.running) {
+        error = "shard reload already running";
+        return false;
+    }
+    // 트레이서의 영역은 현재 세트의 매핑 주소를 가리킴 (교체 후 해제된 주소를 감시하게 됨)
+    if (page_tracer_) {
+        error = "page access tracing is active";
+        return false;
+    }
+    std::string target = dir.empty() ? hnsw_index_dir_ : dir;
+    if (!std::filesystem::is_directory(target)) {
+        error = "not a directory: " + target;
+        return false;
+    }
+    if (dropsCompactedShards(target, error)) {
+        return false;
+    }
+
+    // 이전 reload 스레드는 running=false로 바꾼 뒤 끝나므로 여기서 바로 join됨
+    if (reload_thread_.joinable()) {
+        reload_thread_.join();
+    }
+    reload_status_.running = true;
+    reload_status_.dir = target;
+    reload_thread_ = std::thread([this, target] { reloadShards(target); });
+    return true;
+}
+
+bool VectorDB::dropsCompactedShards(const std::string& dir, std::string& error) const {
+    std::error_code ec;
+    if (std::filesystem::equivalent(dir, hnsw_index_dir_, ec)) {
+        return false;
+    }
+    // 다른 디렉토리의 세트에는 이 디렉토리에 쓴 compaction 샤드가 없음 (그 벡터는 flat에서도 이미 빠짐)
+    auto hnsw = hnswManager();
+    for (const auto& path : hnsw->getIndexPaths()) {
+        if (std::filesystem::path(path).filename().string().starts_with("hnsw_index_compact_")) {
+            error = "compacted shard " + path + " exists only in " + hnsw_index_dir_ +
+                    " (copy the compaction shards into " + dir + " or reload " + hnsw_index_dir_ + ")";
+            return true;
+        }
+    }
+    return false;
+}
+
+ShardReloadStatus VectorDB::getShardReloadStatus() const {
+    std::lock_guard<std::mutex> lock(reload_status_mutex_);
+    return reload_status_;
+}
+
+void VectorDB::reloadShards(const std::string& dir) {
+    auto finish = [this](const std::string& error, size_t shard_count, double load_ms, double drain_ms) {
+        std::lock_guard<std::mutex> lock(reload_status_mutex_);
+        reload_status_.running = false;
+        reload_status_.last_error = error;
+        if (error.empty()) {
+            ++reload_status_.generation;
+            reload_status_.shard_count = shard_count;
+            reload_status_.load_ms = load_ms;
+            reload_status_.drain_ms = drain_ms;
+        }
+    };
+
+    std::cout << "=== HNSW 샤드 세트 reload 시작: " << dir << " ===" << std::endl;
+    // 로드부터 교체까지 compaction이 끼어들지 않도록 (새 세트에 없는 compaction 샤드가 생기지 않게)
+    std::lock_guard<std::mutex> shard_set_lock(shard_set_mutex_);
+    
+    // 시작 요청과 락 사이에 compaction이 끝났을 수 있으므로 다시 확인
+    std::string error;
+    if (dropsCompactedShards(dir, error)) {
+        std::cerr << "Shard reload refused: " << error << std::endl;
+        finish(error, 0, 0.0, 0.0);
+        return;
+    }
+
+    // 1. 새 세트 로드: 검색은 그동안 이전 세트로 계속 처리 (워밍업과 DRAM 복제도 initialize 안에서 끝남)
+    //    DRAM 복제 예산이 두 세트에 동시에 잡히지 않도록 이전 세트의 복제를 먼저 파일 매핑으로 되돌림
+    //    (로드하는 동안 이전 세트의 hot 구간은 CXL에서 읽고, 로드가 실패해도 복제 없이 계속 서빙)
+    if (options_.shard_load.dram_replica_bytes > 0 && options_.shard_load.engine != ShardEngine::IVFSQ8) {
+        size_t released = hnswManager()->releaseReplicas();
+        std::cout << "Released " << released / 1024 / 1024 << "MB of DRAM replicas of the current shard set" << std::endl;
+    }
+    auto load_start = std::chrono::steady_clock::now();
+    auto fresh = std::make_shared<HNSWIndexManager>(dir, VECTOR_DIM, options_.shard_load);
+    fresh->setMetrics(&search_metrics_);
+    if (!fresh->initialize()) {
+        std::cerr << "Shard reload failed, keeping current shard set: " << dir << std::endl;
+        finish("failed to load shard set from " + dir, 0, 0.0, 0.0);
+        return;
+    }
+    fresh->setExecutor(shard_executor_.get(), flat_queue_idx_);
+    double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+    size_t shard_count = fresh->getIndexCount();
+
+    // 2. 공개: 이후 시작하는 검색은 새 세트를 봄
+    //    포인터 교체만 배타적 tier 락 안에서 (진행 중인 검색/삭제가 tier 락을 잡은 채 세트가 바뀌지 않도록,
+    //    새 세트의 로드와 이전 세트의 grace period는 락 밖)
+    std::shared_ptr<HNSWIndexManager> old;
+    {
+        std::unique_lock<std::shared_mutex> lock(tier_mutex_);
+        old = hnsw_manager_.exchange(fresh, std::memory_order_acq_rel);
+        hnsw_index_dir_ = dir;
+        data_version_.fetch_add(1, std::memory_order_release);
+    }
+    fresh.reset();
+
+    // 3. grace period: 이전 세트를 snapshot으로 잡은 검색이 모두 끝나면 여기서 해제 (munmap)
+    auto drain_start = std::chrono::steady_clock::now();
+    auto next_log = drain_start + RELOAD_DRAIN_LOG_INTERVAL;
+    while (old.use_count() > 1) {
+        std::this_thread::sleep_for(RELOAD_DRAIN_POLL);
+        if (std::chrono::steady_clock::now() >= next_log) {
+            std::cout << "Waiting for " << (old.use_count() - 1)
+                      << " in-flight searches on the previous shard set" << std::endl;
+            next_log += RELOAD_DRAIN_LOG_INTERVAL;
+        }
+    }
+    double drain_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - drain_start).count();
+    old.reset();
+
+    std::cout << "=== HNSW 샤드 세트 reload 완료: " << shard_count << " shards (load "
+              << load_ms << "ms, drain " << drain_ms << "ms) ===" << std::endl;
+    finish("", shard_count, load_ms, drain_ms);
+}
+
 void VectorDB::shutdown() {
     std::cout << "VectorDB 종료 중..." << std::endl;
     
+    // 매핑을 해제하기 전에 감시 중인 페이지 권한부터 복구
+    if (page_tracer_) {
+        page_tracer_->stop();
+        if (!options_.trace_output.empty()) {
+            dumpPageTrace(options_.trace_output);
+        }
+        page_tracer_.reset();
+    }
+    
+    if (compactor_.joinable() || flat_poller_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(compact_mutex_);
+            compactor_stop_ = true;
+        }
+        compact_cv_.notify_all();
+        if (compactor_.joinable()) {
+            compactor_.join();
+        }
+        if (flat_poller_.joinable()) {
+            flat_poller_.join();
+        }
+    }
+    
+    // 진행 중인 reload는 끝까지 기다림 (로드 중인 세트가 executor를 잡기 전에 멈추도록)
+    if (reload_thread_.joinable()) {
+        reload_thread_.join();
+    }
+    
+    if (shard_executor_) {
+        if (auto hnsw = hnswManager()) {
+            hnsw->setExecutor(nullptr, 1);
+        }
+        shard_executor_->stop();
+        shard_executor_.reset();
+    }
+    
     if (flat_index_) {
         flat_index_.reset();
     }
@@ -6,31 +6,122 @@
 #include <string>
 #include <atomic>
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
 
 // 분리된 인덱스 헤더들
 #include "flat_index.h"
 #include "hnsw_index.h"
+#include "shard_executor.h"
+#include "page_tracer.h"
+
+// VectorDB 실행 옵션 (main.cpp의 명령행 옵션으로 설정)
+struct VectorDBOptions {
+    size_t shard_threads_per_queue = 0;  // 샤드 큐당 스레드 수 (0이면 자동)
+    std::vector<int> shard_cpus;         // 샤드 스레드를 pinning할 CPU 목록 (비어 있으면 pinning 안 함)
+    // 검색 연산 스레드 예산: 샤드 큐 스레드 합, Knowhere 풀, flat/exact OpenMP 스캔이 모두 이 값을 따름
+    // (0이면 하드웨어 스레드 수 / Knowhere 64 / OpenMP 기본값)
+    size_t compute_threads = 0;
+    
+    ShardLoadOptions shard_load;         // HNSW 샤드 병렬 로드 / 워밍업
+    FlatIndexOptions flat;               // 새 flat 파일의 압축 스캔 코드 / rerank 후보 배수 / 호스트 간 공유 역할
+    // flat.sharing이 Reader일 때 writer가 공개한 새 row를 확인하는 주기
+    std::chrono::milliseconds flat_poll_interval{10};
+    
+    bool enable_compaction = true;       // flat 티어를 백그라운드에서 HNSW 샤드로 compaction
+    size_t compact_threshold = 0;        // compaction을 시작할 flat 벡터 수 (0이면 flat 용량의 90%)
+    
+    bool trace_pages = false;            // 샤드/flat 매핑의 페이지 접근 샘플링 (계측 모드)
+    PageTracerOptions page_trace;
+    std::string trace_output;            // 종료 시 heatmap/DAMON scheme을 기록할 경로 prefix (비어 있으면 기록 안 함)
+};
+
+// 샤드 상태 (/api/status 보고용)
+struct ShardInfo {
+    std::string path;
+    size_t vector_count;
+    size_t deleted_count;    // tombstone으로 표시된 벡터 수
+    ShardLoadStats load_stats;
+    size_t resident_bytes;   // 조회 시점의 Rss
+};
+
+// 샤드 세트 hot-swap 상태 (/api/status 보고용)
+struct ShardReloadStatus {
+    bool running = false;
+    uint64_t generation = 0;      // 시작 이후 공개된 새 샤드 세트 수
+    std::string dir;              // 마지막으로 요청된 디렉토리
+    std::string last_error;       // 마지막 실패 이유 (성공하면 비움)
+    size_t shard_count = 0;        // 마지막으로 공개된 세트의 샤드 수
+    double load_ms = 0.0;         // 새 세트 로드 + 워밍업 + DRAM 복제
+    double drain_ms = 0.0;        // 공개 후 이전 세트를 쓰던 검색이 모두 끝날 때까지
+};
 
 // VectorDB 메인 클래스
 class VectorDB {
 private:
     static constexpr size_t VECTOR_DIM = 768;
     static constexpr int DEFAULT_K = 10;
+    static constexpr size_t FLAT_CAPACITY = 1000000;
+    // exact search가 tier 락을 한 번 잡고 스캔하는 최대 샤드 row 수 (구간 사이에 락을 풀어 compaction 공개가 끼어들 수 있게)
+    static constexpr size_t EXACT_LOCK_WINDOW_ROWS = 1 << 20;
+    // reload 후 이전 세트를 잡은 검색이 끝났는지 확인하는 주기와 대기 로그 주기
+    static constexpr std::chrono::milliseconds RELOAD_DRAIN_POLL{10};
+    static constexpr std::chrono::seconds RELOAD_DRAIN_LOG_INTERVAL{5};
     
     std::string hnsw_index_dir_;
     std::string flat_index_path_;
+    VectorDBOptions options_;
     
-    // HNSW 인덱스 관리자
-    std::unique_ptr<HNSWIndexManager> hnsw_manager_;
+    // HNSW 인덱스 관리자 (RCU: 검색은 시작할 때 snapshot을 잡고, reload는 포인터만 바꾼 뒤
+    // 이전 세트를 잡은 검색이 모두 끝나면 reload 스레드에서 해제)
+    std::atomic<std::shared_ptr<HNSWIndexManager>> hnsw_manager_;
     
     // Append-only flat 인덱스
     std::unique_ptr<AppendOnlyFlatIndex> flat_index_;
     
+    // 샤드 검색 executor (HNSW 샤드별 큐 + 마지막 큐는 flat 인덱스 전용)
+    std::unique_ptr<ShardExecutor> shard_executor_;
+    size_t flat_queue_idx_;
+    
     // ID 생성기
     std::atomic<uint64_t> next_id_;
+    
+    // 검색 결과가 바뀔 수 있는 변경(삽입, 삭제, compaction 공개)마다 증가 (결과 캐시 무효화용)
+    std::atomic<uint64_t> data_version_;
+    
+    // 티어 구성 보호: 검색/삽입/삭제는 shared, compaction 결과 반영(샤드 추가 + flat 비우기)은 exclusive
+    mutable std::shared_mutex tier_mutex_;
+    
+    // 백그라운드 compactor
+    size_t compact_threshold_;
+    std::thread compactor_;
+    std::mutex compact_mutex_;
+    std::condition_variable compact_cv_;
+    bool compact_requested_;
+    bool compactor_stop_;
+    std::atomic<size_t> total_compactions_;
+    
+    // 샤드 세트 변경 직렬화: compaction(샤드 추가)과 reload(세트 교체)가 겹치지 않도록
+    std::mutex shard_set_mutex_;
+    std::thread reload_thread_;
+    mutable std::mutex reload_status_mutex_;
+    ShardReloadStatus reload_status_;
+    
+    // 공유 flat reader: writer의 공개 상태를 주기적으로 확인하는 스레드 (compactor와 stop 플래그를 공유)
+    std::thread flat_poller_;
+    std::atomic<uint64_t> total_flat_refreshes_;
+    
+    // 검색 단계별 latency (/metrics)
+    SearchMetrics search_metrics_;
+    
+    // 페이지 접근 tracer (trace_pages일 때만 생성, 시작 시점의 샤드와 flat 매핑만 추적)
+    std::unique_ptr<PageAccessTracer> page_tracer_;
 
 public:
-    VectorDB(const std::string& hnsw_dir, const std::string& flat_path);
+    VectorDB(const std::string& hnsw_dir, const std::string& flat_path,
+             const VectorDBOptions& options = VectorDBOptions());
     ~VectorDB();
     
     bool initialize();
@@ -38,17 +129,30 @@ public:
     // 벡터 삽입
     bool insertVector(const std::vector<float>& vector, uint64_t& assigned_id);
     
+    // 여러 벡터를 한 그룹으로 삽입 (연속 append + 그룹당 flush 한 번)
+    // vectors: count × VECTOR_DIM 연속 배열, 성공 시 assigned_ids에 count개 ID
+    bool insertVectors(const float* vectors, size_t count, std::vector<uint64_t>& assigned_ids);
+    
+    // 벡터 삭제 (tombstone 표시, 공간은 flat은 compaction 때, HNSW 샤드는 재빌드 때 회수)
+    // found[i]: ids[i]가 살아 있어서 이번에 삭제됐는지, 반환값은 삭제한 수 (공유 flat reader면 false)
+    bool deleteVectors(const std::vector<uint64_t>& ids, std::vector<bool>& found, size_t& deleted);
+    
     // 벡터 검색
     std::vector<SearchResult> searchVectors(const std::vector<float>& query, int k = DEFAULT_K);
     
     // Exact Search (HNSW + Flat 모두 brute-force)
     std::vector<SearchResult> exactSearchVectors(const std::vector<float>& query, int k = DEFAULT_K);
     
-    // 배치 벡터 검색 (버퍼 재사용)
+    // 배치 벡터 검색 (버퍼 재사용, ef가 0이면 HNSW 기본값)
     std::vector<std::vector<SearchResult>> searchVectorsBatch(
         const std::vector<std::vector<float>>& queries, 
         int k,
-        std::vector<float>& reused_batch_buffer);
+        std::vector<float>& reused_batch_buffer,
+        int ef = 0);
+    
+    // 연속 배열(count × VECTOR_DIM) 배치 검색 (HNSW 샤드와 flat 스캔이 queries를 복사 없이 참조)
+    std::vector<std::vector<SearchResult>> searchVectorsBatch(
+        const float* queries, size_t count, int k, int ef = 0);
     
     // 배치 Exact Search
     std::vector<std::vector<SearchResult>> exactSearchVectorsBatch(
@@ -56,14 +160,72 @@ public:
         int k = DEFAULT_K);
     
     // 상태 확인
+    size_t getVectorDim() const { return VECTOR_DIM; }
     size_t getFlatIndexCount() const;
     bool isFlatIndexFull() const;
+    FlatCodeType getFlatCodeType() const { return flat_index_->getCodeType(); }
+    size_t getFlatScanBytesPerRow() const { return flat_index_->getScanBytesPerRow(); }
+    size_t getHNSWIndexCount() const;
+    // tombstone으로 표시됐지만 아직 회수되지 않은 벡터 수
+    size_t getFlatDeletedCount() const { return flat_index_->getDeletedCount(); }
+    size_t getHNSWDeletedCount() const;
+    std::vector<ShardInfo> getShardInfo() const;
+    size_t getCompactionCount() const { return total_compactions_.load(); }
+    FlatSharingMode getFlatSharingMode() const { return flat_index_->getSharingMode(); }
+    // Reader 모드에서 writer의 새 row를 반영한 횟수
+    uint64_t getFlatRefreshCount() const { return total_flat_refreshes_.load(); }
+    // 변경이 공개된 뒤에 증가하므로, 검색 전에 읽은 버전이 같으면 그 사이 결과가 바뀌지 않음
+    uint64_t getDataVersion() const { return data_version_.load(std::memory_order_acquire); }
+    const PageAccessTracer* getPageTracer() const { return page_tracer_.get(); }
+    const SearchMetrics& getSearchMetrics() const { return search_metrics_; }
+    
+    // dir(비어 있으면 현재 디렉토리)의 샤드 세트를 백그라운드에서 로드/워밍업한 뒤 교체
+    // 이미 reload 중이거나 시작할 수 없으면 false와 error
+    bool startShardReload(const std::string& dir, std::string& error);
+    ShardReloadStatus getShardReloadStatus() const;
+    
+    // 현재까지의 페이지 접근 통계를 <prefix>.heatmap.tsv, <prefix>.damon.json으로 기록
+    bool dumpPageTrace(const std::string& prefix, double min_rate = 0.5,
+                       const std::string& action = "replicate") const;
+    // HTTP 덤프를 쓸 디렉토리 (--trace-output prefix의 디렉토리, 없으면 현재 디렉토리)
+    std::string getTraceOutputDir() const;
     
     void shutdown();
-
-private:
-    std::vector<SearchResult> mergeSearchResults(
+    
+    // HNSW 결과와 flat 결과를 거리순으로 병합해 상위 k개 (상태를 쓰지 않음, 벤치마크에서도 사용)
+    static std::vector<SearchResult> mergeSearchResults(
         const std::vector<SearchResult>& hnsw_results,
         const std::vector<SearchResult>& flat_results,
-        int k) const;
+        int k);
+
+private:
+    std::shared_ptr<HNSWIndexManager> hnswManager() const {
+        return hnsw_manager_.load(std::memory_order_acquire);
+    }
+    void reloadShards(const std::string& dir);
+    // dir로 바꾸면 현재 세트의 compaction 샤드(flat prefix는 이미 제거됨)가 빠지는지 확인
+    bool dropsCompactedShards(const std::string& dir, std::string& error) const;
+    
+    // 삽입 후 flat 벡터 수가 임계값을 넘으면 compactor를 깨움
+    void maybeRequestCompaction();
+    void compactionLoop();
+    // 공유 flat reader: writer가 공개한 row를 반영하고 결과 캐시 무효화
+    void flatPollLoop();
+    bool refreshSharedFlat();
+    // 공유 flat reader: writer가 HNSW 샤드 .tomb에 쓴 삭제 표시를 반영
+    void refreshSharedTombstones();
+    // writer가 compaction으로 공개했지만 아직 붙이지 않은 샤드 로드 (shard_set_mutex_ 보유 상태에서 호출)
+    std::vector<LoadedHNSWIndex> loadWriterCompactedShards(HNSWIndexManager& hnsw);
+    // 현재 flat 내용을 HNSW 샤드로 빌드해서 추가하고 flat 티어를 비움
+    bool compactFlatIndex();
+    // compaction 도중 종료되어 남은 임시 파일 정리 및 중복 flat prefix 제거
+    void recoverCompaction();
+    
+    bool startPageTrace();
+    void notePageTraceQueries(size_t count) {
+        if (page_tracer_) {
+            page_tracer_->noteQueries(count);
+        }
+    }
+    
 };
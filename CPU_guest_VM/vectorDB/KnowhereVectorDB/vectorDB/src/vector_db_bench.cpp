@@ -0,0 +1,399 @@
+// 검색 hot path 컴포넌트별 마이크로벤치마크 (Google Benchmark)
+//
+// 각 벤치마크는 --bench-dirs로 준 디렉토리마다 등록됨 (예: /dev/shm = DRAM, /mnt/famfs = CXL)
+// flat 파일과 HNSW 샤드는 디렉토리 안에 만들어서 재사용 (HNSW 빌드는 오래 걸리므로 있으면 그대로 사용)
+//
+//   ./vector_db_bench --bench-dirs=/dev/shm,/mnt/famfs --benchmark_filter=flat
+//
+// Google Benchmark 옵션(--benchmark_*)은 그대로 전달됨
+
+#include "flat_index.h"
+#include "hnsw_index.h"
+#include "hnsw_builder.h"
+#include "vector_db.h"
+#include "distance_kernels.h"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr size_t DIM = 768;
+constexpr int K = 10;
+constexpr size_t NUM_QUERIES = 256;      // 반복마다 돌아가며 사용하는 쿼리 수
+constexpr size_t INSERT_CHUNK = 10000;
+
+struct BenchOptions {
+    std::vector<std::string> dirs = {"/dev/shm"};
+    std::vector<size_t> flat_rows = {10000, 100000, 500000};
+    size_t hnsw_rows = 100000;
+    std::string hnsw_dir;    // 지정하면 이 디렉토리의 기존 샤드(hnsw_index_*.bin)를 사용
+    uint64_t seed = 42;
+};
+
+BenchOptions g_options;
+
+// 정규화된 랜덤 벡터 count개 (count × DIM)
+std::vector<float> makeVectors(size_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> data(count * DIM);
+    for (auto& value : data) {
+        value = dist(rng);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        distance::normalizeInPlace(&data[i * DIM], DIM);
+    }
+    return data;
+}
+
+const std::vector<float>& queries() {
+    static const std::vector<float> data = makeVectors(NUM_QUERIES, g_options.seed + 1);
+    return data;
+}
+
+std::string dirLabel(const std::string& dir) {
+    return std::filesystem::path(dir).filename().string().empty() ? dir
+                                                                  : std::filesystem::path(dir).filename().string();
+}
+
+// ---------------------------------------------------------------------------
+// 픽스처 (디렉토리 × 설정마다 한 번 생성해서 모든 반복이 공유)
+
+AppendOnlyFlatIndex* getFlatIndex(const std::string& dir, size_t rows, FlatCodeType code_type) {
+    static std::map<std::string, std::unique_ptr<AppendOnlyFlatIndex>> cache;
+    std::string path = dir + "/vector_db_bench_flat_" + flatCodeTypeName(code_type) + "_" + std::to_string(rows) + ".bin";
+    auto it = cache.find(path);
+    if (it != cache.end()) {
+        return it->second.get();
+    }
+
+    // 채우는 과정이 측정 대상이 아니므로 매번 새로 만들어서 정확히 rows개로 맞춤
+    std::filesystem::remove(path);
+    FlatIndexOptions flat_options;
+    flat_options.code_type = code_type;
+    auto index = std::make_unique<AppendOnlyFlatIndex>(path, DIM, rows, flat_options);
+    if (!index->initialize()) {
+        return nullptr;
+    }
+
+    std::vector<uint64_t> ids(INSERT_CHUNK);
+    for (size_t begin = 0; begin < rows; begin += INSERT_CHUNK) {
+        size_t count = std::min(INSERT_CHUNK, rows - begin);
+        auto vectors = makeVectors(count, g_options.seed + begin);
+        for (size_t i = 0; i < count; ++i) {
+            ids[i] = begin + i;
+        }
+        if (!index->insertBatch(vectors.data(), count, ids.data())) {
+            return nullptr;
+        }
+    }
+
+    auto* raw = index.get();
+    cache.emplace(path, std::move(index));
+    return raw;
+}
+
+// dir: --bench-dirs 항목이면 그 안에 벤치마크 샤드를 만들고, --hnsw-dir이면 기존 샤드를 그대로 로드
+HNSWIndexManager* getHNSWManager(const std::string& dir) {
+    static std::map<std::string, std::unique_ptr<HNSWIndexManager>> cache;
+    std::string shard_dir = g_options.hnsw_dir.empty() ? dir + "/vector_db_bench_hnsw" : dir;
+    auto it = cache.find(dir);
+    if (it != cache.end()) {
+        return it->second.get();
+    }
+
+    std::string shard_path = shard_dir + "/hnsw_index_0.bin";
+    if (g_options.hnsw_dir.empty() && !std::filesystem::exists(shard_path)) {
+        std::cout << "Building benchmark HNSW shard (" << g_options.hnsw_rows << " vectors): " << shard_path
+                  << std::endl;
+        std::filesystem::create_directories(shard_dir);
+        auto vectors = makeVectors(g_options.hnsw_rows, g_options.seed + 7);
+        HNSWBuilder builder;
+        if (!builder.train(vectors.data(), g_options.hnsw_rows) ||
+            !builder.add(vectors.data(), g_options.hnsw_rows) || !builder.save(shard_path)) {
+            return nullptr;
+        }
+    }
+
+    // executor 없이 호출 스레드에서 실행 → 샤드 하나의 검색 비용만 측정
+    auto manager = std::make_unique<HNSWIndexManager>(shard_dir, DIM);
+    if (!manager->initialize()) {
+        return nullptr;
+    }
+    auto* raw = manager.get();
+    cache.emplace(dir, std::move(manager));
+    return raw;
+}
+
+// ---------------------------------------------------------------------------
+// 벤치마크 본문
+
+void BM_FlatSearch(benchmark::State& state, std::string dir, FlatCodeType code_type) {
+    size_t rows = static_cast<size_t>(state.range(0));
+    auto* index = getFlatIndex(dir, rows, code_type);
+    if (!index) {
+        state.SkipWithError("flat index setup failed");
+        return;
+    }
+    const auto& qs = queries();
+    std::vector<float> query(DIM);
+    size_t q = 0;
+    for (auto _ : state) {
+        std::copy_n(&qs[(q++ % NUM_QUERIES) * DIM], DIM, query.begin());
+        benchmark::DoNotOptimize(index->bruteForceSearch(query, K));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * rows * index->getScanBytesPerRow()));
+}
+
+void BM_FlatSearchBatch(benchmark::State& state, std::string dir, FlatCodeType code_type) {
+    size_t rows = static_cast<size_t>(state.range(0));
+    size_t batch = static_cast<size_t>(state.range(1));
+    auto* index = getFlatIndex(dir, rows, code_type);
+    if (!index) {
+        state.SkipWithError("flat index setup failed");
+        return;
+    }
+    const auto& qs = queries();
+    size_t offset = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index->bruteForceSearchBatch(&qs[offset * DIM], batch, K));
+        offset = (offset + batch) % (NUM_QUERIES - batch + 1);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * rows * index->getScanBytesPerRow()));
+}
+
+void BM_HNSWSearch(benchmark::State& state, std::string dir) {
+    int ef = static_cast<int>(state.range(0));
+    auto* manager = getHNSWManager(dir);
+    if (!manager) {
+        state.SkipWithError("HNSW shard setup failed");
+        return;
+    }
+    const auto& qs = queries();
+    std::vector<float> query(DIM);
+    size_t q = 0;
+    for (auto _ : state) {
+        std::copy_n(&qs[(q++ % NUM_QUERIES) * DIM], DIM, query.begin());
+        benchmark::DoNotOptimize(manager->search(query, K, ef));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_HNSWSearchBatch(benchmark::State& state, std::string dir) {
+    int ef = static_cast<int>(state.range(0));
+    size_t batch = static_cast<size_t>(state.range(1));
+    auto* manager = getHNSWManager(dir);
+    if (!manager) {
+        state.SkipWithError("HNSW shard setup failed");
+        return;
+    }
+    const auto& qs = queries();
+    size_t offset = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager->searchBatch(&qs[offset * DIM], batch, K, ef));
+        offset = (offset + batch) % (NUM_QUERIES - batch + 1);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+}
+
+// HNSW 샤드 결과(shards × k) + flat 결과(k) 병합
+void BM_MergeSearchResults(benchmark::State& state) {
+    int k = static_cast<int>(state.range(0));
+    size_t shards = static_cast<size_t>(state.range(1));
+    std::mt19937_64 rng(g_options.seed);
+    std::uniform_real_distribution<float> dist(0.0f, 2.0f);
+    std::vector<SearchResult> hnsw_results;
+    std::vector<SearchResult> flat_results;
+    for (size_t i = 0; i < shards * static_cast<size_t>(k); ++i) {
+        hnsw_results.emplace_back(i, dist(rng));
+    }
+    for (int i = 0; i < k; ++i) {
+        flat_results.emplace_back(1000000 + i, dist(rng));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(VectorDB::mergeSearchResults(hnsw_results, flat_results, k));
+    }
+}
+
+// /api/search 요청 본문 파싱 (handleSearchRequest와 같은 경로: json::parse → 슬롯 arena로 float 복사)
+void BM_JsonDecodeSearchRequest(benchmark::State& state) {
+    std::ostringstream body_stream;
+    body_stream.precision(9);
+    body_stream << "{\"k\":" << K << ",\"vector\":[";
+    for (size_t d = 0; d < DIM; ++d) {
+        body_stream << (d ? "," : "") << queries()[d];
+    }
+    body_stream << "]}";
+    std::string body = body_stream.str();
+    std::vector<float> query(DIM);
+
+    for (auto _ : state) {
+        auto request_json = json::parse(body);
+        const auto& vector_json = request_json["vector"];
+        for (size_t i = 0; i < vector_json.size(); ++i) {
+            query[i] = vector_json[i].get<float>();
+        }
+        benchmark::DoNotOptimize(request_json.value("k", 10));
+        benchmark::DoNotOptimize(query.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+}
+
+// 검색 응답 본문 생성 (completeSearch와 같은 모양)
+void BM_JsonEncodeSearchResponse(benchmark::State& state) {
+    int k = static_cast<int>(state.range(0));
+    std::vector<SearchResult> results;
+    for (int i = 0; i < k; ++i) {
+        results.emplace_back(123456789 + i, 0.1f + 0.001f * i);
+    }
+    size_t bytes = 0;
+    for (auto _ : state) {
+        json results_array = json::array();
+        for (const auto& result : results) {
+            results_array.push_back({{"id", result.id}, {"distance", result.distance}});
+        }
+        json data = {
+            {"results", results_array},
+            {"search_time_us", 1234},
+            {"total_results", results.size()},
+            {"ef", 400},
+        };
+        json response = {{"success", true}, {"timestamp", 0}, {"data", data}};
+        std::string body = response.dump();
+        bytes += body.size();
+        benchmark::DoNotOptimize(body.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void registerBenchmarks() {
+    for (const auto& dir : g_options.dirs) {
+        std::string label = dirLabel(dir);
+
+        for (FlatCodeType code_type : {FlatCodeType::None, FlatCodeType::FP16, FlatCodeType::SQ8}) {
+            std::string codes = flatCodeTypeName(code_type);
+            auto* single = benchmark::RegisterBenchmark(("flat_search/" + label + "/" + codes).c_str(),
+                                                        BM_FlatSearch, dir, code_type);
+            auto* batch = benchmark::RegisterBenchmark(("flat_search_batch/" + label + "/" + codes).c_str(),
+                                                       BM_FlatSearchBatch, dir, code_type);
+            for (size_t rows : g_options.flat_rows) {
+                single->Arg(static_cast<int64_t>(rows));
+                for (int64_t b : {8, 32, 128}) {
+                    batch->Args({static_cast<int64_t>(rows), b});
+                }
+            }
+            single->Unit(benchmark::kMicrosecond)->UseRealTime();
+            batch->Unit(benchmark::kMicrosecond)->UseRealTime();
+        }
+
+    }
+
+    // --hnsw-dir을 주면 실제 샤드 디렉토리 하나만 측정
+    std::vector<std::string> hnsw_dirs = g_options.hnsw_dir.empty() ? g_options.dirs
+                                                                    : std::vector<std::string>{g_options.hnsw_dir};
+    for (const auto& dir : hnsw_dirs) {
+        std::string label = dirLabel(dir);
+        benchmark::RegisterBenchmark(("hnsw_search/" + label).c_str(), BM_HNSWSearch, dir)
+            ->ArgName("ef")->Arg(50)->Arg(100)->Arg(200)->Arg(400)
+            ->Unit(benchmark::kMicrosecond)->UseRealTime();
+        auto* hnsw_batch = benchmark::RegisterBenchmark(("hnsw_search_batch/" + label).c_str(),
+                                                        BM_HNSWSearchBatch, dir);
+        hnsw_batch->ArgNames({"ef", "batch"});
+        for (int64_t ef : {100, 400}) {
+            for (int64_t b : {1, 8, 32, 128}) {
+                hnsw_batch->Args({ef, b});
+            }
+        }
+        hnsw_batch->Unit(benchmark::kMicrosecond)->UseRealTime();
+    }
+
+    benchmark::RegisterBenchmark("merge_search_results", BM_MergeSearchResults)
+        ->ArgNames({"k", "shards"})->Args({10, 4})->Args({10, 16})->Args({100, 4})->Args({100, 16});
+    benchmark::RegisterBenchmark("json_decode_search_request", BM_JsonDecodeSearchRequest);
+    benchmark::RegisterBenchmark("json_encode_search_response", BM_JsonEncodeSearchResponse)
+        ->ArgName("k")->Arg(10)->Arg(100);
+}
+
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// 자체 옵션을 소비하고 나머지는 Google Benchmark에 넘김
+bool parseBenchOptions(int& argc, char** argv) {
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+
+        if (arg.starts_with("--bench-dirs=")) {
+            g_options.dirs = splitList(value());
+        } else if (arg.starts_with("--flat-rows=")) {
+            g_options.flat_rows.clear();
+            for (const auto& item : splitList(value())) {
+                g_options.flat_rows.push_back(std::strtoull(item.c_str(), nullptr, 10));
+            }
+        } else if (arg.starts_with("--hnsw-rows=")) {
+            g_options.hnsw_rows = std::strtoull(value().c_str(), nullptr, 10);
+        } else if (arg.starts_with("--hnsw-dir=")) {
+            g_options.hnsw_dir = value();
+        } else if (arg.starts_with("--seed=")) {
+            g_options.seed = std::strtoull(value().c_str(), nullptr, 10);
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+
+    for (const auto& dir : g_options.dirs) {
+        if (!std::filesystem::is_directory(dir)) {
+            std::cerr << "Benchmark directory not found: " << dir << std::endl;
+            return false;
+        }
+    }
+    if (g_options.dirs.empty() || g_options.flat_rows.empty() || g_options.hnsw_rows == 0) {
+        std::cerr << "Usage: " << argv[0] << " [--bench-dirs=a,b] [--flat-rows=n,m] [--hnsw-rows=n] "
+                  << "[--hnsw-dir=path] [--seed=n] [--benchmark_...]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (!parseBenchOptions(argc, argv)) {
+        return 1;
+    }
+    std::cout << "Distance kernel: " << distance::getKernelName() << std::endl;
+
+    registerBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
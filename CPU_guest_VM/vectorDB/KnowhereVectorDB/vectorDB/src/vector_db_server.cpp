@@ -2,15 +2,39 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <tuple>
 
 // thread_local 버퍼들 정의
 thread_local std::vector<float> VectorDBServer::worker_batch_buffer_;
-thread_local std::vector<std::vector<float>> VectorDBServer::worker_queries_buffer_;
 thread_local std::vector<int> VectorDBServer::worker_k_values_buffer_;
+thread_local std::vector<SearchResult> VectorDBServer::cache_lookup_buffer_;
 
-VectorDBServer::VectorDBServer(const std::string& hnsw_path, const std::string& flat_path, int port)
-    : running_(false), port_(port), acceptor_(ioc_) {
-    vector_db_ = std::make_unique<VectorDB>(hnsw_path, flat_path);
+VectorDBServer::VectorDBServer(const std::string& hnsw_path, const std::string& flat_path,
+                               const ServerConfig& config)
+    : running_(false), config_(config), port_(config.port), num_search_workers_(0),
+      thread_layout_ok_(false), acceptor_(ioc_), batch_size_limit_(std::max<size_t>(1, config.max_batch_size)),
+      max_batch_size_(std::max<size_t>(1, config.max_batch_size)), batch_wait_us_(config.max_batch_wait.count()) {
+    // 검색 쪽 스레드 수는 모두 검색 코어 수에서 유도 (명령행에서 직접 지정한 값은 그대로)
+    thread_layout_ok_ = planThreadLayout(config_.threads, thread_layout_);
+    if (thread_layout_ok_) {
+        if (config_.db.compute_threads == 0) {
+            config_.db.compute_threads = thread_layout_.search_threads;
+        }
+        if (config_.threads.pin && config_.db.shard_cpus.empty()) {
+            config_.db.shard_cpus = thread_layout_.search_cpus;
+        }
+    }
+    vector_db_ = std::make_unique<VectorDB>(hnsw_path, flat_path, config_.db);
+    size_t slot_count = std::max<size_t>(1, config.search_slots);
+    slot_pool_ = std::make_unique<SearchSlotPool>(slot_count, vector_db_->getVectorDim());
+    search_slots_.resize(slot_count);
+    search_queue_.reserve(slot_count);
+    if (config.query_cache_entries > 0) {
+        query_cache_ = std::make_unique<QueryResultCache>(config.query_cache_entries, config.query_cache_quantize);
+    }
 }
 
 VectorDBServer::~VectorDBServer() {
@@ -20,20 +44,65 @@ VectorDBServer::~VectorDBServer() {
 bool VectorDBServer::initialize() {
     std::cout << "=== VectorDB 서버 초기화 ===" << std::endl;
     
+    if (!thread_layout_ok_) {
+        std::cerr << "Invalid thread budget" << std::endl;
+        return false;
+    }
+    std::cout << "Thread budget: " << thread_layout_.io_threads << " I/O threads on CPUs "
+              << formatCpuList(thread_layout_.io_cpus) << ", " << thread_layout_.search_threads
+              << " search threads on CPUs " << formatCpuList(thread_layout_.search_cpus);
+    if (thread_layout_.search_node >= 0) {
+        std::cout << " (NUMA node " << thread_layout_.search_node << ")";
+    }
+    std::cout << (config_.threads.pin ? ", pinned" : ", not pinned") << std::endl;
+    
+    // 초기화 중에 만들어지는 스레드(샤드 로더, Knowhere 풀, compactor)가 검색 코어 mask를 물려받도록
+    // 메인 스레드를 잠시 검색 코어에 pinning (start()에서 I/O 코어로 옮김)
+    if (config_.threads.pin) {
+        pinCurrentThreadToCpus(thread_layout_.search_cpus);
+    }
+    
     // VectorDB 초기화
     if (!vector_db_->initialize()) {
         std::cerr << "Failed to initialize VectorDB" << std::endl;
         return false;
     }
     
-    auto hardware_threads = std::thread::hardware_concurrency();
+    num_search_workers_ = config_.search_workers;
+    if (num_search_workers_ == 0) {
+        num_search_workers_ = thread_layout_.search_threads;
+    }
 
-    search_pool_ = std::make_unique<net::thread_pool>(hardware_threads);
-    
-    // Search worker들 시작
-    startSearchWorkers(hardware_threads);
+    // 워커 루프들이 스레드를 하나씩 점유하므로 exact search용 스레드 하나를 추가로 둠
+    search_pool_ = std::make_unique<net::thread_pool>(num_search_workers_ + 1);
 
-    std::cout << "Using " << hardware_threads << " threads for search workers" << std::endl;
+    active_workers_.store(num_search_workers_);
+    
+    std::cout << "Using " << num_search_workers_ << " threads for search workers" << std::endl;
+    if (config_.adaptive_ef_queue_depth > 0) {
+        std::cout << "Adaptive ef: queue depth > " << config_.adaptive_ef_queue_depth
+                  << " lowers ef (min " << config_.min_adaptive_ef << ")" << std::endl;
+    }
+    std::cout << "Batching: max " << config_.max_batch_size << " queries, max wait "
+              << config_.max_batch_wait.count() << "us, latency target "
+              << config_.batch_latency_target.count() << "us" << std::endl;
+    std::cout << "Search slots: " << slot_pool_->capacity() << " ("
+              << slot_pool_->capacity() * vector_db_->getVectorDim() * sizeof(float) / 1024 << " KB query arena)"
+              << std::endl;
+    if (query_cache_) {
+        std::cout << "Query result cache: " << query_cache_->capacity() << " entries, quantize step "
+                  << config_.query_cache_quantize << std::endl;
+    }
+    if (config_.auto_tune) {
+        TunerOptions tuning = config_.tuning;
+        tuning.max_workers = num_search_workers_;
+        tuning.max_batch_limit = std::max(tuning.max_batch_limit, max_batch_size_.load());
+        tuner_ = std::make_unique<OnlineTuner>(
+            tuning, TunerKnobs{max_batch_size_.load(), batch_wait_us_.load(), num_search_workers_});
+        std::cout << "Auto-tuning: p99 <= " << tuning.p99_bound.count() << "us, "
+                  << tuning.interval.count() << "ms windows, batch <= " << tuning.max_batch_limit
+                  << ", wait <= " << tuning.max_batch_wait_us << "us, workers <= " << tuning.max_workers << std::endl;
+    }
     
     std::cout << "VectorDB 서버 초기화 완료" << std::endl;
     return true;
@@ -47,6 +116,11 @@ void VectorDBServer::start() {
     
     running_.store(true);
     
+    // Search worker들 시작 (running_이 켜진 뒤에 시작해야 루프가 바로 종료되지 않음)
+    startSearchWorkers(static_cast<int>(num_search_workers_));
+    startInsertCommitter();
+    startTuner();
+    
     try {
         // TCP acceptor 설정
         auto const address = net::ip::make_address("0.0.0.0");
@@ -59,21 +133,27 @@ void VectorDBServer::start() {
         
         std::cout << "VectorDB 서버 시작됨 - 포트: " << port_ << std::endl;
         std::cout << "API 엔드포인트:" << std::endl;
-        std::cout << "  POST /api/vectors      - 벡터 삽입" << std::endl;
+        std::cout << "  POST /api/vectors      - 벡터 삽입 (alias: /api/insert)" << std::endl;
+        std::cout << "  DELETE /api/vectors    - 벡터 삭제 (ID 목록)" << std::endl;
         std::cout << "  POST /api/search       - 벡터 검색 (HNSW approximate)" << std::endl;
+        std::cout << "  POST /api/search/bin   - 벡터 검색 (binary float32, 다중 쿼리)" << std::endl;
         std::cout << "  POST /api/exact-search - 벡터 검색 (Brute-force exact)" << std::endl;
         std::cout << "  GET  /api/status       - 상태 조회" << std::endl;
+        std::cout << "  POST /api/admin/reload - HNSW 샤드 세트 hot-swap" << std::endl;
+        std::cout << "  GET  /metrics          - Prometheus 메트릭" << std::endl;
         std::cout << "  GET  /health           - 헬스체크" << std::endl;
         
-        // auto const threads = std::max(1u, std::thread::hardware_concurrency());
-        auto const threads = std::thread::hardware_concurrency();
+        auto const threads = std::max<size_t>(1, thread_layout_.io_threads);
         std::cout << "Starting " << threads << " IO threads" << std::endl;
         ioc_threads_.reserve(threads);
         
         // Accept 시작
         startAccepting();
         
-        // IO context 실행
+        // IO context 실행 (메인 스레드도 I/O 스레드이므로 먼저 I/O 코어로 옮기면 새 스레드가 mask를 물려받음)
+        if (config_.threads.pin) {
+            pinCurrentThreadToCpus(thread_layout_.io_cpus);
+        }
         for(auto i = threads - 1; i > 0; --i) {
             ioc_threads_.emplace_back([this] { ioc_.run(); });
         }
@@ -99,6 +179,9 @@ void VectorDBServer::stop() {
         acceptor_.close();
     }
     
+    // Search workers 정지 (큐에 남은 검색의 503 응답이 나가도록 I/O 스레드를 멈추기 전에)
+    stopSearchWorkers();
+    
     // IO context 정지
     ioc_.stop();
     
@@ -110,8 +193,10 @@ void VectorDBServer::stop() {
     }
     ioc_threads_.clear();
     
-    // Search workers 정지
-    stopSearchWorkers();
+    stopTuner();
+    
+    // 대기 중인 삽입을 모두 커밋한 뒤 committer 정지
+    stopInsertCommitter();
     
     // Search pool 정지
     if (search_pool_) {
@@ -124,49 +209,176 @@ void VectorDBServer::stop() {
 
 void VectorDBServer::startSearchWorkers(int num_workers) {
     for (int i = 0; i < num_workers; ++i) {
-        net::post(*search_pool_, [this] { searchWorkerLoop(); });
+        net::post(*search_pool_, [this, i] {
+            if (config_.threads.pin) {
+                pinCurrentThreadToCpus(thread_layout_.search_cpus);
+            }
+            searchWorkerLoop(static_cast<size_t>(i));
+        });
     }
     std::cout << "Started " << num_workers << " search worker threads" << std::endl;
 }
 
 void VectorDBServer::stopSearchWorkers() {
-    // search_pool이 join()될 때 자동으로 모든 워커가 종료됨
+    // semaphore에서 대기 중인 워커들을 깨워 루프를 빠져나오게 함
+    // (search_pool이 join()될 때 모든 워커가 종료됨)
     std::cout << "Stopping search workers..." << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+        workers_cv_.notify_all();
+    }
+    pending_tasks_.release(static_cast<std::ptrdiff_t>(num_search_workers_));
+    
+    // 워커가 더 가져가지 않으므로 큐에 남은 검색은 재시도할 수 있게 503으로 응답하고 슬롯 반환
+    size_t drained = 0;
+    uint32_t slot = 0;
+    while (search_queue_.tryPop(slot)) {
+        failSearch(slot, "Server is shutting down", http::status::service_unavailable);
+        ++drained;
+    }
+    if (drained > 0) {
+        std::cout << "Answered " << drained << " queued searches with 503" << std::endl;
+    }
+}
+
+std::chrono::steady_clock::time_point VectorDBServer::requestDeadline(
+    const http::request<http::string_body>& req, std::chrono::steady_clock::time_point now) const {
+    // 헤더 값은 요청 도착 시점 기준 남은 시간(ms), 0 이하이거나 숫자가 아니면 서버 기본값
+    std::chrono::milliseconds budget = config_.default_deadline;
+    auto it = req.find(DEADLINE_HEADER);
+    if (it != req.end()) {
+        long long value = std::atoll(std::string(it->value()).c_str());
+        if (value > 0) {
+            budget = std::chrono::milliseconds(value);
+        }
+    }
+    if (budget.count() <= 0) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return now + budget;
+}
+
+std::chrono::microseconds VectorDBServer::estimateQueueDelay() const {
+    // 한 라운드에 모든 워커가 배치 상한만큼씩 처리한다고 보고, 앞에 쌓인 라운드 수 + 자기 배치 한 번
+    // (EDF라 deadline이 더 늦은 태스크는 실제로는 앞서지 않으므로 보수적인 추정)
+    size_t per_round = std::max<size_t>(1, batch_size_limit_.load(std::memory_order_relaxed) *
+                                               std::max<size_t>(1, active_workers_.load(std::memory_order_relaxed)));
+    size_t rounds = search_queue_.size_approx() / per_round + 1;
+    int64_t batch_us = avg_batch_latency_us_.load(std::memory_order_relaxed);
+    return std::chrono::microseconds(static_cast<int64_t>(rounds) * batch_us);
+}
+
+bool VectorDBServer::admitSearch(std::chrono::steady_clock::time_point deadline,
+                                 std::chrono::steady_clock::time_point now, size_t count) {
+    if (!config_.admission_control || deadline == std::chrono::steady_clock::time_point::max()) {
+        return true;
+    }
+    if (now + estimateQueueDelay() <= deadline) {
+        return true;
+    }
+    total_rejected_.fetch_add(count, std::memory_order_relaxed);
+    return false;
 }
 
-void VectorDBServer::searchWorkerLoop() {
-    std::vector<SearchTask> current_batch;
-    auto last_batch_time = std::chrono::high_resolution_clock::now();
+bool VectorDBServer::dropIfExpired(uint32_t slot) {
+    if (std::chrono::steady_clock::now() <= search_slots_[slot].deadline) {
+        return false;
+    }
+    total_timed_out_.fetch_add(1, std::memory_order_relaxed);
+    failSearch(slot, "Deadline expired while queued", http::status::gateway_timeout);
+    return true;
+}
+
+void VectorDBServer::enqueueSearchTask(uint32_t slot) {
+    SearchSlot& task = search_slots_[slot];
+    // 종료가 시작된 뒤에는 큐를 비운 뒤라 넣으면 응답하지 못하고 남음
+    if (!running_.load()) {
+        failSearch(slot, "Server is shutting down", http::status::service_unavailable);
+        return;
+    }
+    if (query_cache_) {
+        // 버전은 검색 전에 읽어야 함: 검색 도중 삽입이 공개되면 이 결과는 다음 조회에서 무효가 됨
+        task.cache_version = vector_db_->getDataVersion();
+        query_cache_->makeKey(slot_pool_->query(slot), vector_db_->getVectorDim(), task.k, task.ef, task.cache_key);
+        
+        if (query_cache_->lookup(task.cache_key, task.cache_version, cache_lookup_buffer_)) {
+            total_processed_.fetch_add(1);
+            completeSearch(slot, cache_lookup_buffer_.data(), cache_lookup_buffer_.size(),
+                           std::chrono::microseconds(0), 0);
+            return;
+        }
+    } else {
+        task.cache_key.clear();
+    }
+    
+    task.enqueue_time = std::chrono::steady_clock::now();
+    auto key = task.deadline == std::chrono::steady_clock::time_point::max()
+                   ? task.enqueue_time + NO_DEADLINE_ORDER_SLACK : task.deadline;
+    search_queue_.push(slot, key);
+    pending_tasks_.release();
+}
+
+bool VectorDBServer::dequeueSearchTask(uint32_t& slot) {
+    // 토큰을 얻었으면 항목이 곧 보이므로 성공할 때까지 재시도 (종료 시 깨운 토큰은 항목이 없음)
+    while (!search_queue_.tryPop(slot)) {
+        if (!running_.load()) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void VectorDBServer::searchWorkerLoop(size_t worker_idx) {
+    std::vector<uint32_t> current_batch;
+    current_batch.reserve(max_batch_size_.load());
     
     while (running_.load()) {
-        SearchTask task;
-        bool has_task = false;
-        
-        // 1. 가능한 많은 태스크를 배치에 수집
-        while (current_batch.size() < MAX_BATCH_SIZE) {
-            if (search_queue_.try_dequeue(task)) {
-                current_batch.push_back(std::move(task));
-                has_task = true;
-            } else {
-                break; // 더 이상 태스크가 없음
-            }
+        // 0. 튜닝으로 활성 워커 수가 줄면 번호가 큰 워커부터 태스크를 가져가지 않고 대기
+        if (worker_idx >= active_workers_.load(std::memory_order_relaxed)) {
+            std::unique_lock<std::mutex> lock(workers_mutex_);
+            workers_cv_.wait(lock, [this, worker_idx] {
+                return worker_idx < active_workers_.load() || !running_.load();
+            });
+            continue;
         }
         
-        auto now = std::chrono::high_resolution_clock::now();
-        bool timeout_reached = (now - last_batch_time) >= BATCH_TIMEOUT;
-        bool batch_full = current_batch.size() >= MAX_BATCH_SIZE;
+        // 1. 태스크가 들어올 때까지 블록 (idle 시 CPU 사용 없음)
+        pending_tasks_.acquire();
         
-        // 2. 배치 처리 조건 체크
-        if (!current_batch.empty() && (batch_full || timeout_reached)) {
-            processBatch(current_batch);
-            current_batch.clear();
-            last_batch_time = now;
+        uint32_t slot = 0;
+        if (!dequeueSearchTask(slot)) {
+            break;  // 종료
+        }
+        // deadline이 지난 태스크는 검색하지 않음 (과부하 때 이미 포기된 요청에 코어를 쓰지 않도록)
+        if (dropIfExpired(slot)) {
+            continue;
         }
         
-        // 3. 아무 작업이 없으면 짧게 대기
-        if (!has_task && current_batch.empty()) {
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        // 배치 대기 기한은 이전 배치가 아니라 가장 오래된 태스크 도착 시점 기준
+        auto batch_wait = std::chrono::microseconds(batch_wait_us_.load(std::memory_order_relaxed));
+        auto batch_deadline = search_slots_[slot].enqueue_time + batch_wait;
+        current_batch.push_back(slot);
+        
+        // 2. 현재 배치 크기 상한까지 큐에 쌓인 태스크를 deadline 순으로 수집
+        //    큐가 깊으면 먼저 깨어난 워커가 큰 배치를 가져가고, 나머지 워커는 계속 잠들어 있음
+        size_t limit = batch_size_limit_.load(std::memory_order_relaxed);
+        while (current_batch.size() < limit) {
+            bool acquired = pending_tasks_.try_acquire();
+            if (!acquired && batch_wait.count() > 0) {
+                acquired = pending_tasks_.try_acquire_until(batch_deadline);
+            }
+            if (!acquired || !dequeueSearchTask(slot)) {
+                break;
+            }
+            if (!dropIfExpired(slot)) {
+                current_batch.push_back(slot);
+            }
         }
+        
+        // 3. 배치 처리
+        processBatch(current_batch);
+        current_batch.clear();
     }
     
     // 종료 시 남은 배치 처리
@@ -175,72 +387,474 @@ void VectorDBServer::searchWorkerLoop() {
     }
 }
 
-void VectorDBServer::processBatch(const std::vector<SearchTask>& batch) {
+void VectorDBServer::updateBatchSizeLimit(size_t batch_size, std::chrono::microseconds batch_latency) {
+    // 배치 latency EWMA (alpha = 1/8)
+    int64_t latency_us = batch_latency.count();
+    int64_t prev = avg_batch_latency_us_.load(std::memory_order_relaxed);
+    int64_t avg = prev == 0 ? latency_us : prev + (latency_us - prev) / 8;
+    avg_batch_latency_us_.store(avg, std::memory_order_relaxed);
+    
+    // AIMD: 목표를 넘으면 상한을 3/4로, 꽉 찬 배치가 목표의 80% 이내면 1씩 증가
+    size_t limit = batch_size_limit_.load(std::memory_order_relaxed);
+    int64_t target_us = config_.batch_latency_target.count();
+    if (avg > target_us) {
+        limit = std::max<size_t>(1, limit * 3 / 4);
+    } else if (batch_size >= limit && avg * 10 < target_us * 8) {
+        limit = limit + 1;
+    }
+    batch_size_limit_.store(std::min(limit, max_batch_size_.load(std::memory_order_relaxed)),
+                            std::memory_order_relaxed);
+}
+
+void VectorDBServer::startTuner() {
+    if (!tuner_) {
+        return;
+    }
+    tuner_thread_ = std::thread([this] { tuneLoop(); });
+}
+
+void VectorDBServer::stopTuner() {
+    {
+        std::lock_guard<std::mutex> lock(tune_mutex_);
+        tune_cv_.notify_all();
+    }
+    if (tuner_thread_.joinable()) {
+        tuner_thread_.join();
+    }
+}
+
+void VectorDBServer::tuneLoop() {
+    auto window_start = std::chrono::steady_clock::now();
+    uint64_t processed_before = total_processed_.load();
+    std::vector<uint64_t> latency_before = request_latency_us_.bucketCounts();
+    
+    std::unique_lock<std::mutex> lock(tune_mutex_);
+    while (running_.load()) {
+        tune_cv_.wait_for(lock, tuner_->options().interval, [this] { return !running_.load(); });
+        if (!running_.load()) {
+            return;
+        }
+        
+        // 구간 동안의 처리량과 (큐 대기 + 검색) p99
+        auto now = std::chrono::steady_clock::now();
+        uint64_t processed = total_processed_.load();
+        std::vector<uint64_t> latency = request_latency_us_.bucketCounts();
+        std::vector<uint64_t> window(latency.size());
+        for (size_t b = 0; b < latency.size(); ++b) {
+            window[b] = latency[b] - latency_before[b];
+        }
+        double seconds = std::chrono::duration<double>(now - window_start).count();
+        TunerSample sample;
+        sample.queries = processed - processed_before;
+        sample.qps = seconds > 0.0 ? static_cast<double>(sample.queries) / seconds : 0.0;
+        sample.p99_us = request_latency_us_.percentile(window, 0.99);
+        
+        TunerKnobs before = tuner_->current();
+        const TunerKnobs& next = tuner_->observe(sample);
+        if (!(next == before)) {
+            std::cout << "Auto-tune: " << sample.qps << " qps, p99 " << sample.p99_us << "us -> batch "
+                      << next.max_batch << ", wait " << next.batch_wait_us << "us, workers " << next.workers
+                      << std::endl;
+        }
+        applyTuning(next);
+        
+        // 설정을 바꾼 뒤부터 다음 구간 측정
+        window_start = std::chrono::steady_clock::now();
+        processed_before = total_processed_.load();
+        latency_before = request_latency_us_.bucketCounts();
+    }
+}
+
+void VectorDBServer::applyTuning(const TunerKnobs& knobs) {
+    max_batch_size_.store(knobs.max_batch, std::memory_order_relaxed);
+    size_t limit = batch_size_limit_.load(std::memory_order_relaxed);
+    if (limit > knobs.max_batch) {
+        batch_size_limit_.store(knobs.max_batch, std::memory_order_relaxed);
+    }
+    batch_wait_us_.store(knobs.batch_wait_us, std::memory_order_relaxed);
+    
+    size_t workers = std::clamp<size_t>(knobs.workers, 1, num_search_workers_);
+    if (workers != active_workers_.load()) {
+        std::lock_guard<std::mutex> worker_lock(workers_mutex_);
+        active_workers_.store(workers);
+        workers_cv_.notify_all();
+    }
+}
+
+void VectorDBServer::startInsertCommitter() {
+    insert_committer_ = std::thread([this] { insertCommitLoop(); });
+}
+
+void VectorDBServer::stopInsertCommitter() {
+    {
+        std::lock_guard<std::mutex> lock(insert_mutex_);
+        insert_cv_.notify_all();
+    }
+    if (insert_committer_.joinable()) {
+        insert_committer_.join();
+    }
+}
+
+void VectorDBServer::enqueueInsertTask(InsertTask&& task) {
+    {
+        std::lock_guard<std::mutex> lock(insert_mutex_);
+        insert_queue_.push_back(std::move(task));
+    }
+    insert_cv_.notify_one();
+}
+
+void VectorDBServer::insertCommitLoop() {
+    std::vector<InsertTask> group;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(insert_mutex_);
+            insert_cv_.wait(lock, [this] {
+                return !insert_queue_.empty() || !running_.load();
+            });
+            
+            // 종료 시에도 남은 삽입은 모두 커밋
+            if (insert_queue_.empty()) {
+                return;
+            }
+            
+            // 이전 그룹을 flush하는 동안 쌓인 삽입들을 한 그룹으로 가져감
+            size_t group_vectors = 0;
+            while (!insert_queue_.empty()) {
+                size_t count = insert_queue_.front().count;
+                if (!group.empty() && group_vectors + count > MAX_INSERT_GROUP_VECTORS) {
+                    break;
+                }
+                group_vectors += count;
+                group.push_back(std::move(insert_queue_.front()));
+                insert_queue_.pop_front();
+            }
+        }
+        
+        commitInsertGroup(group);
+        group.clear();
+    }
+}
+
+void VectorDBServer::commitInsertGroup(std::vector<InsertTask>& group) {
+    size_t total = 0;
+    for (const auto& task : group) {
+        total += task.count;
+    }
+    
+    // 그룹 전체를 하나의 연속 버퍼로 모아 한 번에 append
+    std::vector<float> group_buffer;
+    if (group.size() == 1) {
+        group_buffer = std::move(group.front().vectors);
+    } else {
+        group_buffer.reserve(total * vector_db_->getVectorDim());
+        for (const auto& task : group) {
+            group_buffer.insert(group_buffer.end(), task.vectors.begin(), task.vectors.end());
+        }
+    }
+    
+    std::vector<uint64_t> ids;
+    bool ok = false;
+    try {
+        ok = vector_db_->insertVectors(group_buffer.data(), total, ids);
+    } catch (const std::exception& e) {
+        std::cerr << "Insert group failed: " << e.what() << std::endl;
+    }
+    
+    if (!ok) {
+        if (group.size() > 1) {
+            // 그룹 전체가 flat에 들어가지 않아도 혼자서는 들어가는 요청은 받도록 하나씩 다시 커밋
+            // (그룹 append는 실패하면 아무것도 쓰지 않으므로 각 요청의 벡터가 그대로 남아 있음)
+            std::cerr << "Insert group of " << group.size() << " requests failed, committing them one by one" << std::endl;
+            std::vector<InsertTask> single;
+            for (auto& task : group) {
+                single.clear();
+                single.push_back(std::move(task));
+                commitInsertGroup(single);
+            }
+            return;
+        }
+        group.front().error_callback("Insert failed (flat index full or write error)");
+        return;
+    }
+    
+    // flush가 끝난 뒤에만 각 요청에 자기 몫의 ID를 돌려줌
+    size_t offset = 0;
+    for (auto& task : group) {
+        std::vector<uint64_t> task_ids(ids.begin() + offset, ids.begin() + offset + task.count);
+        offset += task.count;
+        task.callback(std::move(task_ids));
+    }
+    
+    total_inserted_.fetch_add(total);
+    total_insert_groups_.fetch_add(1);
+}
+
+int VectorDBServer::efForRecallTarget(int k, double recall_target) {
+    // 768차원 COSINE 샤드 기준의 대략적인 recall@k 대비 ef (정확한 값은 데이터셋마다 다름)
+    static constexpr struct { double recall; int ef; } RECALL_EF_TABLE[] = {
+        {0.80, 64}, {0.90, 128}, {0.95, 200}, {0.98, 400}, {0.99, 800},
+    };
+    int ef = 1600;
+    for (const auto& entry : RECALL_EF_TABLE) {
+        if (recall_target <= entry.recall) {
+            ef = entry.ef;
+            break;
+        }
+    }
+    return std::max(ef, k);
+}
+
+int VectorDBServer::effectiveEf(const SearchSlot& task, size_t queue_depth, bool& degraded) const {
+    int nominal = HNSWIndexManager::resolveEf(task.k, task.ef);
+    degraded = false;
+    
+    size_t threshold = config_.adaptive_ef_queue_depth;
+    if (task.strict_ef || threshold == 0 || queue_depth <= threshold) {
+        return nominal;
+    }
+    
+    // 큐가 임계값의 n배로 쌓이면 ef를 1/n로 (최소 min_adaptive_ef, k)
+    int scaled = static_cast<int>(static_cast<double>(nominal) * threshold / queue_depth);
+    int ef = std::max({scaled, config_.min_adaptive_ef, task.k});
+    degraded = ef < nominal;
+    return std::min(ef, nominal);
+}
+
+void VectorDBServer::processBatch(const std::vector<uint32_t>& batch) {
     if (batch.empty()) return;
     
+    auto dequeue_time = std::chrono::steady_clock::now();
+    for (uint32_t slot : batch) {
+        queue_wait_us_.observe(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            dequeue_time - search_slots_[slot].enqueue_time).count()));
+    }
+    batch_size_hist_.observe(batch.size());
+    
+    // 1. 태스크별 실효 ef와 k 구간으로 그룹핑
+    //    k=1000 요청 하나 때문에 배치 전체가 큰 k/ef로 검색되지 않도록 그룹마다 따로 검색
+    size_t queue_depth = search_queue_.size_approx();
+    struct GroupKey {
+        int ef;
+        int k_class;
+        bool degraded;
+        bool operator<(const GroupKey& other) const {
+            return std::tie(ef, k_class, degraded) < std::tie(other.ef, other.k_class, other.degraded);
+        }
+    };
+    std::vector<std::pair<GroupKey, size_t>> keyed;
+    keyed.reserve(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const SearchSlot& task = search_slots_[batch[i]];
+        bool degraded = false;
+        int ef = effectiveEf(task, queue_depth, degraded);
+        int k_class = 1;
+        while (k_class < task.k) {
+            k_class *= 2;
+        }
+        keyed.push_back({GroupKey{ef, k_class, degraded}, i});
+    }
+    std::stable_sort(keyed.begin(), keyed.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    // 2. 그룹별 검색 (AIMD는 배치 전체 시간 기준)
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<size_t> members;
+    for (size_t begin = 0; begin < keyed.size();) {
+        size_t end = begin;
+        members.clear();
+        while (end < keyed.size() && !(keyed[begin].first < keyed[end].first)) {
+            members.push_back(keyed[end].second);
+            ++end;
+        }
+        processSearchGroup(batch, members, keyed[begin].first.ef, keyed[begin].first.degraded);
+        begin = end;
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto total_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    updateBatchSizeLimit(batch.size(), total_time);
+    batch_search_us_.observe(static_cast<uint64_t>(total_time.count()));
+    
+    total_processed_.fetch_add(batch.size());
+    total_batches_.fetch_add(1);
+}
+
+void VectorDBServer::processSearchGroup(const std::vector<uint32_t>& batch, const std::vector<size_t>& members,
+                                        int ef, bool degraded) {
     try {
-        // 1. 배치 데이터 준비 (버퍼 재사용)
-        worker_queries_buffer_.clear();
+        // 1. 그룹 쿼리를 연속 버퍼로 모음 (쿼리 하나면 슬롯을 그대로 사용)
+        //    Knowhere 데이터셋과 flat 스캔이 이 버퍼를 복사 없이 참조
+        size_t dim = vector_db_->getVectorDim();
         worker_k_values_buffer_.clear();
+        worker_k_values_buffer_.reserve(members.size());
         
-        worker_queries_buffer_.reserve(batch.size());
-        worker_k_values_buffer_.reserve(batch.size());
-        
-        for (const auto& task : batch) {
-            worker_queries_buffer_.push_back(task.query_vector);
-            worker_k_values_buffer_.push_back(task.k);
+        const float* queries = slot_pool_->query(batch[members.front()]);
+        if (members.size() > 1) {
+            worker_batch_buffer_.resize(members.size() * dim);
+            for (size_t i = 0; i < members.size(); ++i) {
+                std::memcpy(&worker_batch_buffer_[i * dim], slot_pool_->query(batch[members[i]]),
+                            dim * sizeof(float));
+            }
+            queries = worker_batch_buffer_.data();
+        }
+        for (size_t idx : members) {
+            worker_k_values_buffer_.push_back(search_slots_[batch[idx]].k);
         }
         
-        // 2. 배치 검색 수행
+        // 2. 그룹의 최대 k로 배치 검색 (ef는 그룹 공통)
         auto start_time = std::chrono::high_resolution_clock::now();
-        
-        // 최대 k 값으로 배치 검색 (버퍼 재사용)
         int max_k = *std::max_element(worker_k_values_buffer_.begin(), worker_k_values_buffer_.end());
-        auto batch_results = vector_db_->searchVectorsBatch(worker_queries_buffer_, max_k, worker_batch_buffer_);
+        auto batch_results = vector_db_->searchVectorsBatch(queries, members.size(), max_k, ef);
+        auto total_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start_time);
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto total_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        total_search_groups_.fetch_add(1);
+        if (degraded) {
+            total_degraded_.fetch_add(members.size());
+        }
         
-        // 3. 개별 결과를 각 콜백으로 전달
-        for (size_t i = 0; i < batch.size(); ++i) {
-            AsyncSearchResult result;
+        // 3. 개별 결과를 각 슬롯의 응답으로 전달 (그룹 평균 시간)
+        for (size_t i = 0; i < members.size(); ++i) {
+            uint32_t slot = batch[members[i]];
+            const SearchSlot& task = search_slots_[slot];
             
             // 요청된 k 값만큼만 결과 잘라서 전달
-            int requested_k = worker_k_values_buffer_[i];
-            if (i < batch_results.size()) {
-                if (batch_results[i].size() > static_cast<size_t>(requested_k)) {
-                    result.results.assign(batch_results[i].begin(), 
-                                        batch_results[i].begin() + requested_k);
-                } else {
-                    result.results = batch_results[i];
-                }
-            }
+            const std::vector<SearchResult>* results = i < batch_results.size() ? &batch_results[i] : nullptr;
+            size_t count = results ? std::min<size_t>(results->size(), worker_k_values_buffer_[i]) : 0;
             
-            // 평균 시간 계산
-            result.search_time = total_time / batch.size();
+            // 과부하로 ef를 낮춘 결과는 캐시하지 않음 (평소 요청에 낮은 recall 결과가 재사용되지 않도록)
+            if (query_cache_ && !task.cache_key.empty() && !degraded && results) {
+                query_cache_->insert(task.cache_key, task.cache_version,
+                                     std::vector<SearchResult>(results->begin(), results->begin() + count));
+            }
             
-            // 콜백을 I/O 컨텍스트로 포스트
-            net::post(ioc_, [callback = batch[i].callback, result = std::move(result)]() mutable {
-                callback(std::move(result));
-            });
+            request_latency_us_.observeSince(task.enqueue_time);
+            completeSearch(slot, results ? results->data() : nullptr, count, total_time / members.size(), ef);
         }
         
-        total_processed_.fetch_add(batch.size());
-        
-        // 배치 처리 로그 (선택적)
-        // std::cout << "Processed batch of " << batch.size() << " queries in " 
-        //           << std::chrono::duration_cast<std::chrono::milliseconds>(total_time).count() 
-        //           << " ms" << std::endl;
-        
     } catch (const std::exception& e) {
-        // 에러 시 모든 태스크에 에러 전달
+        // 에러 시 그룹의 모든 태스크에 에러 전달
         std::string error_msg = std::string("Batch search failed: ") + e.what();
-        for (const auto& task : batch) {
-            net::post(ioc_, [error_callback = task.error_callback, error_msg]() {
-                error_callback(error_msg);
-            });
+        for (size_t idx : members) {
+            failSearch(batch[idx], error_msg);
+        }
+    }
+}
+
+void VectorDBServer::completeSearch(uint32_t slot, const SearchResult* results, size_t count,
+                                    std::chrono::microseconds search_time, int ef) {
+    SearchSlot& task = search_slots_[slot];
+    
+    if (task.reply == SearchReply::Binary) {
+        // 응답 버퍼의 자기 자리에 직접 기록
+        auto state = std::move(task.binary);
+        uint32_t q = task.binary_index;
+        releaseSearchSlot(slot);
+        
+        char* dst = state->body.data() + sizeof(binproto::SearchResponseHeader)
+                  + static_cast<size_t>(q) * state->k * sizeof(binproto::ResultEntry);
+        for (uint32_t j = 0; j < state->k; ++j) {
+            binproto::ResultEntry entry{binproto::INVALID_ID, 0.0f};
+            if (j < count) {
+                entry.id = results[j].id;
+                entry.distance = results[j].distance;
+            }
+            std::memcpy(dst + j * sizeof(entry), &entry, sizeof(entry));
+        }
+        finishBinaryQuery(state);
+        return;
+    }
+    
+    // JSON 응답은 호출 스레드(워커)에서 만들고, 네트워크 작업만 I/O 스레드로 한 번 post
+    auto serialize_start = std::chrono::steady_clock::now();
+    json results_array = json::array();
+    for (size_t i = 0; i < count; ++i) {
+        results_array.push_back({{"id", results[i].id}, {"distance", results[i].distance}});
+    }
+    json data = {
+        {"results", results_array},
+        {"search_time_us", search_time.count()},
+        {"total_results", count},
+        {"ef", ef},
+    };
+    
+    http::response<http::string_body> res{http::status::ok, task.http_version};
+    res.set(http::field::content_type, "application/json");
+    res.body() = createSuccessResponse(data).dump();
+    res.prepare_payload();
+    serialize_us_.observeSince(serialize_start);
+    
+    SendCallback send_callback = std::move(task.send_callback);
+    releaseSearchSlot(slot);
+    
+    net::post(ioc_, [this, send_callback = std::move(send_callback), res = std::move(res),
+                     posted = std::chrono::steady_clock::now()]() mutable {
+        post_delay_us_.observeSince(posted);
+        send_callback(std::move(res));
+    });
+}
+
+void VectorDBServer::failSearch(uint32_t slot, const std::string& error_msg, http::status status) {
+    SearchSlot& task = search_slots_[slot];
+    
+    if (task.reply == SearchReply::Binary) {
+        auto state = std::move(task.binary);
+        releaseSearchSlot(slot);
+        if (status == http::status::gateway_timeout) {
+            state->timed_out.store(true);
+        } else if (status == http::status::service_unavailable) {
+            state->unavailable.store(true);
         }
+        state->failed.store(true);
+        finishBinaryQuery(state);
+        return;
     }
+    
+    http::response<http::string_body> res{status, task.http_version};
+    res.set(http::field::content_type, "application/json");
+    res.body() = createErrorResponse(error_msg).dump();
+    res.prepare_payload();
+    
+    SendCallback send_callback = std::move(task.send_callback);
+    releaseSearchSlot(slot);
+    
+    net::post(ioc_, [send_callback = std::move(send_callback), res = std::move(res)]() mutable {
+        send_callback(std::move(res));
+    });
+}
+
+void VectorDBServer::releaseSearchSlot(uint32_t slot) {
+    SearchSlot& task = search_slots_[slot];
+    task.send_callback = nullptr;
+    task.binary.reset();
+    slot_pool_->release(slot);
+}
+
+void VectorDBServer::finishBinaryQuery(const std::shared_ptr<BinarySearchState>& state) {
+    // 마지막으로 끝난 쿼리가 응답을 I/O 컨텍스트로 보냄
+    if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    
+    http::status status = state->timed_out.load() ? http::status::gateway_timeout
+                        : state->unavailable.load() ? http::status::service_unavailable
+                        : state->failed.load() ? http::status::internal_server_error : http::status::ok;
+    http::response<http::string_body> res{status, state->http_version};
+    res.set(http::field::content_type, "application/octet-stream");
+    if (status == http::status::service_unavailable) {
+        res.set(http::field::retry_after, "1");
+    }
+    if (state->failed.load()) {
+        binproto::SearchResponseHeader error_header{binproto::RESPONSE_MAGIC, binproto::STATUS_ERROR, 0, 0};
+        res.body().assign(reinterpret_cast<const char*>(&error_header), sizeof(error_header));
+    } else {
+        res.body() = std::move(state->body);
+    }
+    res.prepare_payload();
+    net::post(ioc_, [send_callback = std::move(state->send_callback), res = std::move(res)]() mutable {
+        send_callback(std::move(res));
+    });
 }
 
 void VectorDBServer::startAccepting() {
@@ -258,7 +872,10 @@ void VectorDBServer::onAccept(beast::error_code ec, tcp::socket socket) {
     }
     
     // 새 세션 생성
-    std::make_shared<HttpSession>(std::move(socket), this)->run();
+    std::make_shared<HttpSession>(std::move(socket),
+        [this](http::request<http::string_body>&& req, SendCallback send_callback) {
+            handleRequest(std::move(req), std::move(send_callback));
+        })->run();
     
     // 다음 연결 대기
     if (running_.load()) {
@@ -271,6 +888,12 @@ void VectorDBServer::handleRequest(
     http::request<http::string_body>&& req, 
     std::function<void(http::response<http::string_body>&&)> send_callback) {
     
+    // 모든 응답을 상태 코드별로 집계 (비동기 응답도 결국 이 콜백을 거침)
+    send_callback = [this, send = std::move(send_callback)](http::response<http::string_body>&& res) {
+        countResponse(res.result_int());
+        send(std::move(res));
+    };
+    
     auto addCorsHeaders = [](auto& res) {
         res.set(http::field::access_control_allow_origin, "*");
         res.set(http::field::access_control_allow_methods, "GET, POST, PUT, DELETE, OPTIONS");
@@ -290,6 +913,20 @@ void VectorDBServer::handleRequest(
         // 이 함수는 이제 비동기적으로 동작하며, 완료되면 내부에서 send_callback을 호출합니다.
         return handleSearchRequest(req.body(), req, std::move(send_callback));
     }
+    else if (req.method() == http::verb::post && target == "/api/search/bin") {
+        // 바이너리 float32 검색 엔드포인트 (JSON 파싱 없음)
+        return handleBinarySearchRequest(req, std::move(send_callback));
+    }
+    else if (req.method() == http::verb::post && (target == "/api/vectors" || target == "/api/insert")) {
+        return handleInsertRequest(req.body(), req, std::move(send_callback));
+    }
+    else if (req.method() == http::verb::delete_ && target == "/api/vectors") {
+        // tombstone 내구화(msync)가 I/O 스레드를 막지 않도록 search_pool_에서 실행
+        return handleDeleteRequest(req, [send_callback, addCorsHeaders](http::response<http::string_body>&& res) {
+            addCorsHeaders(res);
+            send_callback(std::move(res));
+        });
+    }
     else if (req.method() == http::verb::post && target == "/api/exact-search") {
         // Exact search (brute-force) 엔드포인트
         return handleExactSearchRequest(req.body(), req, std::move(send_callback));
@@ -299,6 +936,21 @@ void VectorDBServer::handleRequest(
         addCorsHeaders(response);
         return send_callback(std::move(response)); // 즉시 콜백 호출
     }
+    else if (req.method() == http::verb::post && target == "/api/trace/dump") {
+        return handleTraceDumpRequest(req, [send_callback, addCorsHeaders](http::response<http::string_body>&& res) {
+            addCorsHeaders(res);
+            send_callback(std::move(res));
+        });
+    }
+    else if (req.method() == http::verb::post && target == "/api/admin/reload") {
+        auto response = handleReloadRequest(req);
+        addCorsHeaders(response);
+        return send_callback(std::move(response)); // 즉시 콜백 호출
+    }
+    else if (req.method() == http::verb::get && target == "/metrics") {
+        auto response = handleMetricsRequest(req);
+        return send_callback(std::move(response)); // 즉시 콜백 호출
+    }
     else if (req.method() == http::verb::get && target == "/health") {
         auto response = handleHealthRequest(req);
         addCorsHeaders(response);
@@ -331,7 +983,15 @@ void VectorDBServer::handleSearchRequest(
             return send_callback(std::move(res));
         }
         
-        std::vector<float> query_vector = request_json["vector"].get<std::vector<float>>();
+        // 차원이 다른 쿼리가 배치에 섞이면 배치 전체가 실패하므로 여기서 거름
+        const auto& vector_json = request_json["vector"];
+        if (vector_json.size() != vector_db_->getVectorDim()) {
+            http::response<http::string_body> res{http::status::bad_request, 11};
+            res.set(http::field::content_type, "application/json");
+            res.body() = createErrorResponse("Vector dimension mismatch").dump();
+            res.prepare_payload();
+            return send_callback(std::move(res));
+        }
         
         // k 값 추출 (기본값: 10)
         int k = request_json.value("k", 10);
@@ -346,61 +1006,283 @@ void VectorDBServer::handleSearchRequest(
             }
         }
 
+        // ef 직접 지정 또는 recall_target (둘 다 없으면 서버 기본 ef, 적응형 ef 대상)
+        int ef = 0;
+        bool strict_ef = false;
+        if (request_json.contains("ef")) {
+            if (!request_json["ef"].is_number_integer() || request_json["ef"].get<int>() <= 0 ||
+                request_json["ef"].get<int>() > MAX_REQUEST_EF) {
+                http::response<http::string_body> res{http::status::bad_request, 11};
+                res.set(http::field::content_type, "application/json");
+                res.body() = createErrorResponse("ef must be between 1 and " + std::to_string(MAX_REQUEST_EF)).dump();
+                res.prepare_payload();
+                return send_callback(std::move(res));
+            }
+            ef = request_json["ef"].get<int>();
+            strict_ef = true;
+        } else if (request_json.contains("recall_target")) {
+            double recall_target = request_json["recall_target"].is_number()
+                                       ? request_json["recall_target"].get<double>() : -1.0;
+            if (recall_target <= 0.0 || recall_target > 1.0) {
+                http::response<http::string_body> res{http::status::bad_request, 11};
+                res.set(http::field::content_type, "application/json");
+                res.body() = createErrorResponse("recall_target must be in (0, 1]").dump();
+                res.prepare_payload();
+                return send_callback(std::move(res));
+            }
+            ef = efForRecallTarget(k, recall_target);
+        }
+
+        // 예상 큐 대기가 deadline을 넘으면 파싱/큐잉 없이 바로 거절 (클라이언트가 다른 replica로 재시도할 시간을 남김)
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = requestDeadline(req, now);
+        if (!admitSearch(deadline, now, 1)) {
+            http::response<http::string_body> res{http::status::service_unavailable, req.version()};
+            res.set(http::field::content_type, "application/json");
+            res.set(http::field::retry_after, "1");
+            res.body() = createErrorResponse("Deadline cannot be met (estimated queue delay " +
+                                             std::to_string(estimateQueueDelay().count()) + "us)").dump();
+            res.prepare_payload();
+            return send_callback(std::move(res));
+        }
+        
         // --- 여기가 비동기 처리의 핵심입니다 ---
-        SearchTask task;
-        task.request_id = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-        task.query_vector = std::move(query_vector);
+        // 쿼리를 중간 벡터 없이 슬롯 arena에 바로 파싱 (슬롯이 없으면 과부하로 거절)
+        uint32_t slot = 0;
+        if (!slot_pool_->acquire(slot)) {
+            http::response<http::string_body> res{http::status::service_unavailable, req.version()};
+            res.set(http::field::content_type, "application/json");
+            res.set(http::field::retry_after, "1");
+            res.body() = createErrorResponse("Search queue full").dump();
+            res.prepare_payload();
+            return send_callback(std::move(res));
+        }
+        
+        float* query = slot_pool_->query(slot);
+        try {
+            for (size_t i = 0; i < vector_json.size(); ++i) {
+                query[i] = vector_json[i].get<float>();
+            }
+        } catch (...) {
+            releaseSearchSlot(slot);
+            throw;
+        }
+        
+        SearchSlot& task = search_slots_[slot];
         task.k = k;
+        task.ef = ef;
+        task.strict_ef = strict_ef;
+        task.deadline = deadline;
+        task.reply = SearchReply::Json;
+        task.http_version = req.version();
+        // 완료 시 워커가 JSON 응답을 만들어 이 콜백으로 보냄 (completeSearch/failSearch)
+        task.send_callback = std::move(send_callback);
+        
+        // 작업을 큐에 넣습니다. I/O 스레드는 여기서 블록되지 않고 즉시 다음 일을 처리하러 갑니다.
+        // 콜백은 이미 슬롯으로 옮겨졌으므로 실패하면 아래 catch가 아니라 슬롯을 통해 응답
+        try {
+            enqueueSearchTask(slot);
+        } catch (const std::exception& e) {
+            failSearch(slot, std::string("Failed to queue search: ") + e.what(), http::status::internal_server_error);
+        }
+        
+    } catch (const std::exception& e) {
+        // JSON 파싱 오류 등 즉시 에러를 반환할 수 있는 경우
+        http::response<http::string_body> res{http::status::bad_request, req.version()};
+        res.set(http::field::content_type, "application/json");
+        res.body() = createErrorResponse(std::string("Invalid request: ") + e.what()).dump();
+        res.prepare_payload();
+        return send_callback(std::move(res));
+    }
+}
+
+void VectorDBServer::handleBinarySearchRequest(
+    const http::request<http::string_body>& req,
+    std::function<void(http::response<http::string_body>&&)> send_callback) {
+    
+    auto version = req.version();
+    auto sendBinaryError = [version, &send_callback](http::status status, const std::string& message) {
+        http::response<http::string_body> res{status, version};
+        res.set(http::field::content_type, "text/plain");
+        if (status == http::status::service_unavailable) {
+            // JSON 경로와 같이 과부하 거절에는 재시도 간격을 알려줌
+            res.set(http::field::retry_after, "1");
+        }
+        res.body() = message;
+        res.prepare_payload();
+        send_callback(std::move(res));
+    };
+    
+    const std::string& body = req.body();
+    if (body.size() < sizeof(binproto::SearchRequestHeader)) {
+        return sendBinaryError(http::status::bad_request, "Request too short");
+    }
+    
+    binproto::SearchRequestHeader header;
+    std::memcpy(&header, body.data(), sizeof(header));
+    
+    if (header.magic != binproto::REQUEST_MAGIC) {
+        return sendBinaryError(http::status::bad_request, "Invalid magic");
+    }
+    if (header.k == 0 || header.k > 1000) {
+        return sendBinaryError(http::status::bad_request, "k must be between 1 and 1000");
+    }
+    if (header.count == 0 || header.count > binproto::MAX_QUERIES_PER_REQUEST) {
+        return sendBinaryError(http::status::bad_request, "Invalid query count");
+    }
+    // JSON 경로와 같이 상한을 넘는 ef는 잘라 쓰지 않고 거절 (0은 서버 기본 ef)
+    if (header.ef > static_cast<uint32_t>(MAX_REQUEST_EF)) {
+        return sendBinaryError(http::status::bad_request, "ef must be between 0 and " + std::to_string(MAX_REQUEST_EF));
+    }
+    if (header.dim != vector_db_->getVectorDim()) {
+        return sendBinaryError(http::status::bad_request, "Vector dimension mismatch");
+    }
+    if (body.size() != binproto::requestSize(header.count, header.dim)) {
+        return sendBinaryError(http::status::bad_request, "Body size does not match header");
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    auto deadline = requestDeadline(req, now);
+    if (!admitSearch(deadline, now, header.count)) {
+        return sendBinaryError(http::status::service_unavailable, "Deadline cannot be met");
+    }
+    
+    // 요청의 모든 쿼리 슬롯을 한 번에 확보 (일부만 큐에 들어가는 일이 없도록)
+    static thread_local std::vector<uint32_t> slots;
+    slots.resize(header.count);
+    if (!slot_pool_->acquire(header.count, slots.data())) {
+        return sendBinaryError(http::status::service_unavailable, "Search queue full");
+    }
+    
+    // 응답 버퍼를 미리 할당하고 각 쿼리 결과를 자기 자리에 직접 기록
+    auto state = std::make_shared<BinarySearchState>(header.count, header.k, version, std::move(send_callback));
+    state->body.resize(binproto::responseSize(header.count, header.k));
+    
+    binproto::SearchResponseHeader response_header{binproto::RESPONSE_MAGIC, binproto::STATUS_OK, header.count, header.k};
+    std::memcpy(state->body.data(), &response_header, sizeof(response_header));
+    
+    const char* query_data = body.data() + sizeof(binproto::SearchRequestHeader);
+    size_t query_bytes = static_cast<size_t>(header.dim) * sizeof(float);
+    
+    for (uint32_t q = 0; q < header.count; ++q) {
+        uint32_t slot = slots[q];
+        std::memcpy(slot_pool_->query(slot), query_data + q * query_bytes, query_bytes);
         
-        // [콜백 설정 1] 검색 성공 시
-        task.callback = [this, version = req.version(), send_callback](AsyncSearchResult search_result) {
-            // 이 코드는 워커 스레드에서 실행됩니다.
-            json results_array = json::array();
-            for (const auto& result : search_result.results) {
-                results_array.push_back({{"id", result.id}, {"distance", result.distance}});
+        SearchSlot& task = search_slots_[slot];
+        task.k = static_cast<int>(header.k);
+        task.ef = static_cast<int>(header.ef);
+        task.strict_ef = header.ef != 0;
+        task.deadline = deadline;
+        task.reply = SearchReply::Binary;
+        task.http_version = version;
+        task.binary = state;
+        task.binary_index = q;
+    }
+    
+    // 모든 슬롯을 채운 뒤에 큐에 넣음 (중간에 실패하면 남은 슬롯도 실패로 끝내야 응답이 한 번 나감)
+    for (uint32_t q = 0; q < header.count; ++q) {
+        try {
+            enqueueSearchTask(slots[q]);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to queue binary search: " << e.what() << std::endl;
+            for (uint32_t rest = q; rest < header.count; ++rest) {
+                failSearch(slots[rest], e.what(), http::status::internal_server_error);
             }
+            return;
+        }
+    }
+}
+
+void VectorDBServer::handleInsertRequest(
+    const std::string& body, 
+    const http::request<http::string_body>& req,
+    std::function<void(http::response<http::string_body>&&)> send_callback) {
+    
+    auto sendBadRequest = [&req, &send_callback, this](const std::string& message) {
+        http::response<http::string_body> res{http::status::bad_request, req.version()};
+        res.set(http::field::content_type, "application/json");
+        res.body() = createErrorResponse(message).dump();
+        res.prepare_payload();
+        send_callback(std::move(res));
+    };
+    
+    try {
+        auto request_json = json::parse(body);
+        size_t dim = vector_db_->getVectorDim();
+        
+        // 단일 "vector" 또는 배치 "vectors"를 하나의 연속 배열로 변환
+        InsertTask task;
+        bool batched = request_json.contains("vectors");
+        if (batched) {
+            const auto& vectors = request_json["vectors"];
+            if (!vectors.is_array() || vectors.empty()) {
+                return sendBadRequest("Missing or invalid 'vectors' field");
+            }
+            if (vectors.size() > MAX_INSERT_VECTORS_PER_REQUEST) {
+                return sendBadRequest("Too many vectors in one request");
+            }
+            task.vectors.reserve(vectors.size() * dim);
+            for (const auto& vector : vectors) {
+                if (!vector.is_array() || vector.size() != dim) {
+                    return sendBadRequest("Vector dimension mismatch");
+                }
+                for (const auto& value : vector) {
+                    task.vectors.push_back(value.get<float>());
+                }
+            }
+            task.count = vectors.size();
+        } else {
+            if (!request_json.contains("vector") || !request_json["vector"].is_array()) {
+                return sendBadRequest("Missing or invalid 'vector' field");
+            }
+            task.vectors = request_json["vector"].get<std::vector<float>>();
+            if (task.vectors.size() != dim) {
+                return sendBadRequest("Vector dimension mismatch");
+            }
+            task.count = 1;
+        }
+        
+        auto start_time = std::chrono::steady_clock::now();
+        
+        task.callback = [this, version = req.version(), send_callback, batched, start_time](std::vector<uint64_t> ids) {
+            // committer 스레드에서 실행됨
+            auto insert_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_time);
             json data = {
-                {"results", results_array},
-                {"search_time_us", search_result.search_time.count()},
-                {"total_results", search_result.results.size()},
+                {"count", ids.size()},
+                {"insert_time_us", insert_time.count()}
             };
+            if (batched) {
+                data["ids"] = ids;
+            } else {
+                data["id"] = ids.front();
+            }
             
             http::response<http::string_body> res{http::status::ok, version};
             res.set(http::field::content_type, "application/json");
             res.body() = createSuccessResponse(data).dump();
             res.prepare_payload();
             
-            // 중요: 네트워크 작업은 I/O 스레드에서 수행해야 합니다.
-            // net::post를 사용해 I/O 컨텍스트로 작업을 다시 보냅니다.
             net::post(ioc_, [send_callback, res = std::move(res)]() mutable {
                 send_callback(std::move(res));
             });
         };
         
-        // [콜백 설정 2] 검색 실패 시
         task.error_callback = [this, version = req.version(), send_callback](const std::string& error_msg) {
-            // 이 코드도 워커 스레드에서 실행됩니다.
-            http::response<http::string_body> res{http::status::internal_server_error, version};
+            http::response<http::string_body> res{http::status::insufficient_storage, version};
             res.set(http::field::content_type, "application/json");
             res.body() = createErrorResponse(error_msg).dump();
             res.prepare_payload();
-
-            // 중요: 네트워크 작업은 I/O 스레드에서 수행해야 합니다.
+            
             net::post(ioc_, [send_callback, res = std::move(res)]() mutable {
                 send_callback(std::move(res));
             });
         };
         
-        // 작업을 큐에 넣습니다. I/O 스레드는 여기서 블록되지 않고 즉시 다음 일을 처리하러 갑니다.
-        search_queue_.enqueue(task);
+        enqueueInsertTask(std::move(task));
         
     } catch (const std::exception& e) {
-        // JSON 파싱 오류 등 즉시 에러를 반환할 수 있는 경우
-        http::response<http::string_body> res{http::status::bad_request, req.version()};
-        res.set(http::field::content_type, "application/json");
-        res.body() = createErrorResponse(std::string("Invalid request: ") + e.what()).dump();
-        res.prepare_payload();
-        return send_callback(std::move(res));
+        return sendBadRequest(std::string("Invalid request: ") + e.what());
     }
 }
 
@@ -412,16 +1294,41 @@ void VectorDBServer::handleExactSearchRequest(
     try {
         auto request_json = json::parse(body);
         
-        // 쿼리 벡터 추출
-        if (!request_json.contains("vector") || !request_json["vector"].is_array()) {
+        // 쿼리 벡터 추출: 단일 "vector" 또는 ground truth 생성용 배치 "vectors" (한 번의 스캔으로 모두 계산)
+        bool batched = request_json.contains("vectors");
+        const char* field = batched ? "vectors" : "vector";
+        if (!request_json.contains(field) || !request_json[field].is_array() || request_json[field].empty()) {
             http::response<http::string_body> res{http::status::bad_request, 11};
             res.set(http::field::content_type, "application/json");
-            res.body() = createErrorResponse("Missing or invalid 'vector' field").dump();
+            res.body() = createErrorResponse(std::string("Missing or invalid '") + field + "' field").dump();
             res.prepare_payload();
             return send_callback(std::move(res));
         }
         
-        std::vector<float> query_vector = request_json["vector"].get<std::vector<float>>();
+        if (batched && request_json["vectors"].size() > MAX_EXACT_QUERIES_PER_REQUEST) {
+            http::response<http::string_body> res{http::status::bad_request, 11};
+            res.set(http::field::content_type, "application/json");
+            res.body() = createErrorResponse("Too many vectors in one request (max " +
+                                             std::to_string(MAX_EXACT_QUERIES_PER_REQUEST) + ")").dump();
+            res.prepare_payload();
+            return send_callback(std::move(res));
+        }
+        
+        std::vector<std::vector<float>> queries;
+        if (batched) {
+            queries = request_json["vectors"].get<std::vector<std::vector<float>>>();
+        } else {
+            queries.push_back(request_json["vector"].get<std::vector<float>>());
+        }
+        for (const auto& query : queries) {
+            if (query.size() != vector_db_->getVectorDim()) {
+                http::response<http::string_body> res{http::status::bad_request, 11};
+                res.set(http::field::content_type, "application/json");
+                res.body() = createErrorResponse("Vector dimension mismatch").dump();
+                res.prepare_payload();
+                return send_callback(std::move(res));
+            }
+        }
         
         // k 값 추출 (기본값: 10)
         int k = request_json.value("k", 10);
@@ -439,31 +1346,45 @@ void VectorDBServer::handleExactSearchRequest(
         // Exact search는 동기적으로 실행 (이미 충분히 무거운 작업이므로)
         // search_pool_에서 실행하여 I/O 스레드를 블록하지 않음
         net::post(*search_pool_, [this, 
-                                   query_vector = std::move(query_vector), 
+                                   queries = std::move(queries),
+                                   batched,
                                    k, 
                                    version = req.version(), 
                                    send_callback]() mutable {
             try {
                 auto start_time = std::chrono::high_resolution_clock::now();
                 
-                // VectorDB의 exactSearchVectors 호출
-                auto results = vector_db_->exactSearchVectors(query_vector, k);
+                // VectorDB의 exactSearchVectorsBatch 호출 (단일 쿼리도 같은 경로)
+                auto batch_results = vector_db_->exactSearchVectorsBatch(queries, k);
                 
                 auto end_time = std::chrono::high_resolution_clock::now();
                 auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
                 
                 // 결과를 JSON으로 변환
-                json results_array = json::array();
-                for (const auto& result : results) {
-                    results_array.push_back({{"id", result.id}, {"distance", result.distance}});
-                }
+                auto toJson = [](const std::vector<SearchResult>& results) {
+                    json results_array = json::array();
+                    for (const auto& result : results) {
+                        results_array.push_back({{"id", result.id}, {"distance", result.distance}});
+                    }
+                    return results_array;
+                };
                 
                 json data = {
-                    {"results", results_array},
                     {"search_time_us", duration.count()},
-                    {"total_results", results.size()},
                     {"search_type", "exact_brute_force"}
                 };
+                if (batched) {
+                    json all_results = json::array();
+                    for (const auto& results : batch_results) {
+                        all_results.push_back(toJson(results));
+                    }
+                    data["results"] = std::move(all_results);
+                    data["total_queries"] = batch_results.size();
+                } else {
+                    const auto& results = batch_results.front();
+                    data["results"] = toJson(results);
+                    data["total_results"] = results.size();
+                }
                 
                 http::response<http::string_body> res{http::status::ok, version};
                 res.set(http::field::content_type, "application/json");
@@ -501,152 +1422,431 @@ http::response<http::string_body> VectorDBServer::handleStatusRequest(const http
     json data = {
         {"flat_index_count", vector_db_->getFlatIndexCount()},
         {"flat_index_full", vector_db_->isFlatIndexFull()},
+        {"flat_scan_codes", flatCodeTypeName(vector_db_->getFlatCodeType())},
+        {"flat_scan_bytes_per_row", vector_db_->getFlatScanBytesPerRow()},
+        {"flat_sharing", flatSharingModeName(vector_db_->getFlatSharingMode())},
+        {"flat_refreshes", vector_db_->getFlatRefreshCount()},
+        {"hnsw_index_count", vector_db_->getHNSWIndexCount()},
+        {"shard_engine", shardEngineName(config_.db.shard_load.engine)},
+        {"shard_filter", std::to_string(config_.db.shard_load.shard_filter_index) + "/" +
+                         std::to_string(config_.db.shard_load.shard_filter_count)},
+        {"total_compactions", vector_db_->getCompactionCount()},
+        {"flat_deleted", vector_db_->getFlatDeletedCount()},
+        {"hnsw_deleted", vector_db_->getHNSWDeletedCount()},
         {"server_running", running_.load()},
         {"port", port_},
         {"queue_size", search_queue_.size_approx()},
-        {"total_processed", total_processed_.load()}
+        {"total_processed", total_processed_.load()},
+        {"total_batches", total_batches_.load()},
+        {"total_inserted", total_inserted_.load()},
+        {"total_insert_groups", total_insert_groups_.load()},
+        {"total_search_groups", total_search_groups_.load()},
+        {"total_degraded_queries", total_degraded_.load()},
+        {"total_timed_out", total_timed_out_.load()},
+        {"total_rejected", total_rejected_.load()},
+        {"default_deadline_ms", config_.default_deadline.count()},
+        {"estimated_queue_delay_us", estimateQueueDelay().count()},
+        {"batch_size_limit", batch_size_limit_.load()},
+        {"avg_batch_latency_us", avg_batch_latency_us_.load()}
     };
     
-    http::response<http::string_body> res{http::status::ok, req.version()};
-    res.set(http::field::content_type, "application/json");
-    res.body() = createSuccessResponse(data).dump();
-    res.prepare_payload();
-    return res;
-}
-
-http::response<http::string_body> VectorDBServer::handleHealthRequest(const http::request<http::string_body>& req) {
-    json response = {
-        {"status", "healthy"},
-        {"timestamp", std::time(nullptr)}
+    json shards = json::array();
+    for (const auto& shard : vector_db_->getShardInfo()) {
+        shards.push_back({
+            {"path", shard.path},
+            {"vectors", shard.vector_count},
+            {"deleted", shard.deleted_count},
+            {"load_ms", shard.load_stats.load_ms},
+            {"warmup_ms", shard.load_stats.warmup_ms},
+            {"file_bytes", shard.load_stats.file_bytes},
+            {"resident_bytes", shard.resident_bytes},
+            {"ivf_routing_bytes", shard.load_stats.routing_bytes},
+            {"ivf_routing_ms", shard.load_stats.routing_ms},
+            {"dram_replica", {
+                {"upper_bytes", shard.load_stats.replica.upper_bytes},
+                {"record_bytes", shard.load_stats.replica.record_bytes},
+                {"neighbor_bytes", shard.load_stats.replica.neighbor_bytes},
+                {"replicated_bytes", shard.load_stats.replica.replicated_bytes},
+                {"runs", shard.load_stats.replica.runs}
+            }}
+        });
+    }
+    data["shards"] = shards;
+    
+    if (query_cache_) {
+        uint64_t hits = query_cache_->getHits();
+        uint64_t lookups = hits + query_cache_->getMisses();
+        data["query_cache"] = {
+            {"entries", query_cache_->size()},
+            {"capacity", query_cache_->capacity()},
+            {"hits", hits},
+            {"misses", query_cache_->getMisses()},
+            {"stale", query_cache_->getStale()},
+            {"hit_ratio", lookups ? static_cast<double>(hits) / lookups : 0.0},
+            {"data_version", vector_db_->getDataVersion()}
+        };
+    }
+    
+    data["search_slots"] = {
+        {"capacity", slot_pool_->capacity()},
+        {"in_use", slot_pool_->inUse()},
+        {"peak_in_use", slot_pool_->peakInUse()},
+        {"exhausted", slot_pool_->getExhausted()}
     };
     
+    // 현재 배치/워커 설정 (고정 실행에는 --max-batch / --batch-wait-us / --workers로 그대로 지정)
+    data["tuning"] = {
+        {"auto_tune", tuner_ != nullptr},
+        {"max_batch", max_batch_size_.load()},
+        {"batch_wait_us", batch_wait_us_.load()},
+        {"active_workers", active_workers_.load()}
+    };
+    if (tuner_) {
+        std::lock_guard<std::mutex> lock(tune_mutex_);
+        const TunerKnobs& best = tuner_->best();
+        data["tuning"]["p99_bound_us"] = tuner_->options().p99_bound.count();
+        data["tuning"]["best"] = {
+            {"max_batch", best.max_batch},
+            {"batch_wait_us", best.batch_wait_us},
+            {"workers", best.workers},
+            {"qps", tuner_->bestSample().qps},
+            {"p99_us", tuner_->bestSample().p99_us}
+        };
+        data["tuning"]["trials"] = tuner_->getTrials();
+        data["tuning"]["accepted"] = tuner_->getAccepted();
+    }
+    
+    data["threads"] = {
+        {"io_threads", thread_layout_.io_threads},
+        {"io_cpus", formatCpuList(thread_layout_.io_cpus)},
+        {"search_workers", num_search_workers_},
+        {"active_search_workers", active_workers_.load()},
+        {"compute_threads", config_.db.compute_threads},
+        {"search_cpus", formatCpuList(thread_layout_.search_cpus)},
+        {"search_node", thread_layout_.search_node},
+        {"pinned", config_.threads.pin}
+    };
+    
+    ShardReloadStatus reload = vector_db_->getShardReloadStatus();
+    data["shard_reload"] = {
+        {"running", reload.running},
+        {"generation", reload.generation},
+        {"dir", reload.dir},
+        {"shard_count", reload.shard_count},
+        {"load_ms", reload.load_ms},
+        {"drain_ms", reload.drain_ms},
+        {"last_error", reload.last_error}
+    };
+    
+    if (const auto* tracer = vector_db_->getPageTracer()) {
+        data["page_trace"] = {
+            {"running", tracer->isRunning()},
+            {"epochs", tracer->getEpochs()},
+            {"sampled_accesses", tracer->getFaults()},
+            {"queries", tracer->getQueries()}
+        };
+    }
+    
     http::response<http::string_body> res{http::status::ok, req.version()};
     res.set(http::field::content_type, "application/json");
-    res.body() = response.dump();
+    res.body() = createSuccessResponse(data).dump();
     res.prepare_payload();
     return res;
 }
 
-json VectorDBServer::createErrorResponse(const std::string& message) {
-    return {
-        {"success", false},
-        {"error", message},
-        {"timestamp", std::time(nullptr)}
-    };
-}
-
-json VectorDBServer::createSuccessResponse(const json& data) {
-    json response = {
-        {"success", true},
-        {"timestamp", std::time(nullptr)}
+void VectorDBServer::handleTraceDumpRequest(
+    const http::request<http::string_body>& req,
+    std::function<void(http::response<http::string_body>&&)> send_callback) {
+    
+    auto respond = [version = req.version()](http::status status, const json& body) {
+        http::response<http::string_body> res{status, version};
+        res.set(http::field::content_type, "application/json");
+        res.body() = body.dump();
+        res.prepare_payload();
+        return res;
     };
     
-    if (!data.is_null() && !data.empty()) {
-        response["data"] = data;
+    if (vector_db_->getPageTracer() == nullptr) {
+        return send_callback(respond(http::status::conflict,
+                                     createErrorResponse("Page tracing is not enabled (start with --trace-pages)")));
     }
     
-    return response;
-}
-
-// HttpSession 구현
-HttpSession::HttpSession(tcp::socket&& socket, VectorDBServer* server)
-    : stream_(std::move(socket)), server_(server) {
-}
-
-void HttpSession::run() {
-    net::dispatch(stream_.get_executor(),
-                  beast::bind_front_handler(&HttpSession::doRead,
-                                            shared_from_this()));
+    std::string prefix = "page_trace";
+    double min_rate = 0.5;
+    std::string action = "replicate";
+    try {
+        if (!req.body().empty()) {
+            json request_json = json::parse(req.body());
+            prefix = request_json.value("prefix", prefix);
+            min_rate = request_json.value("min_rate", min_rate);
+            action = request_json.value("action", action);
+        }
+    } catch (const std::exception& e) {
+        return send_callback(respond(http::status::bad_request,
+                                     createErrorResponse(std::string("Invalid request: ") + e.what())));
+    }
+    
+    // 클라이언트는 파일 이름만 고르고 디렉토리는 --trace-output 쪽으로 고정 (경로 구분자, 숨김/상위 경로 거절)
+    bool valid_name = !prefix.empty() && prefix.size() <= MAX_TRACE_PREFIX_LENGTH && prefix.front() != '.' &&
+                      std::all_of(prefix.begin(), prefix.end(), [](unsigned char c) {
+                          return std::isalnum(c) || c == '_' || c == '-' || c == '.';
+                      });
+    if (!valid_name) {
+        return send_callback(respond(http::status::bad_request,
+                                     createErrorResponse("prefix must be a file name of [A-Za-z0-9._-] "
+                                                         "not starting with '.'")));
+    }
+    if (!PageAccessTracer::isDamonAction(action)) {
+        return send_callback(respond(http::status::bad_request,
+                                     createErrorResponse("Unknown DAMOS action: " + action)));
+    }
+    std::string path = (std::filesystem::path(vector_db_->getTraceOutputDir()) / prefix).string();
+    
+    // 파일 쓰기(pagemap 조회 포함)는 search_pool_에서 실행
+    net::post(*search_pool_, [this, path, min_rate, action, respond, send_callback]() {
+        http::response<http::string_body> res;
+        if (!vector_db_->dumpPageTrace(path, min_rate, action)) {
+            res = respond(http::status::internal_server_error, createErrorResponse("Failed to write page trace"));
+        } else {
+            json data = {
+                {"heatmap", path + ".heatmap.tsv"},
+                {"damon_scheme", path + ".damon.json"},
+                {"min_rate", min_rate},
+                {"action", action}
+            };
+            res = respond(http::status::ok, createSuccessResponse(data));
+        }
+        net::post(ioc_, [send_callback, res = std::move(res)]() mutable {
+            send_callback(std::move(res));
+        });
+    });
 }
 
-void HttpSession::doRead() {
-    req_ = {};
+http::response<http::string_body> VectorDBServer::handleReloadRequest(const http::request<http::string_body>& req) {
+    auto respond = [&req](http::status status, const json& body) {
+        http::response<http::string_body> res{status, req.version()};
+        res.set(http::field::content_type, "application/json");
+        res.body() = body.dump();
+        res.prepare_payload();
+        return res;
+    };
     
-    stream_.expires_after(std::chrono::seconds(30));
+    std::string dir;
+    try {
+        if (!req.body().empty()) {
+            json request_json = json::parse(req.body());
+            dir = request_json.value("dir", dir);
+        }
+    } catch (const std::exception& e) {
+        return respond(http::status::bad_request, createErrorResponse(std::string("Invalid request: ") + e.what()));
+    }
+    
+    std::string error;
+    if (!vector_db_->startShardReload(dir, error)) {
+        return respond(http::status::conflict, createErrorResponse("Cannot reload shards: " + error));
+    }
     
-    http::async_read(stream_, buffer_, req_,
-                     beast::bind_front_handler(&HttpSession::onRead,
-                                               shared_from_this()));
+    // 로드/워밍업은 백그라운드에서 진행 (완료 여부는 /api/status의 shard_reload.generation으로 확인)
+    ShardReloadStatus reload = vector_db_->getShardReloadStatus();
+    json data = {
+        {"dir", reload.dir},
+        {"generation", reload.generation}
+    };
+    return respond(http::status::accepted, createSuccessResponse(data));
 }
 
-void HttpSession::onRead(beast::error_code ec, std::size_t bytes_transferred) {
-    boost::ignore_unused(bytes_transferred);
+void VectorDBServer::handleDeleteRequest(
+    const http::request<http::string_body>& req,
+    std::function<void(http::response<http::string_body>&&)> send_callback) {
     
-    if (ec == http::error::end_of_stream) {
-        return doClose();
-    }
+    auto respond = [version = req.version()](http::status status, const json& body) {
+        http::response<http::string_body> res{status, version};
+        res.set(http::field::content_type, "application/json");
+        res.body() = body.dump();
+        res.prepare_payload();
+        return res;
+    };
     
-    if (ec) {
-        std::cerr << "Read error: " << ec.message() << std::endl;
-        return;
+    // 단일 "id" 또는 배치 "ids"
+    std::vector<uint64_t> ids;
+    try {
+        json request_json = json::parse(req.body());
+        if (request_json.contains("ids")) {
+            if (!request_json["ids"].is_array() || request_json["ids"].empty()) {
+                return send_callback(respond(http::status::bad_request,
+                                             createErrorResponse("Missing or invalid 'ids' field")));
+            }
+            ids = request_json["ids"].get<std::vector<uint64_t>>();
+        } else if (request_json.contains("id")) {
+            ids.push_back(request_json["id"].get<uint64_t>());
+        } else {
+            return send_callback(respond(http::status::bad_request,
+                                         createErrorResponse("Missing 'id' or 'ids' field")));
+        }
+    } catch (const std::exception& e) {
+        return send_callback(respond(http::status::bad_request,
+                                     createErrorResponse(std::string("Invalid request: ") + e.what())));
+    }
+    if (ids.size() > MAX_DELETE_IDS_PER_REQUEST) {
+        return send_callback(respond(http::status::bad_request,
+                                     createErrorResponse("Too many ids in one request")));
     }
     
-    // [수정] handleRequest 호출 방식 변경
-    // handleRequest는 이제 즉시 반환되며, 작업이 완료되면 아래 람다 콜백이 호출됩니다.
-    server_->handleRequest(std::move(req_), 
-        // [self = shared_from_this()] 를 통해 비동기 작업 중 HttpSession 객체가 살아있도록 보장
-        [self = shared_from_this()](http::response<http::string_body>&& res) {
-            self->sendResponse(std::move(res));
+    net::post(*search_pool_, [this, ids = std::move(ids), respond, send_callback]() {
+        auto start_time = std::chrono::steady_clock::now();
+        std::vector<bool> found;
+        size_t deleted = 0;
+        http::response<http::string_body> res;
+        if (!vector_db_->deleteVectors(ids, found, deleted)) {
+            res = respond(http::status::conflict,
+                          createErrorResponse("Flat index is a shared reader, delete on the writer host"));
+        } else {
+            auto delete_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_time);
+            
+            json not_found = json::array();
+            for (size_t i = 0; i < ids.size(); ++i) {
+                if (!found[i]) {
+                    not_found.push_back(ids[i]);
+                }
+            }
+            json data = {
+                {"deleted", deleted},
+                {"not_found", not_found},
+                {"delete_time_us", delete_time.count()}
+            };
+            res = respond(http::status::ok, createSuccessResponse(data));
+        }
+        
+        // I/O 컨텍스트로 돌려보내서 응답 전송
+        net::post(ioc_, [send_callback, res = std::move(res)]() mutable {
+            send_callback(std::move(res));
         });
+    });
 }
 
-// [신규] 응답을 받아 비동기 쓰기를 시작하는 함수
-void HttpSession::sendResponse(http::response<http::string_body>&& res) {
-    res_ = std::move(res);
-
-    // 응답을 보내기 전에 keep_alive 상태를 설정합니다.
-    res_.keep_alive(req_.keep_alive());
-
-    // std::cout << "Sending response, size: " << res_.body().size() << " bytes" << std::endl;
-    
-    http::async_write(
-        stream_,
-        res_,
-        beast::bind_front_handler(
-            &HttpSession::onWrite,
-            shared_from_this(),
-            res_.need_eof() // keep_alive가 아니면 연결을 닫도록 설정
-        )
-    );
+void VectorDBServer::countResponse(unsigned status) {
+    size_t slot = 0;
+    while (slot < std::size(TRACKED_STATUS_CODES) && TRACKED_STATUS_CODES[slot] != static_cast<int>(status)) {
+        ++slot;
+    }
+    responses_by_status_[slot].fetch_add(1, std::memory_order_relaxed);
 }
 
-void HttpSession::onWrite(bool close, beast::error_code ec, std::size_t bytes_transferred) {
-    boost::ignore_unused(bytes_transferred);
+http::response<http::string_body> VectorDBServer::handleMetricsRequest(const http::request<http::string_body>& req) {
+    std::ostringstream out;
     
-    if (ec) {
-        std::cerr << "Write error: " << ec.message() << std::endl;
-        return;
+    renderMetricHeader(out, "vectordb_responses_total", "counter", "HTTP responses by status code");
+    for (size_t slot = 0; slot < NUM_STATUS_SLOTS; ++slot) {
+        std::string code = slot < std::size(TRACKED_STATUS_CODES)
+                               ? std::to_string(TRACKED_STATUS_CODES[slot]) : "other";
+        out << "vectordb_responses_total{code=\"" << code << "\"} "
+            << responses_by_status_[slot].load(std::memory_order_relaxed) << "\n";
     }
+    renderMetricHeader(out, "vectordb_requests_timed_out_total", "counter",
+                       "Search requests dropped because their deadline expired");
+    out << "vectordb_requests_timed_out_total " << total_timed_out_.load() << "\n";
+    renderMetricHeader(out, "vectordb_requests_rejected_total", "counter",
+                       "Search queries rejected at admission because the estimated queue delay exceeded their deadline");
+    out << "vectordb_requests_rejected_total " << total_rejected_.load() << "\n";
+    renderMetricHeader(out, "vectordb_estimated_queue_delay_us", "gauge",
+                       "Estimated queue delay used by admission control in microseconds");
+    out << "vectordb_estimated_queue_delay_us " << estimateQueueDelay().count() << "\n";
     
-    // std::cout << "Response sent successfully, " << bytes_transferred << " bytes transferred" << std::endl;
-    
-    if (close) {
-        std::cout << "Closing connection" << std::endl;
-        return doClose();
+    renderMetricHeader(out, "vectordb_queries_processed_total", "counter", "Search queries answered");
+    out << "vectordb_queries_processed_total " << total_processed_.load() << "\n";
+    renderMetricHeader(out, "vectordb_batches_total", "counter", "Search batches executed");
+    out << "vectordb_batches_total " << total_batches_.load() << "\n";
+    renderMetricHeader(out, "vectordb_search_groups_total", "counter", "(ef, k) groups searched within batches");
+    out << "vectordb_search_groups_total " << total_search_groups_.load() << "\n";
+    renderMetricHeader(out, "vectordb_degraded_queries_total", "counter",
+                       "Queries whose ef was lowered by adaptive ef under queue pressure");
+    out << "vectordb_degraded_queries_total " << total_degraded_.load() << "\n";
+    renderMetricHeader(out, "vectordb_inserted_vectors_total", "counter", "Vectors inserted");
+    out << "vectordb_inserted_vectors_total " << total_inserted_.load() << "\n";
+    if (query_cache_) {
+        renderMetricHeader(out, "vectordb_query_cache_lookups_total", "counter", "Query cache lookups by result");
+        out << "vectordb_query_cache_lookups_total{result=\"hit\"} " << query_cache_->getHits() << "\n";
+        out << "vectordb_query_cache_lookups_total{result=\"miss\"} " << query_cache_->getMisses() << "\n";
     }
     
-    // 다음 요청을 위해 응답 객체 초기화
-    res_ = {};
+    renderMetricHeader(out, "vectordb_search_queue_size", "gauge", "Approximate number of queued search tasks");
+    out << "vectordb_search_queue_size " << search_queue_.size_approx() << "\n";
+    renderMetricHeader(out, "vectordb_batch_size_limit", "gauge", "Current adaptive batch size limit");
+    out << "vectordb_batch_size_limit " << batch_size_limit_.load() << "\n";
+    renderMetricHeader(out, "vectordb_flat_vectors", "gauge", "Vectors in the flat tier");
+    out << "vectordb_flat_vectors " << vector_db_->getFlatIndexCount() << "\n";
+    renderMetricHeader(out, "vectordb_flat_refreshes_total", "counter",
+                       "Shared flat reader refreshes that picked up rows published by the writer host");
+    out << "vectordb_flat_refreshes_total " << vector_db_->getFlatRefreshCount() << "\n";
+    renderMetricHeader(out, "vectordb_hnsw_shards", "gauge", "Loaded HNSW shards");
+    out << "vectordb_hnsw_shards " << vector_db_->getHNSWIndexCount() << "\n";
+    renderMetricHeader(out, "vectordb_deleted_vectors", "gauge",
+                       "Vectors marked deleted but not yet reclaimed, by tier");
+    out << "vectordb_deleted_vectors{tier=\"flat\"} " << vector_db_->getFlatDeletedCount() << "\n";
+    out << "vectordb_deleted_vectors{tier=\"hnsw\"} " << vector_db_->getHNSWDeletedCount() << "\n";
+    renderMetricHeader(out, "vectordb_shard_reloads_total", "counter", "HNSW shard sets published by hot-swap reload");
+    out << "vectordb_shard_reloads_total " << vector_db_->getShardReloadStatus().generation << "\n";
+    
+    renderMetricHeader(out, "vectordb_queue_wait_us", "histogram",
+                       "Time a search task spent in the search queue in microseconds");
+    queue_wait_us_.render(out, "vectordb_queue_wait_us");
+    renderMetricHeader(out, "vectordb_batch_size", "histogram", "Queries per search batch");
+    batch_size_hist_.render(out, "vectordb_batch_size");
+    renderMetricHeader(out, "vectordb_request_latency_us", "histogram",
+                       "Search queue wait plus search time per query in microseconds");
+    request_latency_us_.render(out, "vectordb_request_latency_us");
+    renderMetricHeader(out, "vectordb_active_search_workers", "gauge",
+                       "Search workers taking tasks (lowered by auto-tuning)");
+    out << "vectordb_active_search_workers " << active_workers_.load() << "\n";
+    renderMetricHeader(out, "vectordb_batch_search_us", "histogram",
+                       "End-to-end search time per batch in microseconds");
+    batch_search_us_.render(out, "vectordb_batch_search_us");
+    vector_db_->getSearchMetrics().render(out, vector_db_->getHNSWIndexCount());
+    renderMetricHeader(out, "vectordb_serialize_us", "histogram",
+                       "JSON search response serialization time in microseconds");
+    serialize_us_.render(out, "vectordb_serialize_us");
+    renderMetricHeader(out, "vectordb_post_delay_us", "histogram",
+                       "Delay between posting a search result to the I/O context and running it in microseconds");
+    post_delay_us_.render(out, "vectordb_post_delay_us");
     
-    // std::cout << "Keep-alive connection, reading next request" << std::endl;
-    doRead();
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::content_type, "text/plain; version=0.0.4");
+    res.body() = out.str();
+    res.prepare_payload();
+    return res;
 }
 
-void HttpSession::doClose() {
-    std::cout << "Closing HTTP session" << std::endl;
-    beast::error_code ec;
+http::response<http::string_body> VectorDBServer::handleHealthRequest(const http::request<http::string_body>& req) {
+    json response = {
+        {"status", "healthy"},
+        {"timestamp", std::time(nullptr)}
+    };
     
-    // 소켓 shutdown 시도
-    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::content_type, "application/json");
+    res.body() = response.dump();
+    res.prepare_payload();
+    return res;
+}
+
+json VectorDBServer::createErrorResponse(const std::string& message) {
+    return {
+        {"success", false},
+        {"error", message},
+        {"timestamp", std::time(nullptr)}
+    };
+}
+
+json VectorDBServer::createSuccessResponse(const json& data) {
+    json response = {
+        {"success", true},
+        {"timestamp", std::time(nullptr)}
+    };
     
-    if (ec) {
-        std::cerr << "Socket shutdown error: " << ec.message() << std::endl;
+    if (!data.is_null() && !data.empty()) {
+        response["data"] = data;
     }
     
-    // 소켓 닫기
-    stream_.socket().close(ec);
-    
-    if (ec) {
-        std::cerr << "Socket close error: " << ec.message() << std::endl;
-    }
+    return response;
 }
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "vector_db.h"
+#include "binary_protocol.h"
+#include "deadline_queue.h"
+#include "auto_tuner.h"
+#include "query_cache.h"
+#include "search_slot_pool.h"
+#include "http_session.h"
+#include "thread_layout.h"
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
@@ -8,35 +15,67 @@
 #include <boost/asio/strand.hpp>
 #include <boost/asio/thread_pool.hpp>
 #include <boost/config.hpp>
-#include <concurrentqueue.h>
 #include <nlohmann/json.hpp>
 #include <memory>
 #include <string>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <semaphore>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
-namespace beast = boost::beast;
-namespace http = beast::http;
-namespace net = boost::asio;
-using tcp = boost::asio::ip::tcp;
 using json = nlohmann::json;
 
+// 서버 실행 옵션 (main.cpp의 명령행 옵션으로 설정)
+struct ServerConfig {
+    int port = 8080;
+    VectorDBOptions db;
+    
+    // 코어 예산: I/O 코어와 검색 코어로 나누고, 따로 지정하지 않은 스레드 수/pinning은 여기서 유도
+    ThreadBudgetOptions threads;
+    size_t search_workers = 0;                            // 검색 워커 수 (0이면 검색 코어 수)
+    size_t max_batch_size = 32;                           // 배치 크기 상한
+    size_t search_slots = 4096;                           // 동시에 대기/처리 중일 수 있는 검색 쿼리 수 (초과 시 503)
+    std::chrono::microseconds max_batch_wait{0};          // 가장 오래된 요청 도착 시점 기준 최대 배치 대기 시간
+    std::chrono::microseconds batch_latency_target{5000}; // 배치 하나의 검색 latency 목표 (배치 크기 적응 기준)
+    
+    // 검색 deadline: 요청의 X-Request-Deadline-Ms 헤더(도착 시점 기준 ms), 없으면 이 기본값 (0이면 deadline 없음)
+    // deadline이 지난 태스크는 검색하지 않고 504, 예상 큐 대기가 deadline을 넘으면 큐에 넣지 않고 503
+    std::chrono::milliseconds default_deadline{0};
+    bool admission_control = true;                        // false면 deadline이 지난 태스크만 버림
+    
+    size_t query_cache_entries = 0;                       // 검색 결과 캐시 항목 수 (0이면 캐시 안 함)
+    float query_cache_quantize = 0.0f;                    // 캐시 키 양자화 step (0이면 완전히 같은 벡터만 히트)
+    
+    // 온라인 튜닝: 배치 크기 상한, 배치 대기 시간, 활성 워커 수를 tuning.p99_bound 안의 최대 처리량으로 hill-climbing
+    // (max_batch_size / max_batch_wait / search_workers는 시작값, 찾은 값은 /api/status의 tuning)
+    bool auto_tune = false;
+    TunerOptions tuning;
+    
+    // 적응형 ef: 큐 깊이가 임계값을 넘으면 ef를 임계값/깊이 비율로 낮춤 (0이면 사용 안 함)
+    // 요청에서 ef를 직접 지정한 경우는 낮추지 않음
+    size_t adaptive_ef_queue_depth = 0;
+    int min_adaptive_ef = 32;
+};
+
 class VectorDBServer {
 private:
-    // 배치 처리 상수
-    static constexpr size_t MAX_BATCH_SIZE = 32;
-    static constexpr std::chrono::milliseconds BATCH_TIMEOUT{10}; // 10ms
     
     // Worker별 재사용 버퍼들 (thread_local)
     static thread_local std::vector<float> worker_batch_buffer_;
-    static thread_local std::vector<std::vector<float>> worker_queries_buffer_;
     static thread_local std::vector<int> worker_k_values_buffer_;
+    static thread_local std::vector<SearchResult> cache_lookup_buffer_;
     
     // 기존 멤버들
     std::unique_ptr<VectorDB> vector_db_;
     std::atomic<bool> running_;
+    ServerConfig config_;
     int port_;
+    size_t num_search_workers_;
+    ThreadLayout thread_layout_;
+    bool thread_layout_ok_;
 
     // Beast/Asio 관련
     net::io_context ioc_;
@@ -44,29 +83,130 @@ private:
     tcp::acceptor acceptor_;
     std::vector<std::thread> ioc_threads_;
 
-    // 비동기 처리를 위한 구조체
-    struct AsyncSearchResult {
-        std::vector<SearchResult> results;
-        std::chrono::microseconds search_time;
+    using SendCallback = std::function<void(http::response<http::string_body>&&)>;
+    
+    // 검색 결과를 돌려줄 형식
+    enum class SearchReply : uint8_t {
+        Json,     // /api/search: 워커에서 JSON 응답을 만들어 바로 전송
+        Binary,   // /api/search/bin: 요청의 응답 버퍼 자기 자리에 기록, 마지막 쿼리가 전송
     };
-
-    struct SearchTask {
-        std::string request_id;
-        std::vector<float> query_vector;
-        int k;
-        std::function<void(AsyncSearchResult)> callback;
+    
+    // 바이너리 검색 요청 하나의 응답 (쿼리 슬롯들이 공유)
+    struct BinarySearchState {
+        std::string body;
+        std::atomic<uint32_t> remaining;
+        std::atomic<bool> failed{false};
+        std::atomic<bool> timed_out{false};   // 쿼리 하나라도 deadline이 지나 버려짐 (504)
+        std::atomic<bool> unavailable{false}; // 쿼리 하나라도 종료로 큐에서 버려짐 (503)
+        uint32_t k;
+        unsigned http_version;
+        SendCallback send_callback;
+        BinarySearchState(uint32_t count, uint32_t result_k, unsigned version, SendCallback send)
+            : remaining(count), k(result_k), http_version(version), send_callback(std::move(send)) {}
+    };
+    
+    // 검색 슬롯 메타데이터 (쿼리 float는 slot_pool_->query(slot)에 한 번만 기록됨)
+    // 큐에는 슬롯 번호만 들어가고, 슬롯 번호가 곧 완료 handle
+    // 완료되면 워커가 응답을 만들어 ioc_로 한 번만 post하고 슬롯을 반납
+    struct SearchSlot {
+        int k = 0;
+        int ef = 0;                   // 0이면 HNSW 기본 ef
+        bool strict_ef = false;       // 요청이 ef를 직접 지정함 (적응형 ef로 낮추지 않음)
+        std::chrono::steady_clock::time_point enqueue_time;
+        std::chrono::steady_clock::time_point deadline;  // time_point::max()면 deadline 없음
+        std::string cache_key;        // 결과 캐시 키 (캐시를 쓰지 않으면 비어 있음, 용량은 슬롯 재사용 시 유지)
+        uint64_t cache_version = 0;   // 큐에 넣을 때의 데이터 버전
+        SearchReply reply = SearchReply::Json;
+        unsigned http_version = 11;
+        SendCallback send_callback;                 // Json
+        std::shared_ptr<BinarySearchState> binary;  // Binary
+        uint32_t binary_index = 0;                  // 바이너리 요청 안에서의 쿼리 번호
+    };
+    
+    static constexpr int MAX_REQUEST_EF = 4096;
+    // deadline 없는 태스크의 EDF 정렬 키 = 도착 시점 + 이 값 (deadline 있는 태스크에 계속 밀려 굶지 않도록)
+    static constexpr std::chrono::milliseconds NO_DEADLINE_ORDER_SLACK{1000};
+    static constexpr const char* DEADLINE_HEADER = "X-Request-Deadline-Ms";
+    
+    // 검색 쿼리 arena + 슬롯 메타데이터 (서버 시작 시 config_.search_slots개 할당)
+    std::unique_ptr<SearchSlotPool> slot_pool_;
+    std::vector<SearchSlot> search_slots_;
+    
+    // EDF 큐(슬롯 번호) + 대기 중인 태스크 수를 세는 semaphore
+    // (워커는 busy-polling 대신 semaphore에서 블록)
+    DeadlineQueue search_queue_;
+    std::counting_semaphore<> pending_tasks_{0};
+    
+    // 검색 결과 캐시 (query_cache_entries > 0일 때만)
+    std::unique_ptr<QueryResultCache> query_cache_;
+    
+    // 적응형 배치 크기 (최근 배치 latency와 목표 latency로 조정)
+    std::atomic<size_t> batch_size_limit_;
+    std::atomic<int64_t> avg_batch_latency_us_{0};
+    
+    // 실행 중에 바뀌는 배치/워커 설정 (시작값은 config_, auto_tune이면 tuner가 갱신)
+    std::atomic<size_t> max_batch_size_;
+    std::atomic<int64_t> batch_wait_us_;
+    std::atomic<size_t> active_workers_{0};
+    // 활성 워커 수보다 번호가 큰 워커는 여기서 대기
+    std::mutex workers_mutex_;
+    std::condition_variable workers_cv_;
+    
+    // 온라인 튜닝 스레드 (auto_tune일 때만)
+    std::unique_ptr<OnlineTuner> tuner_;
+    mutable std::mutex tune_mutex_;
+    std::condition_variable tune_cv_;
+    std::thread tuner_thread_;
+    // 큐 대기 + 검색 시간 (튜닝 구간 p99 계산용)
+    Histogram request_latency_us_{Histogram::latencyBucketsUs()};
+    
+    // 삽입 요청 (group commit)
+    // 동시에 들어온 삽입들을 committer 스레드가 모아 하나의 append + flush 한 번으로 처리
+    struct InsertTask {
+        std::vector<float> vectors;  // count × dim 연속 배열
+        size_t count = 0;
+        std::function<void(std::vector<uint64_t>)> callback;
         std::function<void(std::string)> error_callback;
     };
     
-    // Lock-free queue
-    moodycamel::ConcurrentQueue<SearchTask> search_queue_;
+    static constexpr size_t MAX_INSERT_VECTORS_PER_REQUEST = 1024;
+    static constexpr size_t MAX_DELETE_IDS_PER_REQUEST = 4096;
+    static constexpr size_t MAX_TRACE_PREFIX_LENGTH = 128;
+    // /api/exact-search "vectors" 배치 상한 (쿼리마다 top-k 버퍼를 잡고 전체 flat을 한 번 스캔함)
+    static constexpr size_t MAX_EXACT_QUERIES_PER_REQUEST = 1024;
+    static constexpr size_t MAX_INSERT_GROUP_VECTORS = 4096;
+    
+    std::mutex insert_mutex_;
+    std::condition_variable insert_cv_;
+    std::deque<InsertTask> insert_queue_;
+    std::thread insert_committer_;
+    
+    // /metrics 단계별 히스토그램 (검색 경로 내부 단계는 VectorDB::getSearchMetrics)
+    Histogram queue_wait_us_{Histogram::latencyBucketsUs()};     // search_queue_ 대기 시간
+    Histogram batch_size_hist_{Histogram::sizeBuckets()};
+    Histogram batch_search_us_{Histogram::latencyBucketsUs()};   // 배치 하나의 전체 검색 시간
+    Histogram serialize_us_{Histogram::latencyBucketsUs()};      // 검색 응답 JSON 생성
+    Histogram post_delay_us_{Histogram::latencyBucketsUs()};     // 워커에서 ioc_로 post한 뒤 실행될 때까지
+    
+    // 상태 코드별 응답 수 (4xx/5xx는 거부/실패 요청)
+    static constexpr int TRACKED_STATUS_CODES[] = {200, 400, 404, 409, 413, 500, 503, 504, 507};
+    static constexpr size_t NUM_STATUS_SLOTS = std::size(TRACKED_STATUS_CODES) + 1;  // 마지막은 그 외
+    std::atomic<uint64_t> responses_by_status_[NUM_STATUS_SLOTS] = {};
+    std::atomic<uint64_t> total_timed_out_{0};   // 큐에서 deadline이 지나 검색하지 않은 쿼리 수
+    std::atomic<uint64_t> total_rejected_{0};    // 예상 큐 대기가 deadline을 넘어 받지 않은 쿼리 수
     
     // 통계
+    std::atomic<size_t> total_inserted_{0};
+    std::atomic<size_t> total_insert_groups_{0};
     std::atomic<size_t> queue_size_{0};
     std::atomic<size_t> total_processed_{0};
+    std::atomic<size_t> total_batches_{0};
+    std::atomic<size_t> total_search_groups_{0};  // 배치 안의 (ef, k) 그룹 수
+    std::atomic<size_t> total_degraded_{0};       // 적응형 ef로 ef가 낮아진 쿼리 수
 
 public:
-    VectorDBServer(const std::string& hnsw_path, const std::string& flat_path, int port = 8080);
+    VectorDBServer(const std::string& hnsw_path, const std::string& flat_path,
+                   const ServerConfig& config = ServerConfig());
     ~VectorDBServer();
     
     bool initialize();
@@ -79,9 +219,56 @@ public:
     
 private:
     void startSearchWorkers(int num_workers = 64);
+    // 워커를 깨우고 큐에 남은 검색을 503으로 응답 (응답이 전송되도록 ioc_를 멈추기 전에 호출)
     void stopSearchWorkers();
-    void searchWorkerLoop();
-    void processBatch(const std::vector<SearchTask>& batch);
+    void searchWorkerLoop(size_t worker_idx);
+    void processBatch(const std::vector<uint32_t>& batch);
+    // 같은 ef, 비슷한 k(2의 거듭제곱 구간)의 태스크들을 한 번에 검색
+    void processSearchGroup(const std::vector<uint32_t>& batch, const std::vector<size_t>& members,
+                            int ef, bool degraded);
+    // 태스크의 실효 ef (적응형 ef 적용, degraded는 낮아졌는지 여부)
+    int effectiveEf(const SearchSlot& task, size_t queue_depth, bool& degraded) const;
+    // recall 목표를 ef로 변환 (대략적인 기준표)
+    static int efForRecallTarget(int k, double recall_target);
+    
+    // 요청 헤더(또는 서버 기본값)의 deadline, 없으면 time_point::max()
+    std::chrono::steady_clock::time_point requestDeadline(const http::request<http::string_body>& req,
+                                                          std::chrono::steady_clock::time_point now) const;
+    // 지금 큐에 넣으면 검색이 끝날 때까지 걸릴 예상 시간 (큐 깊이 / 워커 처리량 × 배치 latency EWMA)
+    std::chrono::microseconds estimateQueueDelay() const;
+    // deadline을 지킬 수 없을 것 같으면 false (count는 요청의 쿼리 수, 거절 통계용)
+    bool admitSearch(std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::time_point now,
+                     size_t count);
+    // deadline이 지났으면 검색하지 않고 504로 완료
+    bool dropIfExpired(uint32_t slot);
+    
+    // 쿼리를 기록한 슬롯을 큐에 넣고 대기 중인 워커 하나를 깨움 (캐시 히트면 큐를 거치지 않고 바로 완료)
+    void enqueueSearchTask(uint32_t slot);
+    // semaphore 토큰을 이미 획득한 상태에서 큐에서 슬롯 하나를 꺼냄 (종료 시 false)
+    bool dequeueSearchTask(uint32_t& slot);
+    // 검색 결과를 슬롯의 응답 형식으로 보내고 슬롯 반납 (워커 또는 캐시 히트 시 I/O 스레드에서 호출)
+    void completeSearch(uint32_t slot, const SearchResult* results, size_t count,
+                        std::chrono::microseconds search_time, int ef);
+    void failSearch(uint32_t slot, const std::string& error_msg,
+                    http::status status = http::status::internal_server_error);
+    void releaseSearchSlot(uint32_t slot);
+    // 바이너리 요청의 쿼리 하나가 끝남 (마지막이면 응답 전송)
+    void finishBinaryQuery(const std::shared_ptr<BinarySearchState>& state);
+    // 배치 처리 결과로 다음 배치 크기 상한 조정 (AIMD)
+    void updateBatchSizeLimit(size_t batch_size, std::chrono::microseconds batch_latency);
+    
+    // 온라인 튜닝: 구간마다 처리량/p99를 측정해서 tuner가 고른 설정을 적용
+    void startTuner();
+    void stopTuner();
+    void tuneLoop();
+    void applyTuning(const TunerKnobs& knobs);
+    
+    // 삽입 group commit 스레드
+    void startInsertCommitter();
+    void stopInsertCommitter();
+    void insertCommitLoop();
+    void commitInsertGroup(std::vector<InsertTask>& group);
+    void enqueueInsertTask(InsertTask&& task);
     
     void startAccepting();
     void onAccept(beast::error_code ec, tcp::socket socket);
@@ -96,6 +283,17 @@ private:
         const http::request<http::string_body>& req,
         std::function<void(http::response<http::string_body>&&)> send_callback);
     
+    // 바이너리 검색 (binary_protocol.h 포맷, 요청당 여러 쿼리)
+    void handleBinarySearchRequest(
+        const http::request<http::string_body>& req,
+        std::function<void(http::response<http::string_body>&&)> send_callback);
+    
+    // 벡터 삽입 (단일 "vector" 또는 배치 "vectors"), flush 완료 후 ID 반환
+    void handleInsertRequest(
+        const std::string& body, 
+        const http::request<http::string_body>& req,
+        std::function<void(http::response<http::string_body>&&)> send_callback);
+    
     void handleExactSearchRequest(
         const std::string& body, 
         const http::request<http::string_body>& req,
@@ -104,27 +302,15 @@ private:
     // 이 핸들러들은 간단하므로 동기적으로 응답을 생성하고 바로 콜백을 호출합니다.
     http::response<http::string_body> handleStatusRequest(const http::request<http::string_body>& req);
     http::response<http::string_body> handleHealthRequest(const http::request<http::string_body>& req);
-};
-
-// HTTP 세션 클래스
-class HttpSession : public std::enable_shared_from_this<HttpSession> {
-private:
-    beast::tcp_stream stream_;
-    beast::flat_buffer buffer_;
-    http::request<http::string_body> req_;
-    http::response<http::string_body> res_;  // 응답 객체를 멤버로 유지
-    VectorDBServer* server_;
-
-public:
-    HttpSession(tcp::socket&& socket, VectorDBServer* server);
-    void run();
-
-private:
-    void doRead();
-    void onRead(beast::error_code ec, std::size_t bytes_transferred);
-
-    void sendResponse(http::response<http::string_body>&& response);
-
-    void onWrite(bool close, beast::error_code ec, std::size_t bytes_transferred);
-    void doClose();
+    // Prometheus text exposition
+    http::response<http::string_body> handleMetricsRequest(const http::request<http::string_body>& req);
+    void countResponse(unsigned status);
+    // 페이지 접근 추적 결과 기록 (--trace-pages로 시작한 경우만)
+    void handleTraceDumpRequest(const http::request<http::string_body>& req,
+                                std::function<void(http::response<http::string_body>&&)> send_callback);
+    // ID로 벡터 삭제 (파싱만 IO 스레드에서, tombstone 표시와 내구화는 search_pool_에서 처리)
+    void handleDeleteRequest(const http::request<http::string_body>& req,
+                             std::function<void(http::response<http::string_body>&&)> send_callback);
+    // 샤드 세트 hot-swap 시작 (로드는 백그라운드, 진행 상황은 /api/status의 shard_reload)
+    http::response<http::string_body> handleReloadRequest(const http::request<http::string_body>& req);
 };
@@ -70,41 +70,46 @@ test_endpoint "GET" "/health" "" "Server health status"
 echo "2. Status Check"
 test_endpoint "GET" "/api/status" "" "Server status information"
 
-# # 3. Insert Vectors
-# echo "3. Insert Test Vectors"
-# vector_ids=()
-
-# for i in {1..3}; do
-#     echo "Inserting vector $i/3..."
-#     vector=$(generate_random_vector)
-#     data="{\"vector\": $vector}"
+# 3. Insert Vectors
+echo "3. Insert Test Vectors"
+vector_ids=()
+
+for i in {1..3}; do
+    echo "Inserting vector $i/3..."
+    vector=$(generate_random_vector)
+    data="{\"vector\": $vector}"
     
-#     response=$(curl -s -w "\n%{http_code}" -X POST \
-#                -H "Content-Type: application/json" \
-#                -d "$data" \
-#                "$BASE_URL/api/vectors")
+    response=$(curl -s -w "\n%{http_code}" -X POST \
+               -H "Content-Type: application/json" \
+               -d "$data" \
+               "$BASE_URL/api/vectors")
     
-#     body=$(echo "$response" | head -n -1)
-#     status_code=$(echo "$response" | tail -n 1)
+    body=$(echo "$response" | head -n -1)
+    status_code=$(echo "$response" | tail -n 1)
     
-#     if [ "$status_code" -eq 200 ]; then
-#         # Extract ID from response
-#         id=$(echo "$body" | python3 -c "
-# import json, sys
-# try:
-#     data = json.load(sys.stdin)
-#     print(data['data']['id'])
-# except:
-#     print('0')
-# ")
-#         vector_ids+=($id)
-#         echo -e "${GREEN}✓ Vector $i inserted with ID: $id${NC}"
-#     else
-#         echo -e "${RED}✗ Failed to insert vector $i (HTTP $status_code)${NC}"
-#         echo "$body"
-#     fi
-# done
-# echo ""
+    if [ "$status_code" -eq 200 ]; then
+        # Extract ID from response
+        id=$(echo "$body" | python3 -c "
+import json, sys
+try:
+    data = json.load(sys.stdin)
+    print(data['data']['id'])
+except:
+    print('0')
+")
+        vector_ids+=($id)
+        echo -e "${GREEN}✓ Vector $i inserted with ID: $id${NC}"
+    else
+        echo -e "${RED}✗ Failed to insert vector $i (HTTP $status_code)${NC}"
+        echo "$body"
+    fi
+done
+echo ""
+
+# 3b. Batch insert (group commit)
+echo "3b. Batch Insert Test"
+vectors="[$(generate_random_vector),$(generate_random_vector),$(generate_random_vector)]"
+test_endpoint "POST" "/api/insert" "{\"vectors\": $vectors}" "Batch insert of 3 vectors"
 
 # 4. Search Tests
 echo "4. Search Test Queries"
@@ -145,6 +150,40 @@ except Exception as e:
     echo ""
 done
 
+# 4b. Binary Search Test (POST /api/search/bin, 4 queries in one request)
+echo "4b. Binary Search Test"
+python3 - "$BASE_URL" <<'PYEOF'
+import random, struct, sys, urllib.request
+base_url = sys.argv[1]
+dim, k, count = 768, 10, 4
+body = struct.pack('<6I', 0x53424456, k, 0, count, dim, 0)
+body += struct.pack('<%df' % (dim * count), *[random.uniform(-1, 1) for _ in range(dim * count)])
+req = urllib.request.Request(base_url + '/api/search/bin', data=body,
+                             headers={'Content-Type': 'application/octet-stream'})
+try:
+    data = urllib.request.urlopen(req).read()
+    magic, status, n, kk = struct.unpack_from('<4I', data)
+    print(f'  status={status}, queries={n}, k={kk}')
+    for q in range(n):
+        off = 16 + q * kk * 12
+        top = [struct.unpack_from('<Qf', data, off + j * 12) for j in range(min(3, kk))]
+        print(f'    query {q}: ' + ', '.join(f'{i}:{d:.4f}' for i, d in top))
+except Exception as e:
+    print(f'  Binary search failed: {e}')
+PYEOF
+echo ""
+
+# 4c. Prometheus metrics (text format, only a few series shown)
+echo "4c. Metrics Check"
+metrics=$(curl -s "$BASE_URL/metrics")
+if echo "$metrics" | grep -q "^vectordb_queue_wait_us_count"; then
+    echo -e "${GREEN}✓ /metrics exposed${NC}"
+    echo "$metrics" | grep -E "^vectordb_(responses_total|queue_wait_us_count|batch_search_us_count|flat_scan_us_count)"
+else
+    echo -e "${RED}✗ /metrics missing expected series${NC}"
+fi
+echo ""
+
 # 5. Final Status Check
 echo "5. Final Status Check"
 test_endpoint "GET" "/api/status" "" "Final server status"